@@ -1,9 +1,11 @@
 
 #include <chrono>
-#include <functional> // For bind.
-#include <ext/random>
+#include <cmath>
+#include <random>
 
 #include "NakagamiFadingModel.h"
+#include "gamma_bulk.h"
+#include "fast_log.h"
 
 namespace
 {
@@ -20,6 +22,22 @@ system_now()
   return static_cast<unsigned long>(now.time_since_epoch().count());
 }
 
+///  The standard natural logarithm.
+struct exact_log
+{
+  double
+  operator()(double x) const
+  { return std::log(x); }
+};
+
+///  The natural logarithm within __gnu_cxx::__detail::__fast_log_error.
+struct fast_log
+{
+  double
+  operator()(double x) const
+  { return __gnu_cxx::__detail::__fast_log(x); }
+};
+
 }
 
 ///
@@ -33,12 +51,14 @@ public:
   ///  @brief  Create a Nakagami fading model implementation.
   ///  @param  m  The Nakagami shape parameter or fading figure.
   ///  @param  omega  The Nakagami shape parameter in dBp where 'p' is some power unit.
-  Impl(double m, double omega)
+  ///  @param  accuracy  The accuracy of the logarithms of the sampler.
+  Impl(double m, double omega, Accuracy accuracy)
   : _M_mu{m},
     _M_omega{std::pow(10.0, omega / 10.0)},
+    _M_accuracy{accuracy},
     _M_re{system_now()},
-    _M_nakd{_M_mu, _M_omega},
-    _M_gen{std::bind(_M_nakd, _M_re)}
+    _M_param{_M_mu, _M_omega / _M_mu},
+    _M_next{_S_block}
   { }
 
   ///  Return the Nakagami shape parameter or fading figure.
@@ -51,10 +71,38 @@ public:
   omega() const
   { return 10.0 * std::log10(_M_omega); }
 
+  ///  Return the accuracy of the logarithms of the sampler.
+  Accuracy
+  accuracy() const
+  { return _M_accuracy; }
+
   ///  Return an instantaneous total signal power in dBp where 'p' is the same power unit as omega.
+  ///  The samples are generated a block at a time.
   double
   operator()()
-  { return 10.0 * std::log10(_M_gen()); }
+  {
+    if (_M_next == _S_block)
+      {
+	generate(_M_buf, _M_buf + _S_block);
+	_M_next = 0;
+      }
+    return _M_buf[_M_next++];
+  }
+
+  ///  Fill [first, last) with instantaneous total signal powers in dBp.
+  ///  The square of the Nakagami amplitude is gamma distributed with shape m
+  ///  and scale omega / m; its logarithm is sampled directly and scaled to dB.
+  void
+  generate(double* first, double* last)
+  {
+    const std::size_t n = last - first;
+    if (_M_accuracy == Accuracy::fast)
+      __gnu_cxx::__detail::__generate_log_gamma(_M_re, first, n, _M_param, fast_log{});
+    else
+      __gnu_cxx::__detail::__generate_log_gamma(_M_re, first, n, _M_param, exact_log{});
+    for (std::size_t i = 0; i < n; ++i)
+      first[i] *= _S_dB_amplitude;
+  }
 
 private:
 
@@ -62,19 +110,33 @@ private:
   double _M_mu;
   ///  The Nakagami scale parameter in power units.
   double _M_omega;
+  ///  The accuracy of the logarithms of the sampler.
+  Accuracy _M_accuracy;
   ///  The pseudo-random number engine - the library default.
   std::default_random_engine _M_re;
-  ///  The underlying Nakagami distribution.
-  __gnu_cxx::nakagami_distribution<double> _M_nakd;
-  ///  The variate generator built from the pseudo-random number engine and the Nakagami distribution.
-  decltype(std::bind(_M_nakd, _M_re)) _M_gen;
+  ///  The Marsaglia-Tsang constants of the gamma distributed power.
+  __gnu_cxx::__detail::_Gamma_bulk_param<double> _M_param;
+
+  ///  The number of samples generated together for operator().
+  static constexpr std::size_t _S_block = __gnu_cxx::__detail::__bulk_block;
+  ///  Natural logarithms of the power to dB of the amplitude: 5 / ln(10).
+  static constexpr double _S_dB_amplitude = 2.1714724095162591382556445945830254;
+
+  ///  Samples generated but not yet returned by operator().
+  double _M_buf[_S_block];
+  ///  The next sample of _M_buf to return.
+  std::size_t _M_next;
 };
 
+constexpr std::size_t NakagamiFadingModel::Impl::_S_block;
+constexpr double NakagamiFadingModel::Impl::_S_dB_amplitude;
+
 ///  @brief  Create a Nakagami fading model.
 ///  @param  m  The Nakagami shape parameter or fading figure.
 ///  @param  omega  The Nakagami scale parameter in dBp where 'p' is some power unit.
-NakagamiFadingModel::NakagamiFadingModel(double m, double omega)
-: _M_impl{new NakagamiFadingModel::Impl{m, omega}}
+///  @param  accuracy  The accuracy of the logarithms of the sampler.
+NakagamiFadingModel::NakagamiFadingModel(double m, double omega, Accuracy accuracy)
+: _M_impl{new NakagamiFadingModel::Impl{m, omega, accuracy}}
 { }
 
 ///  Default destructor.
@@ -90,7 +152,17 @@ double
 NakagamiFadingModel::omega() const
 { return _M_impl.get()->omega(); }
 
+///  Return the accuracy of the logarithms of the sampler.
+NakagamiFadingModel::Accuracy
+NakagamiFadingModel::accuracy() const
+{ return _M_impl.get()->accuracy(); }
+
 ///  Return an instantaneous total signal power in dBp where 'p' is the same power unit as omega.
 double
 NakagamiFadingModel::operator()()
 { return _M_impl.get()->operator()(); }
+
+///  Fill [first, last) with instantaneous total signal powers in dBp where 'p' is the same power unit as omega.
+void
+NakagamiFadingModel::generate(double* first, double* last)
+{ _M_impl.get()->generate(first, last); }
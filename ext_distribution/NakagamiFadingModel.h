@@ -28,15 +28,32 @@
 ///  where @f$\Gamma(z)@f$ is the gamma function and @f$m >= 0.5@f$
 ///  and @f$\omega > 0@f$.  Here x is the amplitude so @f$x^2@f$ is the power.
 ///
+///  The power @f$x^2@f$ is gamma distributed with shape m and scale
+///  @f$\omega / m@f$, and is sampled directly in the log domain: the
+///  Marsaglia-Tsang candidate is formed as a logarithm, and no power
+///  is ever formed and converted.  The logarithms may be exact, with the
+///  standard logarithm, or fast, with a vectorizable logarithm whose error
+///  is below 1e-7 relative in the power (about 4.3e-7 dB).
+///
 class NakagamiFadingModel
 {
 
 public:
 
+  ///  The accuracy of the logarithms of the sampler.
+  enum class Accuracy
+  {
+    ///  With the standard logarithm.
+    exact,
+    ///  Within 1e-7 relative in power, for throughput.
+    fast
+  };
+
   ///  @brief  Create a Nakagami fading model.
   ///  @param  m  The Nakagami shape parameter or fading figure.
   ///  @param  omega  The Nakagami scale parameter in dBp where 'p' is some power unit.
-  NakagamiFadingModel(double m, double omega);
+  ///  @param  accuracy  The accuracy of the logarithms of the sampler.
+  NakagamiFadingModel(double m, double omega, Accuracy accuracy = Accuracy::exact);
   ///  Nakagami fading model destructor.
   ~NakagamiFadingModel();
 
@@ -44,10 +61,15 @@ public:
   double m() const;
   ///  Return the Nakagami scale parameter in dBp where 'p' is some power unit.
   double omega() const;
+  ///  Return the accuracy of the logarithms of the sampler.
+  Accuracy accuracy() const;
 
   ///  Return an instantaneous total signal power in dBp where 'p' is the same power unit as omega.
   double operator()();
 
+  ///  Fill [first, last) with instantaneous total signal powers in dBp where 'p' is the same power unit as omega.
+  void generate(double* first, double* last);
+
 private:
 
   class Impl;
@@ -1,10 +1,11 @@
 
 #include <cmath>
 #include <chrono>
-#include <functional> // For bind.
+#include <algorithm>
 #include <ext/random>
 
 #include "RiceFadingModel.h"
+#include "fast_log.h"
 
 namespace
 {
@@ -34,14 +35,15 @@ public:
   ///  @brief  Create a Rice fading model implementation.
   ///  @param  K  The Rice fading parameter in dB.
   ///  @param  A  Return the mean total power in dBp where 'p' is some power unit.
-  Impl(double K, double A)
+  ///  @param  accuracy  The accuracy of the conversion to dB.
+  Impl(double K, double A, Accuracy accuracy)
   : _M_K{std::pow(10.0, K / 10.0)},
     _M_A{std::pow(10.0, A / 10.0)},
     _M_nu{std::sqrt(_M_K * _M_A / (_M_K + 1.0))},
     _M_sigma{std::sqrt(_M_A / (2.0 * (_M_K + 1.0)))},
+    _M_accuracy{accuracy},
     _M_re{system_now()},
-    _M_rd{_M_nu, _M_sigma},
-    _M_gen{std::bind(_M_rd, _M_re)}
+    _M_rd{_M_nu, _M_sigma}
   { }
 
   ///  Return the Rice fading parameter in dB.
@@ -54,10 +56,42 @@ public:
   A() const
   { return 10.0 * std::log10(_M_nu * _M_nu + 2.0 * _M_sigma * _M_sigma); }
 
+  ///  Return the accuracy of the conversion to dB.
+  Accuracy
+  accuracy() const
+  { return _M_accuracy; }
+
   ///  Return an instantaneous total signal power in dBp where 'p' is the same power unit as A.
   double
   operator()()
-  { return 10.0 * std::log10(_M_gen()); }
+  {
+    const double x = _M_rd(_M_re);
+    if (_M_accuracy == Accuracy::fast)
+      return _S_dB * __gnu_cxx::__detail::__fast_log(x);
+    else
+      return 10.0 * std::log10(x);
+  }
+
+  ///  Fill [first, last) with instantaneous total signal powers in dBp.
+  ///  The variates are drawn a block at a time and converted together,
+  ///  so that the fast conversion vectorizes.
+  void
+  generate(double* first, double* last)
+  {
+    const std::size_t block = 256;
+    while (first != last)
+      {
+	const std::size_t n = std::min<std::size_t>(block, last - first);
+	for (std::size_t i = 0; i < n; ++i)
+	  first[i] = _M_rd(_M_re);
+	if (_M_accuracy == Accuracy::fast)
+	  __gnu_cxx::__detail::__fast_log_block(first, first, n, _S_dB);
+	else
+	  for (std::size_t i = 0; i < n; ++i)
+	    first[i] = 10.0 * std::log10(first[i]);
+	first += n;
+      }
+  }
 
 private:
 
@@ -69,19 +103,25 @@ private:
   double _M_nu;
   ///  The scale parameter of the underlying Rice distribution.
   double _M_sigma;
+  ///  The accuracy of the conversion to dB.
+  Accuracy _M_accuracy;
   ///  The pseudo-random number engine - the library default.
   std::default_random_engine _M_re;
   ///  The underlying Rice distribution.
   __gnu_cxx::rice_distribution<double> _M_rd;
-  ///  The variate generator built from the pseudo-random number engine and the Rice distribution.
-  decltype(std::bind(_M_rd, _M_re)) _M_gen;
+
+  ///  Natural logarithms to dB: 10 / ln(10).
+  static constexpr double _S_dB = 4.3429448190325182765112891891660508;
 };
 
+constexpr double RiceFadingModel::Impl::_S_dB;
+
 ///  @brief  Create a Rice fading model.
 ///  @param  K  The Rice fading parameter in dB.
 ///  @param  A  The mean total power in dBp where 'p' is some power unit.
-RiceFadingModel::RiceFadingModel(double K, double A)
-: _M_impl{new RiceFadingModel::Impl{K, A}}
+///  @param  accuracy  The accuracy of the conversion to dB.
+RiceFadingModel::RiceFadingModel(double K, double A, Accuracy accuracy)
+: _M_impl{new RiceFadingModel::Impl{K, A, accuracy}}
 { }
 
 ///  Default destructor.
@@ -97,7 +137,17 @@ double
 RiceFadingModel::A() const
 { return _M_impl.get()->A(); }
 
+///  Return the accuracy of the conversion to dB.
+RiceFadingModel::Accuracy
+RiceFadingModel::accuracy() const
+{ return _M_impl.get()->accuracy(); }
+
 ///  Return an instantaneous total power in dBp where 'p' is the same power unit as A.
 double
 RiceFadingModel::operator()()
 { return _M_impl.get()->operator()(); }
+
+///  Fill [first, last) with instantaneous total powers in dBp where 'p' is the same power unit as A.
+void
+RiceFadingModel::generate(double* first, double* last)
+{ _M_impl.get()->generate(first, last); }
@@ -32,15 +32,30 @@
 ///  of order 0 and @f$K >= 0@f$ and @f$A > 0@f$.  Here x is the amplitude
 ///  so @f$x^2@f$ is the power.
 ///
+///  The conversion of each variate to dB may be exact, with the standard
+///  logarithm, or fast, with a vectorizable logarithm whose error is below
+///  1e-7 relative in the power (about 4.3e-7 dB).  Most of the gain
+///  is in generate(), which converts whole arrays.
+///
 class RiceFadingModel
 {
 
 public:
 
+  ///  The accuracy of the conversion of powers to dB.
+  enum class Accuracy
+  {
+    ///  With the standard logarithm.
+    exact,
+    ///  Within 1e-7 relative in power, for throughput.
+    fast
+  };
+
   ///  @brief  Create a Rice fading model.
   ///  @param  K  The Rice fading parameter in dB.
   ///  @param  A  The mean total power in dBp where 'p' is some power unit.
-  RiceFadingModel(double K, double A);
+  ///  @param  accuracy  The accuracy of the conversion to dB.
+  RiceFadingModel(double K, double A, Accuracy accuracy = Accuracy::exact);
   ///  Rice fading model destructor.
   ~RiceFadingModel();
 
@@ -48,10 +63,15 @@ public:
   double K() const;
   ///  Return the mean total signal power in dBp where 'p' is some power unit.
   double A() const;
+  ///  Return the accuracy of the conversion to dB.
+  Accuracy accuracy() const;
 
   ///  Return an instantaneous total power in dBp where 'p' is the same power unit as A.
   double operator()();
 
+  ///  Fill [first, last) with instantaneous total powers in dBp where 'p' is the same power unit as A.
+  void generate(double* first, double* last);
+
 private:
 
   class Impl;
@@ -5,6 +5,7 @@
 //  Method: D. E. Knuth: TAOCP II, 3.4.1 E (2)
 
 #include <random>
+#include "gamma_bulk.h"
 
 namespace __gnu_cxx
 {
@@ -149,6 +150,28 @@ namespace __gnu_cxx
 	operator()(_UniformRandomNumberGenerator& __urng,
 		   const param_type& __p);
 
+      template<typename _ForwardIterator,
+	       typename _UniformRandomNumberGenerator>
+	void
+	__generate(_ForwardIterator __f, _ForwardIterator __t,
+		   _UniformRandomNumberGenerator& __urng)
+	{ this->__generate(__f, __t, __urng, this->param()); }
+
+      template<typename _ForwardIterator,
+	       typename _UniformRandomNumberGenerator>
+	void
+	__generate(_ForwardIterator __f, _ForwardIterator __t,
+		   _UniformRandomNumberGenerator& __urng,
+		   const param_type& __p)
+	{ this->__generate_impl(__f, __t, __urng, __p); }
+
+      template<typename _UniformRandomNumberGenerator>
+	void
+	__generate(result_type* __f, result_type* __t,
+		   _UniformRandomNumberGenerator& __urng,
+		   const param_type& __p)
+	{ this->__generate_impl(__f, __t, __urng, __p); }
+
       /**
        * @brief Return true if two beta distributions have
        *        the same parameters and the sequences that would
@@ -191,6 +214,13 @@ namespace __gnu_cxx
 		   beta_distribution<_RealType1>&);
 
     private:
+      template<typename _ForwardIterator,
+	       typename _UniformRandomNumberGenerator>
+	void
+	__generate_impl(_ForwardIterator __f, _ForwardIterator __t,
+			_UniformRandomNumberGenerator& __urng,
+			const param_type& __p);
+
       param_type _M_param;
 
       std::gamma_distribution<result_type> _M_gda;
@@ -255,6 +285,40 @@ namespace __gnu_cxx
 	  }
       }
 
+  template<typename _RealType>
+    template<typename _OutputIterator,
+	     typename _UniformRandomNumberGenerator>
+      void
+      beta_distribution<_RealType>::
+      __generate_impl(_OutputIterator __f, _OutputIterator __t,
+		      _UniformRandomNumberGenerator& __urng,
+		      const param_type& __p)
+      {
+	__glibcxx_function_requires(_OutputIteratorConcept<_OutputIterator>)
+
+	//  The gamma variates come in blocks from the shared bulk kernel.
+	const __detail::_Gamma_bulk_param<result_type>
+	  __pa(__p.alpha(), result_type(1)),
+	  __pb(__p.beta(), result_type(1));
+	result_type __x1[__detail::__bulk_block];
+	result_type __x2[__detail::__bulk_block];
+	std::size_t __n = std::distance(__f, __t);
+	while (__n > 0)
+	  {
+	    const std::size_t __m = std::min(__n, __detail::__bulk_block);
+	    __detail::__generate_gamma(__urng, __x1, __m, __pa);
+	    __detail::__generate_gamma(__urng, __x2, __m, __pb);
+	    for (std::size_t __i = 0; __i < __m; ++__i)
+	      {
+		const result_type __s = __x1[__i] + __x2[__i];
+		//  Both variates underflow only for tiny shapes; draw again then.
+		*__f++ = __s != result_type() ? __x1[__i] / __s
+					      : this->operator()(__urng, __p);
+	      }
+	    __n -= __m;
+	  }
+      }
+
   template<typename _RealType, typename _CharT, typename _Traits>
     std::basic_ostream<_CharT, _Traits>&
     operator<<(std::basic_ostream<_CharT, _Traits>& __os,
@@ -0,0 +1,427 @@
+#ifndef __GAMMA_BULK
+#define __GAMMA_BULK 1
+
+//  Bulk generation of uniform, normal and gamma variates, and of the
+//  logarithms of gamma variates, for the __generate_impl members of the
+//  distributions built on gamma variates.
+//  Method: G. Marsaglia, W. W. Tsang, "A simple method for generating
+//  gamma variables", ACM TOMS 26 (2000) 363-372.
+//
+//  The kernels are written so that GCC vectorizes them across a block,
+//  but the loops calling log, cos and sin only vectorize with -ffast-math,
+//  which gives the vector variants of libmvec.  Without it (__FAST_MATH__
+//  undefined) those calls are scalar and the kernels take scalar forms
+//  that make fewer of them: polar normals and a lazy acceptance test.
+//  On x86-64 with -march=native the bulk gamma variates are then 1.2 to
+//  1.5 times as fast as the distributions' operator(), against 2 to 3
+//  times with -O3 -ffast-math.
+
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+
+namespace __gnu_cxx
+{
+
+  namespace __detail
+  {
+
+    /**
+     * @brief The number of variates generated together by the bulk samplers.
+     */
+    constexpr std::size_t __bulk_block = 256;
+
+    /**
+     * @brief Fill @p __u[0..__n-1] with uniform variates in (0, 1].
+     *
+     * The bits of engines with a full 32 or 64 bit range are converted
+     * directly; other engines go through std::generate_canonical.
+     * The upper end is closed and the lower open so that the logarithm
+     * of a variate is always finite.
+     */
+    template<typename _RealType, typename _UniformRandomNumberGenerator>
+      void
+      __generate_canonical_block(_UniformRandomNumberGenerator& __urng,
+				 _RealType* __u, std::size_t __n)
+      {
+	typedef _UniformRandomNumberGenerator _Urng;
+	constexpr std::uint64_t __range = std::uint64_t(_Urng::max())
+					- std::uint64_t(_Urng::min());
+	constexpr int __digits = std::numeric_limits<_RealType>::digits;
+	constexpr int __shift = __digits <= 53 ? __digits : 53;
+	const _RealType __scale = std::ldexp(_RealType(1), -__shift);
+
+	if (__digits <= 53 && __range == ~std::uint64_t(0))
+	  for (std::size_t __i = 0; __i < __n; ++__i)
+	    {
+	      const std::uint64_t __x = std::uint64_t(__urng() - _Urng::min());
+	      __u[__i] = _RealType((__x >> (64 - __shift)) + 1) * __scale;
+	    }
+	else if (__digits <= 32 && __range == 0xffffffffULL)
+	  for (std::size_t __i = 0; __i < __n; ++__i)
+	    {
+	      const std::uint64_t __x = std::uint64_t(__urng() - _Urng::min());
+	      __u[__i] = _RealType((__x >> (32 - __shift)) + 1) * __scale;
+	    }
+	else if (__digits <= 53 && __range == 0xffffffffULL)
+	  for (std::size_t __i = 0; __i < __n; ++__i)
+	    {
+	      const std::uint64_t __hi = std::uint64_t(__urng() - _Urng::min());
+	      const std::uint64_t __lo = std::uint64_t(__urng() - _Urng::min());
+	      const std::uint64_t __x = (__hi << 32 | __lo) >> (64 - __shift);
+	      __u[__i] = _RealType(__x + 1) * __scale;
+	    }
+	else
+	  for (std::size_t __i = 0; __i < __n; ++__i)
+	    __u[__i] = _RealType(1)
+		     - std::generate_canonical<_RealType, __digits>(__urng);
+      }
+
+    /**
+     * @brief Fill @p __z[0..__n-1] with standard normal variates.
+     *
+     * With -ffast-math this is the trigonometric form of the Box-Muller
+     * transform: it has no rejection and its loops vectorize with the
+     * vector log, cos and sin.  Otherwise it is the polar form used by
+     * std::normal_distribution, which rejects a fifth of its candidates
+     * but makes one scalar call to log for two variates instead of three
+     * calls to log, cos and sin.
+     */
+    template<typename _RealType, typename _UniformRandomNumberGenerator>
+      void
+      __generate_normal_block(_UniformRandomNumberGenerator& __urng,
+			      _RealType* __z, std::size_t __n)
+      {
+#ifndef __FAST_MATH__
+	alignas(64) _RealType __w[__bulk_block];
+	while (__n > 0)
+	  {
+	    //  About enough pairs for the variates missing.
+	    const std::size_t __m = std::min(__bulk_block,
+					     2 * ((5 * __n + 7) / 8) + 2);
+	    __generate_canonical_block(__urng, __w, __m);
+	    for (std::size_t __i = 0; __i + 1 < __m && __n > 0; __i += 2)
+	      {
+		const _RealType __x = 2 * __w[__i] - 1;
+		const _RealType __y = 2 * __w[__i + 1] - 1;
+		const _RealType __r2 = __x * __x + __y * __y;
+		if (__r2 >= _RealType(1) || __r2 == _RealType(0))
+		  continue;
+		const _RealType __f = std::sqrt(-2 * std::log(__r2) / __r2);
+		*__z++ = __x * __f;
+		if (--__n > 0)
+		  {
+		    *__z++ = __y * __f;
+		    --__n;
+		  }
+	      }
+	  }
+#else
+	const _RealType __2pi = _RealType(6.283185307179586476925286766559005768L);
+	alignas(64) _RealType __u[__bulk_block];
+	while (__n > 0)
+	  {
+	    const std::size_t __h = std::min(__n, __bulk_block) / 2;
+	    if (__h == 0)
+	      {
+		//  One odd variate left over.
+		__generate_canonical_block(__urng, __u, 2);
+		*__z = std::sqrt(-2 * std::log(__u[0])) * std::cos(__2pi * __u[1]);
+		return;
+	      }
+	    __generate_canonical_block(__urng, __u, 2 * __h);
+	    //  Separate loops for cos and sin: GCC would merge them into sincos,
+	    //  which has no vector variant.
+	    for (std::size_t __i = 0; __i < __h; ++__i)
+	      {
+		__u[__i] = std::sqrt(-2 * std::log(__u[__i]));
+		__z[__i] = __u[__i] * std::cos(__2pi * __u[__h + __i]);
+	      }
+	    for (std::size_t __i = 0; __i < __h; ++__i)
+	      __z[__h + __i] = __u[__i] * std::sin(__2pi * __u[__h + __i]);
+	    __z += 2 * __h;
+	    __n -= 2 * __h;
+	  }
+#endif
+      }
+
+    /**
+     * @brief The constants of the Marsaglia-Tsang method for a gamma
+     *        distribution with shape @p __alpha and scale @p __beta.
+     *
+     * A shape below one is sampled as a gamma variate of shape alpha + 1
+     * times U^(1/alpha), as in std::gamma_distribution.
+     */
+    template<typename _RealType>
+      struct _Gamma_bulk_param
+      {
+	_Gamma_bulk_param(_RealType __alpha = _RealType(1),
+			  _RealType __beta = _RealType(1))
+	: _M_alpha(__alpha), _M_beta(__beta)
+	{
+	  _M_malpha = _M_alpha < _RealType(1) ? _M_alpha + _RealType(1) : _M_alpha;
+	  _M_a1 = _M_malpha - _RealType(1) / _RealType(3);
+	  _M_a2 = _RealType(1) / std::sqrt(_RealType(9) * _M_a1);
+	}
+
+	_RealType _M_alpha;
+	_RealType _M_beta;
+	_RealType _M_malpha;
+	_RealType _M_a1;
+	_RealType _M_a2;
+      };
+
+    /**
+     * @brief The Marsaglia-Tsang acceptance test for the normal variate
+     *        @p __x and the uniform variate @p __u.
+     *
+     * Sets @p __w to the cube of the candidate, or to one if the candidate
+     * is rejected because it is not positive, and returns nonzero if
+     * @p __a1 * @p __w is accepted.  With -ffast-math there are no branches,
+     * so that it vectorizes; otherwise the logarithms are only taken
+     * when the squeeze fails.
+     */
+    template<typename _RealType>
+      inline int
+      __marsaglia_tsang(_RealType __x, _RealType __u,
+			_RealType __a1, _RealType __a2, _RealType& __w)
+      {
+	const _RealType __x2 = __x * __x;
+	_RealType __v = _RealType(1) + __a2 * __x;
+	__v = __v * __v * __v;
+	const bool __pos = __v > _RealType(0);
+	__w = __pos ? __v : _RealType(1);
+	const bool __squeeze = __u < _RealType(1)
+				  - _RealType(0.0331) * __x2 * __x2;
+#ifndef __FAST_MATH__
+	return __pos && (__squeeze
+			 || std::log(__u) < _RealType(0.5) * __x2
+			    + __a1 * (_RealType(1) - __w + std::log(__w)));
+#else
+	const bool __full = std::log(__u)
+			  < _RealType(0.5) * __x2
+			  + __a1 * (_RealType(1) - __w + std::log(__w));
+	return __pos & (__squeeze | __full);
+#endif
+      }
+
+    /**
+     * @brief Fill @p __f[0..__n-1] with gamma variates.
+     *
+     * Each pass draws one normal and one uniform variate per missing output,
+     * runs the Marsaglia-Tsang acceptance test in all lanes at once
+     * without branches and compacts the accepted lanes into the output.
+     * More than 95% of the candidates are accepted for any shape.
+     */
+    template<typename _RealType, typename _UniformRandomNumberGenerator>
+      void
+      __generate_gamma(_UniformRandomNumberGenerator& __urng,
+		       _RealType* __f, std::size_t __n,
+		       const _Gamma_bulk_param<_RealType>& __p)
+      {
+	alignas(64) _RealType __z[__bulk_block];
+	alignas(64) _RealType __u[__bulk_block];
+	alignas(64) _RealType __v[__bulk_block];
+	//  The mask is int rather than bool so that it vectorizes with the reals.
+	int __ok[__bulk_block];
+
+	const _RealType __a1 = __p._M_a1;
+	const _RealType __a2 = __p._M_a2;
+	const _RealType __scale = __a1 * __p._M_beta;
+
+	std::size_t __k = 0;
+	while (__k < __n)
+	  {
+	    const std::size_t __m = std::min(__bulk_block, __n - __k);
+	    __generate_normal_block(__urng, __z, __m);
+	    __generate_canonical_block(__urng, __u, __m);
+	    for (std::size_t __i = 0; __i < __m; ++__i)
+	      {
+		_RealType __w;
+		__ok[__i] = __marsaglia_tsang(__z[__i], __u[__i], __a1, __a2, __w);
+		__v[__i] = __scale * __w;
+	      }
+	    for (std::size_t __i = 0; __i < __m; ++__i)
+	      if (__ok[__i])
+		__f[__k++] = __v[__i];
+	  }
+
+	if (__p._M_alpha != __p._M_malpha)
+	  {
+	    const _RealType __a = _RealType(1) / __p._M_alpha;
+	    for (std::size_t __k = 0; __k < __n; __k += __bulk_block)
+	      {
+		const std::size_t __m = std::min(__bulk_block, __n - __k);
+		__generate_canonical_block(__urng, __u, __m);
+		for (std::size_t __i = 0; __i < __m; ++__i)
+		  __f[__k + __i] *= std::pow(__u[__i], __a);
+	      }
+	  }
+      }
+
+    /**
+     * @brief Fill @p __f[0..__n-1] with gamma variates, the i-th with shape
+     *        @p __alpha[i] and scale @p __beta[i].
+     *
+     * The Marsaglia-Tsang constants of a block of outputs are computed
+     * in one vectorized pass.  The acceptance test then runs over the
+     * outputs still missing in the block, and the rejected ones are
+     * compacted together with their constants and retried until the block
+     * is full; moving the constants keeps the test loop free of gathers.
+     * Without -ffast-math the gain over a loop on the param_type overload
+     * comes only from the uniform and normal blocks: about 1.05 times for
+     * the k distribution and break-even for nakagami, against 1.4 to 1.7
+     * times with it.
+     */
+    template<typename _RealType, typename _UniformRandomNumberGenerator>
+      void
+      __generate_gamma(_UniformRandomNumberGenerator& __urng,
+		       _RealType* __f, std::size_t __n,
+		       const _RealType* __alpha, const _RealType* __beta)
+      {
+	alignas(64) _RealType __a1[__bulk_block];
+	alignas(64) _RealType __a2[__bulk_block];
+	alignas(64) _RealType __scale[__bulk_block];
+	alignas(64) _RealType __boost[__bulk_block];
+	alignas(64) _RealType __z[__bulk_block];
+	alignas(64) _RealType __u[__bulk_block];
+	alignas(64) _RealType __v[__bulk_block];
+	int __ok[__bulk_block];
+	int __idx[__bulk_block];
+
+	for (std::size_t __k = 0; __k < __n; __k += __bulk_block)
+	  {
+	    const std::size_t __m = std::min(__bulk_block, __n - __k);
+	    const _RealType* __al = __alpha + __k;
+	    const _RealType* __be = __beta + __k;
+	    _RealType* __out = __f + __k;
+
+	    //  A shape below one is boosted by U^(1/alpha), others by U^0.
+	    int __any_boost = 0;
+	    for (std::size_t __i = 0; __i < __m; ++__i)
+	      {
+		const bool __small = __al[__i] < _RealType(1);
+		const _RealType __ma = __small ? __al[__i] + _RealType(1) : __al[__i];
+		__a1[__i] = __ma - _RealType(1) / _RealType(3);
+		__a2[__i] = _RealType(1) / std::sqrt(_RealType(9) * __a1[__i]);
+		__scale[__i] = __a1[__i] * __be[__i];
+		__boost[__i] = __small ? _RealType(1) / __al[__i] : _RealType(0);
+		__any_boost |= __small;
+		__idx[__i] = int(__i);
+	      }
+
+	    std::size_t __np = __m;
+	    while (__np > 0)
+	      {
+		__generate_normal_block(__urng, __z, __np);
+		__generate_canonical_block(__urng, __u, __np);
+		for (std::size_t __j = 0; __j < __np; ++__j)
+		  {
+		    _RealType __w;
+		    __ok[__j] = __marsaglia_tsang(__z[__j], __u[__j],
+						  __a1[__j], __a2[__j], __w);
+		    __v[__j] = __scale[__j] * __w;
+		  }
+		std::size_t __nr = 0;
+		for (std::size_t __j = 0; __j < __np; ++__j)
+		  if (__ok[__j])
+		    __out[__idx[__j]] = __v[__j];
+		  else
+		    {
+		      __a1[__nr] = __a1[__j];
+		      __a2[__nr] = __a2[__j];
+		      __scale[__nr] = __scale[__j];
+		      __idx[__nr++] = __idx[__j];
+		    }
+		__np = __nr;
+	      }
+
+	    if (__any_boost)
+	      {
+		__generate_canonical_block(__urng, __u, __m);
+#ifndef __FAST_MATH__
+		for (std::size_t __i = 0; __i < __m; ++__i)
+		  if (__boost[__i] != _RealType(0))
+		    __out[__i] *= std::pow(__u[__i], __boost[__i]);
+#else
+		//  Not pow: its vector variant takes a scalar path for zero exponents.
+		for (std::size_t __i = 0; __i < __m; ++__i)
+		  __out[__i] *= std::exp(__boost[__i] * std::log(__u[__i]));
+#endif
+	      }
+	  }
+      }
+
+    /**
+     * @brief Fill @p __f[0..__n-1] with the logarithms of gamma variates,
+     *        taking logarithms with @p __log.
+     *
+     * The same Marsaglia-Tsang passes as __generate_gamma, but the output
+     * log(a1 beta) + 3 log(1 + a2 x) is formed from the candidate rather
+     * than its cube, and the boost for a shape below one is added as
+     * log(U) / alpha, so that neither overflows nor underflows.
+     * The acceptance test also uses @p __log, which with an approximate
+     * logarithm moves the acceptance probability by no more than its error.
+     */
+    template<typename _RealType, typename _UniformRandomNumberGenerator,
+	     typename _Log>
+      void
+      __generate_log_gamma(_UniformRandomNumberGenerator& __urng,
+			   _RealType* __f, std::size_t __n,
+			   const _Gamma_bulk_param<_RealType>& __p, _Log __log)
+      {
+	alignas(64) _RealType __z[__bulk_block];
+	alignas(64) _RealType __u[__bulk_block];
+	alignas(64) _RealType __v[__bulk_block];
+	int __ok[__bulk_block];
+
+	const _RealType __a1 = __p._M_a1;
+	const _RealType __a2 = __p._M_a2;
+	const _RealType __log_scale = std::log(__a1 * __p._M_beta);
+
+	std::size_t __k = 0;
+	while (__k < __n)
+	  {
+	    const std::size_t __m = std::min(__bulk_block, __n - __k);
+	    __generate_normal_block(__urng, __z, __m);
+	    __generate_canonical_block(__urng, __u, __m);
+	    for (std::size_t __i = 0; __i < __m; ++__i)
+	      {
+		const _RealType __x2 = __z[__i] * __z[__i];
+		const _RealType __t = _RealType(1) + __a2 * __z[__i];
+		const bool __pos = __t > _RealType(0);
+		const _RealType __lw = _RealType(3)
+				     * __log(__pos ? __t : _RealType(1));
+		const bool __squeeze = __u[__i] < _RealType(1)
+				       - _RealType(0.0331) * __x2 * __x2;
+		const bool __full = __log(__u[__i])
+				  < _RealType(0.5) * __x2
+				  + __a1 * (_RealType(1) - __t * __t * __t + __lw);
+		__ok[__i] = __pos & (__squeeze | __full);
+		__v[__i] = __log_scale + __lw;
+	      }
+	    for (std::size_t __i = 0; __i < __m; ++__i)
+	      if (__ok[__i])
+		__f[__k++] = __v[__i];
+	  }
+
+	if (__p._M_alpha != __p._M_malpha)
+	  {
+	    const _RealType __a = _RealType(1) / __p._M_alpha;
+	    for (std::size_t __k = 0; __k < __n; __k += __bulk_block)
+	      {
+		const std::size_t __m = std::min(__bulk_block, __n - __k);
+		__generate_canonical_block(__urng, __u, __m);
+		for (std::size_t __i = 0; __i < __m; ++__i)
+		  __f[__k + __i] += __a * __log(__u[__i]);
+	      }
+	  }
+      }
+
+  } // namespace __detail
+
+}
+
+#endif // __GAMMA_BULK
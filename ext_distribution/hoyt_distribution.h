@@ -277,7 +277,7 @@ namespace __gnu_cxx
 	result_type __num = result_type(0.5L) * (result_type(1) + __q2);
 	typename __gnu_cxx::arcsine_distribution<result_type>::param_type
 	  __pa(__num, __num / __q2);
-	result_type __x = this->_M_ad(__pa, __urng);
+	result_type __x = this->_M_ad(__urng, __pa);
 	result_type __y = this->_M_ed(__urng);
 	return (result_type(2) * __p.q() / (result_type(1) + __q2))
 	       * std::sqrt(__p.omega() * __x * __y);
@@ -303,7 +303,7 @@ namespace __gnu_cxx
 	  __pa(__num, __num / __q2);
 	while (__f != __t)
 	  {
-	    result_type __x = this->_M_ad(__pa, __urng);
+	    result_type __x = this->_M_ad(__urng, __pa);
 	    result_type __y = this->_M_ed(__urng);
 	    *__f++ = (__2q / __q2p1) * std::sqrt(__omega * __x * __y);
 	  }
@@ -0,0 +1,373 @@
+#ifndef __INVERSE_CDF_SAMPLER
+#define __INVERSE_CDF_SAMPLER 1
+
+#include <random>
+#include <vector>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <iterator>
+#include "gamma_bulk.h"
+
+namespace __gnu_cxx
+{
+
+  /**
+   * @brief A sampler for a continuous distribution from a table
+   *        of its quantile function.
+   *
+   * The quantile function is approximated once, from the distribution
+   * function F on a finite domain [a, b], by polynomials of degree 5
+   * on adaptively chosen intervals, as in the PINV method of
+   * G. Derflinger, W. Hörmann and J. Leydold, "Random variate generation
+   * by numerical inversion when only the density is known",
+   * ACM TOMACS 20 (2010) 18.  On each interval the polynomial interpolates
+   * the points (F(x_j), x_j) at the Chebyshev points x_j of the interval.
+   * The interval is shrunk until the polynomial increases between
+   * the nodes and its u-error |F(Q(u)) - u| at several points between
+   * each pair of nodes is below 0.9 times the requested resolution,
+   * the margin covering the error between the check points.
+   *
+   * A variate then costs one uniform variate, a guide table lookup
+   * and a polynomial evaluation, whatever the cost of F; the table pays
+   * off for distributions whose generators need several transcendental
+   * functions or special functions.
+   *
+   * The mass of F outside [a, b] is not sampled; choose a and b where
+   * the tails are well below the u-resolution.  Giving the survival
+   * function 1 - F as well keeps the interpolation nodes in an upper
+   * tail accurate where F itself has rounded to one.
+   */
+  template<typename _RealType = double>
+    class inverse_cdf_sampler
+    {
+      static_assert(std::is_floating_point<_RealType>::value,
+		    "template argument not a floating point type");
+
+    public:
+      /** The type of the range of the distribution. */
+      typedef _RealType result_type;
+
+      /** The degree of the interpolating polynomials. */
+      static constexpr int order = 5;
+
+      /**
+       * @brief Build the table from the distribution function @p __cdf
+       *        on [@p __a, @p __b].
+       */
+      template<typename _Cdf>
+	inverse_cdf_sampler(_Cdf __cdf, result_type __a, result_type __b,
+			    result_type __u_resolution = result_type(1.0e-10))
+	: inverse_cdf_sampler(__cdf,
+			      [&__cdf](result_type __x)
+			      { return result_type(1) - __cdf(__x); },
+			      __a, __b, __u_resolution)
+	{ }
+
+      /**
+       * @brief Build the table from the distribution function @p __cdf
+       *        and the survival function @p __sf on [@p __a, @p __b].
+       */
+      template<typename _Cdf, typename _Sf>
+	inverse_cdf_sampler(_Cdf __cdf, _Sf __sf,
+			    result_type __a, result_type __b,
+			    result_type __u_resolution = result_type(1.0e-10));
+
+      /**
+       * @brief Return the approximate quantile of the probability @p __u
+       *        of the distribution restricted to [a, b].
+       */
+      result_type
+      quantile(result_type __u) const
+      {
+	const result_type __U = __u * this->_M_mass;
+	return this->_M_eval(this->_M_locate(__U), __U);
+      }
+
+      /**
+       * @brief Generating functions.
+       */
+      template<typename _UniformRandomNumberGenerator>
+	result_type
+	operator()(_UniformRandomNumberGenerator& __urng) const
+	{
+	  result_type __u;
+	  __detail::__generate_canonical_block(__urng, &__u, 1);
+	  return this->quantile(__u);
+	}
+
+      template<typename _ForwardIterator,
+	       typename _UniformRandomNumberGenerator>
+	void
+	__generate(_ForwardIterator __f, _ForwardIterator __t,
+		   _UniformRandomNumberGenerator& __urng) const;
+
+      /**
+       * @brief Returns the ends of the domain of the table.
+       */
+      result_type
+      min() const
+      { return this->_M_a; }
+
+      result_type
+      max() const
+      { return this->_M_b; }
+
+      /**
+       * @brief Returns the number of polynomial pieces.
+       */
+      std::size_t
+      intervals() const
+      { return this->_M_iv.size(); }
+
+      /**
+       * @brief Returns the largest u-error found at the check points
+       *        while the table was built.
+       */
+      result_type
+      u_error() const
+      { return this->_M_uerr; }
+
+    private:
+      //  One polynomial piece: x = sum c[k] s^k for s in [0, 1] and the mass
+      //  U = u0 + s / rdu from a, u0 being the start of the piece.
+      struct _Interval
+      {
+	result_type _M_rdu;
+	std::array<result_type, order + 1> _M_c;
+      };
+
+      std::size_t
+      _M_locate(result_type __U) const
+      {
+	std::size_t __k = std::min(std::size_t(__U * this->_M_gscale),
+				   this->_M_guide.size() - 1);
+	std::size_t __i = this->_M_guide[__k];
+	while (this->_M_ustart[__i + 1] <= __U)
+	  ++__i;
+	return __i;
+      }
+
+      result_type
+      _M_eval(std::size_t __i, result_type __U) const
+      {
+	const _Interval& __iv = this->_M_iv[__i];
+	const result_type __s = (__U - this->_M_ustart[__i]) * __iv._M_rdu;
+	result_type __x = __iv._M_c[order];
+	for (int __k = order - 1; __k >= 0; --__k)
+	  __x = __x * __s + __iv._M_c[__k];
+	return __x;
+      }
+
+      result_type _M_a;
+      result_type _M_b;
+      result_type _M_mass;
+      result_type _M_uerr;
+      result_type _M_gscale;
+      std::vector<_Interval> _M_iv;
+      //  The starts of the pieces in mass, followed by a sentinel.
+      std::vector<result_type> _M_ustart;
+      //  _M_guide[k] is the interval holding the mass k / _M_gscale.
+      std::vector<std::size_t> _M_guide;
+    };
+
+}
+
+#endif // __INVERSE_CDF_SAMPLER
+
+#ifndef __INVERSE_CDF_SAMPLER_TCC
+#define __INVERSE_CDF_SAMPLER_TCC 1
+
+namespace __gnu_cxx
+{
+
+  template<typename _RealType>
+    template<typename _Cdf, typename _Sf>
+      inverse_cdf_sampler<_RealType>::
+      inverse_cdf_sampler(_Cdf __cdf, _Sf __sf,
+			  result_type __a, result_type __b,
+			  result_type __u_resolution)
+      : _M_a(__a), _M_b(__b), _M_mass(0), _M_uerr(0), _M_gscale(0)
+      {
+	constexpr int __n = order;
+	constexpr int __checks = 7;
+	const result_type __check[__checks]
+	  = { result_type(1) / 256, result_type(1) / 16, result_type(1) / 4,
+	      result_type(1) / 2, result_type(3) / 4, result_type(15) / 16,
+	      result_type(255) / 256 };
+	const result_type __pi = result_type(3.1415926535897932384626433832795029L);
+	const result_type __eps = std::numeric_limits<result_type>::epsilon();
+
+	if (!(__a < __b))
+	  throw std::domain_error("inverse_cdf_sampler: empty domain");
+	if (!(__u_resolution > result_type(0)))
+	  throw std::domain_error("inverse_cdf_sampler: u-resolution must be positive");
+
+	//  The mass between two points, from F below the median
+	//  and from 1 - F above it.
+	auto __mass = [&](result_type __F0, result_type __S0, result_type __x1)
+	{
+	  return __F0 < result_type(0.5)
+	       ? __cdf(__x1) - __F0
+	       : __S0 - __sf(__x1);
+	};
+
+	//  The Chebyshev-Lobatto points of [0, 1].
+	std::array<result_type, __n + 1> __cheb;
+	for (int __j = 0; __j <= __n; ++__j)
+	  __cheb[__j] = (1 - std::cos(__j * __pi / __n)) / 2;
+
+	result_type __x0 = __a;
+	result_type __h = (__b - __a) / 128;
+	result_type __U0 = 0;
+	while (__x0 < __b)
+	  {
+	    const result_type __F0 = __cdf(__x0);
+	    const result_type __S0 = __sf(__x0);
+	    if (__x0 + __h > __b || __b - (__x0 + __h) < __h / 64)
+	      __h = __b - __x0;
+
+	    while (true)
+	      {
+		std::array<result_type, __n + 1> __xj, __sj, __d;
+		for (int __j = 0; __j <= __n; ++__j)
+		  __xj[__j] = __j == __n ? __x0 + __h : __x0 + __h * __cheb[__j];
+		for (int __j = 0; __j <= __n; ++__j)
+		  __sj[__j] = __j == 0 ? 0 : __mass(__F0, __S0, __xj[__j]);
+		const result_type __du = __sj[__n];
+
+		//  Below the resolution of x the interval is taken as it is.
+		const bool __last_resort
+		  = __h <= 8 * __eps * std::max({std::abs(__x0), std::abs(__x0 + __h),
+						 __b - __a});
+
+		std::array<result_type, __n + 1> __c{};
+		__c[0] = __x0;
+		if (!(__du > 0))
+		  {
+		    //  No mass: never selected.
+		    this->_M_ustart.push_back(__U0);
+		    this->_M_iv.push_back(_Interval{0, __c});
+		    break;
+		  }
+		const result_type __rdu = 1 / __du;
+		bool __ok = true;
+		for (int __j = 1; __j <= __n; ++__j)
+		  {
+		    __sj[__j] *= __rdu;
+		    __ok = __ok && __sj[__j] > __sj[__j - 1];
+		  }
+
+		if (__ok)
+		  {
+		    //  Newton divided differences of x(s), then the monomial form.
+		    __d = __xj;
+		    for (int __k = 1; __k <= __n; ++__k)
+		      for (int __j = __n; __j >= __k; --__j)
+			__d[__j] = (__d[__j] - __d[__j - 1])
+				 / (__sj[__j] - __sj[__j - __k]);
+		    __c.fill(0);
+		    __c[0] = __d[__n];
+		    for (int __k = __n - 1; __k >= 0; --__k)
+		      {
+			for (int __m = __n - __k; __m >= 1; --__m)
+			  __c[__m] = __c[__m - 1] - __sj[__k] * __c[__m];
+			__c[0] = __d[__k] - __sj[__k] * __c[0];
+		      }
+
+		    //  The u-error and the monotony between each pair of nodes,
+		    //  at points crowding towards the nodes: next to an end of
+		    //  the domain where the density is infinite the error does
+		    //  not vanish at the node but tends to a limit.
+		    result_type __err = 0;
+		    for (int __j = 0; __j < __n && __ok; ++__j)
+		      for (int __i = 0; __i < __checks && __ok; ++__i)
+			{
+			  const result_type __s = __sj[__j]
+			    + (__sj[__j + 1] - __sj[__j]) * __check[__i];
+			  result_type __x = __c[__n];
+			  for (int __k = __n - 1; __k >= 0; --__k)
+			    __x = __x * __s + __c[__k];
+			  __ok = __xj[__j] <= __x && __x <= __xj[__j + 1];
+			  if (__ok)
+			    __err = std::max(__err,
+				std::abs(__mass(__F0, __S0, __x) - __s * __du));
+			}
+		    //  A margin for the error between the check points.
+		    __ok = __ok && __err <= __u_resolution * result_type(0.9);
+		    if (__ok || __last_resort)
+		      this->_M_uerr = std::max(this->_M_uerr, __err);
+		  }
+
+		if (__ok || __last_resort)
+		  {
+		    if (!__ok)
+		      {
+			//  Linear in the last resort.
+			__c.fill(0);
+			__c[0] = __x0;
+			__c[1] = __h;
+		      }
+		    this->_M_ustart.push_back(__U0);
+		    this->_M_iv.push_back(_Interval{__rdu, __c});
+		    __U0 += __du;
+		    break;
+		  }
+		__h /= 2;
+	      }
+
+	    __x0 = __x0 + __h < __b ? __x0 + __h : __b;
+	    __h *= result_type(1.3);
+	  }
+
+	this->_M_mass = __U0;
+	if (!(this->_M_mass > 0))
+	  throw std::domain_error("inverse_cdf_sampler: no mass in the domain");
+
+	const std::size_t __N = this->_M_iv.size();
+	//  A sentinel rather than infinity, which -ffast-math assumes away.
+	this->_M_ustart.push_back(std::numeric_limits<result_type>::max());
+
+	//  Four guide entries per interval: most lookups then land
+	//  in their interval or the next one.
+	const std::size_t __G = 4 * __N;
+	this->_M_gscale = result_type(__G) / this->_M_mass;
+	this->_M_guide.resize(__G + 1);
+	std::size_t __i = 0;
+	for (std::size_t __k = 0; __k <= __G; ++__k)
+	  {
+	    const result_type __U = __k / this->_M_gscale;
+	    while (__i + 1 < __N && this->_M_ustart[__i + 1] <= __U)
+	      ++__i;
+	    this->_M_guide[__k] = __i;
+	  }
+      }
+
+  template<typename _RealType>
+    template<typename _ForwardIterator,
+	     typename _UniformRandomNumberGenerator>
+      void
+      inverse_cdf_sampler<_RealType>::
+      __generate(_ForwardIterator __f, _ForwardIterator __t,
+		 _UniformRandomNumberGenerator& __urng) const
+      {
+	//  The lookups stay scalar: gathering the pieces of a block into
+	//  vector registers costs more than the branches of the guide walk.
+	constexpr std::size_t __blk = __detail::__bulk_block;
+	alignas(64) result_type __u[__blk];
+	std::size_t __n = std::distance(__f, __t);
+	while (__n > 0)
+	  {
+	    const std::size_t __m = std::min(__n, __blk);
+	    __detail::__generate_canonical_block(__urng, __u, __m);
+	    for (std::size_t __i = 0; __i < __m; ++__i)
+	      *__f++ = this->quantile(__u[__i]);
+	    __n -= __m;
+	  }
+      }
+
+}
+
+#endif // __INVERSE_CDF_SAMPLER_TCC
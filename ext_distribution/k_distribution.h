@@ -2,6 +2,7 @@
 #define __K_DISTRIBUTION 1
 
 #include <random>
+#include "gamma_bulk.h"
 
 namespace __gnu_cxx
 {
@@ -171,8 +172,8 @@ namespace __gnu_cxx
 	  typename std::gamma_distribution<result_type>::param_type
 	    __p1(__p.lambda(), result_type(1) / __p.lambda()),
 	    __p2(__p.nu(), __p.mu() / __p.nu());
-	  result_type __x = this->_M_gd1(__p1, __urng);
-	  result_type __y = this->_M_gd2(__p2, __urng);
+	  result_type __x = this->_M_gd1(__urng, __p1);
+	  result_type __y = this->_M_gd2(__urng, __p2);
 	  return std::sqrt(__x * __y);
 	}
 
@@ -198,6 +199,20 @@ namespace __gnu_cxx
 		   const param_type& __p)
 	{ this->__generate_impl(__f, __t, __urng, __p); }
 
+      /**
+       * @brief Generate one variate per element of [__f, __t), each with
+       *        its own parameters: the i-th from @p __lambda[i],
+       *        @p __mu[i] and @p __nu[i].
+       */
+      template<typename _ForwardIterator,
+	       typename _UniformRandomNumberGenerator>
+	void
+	__generate(_ForwardIterator __f, _ForwardIterator __t,
+		   _UniformRandomNumberGenerator& __urng,
+		   const result_type* __lambda, const result_type* __mu,
+		   const result_type* __nu)
+	{ this->__generate_impl(__f, __t, __urng, __lambda, __mu, __nu); }
+
       /**
        * @brief Return true if two K distributions have
        *        the same parameters and the sequences that would
@@ -248,6 +263,14 @@ namespace __gnu_cxx
 			_UniformRandomNumberGenerator& __urng,
 			const param_type& __p);
 
+      template<typename _ForwardIterator,
+	       typename _UniformRandomNumberGenerator>
+	void
+	__generate_impl(_ForwardIterator __f, _ForwardIterator __t,
+			_UniformRandomNumberGenerator& __urng,
+			const result_type* __lambda, const result_type* __mu,
+			const result_type* __nu);
+
       param_type _M_param;
 
       std::gamma_distribution<result_type> _M_gd1;
@@ -274,29 +297,32 @@ namespace __gnu_cxx
 {
 
   template<typename _RealType>
-    template<typename _UniformRandomNumberGenerator>
-      typename k_distribution<_RealType>::result_type
+    template<typename _OutputIterator,
+	     typename _UniformRandomNumberGenerator>
+      void
       k_distribution<_RealType>::
-      operator()(_UniformRandomNumberGenerator& __urng)
+      __generate_impl(_OutputIterator __f, _OutputIterator __t,
+		      _UniformRandomNumberGenerator& __urng,
+		      const param_type& __p)
       {
-	result_type __x = this->_M_gd1(__urng);
-	result_type __y = this->_M_gd2(__urng);
-	return std::sqrt(__x * __y);
-      }
+	__glibcxx_function_requires(_OutputIteratorConcept<_OutputIterator>)
 
-  template<typename _RealType>
-    template<typename _UniformRandomNumberGenerator>
-      typename k_distribution<_RealType>::result_type
-      k_distribution<_RealType>::
-      operator()(_UniformRandomNumberGenerator& __urng,
-		 const param_type& __p)
-      {
-	typename std::gamma_distribution<result_type>::param_type
+	//  The gamma variates come in blocks from the shared bulk kernel.
+	const __detail::_Gamma_bulk_param<result_type>
 	  __p1(__p.lambda(), result_type(1) / __p.lambda()),
 	  __p2(__p.nu(), __p.mu() / __p.nu());
-	result_type __x = this->_M_gd1(__p1, __urng);
-	result_type __y = this->_M_gd2(__p2, __urng);
-	return std::sqrt(__x * __y);
+	result_type __x[__detail::__bulk_block];
+	result_type __y[__detail::__bulk_block];
+	std::size_t __n = std::distance(__f, __t);
+	while (__n > 0)
+	  {
+	    const std::size_t __m = std::min(__n, __detail::__bulk_block);
+	    __detail::__generate_gamma(__urng, __x, __m, __p1);
+	    __detail::__generate_gamma(__urng, __y, __m, __p2);
+	    for (std::size_t __i = 0; __i < __m; ++__i)
+	      *__f++ = std::sqrt(__x[__i] * __y[__i]);
+	    __n -= __m;
+	  }
       }
 
   template<typename _RealType>
@@ -306,18 +332,34 @@ namespace __gnu_cxx
       k_distribution<_RealType>::
       __generate_impl(_OutputIterator __f, _OutputIterator __t,
 		      _UniformRandomNumberGenerator& __urng,
-		      const param_type& __p)
+		      const result_type* __lambda, const result_type* __mu,
+		      const result_type* __nu)
       {
 	__glibcxx_function_requires(_OutputIteratorConcept<_OutputIterator>)
 
-	typename std::gamma_distribution<result_type>::param_type
-	  __p1(__p.lambda(), result_type(1) / __p.lambda()),
-	  __p2(__p.nu(), __p.mu() / __p.nu());
-	while (__f != __t)
+	//  The gamma scales are computed for a block at a time and the
+	//  kernel derives its own constants from the shapes.
+	result_type __s1[__detail::__bulk_block];
+	result_type __s2[__detail::__bulk_block];
+	result_type __x[__detail::__bulk_block];
+	result_type __y[__detail::__bulk_block];
+	std::size_t __n = std::distance(__f, __t);
+	while (__n > 0)
 	  {
-	    result_type __x = this->_M_gd1(__p1, __urng);
-	    result_type __y = this->_M_gd2(__p2, __urng);
-	    *__f++ = std::sqrt(__x * __y);
+	    const std::size_t __m = std::min(__n, __detail::__bulk_block);
+	    for (std::size_t __i = 0; __i < __m; ++__i)
+	      {
+		__s1[__i] = result_type(1) / __lambda[__i];
+		__s2[__i] = __mu[__i] / __nu[__i];
+	      }
+	    __detail::__generate_gamma(__urng, __x, __m, __lambda, __s1);
+	    __detail::__generate_gamma(__urng, __y, __m, __nu, __s2);
+	    for (std::size_t __i = 0; __i < __m; ++__i)
+	      *__f++ = std::sqrt(__x[__i] * __y[__i]);
+	    __lambda += __m;
+	    __mu += __m;
+	    __nu += __m;
+	    __n -= __m;
 	  }
       }
 
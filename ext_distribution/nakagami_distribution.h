@@ -2,6 +2,7 @@
 #define __NAKAGAMI_DISTRIBUTION 1
 
 #include <random>
+#include "gamma_bulk.h"
 
 namespace __gnu_cxx
 {
@@ -138,7 +139,7 @@ namespace __gnu_cxx
         {
 	  typename std::gamma_distribution<result_type>::param_type
 	    __pg(__p.mu(), __p.omega() / __p.mu());
-	  return std::sqrt(this->_M_gd(__pg, __urng));
+	  return std::sqrt(this->_M_gd(__urng, __pg));
 	}
 
       template<typename _ForwardIterator,
@@ -163,6 +164,18 @@ namespace __gnu_cxx
 		   const param_type& __p)
 	{ this->__generate_impl(__f, __t, __urng, __p); }
 
+      /**
+       * @brief Generate one variate per element of [__f, __t), each with
+       *        its own parameters: the i-th from @p __mu[i] and @p __omega[i].
+       */
+      template<typename _ForwardIterator,
+	       typename _UniformRandomNumberGenerator>
+	void
+	__generate(_ForwardIterator __f, _ForwardIterator __t,
+		   _UniformRandomNumberGenerator& __urng,
+		   const result_type* __mu, const result_type* __omega)
+	{ this->__generate_impl(__f, __t, __urng, __mu, __omega); }
+
       /**
        * @brief Return true if two Nakagami distributions have
        *        the same parameters and the sequences that would
@@ -212,6 +225,13 @@ namespace __gnu_cxx
 			_UniformRandomNumberGenerator& __urng,
 			const param_type& __p);
 
+      template<typename _ForwardIterator,
+	       typename _UniformRandomNumberGenerator>
+	void
+	__generate_impl(_ForwardIterator __f, _ForwardIterator __t,
+			_UniformRandomNumberGenerator& __urng,
+			const result_type* __mu, const result_type* __omega);
+
       param_type _M_param;
 
       std::gamma_distribution<result_type> _M_gd;
@@ -247,10 +267,47 @@ namespace __gnu_cxx
       {
 	__glibcxx_function_requires(_OutputIteratorConcept<_OutputIterator>)
 
-	typename std::gamma_distribution<result_type>::param_type
+	//  The gamma variates come in blocks from the shared bulk kernel.
+	const __detail::_Gamma_bulk_param<result_type>
 	  __pg(__p.mu(), __p.omega() / __p.mu());
-	while (__f != __t)
-	  *__f++ = std::sqrt(this->_M_gd(__pg, __urng));
+	result_type __x[__detail::__bulk_block];
+	std::size_t __n = std::distance(__f, __t);
+	while (__n > 0)
+	  {
+	    const std::size_t __m = std::min(__n, __detail::__bulk_block);
+	    __detail::__generate_gamma(__urng, __x, __m, __pg);
+	    for (std::size_t __i = 0; __i < __m; ++__i)
+	      *__f++ = std::sqrt(__x[__i]);
+	    __n -= __m;
+	  }
+      }
+
+  template<typename _RealType>
+    template<typename _OutputIterator,
+	     typename _UniformRandomNumberGenerator>
+      void
+      nakagami_distribution<_RealType>::
+      __generate_impl(_OutputIterator __f, _OutputIterator __t,
+		      _UniformRandomNumberGenerator& __urng,
+		      const result_type* __mu, const result_type* __omega)
+      {
+	__glibcxx_function_requires(_OutputIteratorConcept<_OutputIterator>)
+
+	result_type __s[__detail::__bulk_block];
+	result_type __x[__detail::__bulk_block];
+	std::size_t __n = std::distance(__f, __t);
+	while (__n > 0)
+	  {
+	    const std::size_t __m = std::min(__n, __detail::__bulk_block);
+	    for (std::size_t __i = 0; __i < __m; ++__i)
+	      __s[__i] = __omega[__i] / __mu[__i];
+	    __detail::__generate_gamma(__urng, __x, __m, __mu, __s);
+	    for (std::size_t __i = 0; __i < __m; ++__i)
+	      *__f++ = std::sqrt(__x[__i]);
+	    __mu += __m;
+	    __omega += __m;
+	    __n -= __m;
+	  }
       }
 
   template<typename _RealType, typename _CharT, typename _Traits>
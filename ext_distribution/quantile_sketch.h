@@ -0,0 +1,525 @@
+//
+//  COPYRIGHT:  Copyright 2010 - 2014
+//              Alion Science and Technology
+///
+///  \def  QUANTILE_SKETCH_H
+///
+///  \brief  A guard for the streaming statistics header.
+///
+#ifndef QUANTILE_SKETCH_H
+#define QUANTILE_SKETCH_H 1
+
+///
+///  \file quantile_sketch.h  This file contains the definitions of streaming
+///                           moment and quantile accumulators.
+///
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <cmath>
+
+/**
+ *  @brief  A streaming accumulator of the first four central moments.
+ *          Values are accumulated with the one-pass updates of Welford
+ *          and Pebay so that accumulators filled in separate threads
+ *          can be merged exactly.
+ */
+template<typename Tp>
+  class moments
+  {
+  public:
+
+    ///  Type of datum.
+    using value_type = Tp;
+    ///  Type for sizes.
+    using size_type = std::size_t;
+
+    /**
+     *  @brief  Insertion operator.
+     *  @param[in]  x  The input value.
+     */
+    moments&
+    operator<<(value_type x)
+    {
+      const value_type n1 = _M_num;
+      ++_M_num;
+      const value_type n = _M_num;
+      const value_type delta = x - _M_mean;
+      const value_type delta_n = delta / n;
+      const value_type delta_n2 = delta_n * delta_n;
+      const value_type term1 = delta * delta_n * n1;
+      _M_mean += delta_n;
+      _M_m4 += term1 * delta_n2 * (n * n - 3 * n + 3)
+	     + 6 * delta_n2 * _M_m2 - 4 * delta_n * _M_m3;
+      _M_m3 += term1 * delta_n * (n - 2) - 3 * delta_n * _M_m2;
+      _M_m2 += term1;
+      _M_min = std::min(_M_min, x);
+      _M_max = std::max(_M_max, x);
+      return *this;
+    }
+
+    /**
+     *  @brief  Insert a range of values.
+     *  @param[in] begin The beginning iterator for input data.
+     *  @param[in] end   The ending iterator for input data.
+     */
+    template<typename Iter>
+      void
+      insert(Iter begin, Iter end)
+      {
+	for(; begin != end; ++begin)
+	  *this << *begin;
+      }
+
+    /**
+     *  @brief  Merge the moments of another accumulator into this one.
+     *  @param[in]  mom  The accumulator to merge.
+     */
+    moments&
+    operator+=(const moments& mom)
+    {
+      if (mom._M_num == 0)
+	return *this;
+      if (_M_num == 0)
+	return *this = mom;
+
+      const value_type na = _M_num;
+      const value_type nb = mom._M_num;
+      const value_type n = na + nb;
+      const value_type delta = mom._M_mean - _M_mean;
+      const value_type delta2 = delta * delta;
+      const value_type delta3 = delta * delta2;
+      const value_type delta4 = delta2 * delta2;
+
+      const value_type m2 = _M_m2 + mom._M_m2 + delta2 * na * nb / n;
+      const value_type m3 = _M_m3 + mom._M_m3
+			  + delta3 * na * nb * (na - nb) / (n * n)
+			  + 3 * delta * (na * mom._M_m2 - nb * _M_m2) / n;
+      const value_type m4 = _M_m4 + mom._M_m4
+			  + delta4 * na * nb * (na * na - na * nb + nb * nb)
+			    / (n * n * n)
+			  + 6 * delta2 * (na * na * mom._M_m2 + nb * nb * _M_m2)
+			    / (n * n)
+			  + 4 * delta * (na * mom._M_m3 - nb * _M_m3) / n;
+
+      _M_num += mom._M_num;
+      _M_mean += delta * nb / n;
+      _M_m2 = m2;
+      _M_m3 = m3;
+      _M_m4 = m4;
+      _M_min = std::min(_M_min, mom._M_min);
+      _M_max = std::max(_M_max, mom._M_max);
+      return *this;
+    }
+
+    /**
+     *  @brief  Return the number of items.
+     */
+    size_type
+    count() const noexcept
+    { return _M_num; }
+
+    /**
+     *  @brief  Return the mean.
+     */
+    value_type
+    mean() const noexcept
+    { return _M_mean; }
+
+    /**
+     *  @brief  Return the (population) variance.
+     */
+    value_type
+    variance() const noexcept
+    { return _M_m2 / _M_num; }
+
+    /**
+     *  @brief  Return the standard deviation.
+     */
+    value_type
+    sigma() const noexcept
+    { return std::sqrt(variance()); }
+
+    /**
+     *  @brief  Return the skewness.
+     */
+    value_type
+    skewness() const noexcept
+    { return std::sqrt(value_type(_M_num)) * _M_m3 / std::pow(_M_m2, 1.5); }
+
+    /**
+     *  @brief  Return the excess kurtosis.
+     */
+    value_type
+    kurtosis() const noexcept
+    { return value_type(_M_num) * _M_m4 / (_M_m2 * _M_m2) - 3; }
+
+    /**
+     *  @brief  Return the smallest value inserted.
+     */
+    value_type
+    min() const noexcept
+    { return _M_min; }
+
+    /**
+     *  @brief  Return the largest value inserted.
+     */
+    value_type
+    max() const noexcept
+    { return _M_max; }
+
+    /**
+     *  @brief  Reset the accumulator.
+     */
+    void
+    reset()
+    { *this = moments(); }
+
+  private:
+
+    ///  The number of items.
+    size_type _M_num = 0;
+
+    ///  The running mean.
+    value_type _M_mean = value_type{};
+
+    ///  The running sums of the second, third and fourth powers
+    ///  of the deviation from the mean.
+    value_type _M_m2 = value_type{};
+    value_type _M_m3 = value_type{};
+    value_type _M_m4 = value_type{};
+
+    ///  The running extrema.
+    value_type _M_min = std::numeric_limits<value_type>::max();
+    value_type _M_max = std::numeric_limits<value_type>::lowest();
+  };
+
+/**
+ *  @brief  A streaming quantile sketch - the merging t-digest of Dunning.
+ *          Values are clustered into weighted centroids which are small
+ *          near the tails and larger near the median so quantile estimates
+ *          are most accurate for extreme quantiles.  The centroid sizes
+ *          are limited by the logistic scale function k2, under which
+ *          a centroid at quantile q holds about q n log(n) / compression
+ *          items: the extreme items stay single and the relative error
+ *          in q is the same far into the tails.  The number of centroids
+ *          grows only as the compression parameter.  Sketches filled in
+ *          separate threads are merged in time proportional to the size
+ *          of the sketch.
+ *
+ *          Insertions are buffered and the const queries fold the buffer
+ *          into the centroids, so a sketch is not safe to use from several
+ *          threads at once, even if they only query it.
+ */
+template<typename Tp>
+  class quantile_sketch
+  {
+  public:
+
+    ///  Type of datum.
+    using value_type = Tp;
+    ///  Type for sizes.
+    using size_type = std::size_t;
+
+    /**
+     *  @brief  Create a quantile sketch.
+     *
+     *  @param[in]  compression  The accuracy parameter: larger values give
+     *                           more centroids and more accurate quantiles.
+     */
+    explicit
+    quantile_sketch(value_type compression = value_type{200})
+    : _M_compression{compression}
+    {
+      if (!(compression >= value_type{10}))
+	throw std::domain_error("quantile_sketch: compression must be at least 10");
+      _M_centroid.reserve(size_type(2 * compression));
+      _M_buffer.reserve(_S_buffer_factor * size_type(compression));
+    }
+
+    /**
+     *  @brief  Insertion operator.
+     *  @param[in]  x  The input value.
+     */
+    quantile_sketch&
+    operator<<(value_type x)
+    {
+      if (std::isnan(x))
+	return *this;
+      _M_buffer.push_back({x, value_type{1}});
+      if (_M_buffer.size() >= _S_buffer_factor * size_type(_M_compression))
+	_M_compress();
+      return *this;
+    }
+
+    /**
+     *  @brief  Insert a range of values.
+     *  @param[in] begin The beginning iterator for input data.
+     *  @param[in] end   The ending iterator for input data.
+     */
+    template<typename Iter>
+      void
+      insert(Iter begin, Iter end)
+      {
+	for(; begin != end; ++begin)
+	  *this << *begin;
+      }
+
+    /**
+     *  @brief  Merge another sketch into this one.
+     *  @param[in]  sk  The sketch to merge.
+     */
+    quantile_sketch&
+    operator+=(const quantile_sketch& sk)
+    {
+      if (&sk == this)
+	return *this += quantile_sketch(sk);
+
+      _M_compress();
+      _M_buffer.insert(_M_buffer.end(),
+		       sk._M_centroid.begin(), sk._M_centroid.end());
+      _M_buffer.insert(_M_buffer.end(),
+		       sk._M_buffer.begin(), sk._M_buffer.end());
+      //  The centroid means lie inside the extrema of the values they hold.
+      _M_min = std::min(_M_min, sk._M_min);
+      _M_max = std::max(_M_max, sk._M_max);
+      _M_compress();
+      return *this;
+    }
+
+    /**
+     *  @brief  Return the number of items.
+     */
+    size_type
+    count() const
+    {
+      _M_compress();
+      return static_cast<size_type>(_M_total);
+    }
+
+    /**
+     *  @brief  Return the number of centroids retained.
+     */
+    size_type
+    size() const
+    {
+      _M_compress();
+      return _M_centroid.size();
+    }
+
+    /**
+     *  @brief  Return the estimate of the value below which a fraction q
+     *          of the items lie.
+     *  @param[in]  q  The probability 0 <= q <= 1.
+     */
+    value_type
+    quantile(value_type q) const
+    {
+      _M_compress();
+      if (_M_centroid.empty())
+	return std::numeric_limits<value_type>::quiet_NaN();
+      if (q <= value_type{0})
+	return _M_min;
+      if (q >= value_type{1})
+	return _M_max;
+
+      const value_type index = q * _M_total;
+      value_type prev_x = _M_min;
+      value_type prev_c = value_type{0};
+      value_type cum = value_type{0};
+      for (const auto& c : _M_centroid)
+      {
+	const value_type ctr = cum + c.weight / 2;
+	if (index < ctr)
+	  return _S_lerp(prev_c, prev_x, ctr, c.mean, index);
+	prev_x = c.mean;
+	prev_c = ctr;
+	cum += c.weight;
+      }
+      return _S_lerp(prev_c, prev_x, _M_total, _M_max, index);
+    }
+
+    /**
+     *  @brief  Return the estimate of the fraction of items less than x.
+     *  @param[in]  x  The value.
+     */
+    value_type
+    cdf(value_type x) const
+    {
+      _M_compress();
+      if (_M_centroid.empty())
+	return std::numeric_limits<value_type>::quiet_NaN();
+      if (x < _M_min)
+	return value_type{0};
+      if (x >= _M_max)
+	return value_type{1};
+
+      value_type prev_x = _M_min;
+      value_type prev_c = value_type{0};
+      value_type cum = value_type{0};
+      for (const auto& c : _M_centroid)
+      {
+	const value_type ctr = cum + c.weight / 2;
+	if (x < c.mean)
+	  return _S_lerp(prev_x, prev_c, c.mean, ctr, x) / _M_total;
+	prev_x = c.mean;
+	prev_c = ctr;
+	cum += c.weight;
+      }
+      return _S_lerp(prev_x, prev_c, _M_max, _M_total, x) / _M_total;
+    }
+
+    /**
+     *  @brief  Return the smallest value inserted.
+     */
+    value_type
+    min() const
+    {
+      _M_compress();
+      return _M_min;
+    }
+
+    /**
+     *  @brief  Return the largest value inserted.
+     */
+    value_type
+    max() const
+    {
+      _M_compress();
+      return _M_max;
+    }
+
+    /**
+     *  @brief  Reset the sketch.
+     */
+    void
+    reset()
+    {
+      _M_centroid.clear();
+      _M_buffer.clear();
+      _M_total = value_type{0};
+      _M_min = std::numeric_limits<value_type>::max();
+      _M_max = std::numeric_limits<value_type>::lowest();
+    }
+
+  private:
+
+    ///  The size of the insertion buffer as a multiple of the compression.
+    static constexpr size_type _S_buffer_factor = 5;
+
+    ///  A weighted cluster of values.
+    struct _Centroid
+    {
+      value_type mean;
+      value_type weight;
+
+      bool
+      operator<(const _Centroid& c) const
+      { return mean < c.mean; }
+    };
+
+    static value_type
+    _S_lerp(value_type x0, value_type y0, value_type x1, value_type y1,
+	    value_type x)
+    {
+      if (x1 <= x0)
+	return (y0 + y1) / 2;
+      return y0 + (y1 - y0) * (x - x0) / (x1 - x0);
+    }
+
+    /**
+     *  @brief  Return the scale function k2(q) = norm log(q / (1 - q))
+     *          which limits centroid sizes to one unit of k.
+     */
+    static value_type
+    _S_k(value_type q, value_type norm)
+    { return norm * std::log(q / (1 - q)); }
+
+    /**
+     *  @brief  Return the inverse of the scale function.
+     */
+    static value_type
+    _S_q(value_type k, value_type norm)
+    { return 1 / (1 + std::exp(-k / norm)); }
+
+    /**
+     *  @brief  Return the item count limit of the centroid starting
+     *          after sofar items.  The first centroid is a single item.
+     */
+    value_type
+    _M_limit(value_type sofar, value_type norm) const
+    {
+      if (sofar <= value_type{0})
+	return value_type{0};
+      return _S_q(_S_k(sofar / _M_total, norm) + 1, norm) * _M_total;
+    }
+
+    /**
+     *  @brief  Fold the buffered values into the centroids.
+     */
+    void
+    _M_compress() const
+    {
+      if (_M_buffer.empty())
+	return;
+
+      for (const auto& c : _M_buffer)
+      {
+	_M_total += c.weight;
+	_M_min = std::min(_M_min, c.mean);
+	_M_max = std::max(_M_max, c.mean);
+      }
+      _M_buffer.insert(_M_buffer.end(),
+		       _M_centroid.begin(), _M_centroid.end());
+      std::sort(_M_buffer.begin(), _M_buffer.end());
+      _M_centroid.clear();
+
+      //  The normalization of k2 for n items: compression / Z(n).
+      const value_type norm = _M_compression
+	/ (4 * std::log(std::max(_M_total / _M_compression, value_type{1}))
+	   + 24);
+      value_type sofar = value_type{0};
+      value_type q_limit = _M_limit(sofar, norm);
+      _Centroid cur = _M_buffer.front();
+      for (size_type i = 1; i < _M_buffer.size(); ++i)
+      {
+	const auto& c = _M_buffer[i];
+	if (sofar + cur.weight + c.weight <= q_limit)
+	{
+	  cur.weight += c.weight;
+	  cur.mean += (c.mean - cur.mean) * c.weight / cur.weight;
+	}
+	else
+	{
+	  sofar += cur.weight;
+	  _M_centroid.push_back(cur);
+	  q_limit = _M_limit(sofar, norm);
+	  cur = c;
+	}
+      }
+      _M_centroid.push_back(cur);
+      _M_buffer.clear();
+    }
+
+    ///  The compression parameter.
+    value_type _M_compression;
+
+    //  The queries fold the buffer in: the state below is mutable.
+
+    ///  The centroids sorted by mean.
+    mutable std::vector<_Centroid> _M_centroid;
+
+    ///  The values inserted since the last compression.
+    mutable std::vector<_Centroid> _M_buffer;
+
+    ///  The total weight of the centroids.
+    mutable value_type _M_total = value_type{0};
+
+    ///  The extrema of the values inserted.
+    mutable value_type _M_min = std::numeric_limits<value_type>::max();
+    mutable value_type _M_max = std::numeric_limits<value_type>::lowest();
+  };
+
+#endif // QUANTILE_SKETCH_H
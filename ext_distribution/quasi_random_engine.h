@@ -0,0 +1,633 @@
+#ifndef __QUASI_RANDOM_ENGINE
+#define __QUASI_RANDOM_ENGINE 1
+
+#include <random>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+#include <istream>
+#include <ostream>
+
+namespace __gnu_cxx
+{
+
+  /**
+   * @brief How a quasi-random engine hands out the coordinates of its points.
+   *
+   * In the cyclic order the coordinates of point n are followed by those
+   * of point n + 1, so that a distribution drawing exactly dimension()
+   * uniform variates per variate - one inverse-CDF distribution, or
+   * several in turn - sees one point per variate.
+   *
+   * A rejection method draws an unpredictable number of uniform variates
+   * and would then wander through the coordinates of the following points,
+   * spoiling their low discrepancy.  In the dimension-stable order a point
+   * lasts until next_point() is called; the draws after its last coordinate
+   * come from a pseudo-random engine.  Calling next_point() after each
+   * variate, and resetting the distribution (as __gnu_cxx::qmc_generate
+   * does), then keeps the first dimension() draws of every variate
+   * on the low-discrepancy sequence.
+   */
+  enum class qmc_order
+  {
+    cyclic,
+    dimension_stable
+  };
+
+  namespace __detail
+  {
+
+    /**
+     * @brief The state shared by the quasi-random engines: the dimension,
+     *        the point index, the coordinate within the point, and the
+     *        engine padding the points in the dimension-stable order.
+     */
+    class _Qmc_state
+    {
+    public:
+      typedef std::uint_fast64_t result_type;
+
+      _Qmc_state(std::size_t __dim, qmc_order __order, result_type __seed)
+      : _M_dim(__dim), _M_order(__order), _M_index(0), _M_coord(0),
+	_M_pad(__seed)
+      {
+	if (__dim == 0)
+	  throw std::domain_error("quasi-random engine: zero dimension");
+      }
+
+      std::size_t _M_dim;
+      qmc_order _M_order;
+      //  The index of the current point.
+      std::uint64_t _M_index;
+      //  The next coordinate of the current point to be drawn.
+      std::size_t _M_coord;
+      std::mt19937_64 _M_pad;
+    };
+
+    //  The first primes, for the bases of the Halton sequence.
+    inline std::vector<unsigned>
+    __first_primes(std::size_t __n)
+    {
+      std::vector<unsigned> __p;
+      for (unsigned __k = 2; __p.size() < __n; ++__k)
+	if (std::all_of(__p.begin(), __p.end(),
+			[__k](unsigned __q) { return __k % __q != 0; }))
+	  __p.push_back(__k);
+      return __p;
+    }
+
+  } // namespace __detail
+
+  /**
+   * @brief A Sobol' low-discrepancy sequence as a uniform random
+   *        number generator.
+   *
+   * Each coordinate is a 64-bit fraction, so that one call gives one
+   * uniform variate through std::generate_canonical<double>.  The points
+   * are generated in Gray code order by the method of Antonov and Saleev,
+   * one exclusive or per coordinate.  The direction numbers of dimensions
+   * 2 to 21 are those of S. Joe and F. Y. Kuo, "Constructing Sobol
+   * sequences with better two-dimensional projections", SIAM J. Sci.
+   * Comput. 30 (2008) 2635-2654 (new-joe-kuo-6.21201).
+   *
+   * A nonzero seed applies a random digital shift - an exclusive or
+   * of each coordinate with a random word - which keeps the net
+   * structure and makes averages over independent seeds an unbiased
+   * error estimate.  The unshifted sequence skips its first point,
+   * which is the origin.
+   */
+  class sobol_engine
+  {
+  public:
+    /** The type of the generated random value. */
+    typedef std::uint_fast64_t result_type;
+
+    /** The largest dimension supported. */
+    static constexpr std::size_t max_dimension = 21;
+
+    /**
+     * @brief Constructs the engine for points of dimension @p __dim.
+     */
+    explicit
+    sobol_engine(std::size_t __dim = 1, result_type __seed = 0,
+		 qmc_order __order = qmc_order::cyclic)
+    : _M_state(__dim, __order, __seed)
+    {
+      if (__dim > max_dimension)
+	throw std::domain_error("sobol_engine: dimension too large");
+      this->_M_init_direction();
+      this->seed(__seed);
+    }
+
+    /**
+     * @brief Restarts the sequence, with the digital shift of @p __seed.
+     */
+    void
+    seed(result_type __seed = 0)
+    {
+      this->_M_seed = __seed;
+      this->_M_shift.assign(this->dimension(), 0);
+      if (__seed != 0)
+	{
+	  std::mt19937_64 __g(__seed);
+	  for (auto& __s : this->_M_shift)
+	    __s = __g();
+	}
+      this->_M_state._M_pad.seed(__seed);
+      this->_M_seek(__seed == 0 ? 1 : 0);
+    }
+
+    static constexpr result_type
+    min()
+    { return 0; }
+
+    static constexpr result_type
+    max()
+    { return std::numeric_limits<std::uint64_t>::max(); }
+
+    /**
+     * @brief Returns the next coordinate.
+     */
+    result_type
+    operator()()
+    {
+      auto& __st = this->_M_state;
+      if (__st._M_coord == __st._M_dim)
+	{
+	  if (__st._M_order == qmc_order::dimension_stable)
+	    return __st._M_pad();
+	  this->next_point();
+	}
+      const std::size_t __j = __st._M_coord++;
+      return this->_M_x[__j] ^ this->_M_shift[__j];
+    }
+
+    /**
+     * @brief Moves to the next point if any coordinate of the current one
+     *        has been drawn.
+     */
+    void
+    next_point()
+    {
+      auto& __st = this->_M_state;
+      if (__st._M_coord == 0)
+	return;
+      //  Gray code order: point n + 1 differs from point n
+      //  in the direction of the lowest zero bit of n.
+      const int __c = __builtin_ctzll(~__st._M_index);
+      const std::uint64_t* __v = this->_M_v.data() + __c * __st._M_dim;
+      for (std::size_t __j = 0; __j < __st._M_dim; ++__j)
+	this->_M_x[__j] ^= __v[__j];
+      ++__st._M_index;
+      __st._M_coord = 0;
+    }
+
+    /**
+     * @brief Skips @p __z coordinates.
+     */
+    void
+    discard(unsigned long long __z)
+    {
+      auto& __st = this->_M_state;
+      if (__st._M_order == qmc_order::dimension_stable)
+	for (; __z > 0; --__z)
+	  (*this)();
+      else
+	{
+	  const unsigned long long __c = __st._M_coord + __z;
+	  if (__c <= __st._M_dim)
+	    __st._M_coord = __c;
+	  else
+	    {
+	      //  The point of the last skipped coordinate.
+	      const unsigned long long __k = (__c - 1) / __st._M_dim;
+	      this->_M_seek(__st._M_index + __k);
+	      __st._M_coord = __c - __k * __st._M_dim;
+	    }
+	}
+    }
+
+    std::size_t
+    dimension() const
+    { return this->_M_state._M_dim; }
+
+    qmc_order
+    order() const
+    { return this->_M_state._M_order; }
+
+    /**
+     * @brief Returns the index of the current point in the sequence.
+     */
+    std::uint64_t
+    index() const
+    { return this->_M_state._M_index; }
+
+    friend bool
+    operator==(const sobol_engine& __e1, const sobol_engine& __e2)
+    {
+      return __e1._M_state._M_dim == __e2._M_state._M_dim
+	  && __e1._M_state._M_order == __e2._M_state._M_order
+	  && __e1._M_seed == __e2._M_seed
+	  && __e1._M_state._M_index == __e2._M_state._M_index
+	  && __e1._M_state._M_coord == __e2._M_state._M_coord
+	  && __e1._M_state._M_pad == __e2._M_state._M_pad;
+    }
+
+    template<typename _CharT, typename _Traits>
+      friend std::basic_ostream<_CharT, _Traits>&
+      operator<<(std::basic_ostream<_CharT, _Traits>& __os,
+		 const sobol_engine& __e)
+      {
+	const _CharT __space = __os.widen(' ');
+	return __os << __e._M_state._M_dim << __space
+		    << int(__e._M_state._M_order) << __space
+		    << __e._M_seed << __space
+		    << __e._M_state._M_index << __space
+		    << __e._M_state._M_coord << __space
+		    << __e._M_state._M_pad;
+      }
+
+    template<typename _CharT, typename _Traits>
+      friend std::basic_istream<_CharT, _Traits>&
+      operator>>(std::basic_istream<_CharT, _Traits>& __is,
+		 sobol_engine& __e)
+      {
+	std::size_t __dim, __coord;
+	int __order;
+	result_type __seed;
+	std::uint64_t __index;
+	std::mt19937_64 __pad;
+	if (__is >> __dim >> __order >> __seed >> __index >> __coord >> __pad)
+	  {
+	    __e = sobol_engine(__dim, __seed, qmc_order(__order));
+	    __e._M_seek(__index);
+	    __e._M_state._M_coord = __coord;
+	    __e._M_state._M_pad = __pad;
+	  }
+	return __is;
+      }
+
+  private:
+    void
+    _M_init_direction();
+
+    //  Sets the current point to point @p __n: the exclusive or of the
+    //  direction numbers of the bits of the Gray code of n.
+    void
+    _M_seek(std::uint64_t __n)
+    {
+      const std::size_t __dim = this->dimension();
+      this->_M_x.assign(__dim, 0);
+      const std::uint64_t __g = __n ^ (__n >> 1);
+      for (int __k = 0; __k < 64; ++__k)
+	if ((__g >> __k) & 1)
+	  for (std::size_t __j = 0; __j < __dim; ++__j)
+	    this->_M_x[__j] ^= this->_M_v[__k * __dim + __j];
+      this->_M_state._M_index = __n;
+      this->_M_state._M_coord = 0;
+    }
+
+    __detail::_Qmc_state _M_state;
+    result_type _M_seed;
+    //  The direction numbers, 64 rows of dimension() entries.
+    std::vector<std::uint64_t> _M_v;
+    //  The current point, unshifted, and the shifts.
+    std::vector<std::uint64_t> _M_x;
+    std::vector<std::uint64_t> _M_shift;
+  };
+
+  inline bool
+  operator!=(const sobol_engine& __e1, const sobol_engine& __e2)
+  { return !(__e1 == __e2); }
+
+  inline void
+  sobol_engine::_M_init_direction()
+  {
+    //  Joe and Kuo: the degree s, the coefficients a of the primitive
+    //  polynomial and the initial numbers m_1 ... m_s of dimensions 2 to 21.
+    static constexpr struct
+    {
+      unsigned __s;
+      unsigned __a;
+      unsigned __m[7];
+    }
+    __jk[max_dimension - 1]
+    {
+      {1,  0, {1}},
+      {2,  1, {1, 3}},
+      {3,  1, {1, 3, 1}},
+      {3,  2, {1, 1, 1}},
+      {4,  1, {1, 1, 3, 3}},
+      {4,  4, {1, 3, 5, 13}},
+      {5,  2, {1, 1, 5, 5, 17}},
+      {5,  4, {1, 1, 5, 5, 5}},
+      {5,  7, {1, 1, 7, 11, 19}},
+      {5, 11, {1, 1, 5, 1, 1}},
+      {5, 13, {1, 1, 1, 3, 11}},
+      {5, 14, {1, 3, 5, 5, 31}},
+      {6,  1, {1, 3, 3, 9, 7, 49}},
+      {6, 13, {1, 1, 1, 15, 21, 21}},
+      {6, 16, {1, 3, 1, 13, 27, 49}},
+      {6, 19, {1, 1, 1, 15, 7, 5}},
+      {6, 22, {1, 3, 1, 15, 13, 25}},
+      {6, 25, {1, 1, 5, 5, 19, 61}},
+      {7,  1, {1, 3, 7, 11, 23, 15, 103}},
+      {7,  4, {1, 3, 7, 13, 13, 15, 69}},
+    };
+
+    const std::size_t __dim = this->dimension();
+    this->_M_v.assign(64 * __dim, 0);
+    std::uint64_t __m[64];
+    for (std::size_t __j = 0; __j < __dim; ++__j)
+      {
+	if (__j == 0)
+	  std::fill(__m, __m + 64, 1);
+	else
+	  {
+	    //  m_k = 2 a_1 m_{k-1} ^ 4 a_2 m_{k-2} ^ ... ^ 2^s m_{k-s} ^ m_{k-s}.
+	    const auto& __p = __jk[__j - 1];
+	    for (unsigned __k = 0; __k < __p.__s; ++__k)
+	      __m[__k] = __p.__m[__k];
+	    for (unsigned __k = __p.__s; __k < 64; ++__k)
+	      {
+		std::uint64_t __mk = __m[__k - __p.__s]
+				   ^ (__m[__k - __p.__s] << __p.__s);
+		for (unsigned __i = 1; __i < __p.__s; ++__i)
+		  if ((__p.__a >> (__p.__s - 1 - __i)) & 1)
+		    __mk ^= __m[__k - __i] << __i;
+		__m[__k] = __mk;
+	      }
+	  }
+	//  v_k = m_k / 2^k as a 64-bit fraction.
+	for (unsigned __k = 0; __k < 64; ++__k)
+	  this->_M_v[__k * __dim + __j] = __m[__k] << (63 - __k);
+      }
+  }
+
+  /**
+   * @brief A scrambled Halton low-discrepancy sequence as a uniform random
+   *        number generator.
+   *
+   * Coordinate j of point n is the radical inverse of n in the j-th prime
+   * base.  A nonzero seed scrambles each digit of each base with its own
+   * random permutation (J. Matoušek, "On the L2-discrepancy for anchored
+   * boxes", J. Complexity 14 (1998) 527-556), which removes the
+   * correlations between the coordinates of large bases that spoil the
+   * plain sequence in more than a few dimensions.  The digits beyond
+   * those of n are scrambled too, their sum being kept per base, so that
+   * the coordinates fill 53 bits.  The unscrambled sequence skips its
+   * first point, which is the origin.
+   */
+  class halton_engine
+  {
+  public:
+    /** The type of the generated random value. */
+    typedef std::uint_fast64_t result_type;
+
+    /**
+     * @brief Constructs the engine for points of dimension @p __dim.
+     */
+    explicit
+    halton_engine(std::size_t __dim = 1, result_type __seed = 0,
+		  qmc_order __order = qmc_order::cyclic)
+    : _M_state(__dim, __order, __seed),
+      _M_base(__detail::__first_primes(__dim))
+    { this->seed(__seed); }
+
+    /**
+     * @brief Restarts the sequence, with the digit scrambling of @p __seed.
+     */
+    void
+    seed(result_type __seed = 0)
+    {
+      const std::size_t __dim = this->dimension();
+      this->_M_seed = __seed;
+      this->_M_ndigit.resize(__dim);
+      this->_M_perm_start.resize(__dim + 1);
+      this->_M_perm.clear();
+      this->_M_tail.clear();
+      this->_M_tail_start.resize(__dim + 1);
+      std::mt19937_64 __g(__seed);
+      for (std::size_t __j = 0; __j < __dim; ++__j)
+	{
+	  const unsigned __b = this->_M_base[__j];
+	  //  Enough digits for 53 bits.
+	  unsigned __nd = 0;
+	  for (double __w = 1; __w > std::numeric_limits<double>::epsilon() / 2;
+	       __w /= __b)
+	    ++__nd;
+	  this->_M_ndigit[__j] = __nd;
+	  this->_M_perm_start[__j] = this->_M_perm.size();
+	  for (unsigned __k = 0; __k < __nd; ++__k)
+	    {
+	      const std::size_t __p = this->_M_perm.size();
+	      this->_M_perm.resize(__p + __b);
+	      std::iota(this->_M_perm.begin() + __p, this->_M_perm.end(), 0u);
+	      if (__seed != 0)
+		std::shuffle(this->_M_perm.begin() + __p, this->_M_perm.end(), __g);
+	    }
+	  //  _M_tail[k] is the value of the digits k, k + 1, ... all zero.
+	  this->_M_tail_start[__j] = this->_M_tail.size();
+	  this->_M_tail.resize(this->_M_tail.size() + __nd + 1);
+	  double* __t = this->_M_tail.data() + this->_M_tail_start[__j];
+	  const unsigned* __pi = this->_M_perm.data() + this->_M_perm_start[__j];
+	  __t[__nd] = 0;
+	  for (unsigned __k = __nd; __k-- > 0; )
+	    __t[__k] = __t[__k + 1]
+		     + __pi[__k * __b] * std::pow(double(__b), -double(__k + 1));
+	}
+      this->_M_perm_start[__dim] = this->_M_perm.size();
+      this->_M_state._M_pad.seed(__seed);
+      this->_M_state._M_index = __seed == 0 ? 1 : 0;
+      this->_M_state._M_coord = 0;
+    }
+
+    static constexpr result_type
+    min()
+    { return 0; }
+
+    static constexpr result_type
+    max()
+    { return std::numeric_limits<std::uint64_t>::max(); }
+
+    /**
+     * @brief Returns the next coordinate.
+     */
+    result_type
+    operator()()
+    {
+      auto& __st = this->_M_state;
+      if (__st._M_coord == __st._M_dim)
+	{
+	  if (__st._M_order == qmc_order::dimension_stable)
+	    return __st._M_pad();
+	  this->next_point();
+	}
+      return this->_M_coordinate(__st._M_index, __st._M_coord++);
+    }
+
+    /**
+     * @brief Moves to the next point if any coordinate of the current one
+     *        has been drawn.
+     */
+    void
+    next_point()
+    {
+      auto& __st = this->_M_state;
+      if (__st._M_coord == 0)
+	return;
+      ++__st._M_index;
+      __st._M_coord = 0;
+    }
+
+    /**
+     * @brief Skips @p __z coordinates.
+     */
+    void
+    discard(unsigned long long __z)
+    {
+      auto& __st = this->_M_state;
+      if (__st._M_order == qmc_order::dimension_stable)
+	for (; __z > 0; --__z)
+	  (*this)();
+      else
+	{
+	  const unsigned long long __c = __st._M_coord + __z;
+	  const unsigned long long __k = __c <= __st._M_dim
+				       ? 0 : (__c - 1) / __st._M_dim;
+	  __st._M_index += __k;
+	  __st._M_coord = __c - __k * __st._M_dim;
+	}
+    }
+
+    std::size_t
+    dimension() const
+    { return this->_M_state._M_dim; }
+
+    qmc_order
+    order() const
+    { return this->_M_state._M_order; }
+
+    /**
+     * @brief Returns the index of the current point in the sequence.
+     */
+    std::uint64_t
+    index() const
+    { return this->_M_state._M_index; }
+
+    friend bool
+    operator==(const halton_engine& __e1, const halton_engine& __e2)
+    {
+      return __e1._M_state._M_dim == __e2._M_state._M_dim
+	  && __e1._M_state._M_order == __e2._M_state._M_order
+	  && __e1._M_seed == __e2._M_seed
+	  && __e1._M_state._M_index == __e2._M_state._M_index
+	  && __e1._M_state._M_coord == __e2._M_state._M_coord
+	  && __e1._M_state._M_pad == __e2._M_state._M_pad;
+    }
+
+    template<typename _CharT, typename _Traits>
+      friend std::basic_ostream<_CharT, _Traits>&
+      operator<<(std::basic_ostream<_CharT, _Traits>& __os,
+		 const halton_engine& __e)
+      {
+	const _CharT __space = __os.widen(' ');
+	return __os << __e._M_state._M_dim << __space
+		    << int(__e._M_state._M_order) << __space
+		    << __e._M_seed << __space
+		    << __e._M_state._M_index << __space
+		    << __e._M_state._M_coord << __space
+		    << __e._M_state._M_pad;
+      }
+
+    template<typename _CharT, typename _Traits>
+      friend std::basic_istream<_CharT, _Traits>&
+      operator>>(std::basic_istream<_CharT, _Traits>& __is,
+		 halton_engine& __e)
+      {
+	std::size_t __dim, __coord;
+	int __order;
+	result_type __seed;
+	std::uint64_t __index;
+	std::mt19937_64 __pad;
+	if (__is >> __dim >> __order >> __seed >> __index >> __coord >> __pad)
+	  {
+	    __e = halton_engine(__dim, __seed, qmc_order(__order));
+	    __e._M_state._M_index = __index;
+	    __e._M_state._M_coord = __coord;
+	    __e._M_state._M_pad = __pad;
+	  }
+	return __is;
+      }
+
+  private:
+    //  The scrambled radical inverse of @p __n in the base of coordinate
+    //  @p __j, as a 64-bit fraction.
+    result_type
+    _M_coordinate(std::uint64_t __n, std::size_t __j) const
+    {
+      const unsigned __b = this->_M_base[__j];
+      const unsigned* __pi = this->_M_perm.data() + this->_M_perm_start[__j];
+      const double* __t = this->_M_tail.data() + this->_M_tail_start[__j];
+      const double __rb = 1.0 / __b;
+      double __x = 0, __w = __rb;
+      unsigned __k = 0;
+      for (; __n > 0 && __k < this->_M_ndigit[__j]; ++__k, __n /= __b)
+	{
+	  __x += __pi[__k * __b + __n % __b] * __w;
+	  __w *= __rb;
+	}
+      __x += __t[__k];
+      //  Below one, but rounding may reach it.
+      return __x < 1.0 ? result_type(std::ldexp(__x, 64))
+		       : this->max() - 0x7ff;
+    }
+
+    __detail::_Qmc_state _M_state;
+    result_type _M_seed;
+    std::vector<unsigned> _M_base;
+    std::vector<unsigned> _M_ndigit;
+    //  The permutations of digit k of coordinate j start at
+    //  _M_perm[_M_perm_start[j] + k * base].
+    std::vector<unsigned> _M_perm;
+    std::vector<std::size_t> _M_perm_start;
+    std::vector<double> _M_tail;
+    std::vector<std::size_t> _M_tail_start;
+  };
+
+  inline bool
+  operator!=(const halton_engine& __e1, const halton_engine& __e2)
+  { return !(__e1 == __e2); }
+
+  /**
+   * @brief Fills [@p __f, @p __t) with variates of @p __d, each one
+   *        from its own point of the quasi-random engine @p __qrng.
+   *
+   * The distribution is reset before each variate so that none is
+   * drawn from a value cached from the previous point, such as the second
+   * normal variate of a Box-Muller pair: successive points of a
+   * low-discrepancy sequence are far from independent.  With an engine in
+   * the dimension-stable order every variate then starts at the first
+   * coordinate of its point, however many uniform variates it draws.
+   */
+  template<typename _ForwardIterator, typename _Distribution,
+	   typename _QuasiRandomEngine>
+    void
+    qmc_generate(_ForwardIterator __f, _ForwardIterator __t,
+		 _Distribution& __d, _QuasiRandomEngine& __qrng)
+    {
+      for (; __f != __t; ++__f)
+	{
+	  __d.reset();
+	  *__f = __d(__qrng);
+	  __qrng.next_point();
+	}
+    }
+
+}
+
+#endif // __QUASI_RANDOM_ENGINE
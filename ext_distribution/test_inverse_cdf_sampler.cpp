@@ -0,0 +1,190 @@
+// $HOME/bin/bin/g++ -std=c++14 -O3 -march=native -ffast-math -o test_inverse_cdf_sampler test_inverse_cdf_sampler.cpp
+
+// ./test_inverse_cdf_sampler [count]
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#include "inverse_cdf_sampler.h"
+#include "arcsine_distribution.h"
+#include "pareto_distribution.h"
+#include "logistic_distribution.h"
+#include "hoyt_distribution.h"
+
+const double pi = 3.1415926535897932384626433832795029;
+
+//  The default u-resolution of the tables.
+const double u_resolution = 1.0e-10;
+
+template<typename _Func>
+  double
+  time_ms(_Func __func)
+  {
+    auto __start = std::chrono::steady_clock::now();
+    __func();
+    auto __stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(__stop - __start).count();
+  }
+
+//  The largest |F(Q(u)) - u| over a fine grid of u, with F normalized
+//  to the mass in the table domain; the upper half from 1 - F.
+template<typename _Cdf, typename _Sf>
+  double
+  u_error(const __gnu_cxx::inverse_cdf_sampler<>& ics, _Cdf cdf, _Sf sf)
+  {
+    const double f0 = cdf(ics.min());
+    const double s1 = sf(ics.max());
+    const double mass = sf(ics.min()) - s1;
+    double err = 0.0;
+    const int n = 1000000;
+    for (int i = 0; i <= n; ++i)
+      {
+	const double u = double(i) / n;
+	const double x = ics.quantile(u);
+	err = std::max(err, u < 0.5
+			    ? std::abs((cdf(x) - f0) / mass - u)
+			    : std::abs((sf(x) - s1) / mass - (1 - u)));
+      }
+    return err;
+  }
+
+//  The Kolmogorov-Smirnov statistic sqrt(n) D_n of a sample against the CDF.
+template<typename _Cdf>
+  double
+  ks(std::vector<double> x, _Cdf cdf)
+  {
+    std::sort(x.begin(), x.end());
+    const std::size_t n = x.size();
+    double d = 0.0;
+    for (std::size_t i = 0; i < n; ++i)
+      {
+	const double f = cdf(x[i]);
+	d = std::max(d, std::max(f - double(i) / n, double(i + 1) / n - f));
+      }
+    return std::sqrt(double(n)) * d;
+  }
+
+//  Returns whether the u-error on the grid is within the resolution
+//  the table was built for.
+template<typename _Dist, typename _Cdf, typename _Sf>
+  bool
+  run(const char* name, _Dist dist,
+      const __gnu_cxx::inverse_cdf_sampler<>& ics, _Cdf cdf, _Sf sf,
+      std::size_t count)
+  {
+    std::mt19937_64 urng(42);
+    std::vector<double> x(count);
+
+    const double grid_err = u_error(ics, cdf, sf);
+    std::cout << name << ": " << ics.intervals() << " intervals"
+	      << ", u-error at the check points " << ics.u_error()
+	      << ", on a grid " << grid_err << '\n';
+    const bool ok = grid_err <= u_resolution;
+    if (!ok)
+      std::cout << "  FAIL: u-error above " << u_resolution << '\n';
+
+    auto ms = time_ms([&]{ dist.__generate(x.begin(), x.end(), urng); });
+    std::cout << "  " << std::left << std::setw(16) << "distribution" << std::right
+	      << std::setw(10) << ms << " ms  KS " << ks(x, cdf) << '\n';
+
+    ms = time_ms([&]{
+      for (auto& y : x)
+	y = ics(urng);
+    });
+    std::cout << "  " << std::left << std::setw(16) << "operator()" << std::right
+	      << std::setw(10) << ms << " ms  KS " << ks(x, cdf) << '\n';
+
+    ms = time_ms([&]{ ics.__generate(x.begin(), x.end(), urng); });
+    std::cout << "  " << std::left << std::setw(16) << "__generate" << std::right
+	      << std::setw(10) << ms << " ms  KS " << ks(x, cdf) << '\n';
+    return ok;
+  }
+
+int
+main(int n_app_args, char ** app_args)
+{
+  std::size_t count = 10000000;
+  if (n_app_args > 1)
+    count = std::atol(app_args[1]);
+
+  bool ok = true;
+
+  //  The tables end where the tails are well below the u-resolution.
+  {
+    const double a = -1.0, b = 3.0;
+    auto cdf = [=](double x)
+    { return 2 / pi * std::asin(std::sqrt(std::max(0.0, std::min(1.0, (x - a) / (b - a))))); };
+    auto sf = [=](double x)
+    { return 2 / pi * std::asin(std::sqrt(std::max(0.0, std::min(1.0, (b - x) / (b - a))))); };
+    ok &= run("arcsine(-1, 3)", __gnu_cxx::arcsine_distribution<>(a, b),
+	__gnu_cxx::inverse_cdf_sampler<>(cdf, sf, a, b), cdf, sf, count);
+  }
+
+  {
+    const double alpha = 3.0, mu = 2.0;
+    auto cdf = [=](double x)
+    { return x <= mu ? 0.0 : 1 - std::pow(mu / x, alpha); };
+    auto sf = [=](double x)
+    { return x <= mu ? 1.0 : std::pow(mu / x, alpha); };
+    ok &= run("pareto(3, 2)", __gnu_cxx::pareto_distribution<>(alpha, mu),
+	__gnu_cxx::inverse_cdf_sampler<>(cdf, sf, mu, mu * std::pow(5.0e-12, -1 / alpha)),
+	cdf, sf, count);
+  }
+
+  {
+    const double a = 1.0, b = 0.5;
+    auto cdf = [=](double x)
+    { return 1 / (1 + std::exp(-(x - a) / b)); };
+    auto sf = [=](double x)
+    { return 1 / (1 + std::exp((x - a) / b)); };
+    const double t = b * std::log(1 / 5.0e-12);
+    ok &= run("logistic(1, 0.5)", std::logistic_distribution<>(a, b),
+	__gnu_cxx::inverse_cdf_sampler<>(cdf, sf, a - t, a + t), cdf, sf, count);
+  }
+
+  {
+    //  The Hoyt envelope is |X + iY| with X ~ N(0, s_x^2), Y ~ N(0, s_y^2);
+    //  P(R <= r) and P(R > r) as integrals over the angle of (X, Y),
+    //  the first with expm1 so that it is accurate near zero.
+    const double q = 0.4, omega = 1.5;
+    const double sx2 = q * q * omega / (1 + q * q);
+    const double sy2 = omega / (1 + q * q);
+    auto angular = [=](double r, bool lower)
+    {
+      const int m = 128;
+      double sum = 0.0;
+      for (int i = 0; i < m; ++i)
+	{
+	  const double th = (i + 0.5) * (pi / 2) / m;
+	  const double c = std::cos(th), s = std::sin(th);
+	  const double k = c * c / (2 * sx2) + s * s / (2 * sy2);
+	  sum += (lower ? -std::expm1(-r * r * k) : std::exp(-r * r * k)) / (2 * k);
+	}
+      return 2 / (pi * std::sqrt(sx2 * sy2)) * sum * (pi / 2) / m;
+    };
+    auto cdf = [=](double r) { return angular(r, true); };
+    auto sf = [=](double r) { return angular(r, false); };
+    //  P(R > r) < exp(-r^2 / (2 s_y^2)) / q.
+    const double b = std::sqrt(-2 * sy2 * std::log(5.0e-12 * q));
+    ok &= run("hoyt(0.4, 1.5)", __gnu_cxx::hoyt_distribution<>(q, omega),
+	__gnu_cxx::inverse_cdf_sampler<>(cdf, sf, 0.0, b), cdf, sf, count);
+  }
+
+  try
+    {
+      __gnu_cxx::inverse_cdf_sampler<> bad([](double x) { return x; }, 1.0, 0.0);
+      std::cout << "empty domain accepted\n";
+    }
+  catch (const std::domain_error& e)
+    {
+      std::cout << "empty domain: " << e.what() << '\n';
+    }
+
+  return ok ? 0 : 1;
+}
@@ -2,6 +2,9 @@
 
 #include <iostream>
 #include <iomanip>
+#include <cmath>
+#include <vector>
+#include <chrono>
 
 #include "NakagamiFadingModel.h"
 #include "histogram.h"
@@ -57,4 +60,42 @@ main()
     bin << std::pow(10.0, rayleigh2() / 10.0);
   std::cout << "Mean: " << bin.mean() << std::endl;
   plot_histogram(bin, per);
+
+  //  Exact and fast logarithms, one at a time and in bulk, for m = 2 and
+  //  omega = 12: the power is gamma distributed with shape m and scale
+  //  omega / m, and the mean of 10 log10 of the amplitude is
+  //  5 (psi(m) + ln(omega / m)) / ln(10), with psi(2) = 1 - gamma.
+  const std::size_t n = 10000000;
+  const double m = 2.0, omega = 12.0;
+  const double mean = 5.0 * (1.0 - 0.5772156649015328606 + std::log(omega / m)) / std::log(10.0);
+  //  The variance of the logarithm of a gamma variate is psi'(m) = pi^2 / 6 - 1.
+  const double se = 5.0 / std::log(10.0) * std::sqrt((3.14159265358979323846 * 3.14159265358979323846 / 6.0 - 1.0) / n);
+  std::vector<double> x(n);
+  std::cout << std::endl << "Nakagami fading, mean " << mean << " dB" << std::endl;
+  for (auto accuracy : {NakagamiFadingModel::Accuracy::exact, NakagamiFadingModel::Accuracy::fast})
+  {
+    NakagamiFadingModel model(m, 10.0 * std::log10(omega), accuracy);
+    const char* name = accuracy == NakagamiFadingModel::Accuracy::fast ? "fast " : "exact";
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto & y : x)
+      y = model();
+    auto stop = std::chrono::steady_clock::now();
+    double sum = 0.0;
+    for (auto y : x)
+      sum += y;
+    std::cout << name << " operator(): "
+	      << std::chrono::duration<double, std::milli>(stop - start).count() << " ms"
+	      << "  mean z " << (sum / n - mean) / se << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    model.generate(x.data(), x.data() + n);
+    stop = std::chrono::steady_clock::now();
+    sum = 0.0;
+    for (auto y : x)
+      sum += y;
+    std::cout << name << " generate(): "
+	      << std::chrono::duration<double, std::milli>(stop - start).count() << " ms"
+	      << "  mean z " << (sum / n - mean) / se << std::endl;
+  }
 }
@@ -0,0 +1,109 @@
+// $HOME/bin/bin/g++ -std=c++14 -o test_quantile_sketch test_quantile_sketch.cpp -lpthread
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <ext/random>
+
+#include "quantile_sketch.h"
+
+int
+main()
+{
+  const std::size_t num_threads = 4;
+  const std::size_t per_thread = 1000000;
+
+  std::vector<std::vector<double>> data(num_threads);
+  std::vector<quantile_sketch<double>> sketch(num_threads);
+  std::vector<moments<double>> mom(num_threads);
+
+  std::vector<std::thread> threads;
+  for (std::size_t t = 0; t < num_threads; ++t)
+    threads.emplace_back([&, t]()
+    {
+      std::mt19937 re(t + 1);
+      __gnu_cxx::nakagami_distribution<double> nd(1.5, 2.0);
+      for (std::size_t i = 0; i < per_thread; ++i)
+      {
+	double x = 10.0 * std::log10(nd(re));
+	data[t].push_back(x);
+	sketch[t] << x;
+	mom[t] << x;
+      }
+    });
+  for (auto& thr : threads)
+    thr.join();
+
+  quantile_sketch<double> all;
+  moments<double> mall;
+  std::vector<double> sorted;
+  for (std::size_t t = 0; t < num_threads; ++t)
+  {
+    all += sketch[t];
+    mall += mom[t];
+    sorted.insert(sorted.end(), data[t].begin(), data[t].end());
+  }
+  std::sort(sorted.begin(), sorted.end());
+
+  double sum = 0.0;
+  for (auto x : sorted)
+    sum += x;
+  double mean = sum / sorted.size();
+  double var = 0.0;
+  for (auto x : sorted)
+    var += (x - mean) * (x - mean);
+  var /= sorted.size();
+
+  std::cout << "count:     " << all.count() << " in " << all.size() << " centroids\n";
+  std::cout << "mean:      " << mall.mean() << "  exact " << mean << '\n';
+  std::cout << "sigma:     " << mall.sigma() << "  exact " << std::sqrt(var) << '\n';
+  std::cout << "skewness:  " << mall.skewness() << '\n';
+  std::cout << "kurtosis:  " << mall.kurtosis() << '\n';
+
+  //  The merge keeps the true extrema.
+  assert(all.count() == sorted.size());
+  assert(all.min() == sorted.front());
+  assert(all.max() == sorted.back());
+
+  //  The queries work on a const sketch.
+  const quantile_sketch<double>& call = all;
+
+  std::cout << std::setw(10) << "q" << std::setw(14) << "sketch"
+	    << std::setw(14) << "exact" << std::setw(14) << "cdf"
+	    << std::setw(14) << "rank" << '\n';
+  for (double q : {1.0e-5, 1.0e-4, 1.0e-3, 0.01, 0.1, 0.5, 0.9, 0.99, 0.999,
+		   1.0 - 1.0e-5})
+  {
+    const double n = sorted.size();
+    const double exact = sorted[std::size_t(q * n)];
+    const double est = call.quantile(q);
+    const double cdf = call.cdf(exact);
+    //  The true fraction of items below the estimated quantile.
+    const double rank = (std::lower_bound(sorted.begin(), sorted.end(), est)
+			 - sorted.begin()) / n;
+    std::cout << std::setw(10) << q
+	      << std::setw(14) << est
+	      << std::setw(14) << exact
+	      << std::setw(14) << cdf
+	      << std::setw(14) << rank << '\n';
+
+    //  The rank errors are relative to the distance to the nearer tail.
+    const double tail = std::min(q, 1.0 - q);
+    assert(std::abs(rank - q) <= 0.05 * tail + 2.0 / n);
+    assert(std::abs(cdf - q) <= 0.05 * tail + 2.0 / n);
+    assert(std::abs(est - exact) <= 0.05);
+  }
+
+  //  Merging a sketch into itself doubles it.
+  quantile_sketch<double> twice = all;
+  twice += twice;
+  assert(twice.count() == 2 * sorted.size());
+  assert(twice.min() == sorted.front());
+  assert(twice.max() == sorted.back());
+  assert(std::abs(twice.cdf(all.quantile(0.5)) - 0.5) <= 0.01);
+}
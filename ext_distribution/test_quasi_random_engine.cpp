@@ -0,0 +1,162 @@
+// $HOME/bin/bin/g++ -std=c++14 -O3 -march=native -o test_quasi_random_engine test_quasi_random_engine.cpp
+
+// ./test_quasi_random_engine
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <random>
+#include <vector>
+#include <cmath>
+
+#include "quasi_random_engine.h"
+#include "pareto_distribution.h"
+#include "nakagami_distribution.h"
+
+//  Pseudo-random engines have no points.
+template<typename _Distribution>
+  void
+  qmc_generate(std::vector<double>::iterator f, std::vector<double>::iterator t,
+	       _Distribution& d, std::mt19937_64& urng)
+  {
+    for (; f != t; ++f)
+      *f = d(urng);
+  }
+
+using __gnu_cxx::qmc_generate;
+
+//  Root mean square error of @p estimate over @p reps independent
+//  randomizations, the r-th engine being made by @p make(r).
+template<typename _Make, typename _Estimate>
+  double
+  rmse(std::size_t reps, double exact, _Make make, _Estimate estimate)
+  {
+    double sum = 0.0;
+    for (std::size_t r = 1; r <= reps; ++r)
+      {
+	auto urng = make(r);
+	const double e = estimate(urng) - exact;
+	sum += e * e;
+      }
+    return std::sqrt(sum / reps);
+  }
+
+//  Error against sample count for pseudo-random, Sobol' and Halton points.
+template<typename _Estimator>
+  void
+  run(const char* name, std::size_t dim, double exact, _Estimator estimator,
+      __gnu_cxx::qmc_order order = __gnu_cxx::qmc_order::cyclic)
+  {
+    const std::size_t reps = 32;
+    std::cout << name << '\n'
+	      << std::setw(10) << "N" << std::setw(14) << "mt19937_64"
+	      << std::setw(14) << "sobol" << std::setw(14) << "halton" << '\n';
+    for (std::size_t n = 1 << 8; n <= 1 << 18; n <<= 2)
+      {
+	auto est = [&](auto& urng) { return estimator(urng, n); };
+	const double mc = rmse(reps, exact,
+			       [](std::size_t r) { return std::mt19937_64(r); }, est);
+	const double sobol = rmse(reps, exact,
+				  [=](std::size_t r)
+				  { return __gnu_cxx::sobol_engine(dim, r, order); }, est);
+	const double halton = rmse(reps, exact,
+				   [=](std::size_t r)
+				   { return __gnu_cxx::halton_engine(dim, r, order); }, est);
+	std::cout << std::setw(10) << n << std::setw(14) << mc
+		  << std::setw(14) << sobol << std::setw(14) << halton << '\n';
+      }
+  }
+
+//  The mean over n variates, a new point per variate.
+template<typename _Dist, typename _Func>
+  auto
+  mean_of(_Dist dist, _Func func)
+  {
+    return [=](auto& urng, std::size_t n) mutable
+    {
+      std::vector<double> x(n);
+      qmc_generate(x.begin(), x.end(), dist, urng);
+      double sum = 0.0;
+      for (auto y : x)
+	sum += func(y);
+      return sum / n;
+    };
+  }
+
+//  The largest power of independent Rayleigh fading branches.
+struct selection_diversity
+{
+  int branches;
+  std::exponential_distribution<> ed;
+
+  void
+  reset()
+  { ed.reset(); }
+
+  template<typename _UniformRandomNumberGenerator>
+    double
+    operator()(_UniformRandomNumberGenerator& urng)
+    {
+      double p = 0.0;
+      for (int b = 0; b < branches; ++b)
+	p = std::max(p, ed(urng));
+      return p;
+    }
+};
+
+int
+main()
+{
+  std::cout << std::scientific << std::setprecision(3);
+
+  //  The URNG interface and the state round trip.
+  {
+    __gnu_cxx::sobol_engine s(3, 7);
+    __gnu_cxx::halton_engine h(3, 7);
+    s.discard(10);
+    h.discard(10);
+    std::stringstream str;
+    str << s << ' ' << h;
+    __gnu_cxx::sobol_engine s2;
+    __gnu_cxx::halton_engine h2;
+    str >> s2 >> h2;
+    bool same = s == s2 && h == h2;
+    for (int i = 0; i < 100; ++i)
+      same = same && s() == s2() && h() == h2();
+    __gnu_cxx::sobol_engine s3(3, 7);
+    for (int i = 0; i < 110; ++i)
+      s3();
+    std::cout << "state round trip and discard: " << (same && s3 == s ? "ok" : "FAIL")
+	      << "\n\n";
+  }
+
+  //  One inverse-CDF variate per point: E[min(X, 4)] of a Pareto variate.
+  {
+    const double alpha = 3.0, mu = 2.0, c = 4.0;
+    const double exact = mu + mu / (alpha - 1) * (1 - std::pow(mu / c, alpha - 1));
+    run("E[min(X, 4)], X ~ pareto(3, 2); dimension 1", 1, exact,
+	mean_of(__gnu_cxx::pareto_distribution<>(alpha, mu),
+		[=](double x) { return std::min(x, c); }));
+  }
+  std::cout << '\n';
+
+  //  Selection diversity over four Rayleigh branches: the mean of the
+  //  largest of four exponential powers is 1 + 1/2 + 1/3 + 1/4.
+  run("E[max of 4 Rayleigh branch powers]; dimension 4", 4, 25.0 / 12.0,
+      mean_of(selection_diversity{4, {}}, [](double x) { return x; }));
+  std::cout << '\n';
+
+  //  A rejection method: Nakagami amplitude by Marsaglia-Tsang gamma.
+  //  E[X] = sqrt(omega / m) Gamma(m + 1/2) / Gamma(m).
+  {
+    const double m = 1.5, omega = 2.0;
+    const double exact = std::sqrt(omega / m)
+		       * std::exp(std::lgamma(m + 0.5) - std::lgamma(m));
+    auto est = mean_of(__gnu_cxx::nakagami_distribution<>(m, omega),
+		       [](double x) { return x; });
+    run("E[X], X ~ nakagami(1.5, 2); cyclic order, dimension 3", 3, exact, est);
+    std::cout << '\n';
+    run("E[X], X ~ nakagami(1.5, 2); dimension-stable order, dimension 3", 3, exact, est,
+	__gnu_cxx::qmc_order::dimension_stable);
+  }
+}
@@ -3,6 +3,8 @@
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+#include <vector>
+#include <chrono>
 
 #include "RiceFadingModel.h"
 #include "histogram.h"
@@ -49,4 +51,40 @@ main()
   std::cout << "Rayleigh fading" << std::endl;
   std::cout << "Mean: " << bin.mean() << std::endl;
   plot_histogram(bin, per);
+
+  //  Exact and fast conversions to dB, one at a time and in bulk, for
+  //  Rayleigh fading with A = 2: the power is exponential, and the mean
+  //  of 10 log10 of the amplitude is 5 (ln(A) - gamma) / ln(10).
+  const std::size_t n = 10000000;
+  const double mean = 5.0 * (std::log(2.0) - 0.5772156649015328606) / std::log(10.0);
+  //  The standard deviation of the logarithm of an exponential variate is pi / sqrt(6).
+  const double se = 5.0 / std::log(10.0) * 3.14159265358979323846 / std::sqrt(6.0 * n);
+  std::vector<double> x(n);
+  std::cout << std::endl << "Rayleigh fading, mean " << mean << " dB" << std::endl;
+  for (auto accuracy : {RiceFadingModel::Accuracy::exact, RiceFadingModel::Accuracy::fast})
+  {
+    RiceFadingModel model(-200.0, 10.0 * std::log10(2.0), accuracy);
+    const char* name = accuracy == RiceFadingModel::Accuracy::fast ? "fast " : "exact";
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto & y : x)
+      y = model();
+    auto stop = std::chrono::steady_clock::now();
+    double sum = 0.0;
+    for (auto y : x)
+      sum += y;
+    std::cout << name << " operator(): "
+	      << std::chrono::duration<double, std::milli>(stop - start).count() << " ms"
+	      << "  mean z " << (sum / n - mean) / se << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    model.generate(x.data(), x.data() + n);
+    stop = std::chrono::steady_clock::now();
+    sum = 0.0;
+    for (auto y : x)
+      sum += y;
+    std::cout << name << " generate(): "
+	      << std::chrono::duration<double, std::milli>(stop - start).count() << " ms"
+	      << "  mean z " << (sum / n - mean) / se << std::endl;
+  }
 }
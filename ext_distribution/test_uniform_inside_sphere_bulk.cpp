@@ -0,0 +1,106 @@
+// $HOME/bin/bin/g++ -std=c++14 -O3 -march=native -ffast-math -o test_uniform_inside_sphere_bulk test_uniform_inside_sphere_bulk.cpp
+
+// ./test_uniform_inside_sphere_bulk [count]
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+#include "uniform_inside_sphere_distribution.h"
+
+template<typename _Func>
+  double
+  time_ms(_Func __func)
+  {
+    auto __start = std::chrono::steady_clock::now();
+    __func();
+    auto __stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(__stop - __start).count();
+  }
+
+//  (|x|/r)^D is uniform on [0, 1] for points uniform in the ball:
+//  report the z-scores of its mean and of the largest coordinate mean,
+//  and the number of points outside the ball.
+template<std::size_t Dim>
+  void
+  report(const char* name, const std::vector<std::vector<double>>& x,
+	 double radius, double ms)
+  {
+    const std::size_t n = x[0].size();
+    double sum = 0.0, zmax = 0.0;
+    std::size_t outside = 0;
+    for (std::size_t i = 0; i < n; ++i)
+      {
+	double r2 = 0.0;
+	for (std::size_t j = 0; j < Dim; ++j)
+	  r2 += x[j][i] * x[j][i];
+	outside += r2 > radius * radius;
+	sum += std::pow(std::sqrt(r2) / radius, double(Dim));
+      }
+    for (std::size_t j = 0; j < Dim; ++j)
+      {
+	double m = 0.0;
+	for (std::size_t i = 0; i < n; ++i)
+	  m += x[j][i];
+	//  Var(x_j) = r^2 / (D + 2).
+	zmax = std::max(zmax, std::abs(m / n) / (radius / std::sqrt((Dim + 2.0) * n)));
+      }
+    std::cout << "  " << std::left << std::setw(16) << name << std::right
+	      << std::setw(10) << ms << " ms"
+	      << "  radius z " << std::setw(10) << (sum / n - 0.5) / std::sqrt(1.0 / (12 * n))
+	      << "  max mean z " << std::setw(10) << zmax
+	      << "  outside " << outside << '\n';
+  }
+
+template<std::size_t Dim>
+  void
+  run(std::size_t count, double radius)
+  {
+    std::mt19937_64 urng(42);
+    __gnu_cxx::uniform_inside_sphere_distribution<Dim> uisd(radius);
+    std::vector<std::vector<double>> x(Dim, std::vector<double>(count));
+    std::array<double*, Dim> px;
+    for (std::size_t j = 0; j < Dim; ++j)
+      px[j] = x[j].data();
+
+    std::cout << "D = " << Dim << ", radius = " << radius << '\n';
+
+    auto ms = time_ms([&]{
+      for (std::size_t i = 0; i < count; ++i)
+	{
+	  auto r = uisd(urng);
+	  for (std::size_t j = 0; j < Dim; ++j)
+	    x[j][i] = r[j];
+	}
+    });
+    report<Dim>("operator()", x, radius, ms);
+
+    std::vector<std::array<double, Dim>> y(count);
+    ms = time_ms([&]{ uisd.__generate(y.data(), y.data() + count, urng, uisd.param()); });
+    for (std::size_t i = 0; i < count; ++i)
+      for (std::size_t j = 0; j < Dim; ++j)
+	x[j][i] = y[i][j];
+    report<Dim>("__generate AoS", x, radius, ms);
+
+    ms = time_ms([&]{ uisd.__generate(px, count, urng); });
+    report<Dim>("__generate SoA", x, radius, ms);
+  }
+
+int
+main(int n_app_args, char ** app_args)
+{
+  std::size_t count = 10000000;
+  if (n_app_args > 1)
+    count = std::atol(app_args[1]);
+
+  run<1>(count, 1.0);
+  run<2>(count, 2.5);
+  run<3>(count, 1.0);
+  run<4>(count, 0.5);
+  run<7>(count / 4, 1.0);
+  run<12>(count / 4, 3.0);
+}
@@ -3,7 +3,9 @@
 
 #include <random>
 #include <array>
-#include <ext/random>
+#include <cmath>
+#include <algorithm>
+#include "gamma_bulk.h"
 
 namespace __gnu_cxx //_GLIBCXX_VISIBILITY(default)
 {
@@ -54,12 +56,12 @@ namespace __gnu_cxx //_GLIBCXX_VISIBILITY(default)
        */
       explicit
       uniform_inside_sphere_distribution(_RealType __radius = _RealType(1))
-      : _M_param(__radius), _M_uosd()
+      : _M_param(__radius), _M_nd()
       { }
 
       explicit
       uniform_inside_sphere_distribution(const param_type& __p)
-      : _M_param(__p), _M_uosd()
+      : _M_param(__p), _M_nd()
       { }
 
       /**
@@ -67,7 +69,7 @@ namespace __gnu_cxx //_GLIBCXX_VISIBILITY(default)
        */
       void
       reset()
-      { _M_uosd.reset(); }
+      { _M_nd.reset(); }
 
       /**
        * @brief Returns the @f$radius@f$ of the distribution.
@@ -150,6 +152,23 @@ namespace __gnu_cxx //_GLIBCXX_VISIBILITY(default)
 		   const param_type& __p)
 	{ this->__generate_impl(__f, __t, __urng, __p); }
 
+      /**
+       * @brief Generate @p __n points in structure-of-arrays form:
+       *        coordinate @c j of the i-th point is written to @p __x[j][i].
+       */
+      template<typename _UniformRandomNumberGenerator>
+	void
+	__generate(const std::array<_RealType*, _Dimen>& __x, std::size_t __n,
+		   _UniformRandomNumberGenerator& __urng)
+	{ this->__generate_soa(__x, __n, __urng, this->param()); }
+
+      template<typename _UniformRandomNumberGenerator>
+	void
+	__generate(const std::array<_RealType*, _Dimen>& __x, std::size_t __n,
+		   _UniformRandomNumberGenerator& __urng,
+		   const param_type& __p)
+	{ this->__generate_soa(__x, __n, __urng, __p); }
+
       /**
        * @brief Return true if two uniform on sphere distributions have
        *        the same parameters and the sequences that would be
@@ -158,7 +177,7 @@ namespace __gnu_cxx //_GLIBCXX_VISIBILITY(default)
       friend bool
       operator==(const uniform_inside_sphere_distribution& __d1,
 		 const uniform_inside_sphere_distribution& __d2)
-      { return __d1._M_param == __d2._M_param && __d1._M_uosd == __d2._M_uosd; }
+      { return __d1._M_param == __d2._M_param && __d1._M_nd == __d2._M_nd; }
 
       /**
        * @brief Inserts a %uniform_inside_sphere_distribution random number
@@ -205,8 +224,15 @@ namespace __gnu_cxx //_GLIBCXX_VISIBILITY(default)
 			_UniformRandomNumberGenerator& __urng,
 			const param_type& __p);
 
+      template<typename _UniformRandomNumberGenerator>
+	void
+	__generate_soa(const std::array<_RealType*, _Dimen>& __x, std::size_t __n,
+		       _UniformRandomNumberGenerator& __urng,
+		       const param_type& __p);
+
       param_type _M_param;
-      uniform_on_sphere_distribution<_Dimen, _RealType> _M_uosd;
+      // The directions for large dimensions are normalized normal vectors.
+      std::normal_distribution<_RealType> _M_nd;
     };
 
   /**
@@ -247,19 +273,27 @@ namespace __gnu_cxx //_GLIBCXX_VISIBILITY(default)
 	    result_type;
 
       public:
-	template<typename _UniformOnSphereDistribution,
+	template<typename _NormalDistribution,
 		 typename _UniformRandomNumberGenerator>
 	result_type
-	operator()(_UniformOnSphereDistribution& __uosd,
+	operator()(_NormalDistribution& __nd,
 		   _UniformRandomNumberGenerator& __urng,
 		   _RealType __radius)
         {
 	  std::__detail::_Adaptor<_UniformRandomNumberGenerator,
 				  _RealType> __aurng(__urng);
 
+	  result_type __ret;
+	  _RealType __sq = _RealType(0);
+	  for (auto& __val : __ret)
+	    {
+	      __val = __nd(__urng);
+	      __sq += __val * __val;
+	    }
+
 	  _RealType __pow = 1 / _RealType(_Dimen);
-	  _RealType __urt = __radius * std::pow(__aurng(), __pow);
-	  result_type __ret = __uosd(__aurng);
+	  _RealType __urt = __radius * std::pow(__aurng(), __pow)
+			  / std::sqrt(__sq);
 
 	  std::transform(__ret.begin(), __ret.end(), __ret.begin(),
 			 [__urt](_RealType __val)
@@ -267,6 +301,43 @@ namespace __gnu_cxx //_GLIBCXX_VISIBILITY(default)
 
 	  return __ret;
         }
+
+	// Bulk version: a block of normal vectors, each scaled to the length
+	// radius * U^(1/_Dimen) in one vectorized pass.
+	template<typename _UniformRandomNumberGenerator>
+	void
+	__generate(const std::array<_RealType*, _Dimen>& __x, std::size_t __n,
+		   _UniformRandomNumberGenerator& __urng, _RealType __radius)
+	{
+	  constexpr std::size_t __blk = __detail::__bulk_block;
+	  const _RealType __pow = 1 / _RealType(_Dimen);
+	  alignas(64) _RealType __u[__blk];
+	  alignas(64) _RealType __sq[__blk];
+
+	  for (std::size_t __k = 0; __k < __n; __k += __blk)
+	    {
+	      const std::size_t __m = std::min(__blk, __n - __k);
+	      for (std::size_t __j = 0; __j < _Dimen; ++__j)
+		__detail::__generate_normal_block(__urng, __x[__j] + __k, __m);
+	      __detail::__generate_canonical_block(__urng, __u, __m);
+	      std::fill(__sq, __sq + __m, _RealType(0));
+	      for (std::size_t __j = 0; __j < _Dimen; ++__j)
+		{
+		  const _RealType* __xj = __x[__j] + __k;
+		  for (std::size_t __i = 0; __i < __m; ++__i)
+		    __sq[__i] += __xj[__i] * __xj[__i];
+		}
+	      for (std::size_t __i = 0; __i < __m; ++__i)
+		__u[__i] = __radius * std::pow(__u[__i], __pow)
+			 / std::sqrt(__sq[__i]);
+	      for (std::size_t __j = 0; __j < _Dimen; ++__j)
+		{
+		  _RealType* __xj = __x[__j] + __k;
+		  for (std::size_t __i = 0; __i < __m; ++__i)
+		    __xj[__i] *= __u[__i];
+		}
+	    }
+	}
       };
 
     // Helper class for the uniform_inside_sphere_distribution generation
@@ -279,10 +350,10 @@ namespace __gnu_cxx //_GLIBCXX_VISIBILITY(default)
 	    result_type;
 
       public:
-	template<typename _UniformOnSphereDistribution,
+	template<typename _NormalDistribution,
 		 typename _UniformRandomNumberGenerator>
 	result_type
-	operator()(_UniformOnSphereDistribution&,
+	operator()(_NormalDistribution&,
 		   _UniformRandomNumberGenerator& __urng,
 		   _RealType __radius)
         {
@@ -308,6 +379,54 @@ namespace __gnu_cxx //_GLIBCXX_VISIBILITY(default)
 
 	  return __ret;
         }
+
+	// Bulk version: blocks of candidates in the cube are tested in one
+	// vectorized pass and the accepted ones are compacted into the output.
+	// Every candidate is stored and the accepted ones kept, so the
+	// compaction has no branch to mispredict.
+	// Each pass draws enough candidates to fill the missing points on
+	// average, given the fraction of the cube inside the ball.
+	template<typename _UniformRandomNumberGenerator>
+	void
+	__generate(const std::array<_RealType*, _Dimen>& __x, std::size_t __n,
+		   _UniformRandomNumberGenerator& __urng, _RealType __radius)
+	{
+	  constexpr std::size_t __blk = __detail::__bulk_block;
+	  alignas(64) _RealType __c[_Dimen][__blk];
+	  alignas(64) _RealType __sq[__blk];
+	  int __ok[__blk];
+
+	  // V_D / 2^D = V_{D-2} / 2^{D-2} * pi / (2 D).
+	  _RealType __rate = _RealType(1);
+	  for (std::size_t __j = _Dimen; __j >= 2; __j -= 2)
+	    __rate *= _RealType(1.5707963267948966192313216916397514L)
+		    / _RealType(__j);
+
+	  std::size_t __k = 0;
+	  while (__k < __n)
+	    {
+	      const std::size_t __np
+		= std::min(__blk, std::size_t((__n - __k) / __rate) + 1);
+	      for (std::size_t __j = 0; __j < _Dimen; ++__j)
+		{
+		  __detail::__generate_canonical_block(__urng, __c[__j], __np);
+		  for (std::size_t __i = 0; __i < __np; ++__i)
+		    __c[__j][__i] = _RealType(2) * __c[__j][__i] - _RealType(1);
+		}
+	      std::fill(__sq, __sq + __np, _RealType(0));
+	      for (std::size_t __j = 0; __j < _Dimen; ++__j)
+		for (std::size_t __i = 0; __i < __np; ++__i)
+		  __sq[__i] += __c[__j][__i] * __c[__j][__i];
+	      for (std::size_t __i = 0; __i < __np; ++__i)
+		__ok[__i] = __sq[__i] <= _RealType(1);
+	      for (std::size_t __i = 0; __i < __np && __k < __n; ++__i)
+		{
+		  for (std::size_t __j = 0; __j < _Dimen; ++__j)
+		    __x[__j][__k] = __radius * __c[__j][__i];
+		  __k += __ok[__i];
+		}
+	    }
+	}
       };
   } // namespace
 
@@ -323,7 +442,7 @@ namespace __gnu_cxx //_GLIBCXX_VISIBILITY(default)
 		 const param_type& __p)
       {
         uniform_inside_sphere_helper<_Dimen, _Dimen < 8, _RealType> __helper;
-        return __helper(_M_uosd, __urng, __p.radius());
+        return __helper(_M_nd, __urng, __p.radius());
       }
 
   template<std::size_t _Dimen, typename _RealType>
@@ -337,8 +456,49 @@ namespace __gnu_cxx //_GLIBCXX_VISIBILITY(default)
       {
 	__glibcxx_function_requires(_OutputIteratorConcept<_OutputIterator>)
 
-	while (__f != __t)
-	  *__f++ = this->operator()(__urng, __param);
+	// The points come from the bulk generator a block at a time.
+	alignas(64) _RealType __buf[_Dimen][__detail::__bulk_block];
+	std::array<_RealType*, _Dimen> __x;
+	for (std::size_t __j = 0; __j < _Dimen; ++__j)
+	  __x[__j] = __buf[__j];
+	std::size_t __n = std::distance(__f, __t);
+	while (__n > 0)
+	  {
+	    const std::size_t __m = std::min(__n, __detail::__bulk_block);
+	    this->__generate_soa(__x, __m, __urng, __param);
+	    for (std::size_t __i = 0; __i < __m; ++__i)
+	      {
+		result_type __res;
+		for (std::size_t __j = 0; __j < _Dimen; ++__j)
+		  __res[__j] = __buf[__j][__i];
+		*__f++ = __res;
+	      }
+	    __n -= __m;
+	  }
+      }
+
+  template<std::size_t _Dimen, typename _RealType>
+    template<typename _UniformRandomNumberGenerator>
+      void
+      uniform_inside_sphere_distribution<_Dimen, _RealType>::
+      __generate_soa(const std::array<_RealType*, _Dimen>& __x, std::size_t __n,
+		     _UniformRandomNumberGenerator& __urng,
+		     const param_type& __param)
+      {
+	// With -ffast-math the cost in bulk is in the engine: rejection takes
+	// _Dimen 2^_Dimen / V uniform variates per point and the transform
+	// _Dimen + 1, so the transform wins from dimension 3 on (2.55 against
+	// 3 for dimension 2, 5.73 against 4 for dimension 3).  Without it the
+	// transform makes scalar calls to log and pow for each point, and
+	// rejection wins up to dimension 4 (12.97 variates against 5).
+#ifdef __FAST_MATH__
+	constexpr std::size_t __min_transform = 3;
+#else
+	constexpr std::size_t __min_transform = 5;
+#endif
+        uniform_inside_sphere_helper<_Dimen, _Dimen < __min_transform,
+				     _RealType> __helper;
+        __helper.__generate(__x, __n, __urng, __param.radius());
       }
 
   template<std::size_t _Dimen, typename _RealType, typename _CharT,
@@ -359,7 +519,7 @@ namespace __gnu_cxx //_GLIBCXX_VISIBILITY(default)
       __os.fill(__space);
       __os.precision(std::numeric_limits<_RealType>::max_digits10);
 
-      __os << __x.radius() << __space << __x._M_uosd;
+      __os << __x.radius() << __space << __x._M_nd;
 
       __os.flags(__flags);
       __os.fill(__fill);
@@ -382,7 +542,7 @@ namespace __gnu_cxx //_GLIBCXX_VISIBILITY(default)
       __is.flags(__ios_base::dec | __ios_base::skipws);
 
       _RealType __radius_val;
-      __is >> __radius_val >> __x._M_uosd;
+      __is >> __radius_val >> __x._M_nd;
       __x.param(typename uniform_inside_sphere_distribution<_Dimen, _RealType>::
 		param_type(__radius_val));
 
@@ -16,6 +16,10 @@
 #include <vector>
 #include <algorithm>
 #include <stdexcept>
+#include <numeric>
+#include <cmath>
+#include <thread>
+#include <type_traits>
 
 /**
  *  @brief  A simple histogram class.
@@ -93,18 +97,22 @@ template<typename Tp>
 
     /**
      *  @brief  Create a histogram from a pair of bounds and a number of bins.
+     *          The bins are of equal width so the bin of a value
+     *          is computed arithmetically rather than by search.
      *
      *  @param[in]  num_bins  Number of bins.
      *  @param[in]  xmin      Lower bound of the first bin.
      *  @param[in]  xmax      Upper bound of the last bin.
      */
     histogram(size_type num_bins, value_type xmin, value_type xmax)
-    : _M_bin(num_bins + 1), _M_count(num_bins + 2)
+    : _M_bin(num_bins + 1), _M_count(num_bins + 2),
+      _M_uniform{true}, _M_xmin{xmin},
+      _M_scale{num_bins / (scale_type(xmax) - scale_type(xmin))}
     {
       _M_bin[num_bins] = xmax;
-      value_type delta = (xmax - xmin) / num_bins;
+      const scale_type delta = (scale_type(xmax) - scale_type(xmin)) / num_bins;
       for (size_type i = 0; i < num_bins; ++i)
-	_M_bin[i] = xmin + i * delta;
+	_M_bin[i] = static_cast<value_type>(xmin + i * delta);
     }
 
     /**
@@ -147,25 +155,8 @@ template<typename Tp>
     histogram&
     operator<<(value_type x)
     {
-      if (x < _M_bin.front())
-      {
-	++_M_count.front();
-	return *this;
-      }
-      else if (x >= _M_bin.back())
-      {
-	++_M_count.back();
-	return *this;
-      }
-      else
-      {
-	auto pos = std::lower_bound(std::begin(_M_bin), std::end(_M_bin), x);
-	if (pos == _M_bin.end())
-	  ++_M_count.back();
-	else
-	  ++_M_count[pos - std::begin(_M_bin)];
-	return *this;
-      }
+      ++_M_count[_M_index(x)];
+      return *this;
     }
 
     /**
@@ -176,10 +167,7 @@ template<typename Tp>
     template<typename Iter>
       void
       insert(Iter begin, Iter end)
-      {
-	for(; begin != end; ++begin)
-          *this << *begin;
-      }
+      { _M_accumulate(begin, end, _M_count); }
 
     /**
      *  @brief  Insert a range of values.
@@ -195,6 +183,67 @@ template<typename Tp>
           *this << fun(*begin);
       }
 
+    /**
+     *  @brief  Insert a range of values using several threads.
+     *          Each thread bins a contiguous chunk of the input into
+     *          a private count array; the arrays are summed at the end.
+     *  @param[in] begin The beginning random access iterator for input data.
+     *  @param[in] end   The ending random access iterator for input data.
+     *  @param[in] num_threads  The number of threads to use.
+     */
+    template<typename RandIter>
+      void
+      parallel_insert(RandIter begin, RandIter end,
+		      unsigned num_threads = std::thread::hardware_concurrency())
+      {
+	const size_type len = end - begin;
+	if (num_threads < 2 || len < 2 * _S_block * num_threads)
+	{
+	  _M_accumulate(begin, end, _M_count);
+	  return;
+	}
+
+	std::vector<std::vector<size_type>>
+	  counts(num_threads, std::vector<size_type>(_M_count.size()));
+	std::vector<std::thread> threads;
+	const size_type chunk = len / num_threads;
+	for (unsigned t = 0; t < num_threads; ++t)
+	{
+	  auto first = begin + t * chunk;
+	  auto last = (t + 1 == num_threads ? end : first + chunk);
+	  threads.emplace_back([this, first, last, &counts, t]()
+			       { _M_accumulate(first, last, counts[t]); });
+	}
+	for (auto& thr : threads)
+	  thr.join();
+
+	for (const auto& cnt : counts)
+	  for (size_type i = 0; i < _M_count.size(); ++i)
+	    _M_count[i] += cnt[i];
+      }
+
+    /**
+     *  @brief  Add the counts of another histogram with the same bins.
+     *  @param[in]  hist  The histogram to merge into this one.
+     */
+    histogram&
+    operator+=(const histogram& hist)
+    {
+      if (hist._M_bin != _M_bin)
+	throw std::domain_error("histogram: merging histograms with different bins");
+      for (size_type i = 0; i < _M_count.size(); ++i)
+	_M_count[i] += hist._M_count[i];
+      return *this;
+    }
+
+    /**
+     *  @brief  Return true if the bins are of equal width
+     *          and the bin index is computed arithmetically.
+     */
+    bool
+    uniform() const noexcept
+    { return _M_uniform; }
+
     /**
      *  @brief  Return the number of bins.
      */
@@ -221,6 +270,9 @@ template<typename Tp>
     {
       this->_M_bin.swap(hist._M_bin);
       this->_M_count.swap(hist._M_count);
+      std::swap(this->_M_uniform, hist._M_uniform);
+      std::swap(this->_M_xmin, hist._M_xmin);
+      std::swap(this->_M_scale, hist._M_scale);
     }
 
     /**
@@ -229,7 +281,7 @@ template<typename Tp>
     size_type
     count() const noexcept
     { return std::accumulate(std::begin(this->_M_count),
-			     std::end(this->_M_count), 0); }
+			     std::end(this->_M_count), size_type{0}); }
 
     /**
      *  @brief  Return the number of items from below the lower limit up to bin @c i.
@@ -240,7 +292,7 @@ template<typename Tp>
     {
       size_type m = (i < this->_M_count.size() ? i : this->_M_count.size());
       return std::accumulate(this->_M_count.begin(),
-			     this->_M_count.begin() + m, 0);
+			     this->_M_count.begin() + m, size_type{0});
     }
 
     /**
@@ -329,10 +381,97 @@ template<typename Tp>
     void
     reset()
     { std::fill(std::begin(this->_M_count),
-		std::end(this->_M_count), 0); }
+		std::end(this->_M_count), size_type{0}); }
 
   private:
 
+    ///  Floating point type of the arithmetic bin index, so that
+    ///  histograms of integers do not truncate the bin width.
+    using scale_type = typename std::conditional<std::is_floating_point<Tp>::value,
+						 Tp, double>::type;
+
+    ///  The number of values binned together in the vectorizable index loop.
+    static constexpr size_type _S_block = 256;
+
+    /**
+     *  @brief  Return the index into the count array of value x.
+     *          Bins are half-open [left, right).
+     */
+    size_type
+    _M_index(value_type x) const
+    {
+      if (_M_uniform)
+	return _M_fix_index(x, static_cast<size_type>(_M_uniform_index(x)));
+      else if (x < _M_bin.front())
+	return 0;
+      else if (x >= _M_bin.back())
+	return _M_count.size() - 1;
+      else
+	return std::upper_bound(std::begin(_M_bin), std::end(_M_bin), x)
+	     - std::begin(_M_bin);
+    }
+
+    /**
+     *  @brief  Return the arithmetic estimate of the count index of x
+     *          for uniform bins.  The result is clamped to the tails
+     *          without branches so that loops over this vectorize.
+     */
+    scale_type
+    _M_uniform_index(value_type x) const
+    {
+      const scale_type tail = _M_count.size() - 1;
+      scale_type k = std::floor((scale_type(x) - scale_type(_M_xmin)) * _M_scale)
+		   + scale_type{1};
+      k = k > scale_type{0} ? k : scale_type{0};
+      k = k < tail ? k : tail;
+      return k;
+    }
+
+    /**
+     *  @brief  Correct an arithmetic bin index that rounding, or bin limits
+     *          truncated to an integral type, may have put off
+     *          so that it agrees with the bin limits.
+     */
+    size_type
+    _M_fix_index(value_type x, size_type k) const
+    {
+      while (k > 0 && x < _M_bin[k - 1])
+	--k;
+      while (k < _M_bin.size() && x >= _M_bin[k])
+	++k;
+      return k;
+    }
+
+    /**
+     *  @brief  Accumulate the counts of a range of values into count.
+     *          For uniform bins the indices are computed a block at a time
+     *          in a loop the compiler can vectorize.
+     */
+    template<typename Iter>
+      void
+      _M_accumulate(Iter begin, Iter end, std::vector<size_type>& count) const
+      {
+	if (!_M_uniform)
+	{
+	  for (; begin != end; ++begin)
+	    ++count[_M_index(*begin)];
+	  return;
+	}
+
+	value_type x[_S_block];
+	scale_type k[_S_block];
+	while (begin != end)
+	{
+	  size_type n = 0;
+	  for (; n < _S_block && begin != end; ++n, ++begin)
+	    x[n] = *begin;
+	  for (size_type i = 0; i < n; ++i)
+	    k[i] = _M_uniform_index(x[i]);
+	  for (size_type i = 0; i < n; ++i)
+	    ++count[_M_fix_index(x[i], static_cast<size_type>(k[i]))];
+	}
+      }
+
     ///  The array of bin starting values.
     ///  The first element [0] is the upper bound of the left tail
     ///  and the lower bound of the first bin.
@@ -345,6 +484,15 @@ template<typename Tp>
     ///  The last element [size() - 1] is the count of the right tail.
     ///  This array is one larger than the bin starting value array.
     std::vector<size_type> _M_count;
+
+    ///  True if the bins are of equal width.
+    bool _M_uniform = false;
+
+    ///  The lower bound of the first bin for uniform bins.
+    value_type _M_xmin = value_type{};
+
+    ///  The reciprocal of the bin width for uniform bins.
+    scale_type _M_scale = scale_type{};
   };
 
 
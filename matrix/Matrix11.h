@@ -17,6 +17,13 @@
 
 #include<string>
 #include<algorithm>
+#include<cstdint>
+#include<cstring>
+#include<limits>
+#include<new>
+#include<type_traits>
+#include<utility>
+#include<functional>
 
 
 namespace Numeric_lib
@@ -70,6 +77,9 @@ template<typename T = double, int D = 1>
 
 template<typename T = double, int D = 1> class Row;
 
+//  an elementwise expression of rank D over elements of type T (see below)
+template<typename T, int D, typename E> class Matrix_expr;
+
 // function objects for various apply() operations:
 
 template<typename T>
@@ -178,6 +188,55 @@ template<typename T>
 
 //-----------------------------------------------------------------------------
 
+//  Tag requesting that the elements of a new Matrix be left uninitialized
+//  (default initialized) because they are about to be overwritten:
+//    Matrix<double, 2> m(n1, n2, uninitialized);
+struct Uninitialized
+{ };
+
+constexpr Uninitialized uninitialized{};
+
+//  Memory for Matrix elements.
+//  The elements are aligned to Matrix_allocator<T>::alignment bytes
+//  (a cache line by default) so that loops over them can use aligned
+//  vector loads.  Specialize this for a type to change the alignment
+//  or the source of memory.
+template<typename T>
+  struct Matrix_allocator
+  {
+    static constexpr std::size_t alignment = alignof(T) > 64 ? alignof(T) : 64;
+
+    //  raw storage for n elements
+    static T *
+    allocate(Index n)
+    {
+      //  Over-allocate and stash the pointer from operator new
+      //  just below the aligned block.
+      if (std::size_t(n) > (std::numeric_limits<std::size_t>::max()
+                            - alignment - sizeof(void *)) / sizeof(T))
+        throw std::bad_array_new_length();
+      std::size_t bytes = n * sizeof(T) + alignment + sizeof(void *);
+      char * raw = static_cast<char *>(::operator new(bytes));
+      std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(raw + sizeof(void *));
+      addr = (addr + alignment - 1) & ~std::uintptr_t(alignment - 1);
+      void ** p = reinterpret_cast<void **>(addr);
+      p[-1] = raw;
+      return reinterpret_cast<T *>(p);
+    }
+
+    static void
+    deallocate(T * p, Index)
+    {
+      if (p)
+        ::operator delete(reinterpret_cast<void **>(p)[-1]);
+    }
+  };
+
+template<typename T>
+  constexpr std::size_t Matrix_allocator<T>::alignment;
+
+//-----------------------------------------------------------------------------
+
 //  Matrix_base represents the common part of the Matrix classes:
 template<typename T>
   class Matrix_base
@@ -191,14 +250,86 @@ template<typename T>
     mutable bool owns;
     mutable bool xfer;
 
+    //  allocate and construct n elements: value initialized (zero for
+    //  arithmetic types) if init is true, default initialized otherwise
+    static T *
+    new_elements(Index n, bool init)
+    {
+      T * p = Matrix_allocator<T>::allocate(n);
+      Index i = 0;
+      try
+        {
+          if (init)
+            for (; i < n; ++i)
+              new (p + i) T();
+          else
+            for (; i < n; ++i)
+              new (p + i) T;
+        }
+      catch (...)
+        {
+          delete_elements(p, i);
+          throw;
+        }
+      return p;
+    }
+
+    //  trivially copyable elements are copied as bytes
+    //  (memmove: the views of a matrix may overlap)
+    static void
+    copy_n(const T * from, Index n, T * to, std::true_type)
+    { std::memmove(to, from, n * sizeof(T)); }
+
+    static void
+    copy_n(const T * from, Index n, T * to, std::false_type)
+    {
+      for (Index i = 0; i < n; ++i)
+        to[i] = from[i];
+    }
+
+    static void
+    delete_elements(T * p, Index n)
+    {
+      if (!std::is_trivially_destructible<T>::value)
+        for (Index i = 0; i < n; ++i)
+          p[i].~T();
+      Matrix_allocator<T>::deallocate(p, n);
+    }
+
+    //  move: take the elements of an owning temporary;
+    //  a non-owning a (a Row or slice) still has its elements copied.
+    //  The moved-from matrix keeps its shape but has no elements
+    //  until it is assigned to.
+    Matrix_base(Matrix_base && a)
+    : elem(a.elem), sz(a.sz), owns(a.owns), xfer(false)
+    {
+      if (a.owns)
+        {
+          a.elem = nullptr;
+          a.owns = false;
+          a.xfer = false;
+        }
+      else
+        {
+          elem = new_elements(sz, false);
+          owns = true;
+          copy_elements(a);
+        }
+    }
+
   public:
     Matrix_base(Index n)
-    : elem(new T[n]()), sz(n), owns(true), xfer(false)
+    : elem(new_elements(n, true)), sz(n), owns(true), xfer(false)
         // matrix of n elements (default initialized)
     {
         // std::cerr << "new[" << n << "]->" << elem << "\n";
     }
 
+    //  matrix of n elements left uninitialized
+    Matrix_base(Index n, Uninitialized)
+    : elem(new_elements(n, false)), sz(n), owns(true), xfer(false)
+    { }
+
     //  descriptor for matrix of n elements owned by someone else
     Matrix_base(Index n, T* p)
     : elem(p), sz(n), owns(false), xfer(false)
@@ -207,7 +338,7 @@ template<typename T>
     ~Matrix_base()
     {
       if (owns) {
-        delete [] elem;
+        delete_elements(elem, sz);
       }
     }
 
@@ -223,20 +354,47 @@ template<typename T>
     size() const
     { return sz; }
 
+    //  give a moved-from matrix (value initialized) elements again
+    void
+    restore_elements()
+    {
+      if (elem == nullptr)
+        {
+          elem = new_elements(sz, true);
+          owns = true;
+          xfer = false;
+        }
+    }
+
     void
     copy_elements(const Matrix_base & a)
     {
       if (sz != a.sz)
         error("copy_elements()");
+      if (a.elem == nullptr)
+        error("copy from a moved-from matrix");
 
-     for (Index i = 0; i < sz; ++i)
-        elem[i] = a.elem[i];
+      restore_elements();
+      if (elem != a.elem)
+        copy_n(a.elem, sz, elem, std::is_trivially_copyable<T>());
     }
 
     void
     base_assign(const Matrix_base & a)
     { copy_elements(a); }
 
+    //  move assignment: swap elements with an owning a,
+    //  otherwise (either is a Row or slice) copy them
+    void
+    base_move(Matrix_base & a)
+    {
+      restore_elements();
+      if (owns && a.owns && !a.xfer && sz == a.sz)
+        std::swap(elem, a.elem);
+      else
+        copy_elements(a);
+    }
+
     void
     base_copy(const Matrix_base & a)
     {
@@ -249,7 +407,7 @@ template<typename T>
         }
       else
         {
-          elem = new T[a.sz];
+          elem = new_elements(a.sz, false);
           copy_elements(a);
         }
       owns = true;
@@ -267,10 +425,35 @@ template<typename T>
       x.owns = true;
     }
 
+    //  f(elem[i], e[i]) for an elementwise expression e in one loop;
+    //  if e reads elements of this matrix at other positions
+    //  (through an overlapping slice) it is evaluated into a temporary first
+    template<typename F, typename E>
+      void
+      base_eval(F f, const E & e)
+      {
+        restore_elements();
+        T * p = elem;
+        const Index n = sz;
+        if (e.overlaps(p, n))
+          {
+            T * tmp = new_elements(n, false);
+            for (Index i = 0; i < n; ++i)
+              tmp[i] = e[i];
+            for (Index i = 0; i < n; ++i)
+              f(p[i], tmp[i]);
+            delete_elements(tmp, n);
+          }
+        else
+          for (Index i = 0; i < n; ++i)
+            f(p[i], e[i]);
+      }
+
     template<typename F>
       void
       base_apply(F f)
       {
+        restore_elements();
         for (Index i = 0; i < size(); ++i)
           f(elem[i]);
   }
@@ -279,6 +462,7 @@ template<typename T>
       void
       base_apply(F f, const T & c)
       {
+        restore_elements();
         for (Index i = 0; i < size(); ++i)
           f(elem[i], c);
       }
@@ -308,6 +492,10 @@ private:
     Matrix(Index n1)
     : Matrix_base<T>(n1), d1(n1) { }
 
+    //  elements left uninitialized
+    Matrix(Index n1, Uninitialized u)
+    : Matrix_base<T>(n1, u), d1(n1) { }
+
     Matrix(Row<T, 1> & a)
     : Matrix_base<T>(a.dim1(), a.p), d1(a.dim1()) 
     { 
@@ -322,9 +510,22 @@ private:
         this->base_copy(a);
     }
 
+    // move constructor: take the elements of a temporary
+    Matrix(Matrix && a)
+    : Matrix_base<T>(std::move(a)), d1(a.d1)
+    { }
+
+    //  evaluate an elementwise expression such as a * 2 + b - c
+    //  in one loop into the new elements
+    template<typename E>
+      Matrix(const Matrix_expr<T, 1, E> & e)
+      : Matrix_base<T>(e.size(), uninitialized),
+        d1(e.dim(0))
+      { this->base_eval(Assign<T>(), e); }
+
     template<int n> 
     Matrix(const T (&a)[n])
-    : Matrix_base<T>(n), d1(n)
+    : Matrix_base<T>(n, uninitialized), d1(n)
         // deduce "n" (and "T"), Matrix_base allocates T[n]
     {
         // std::cerr << "matrix ctor\n";
@@ -333,7 +534,7 @@ private:
 
     //  Matrix_base allocates T[n]
     Matrix(const T * p, Index n)
-    : Matrix_base<T>(n), d1(n)
+    : Matrix_base<T>(n, uninitialized), d1(n)
     {
       for (Index i = 0; i < n; ++i)
         this->elem[i] = p[i];
@@ -344,7 +545,7 @@ private:
     //  T f(const T&) would be a typical type for f
     template<typename F>
     Matrix(const Matrix & a, F f)
-    : Matrix_base<T>(a.size()), d1(a.d1)
+    : Matrix_base<T>(a.size(), uninitialized), d1(a.d1)
       {
         for (Index i = 0; i < this->sz; ++i)
           this->elem[i] = f(a.elem[i]); 
@@ -355,7 +556,7 @@ private:
     // T f(const T&, const Arg&) would be a typical type for f
     template<typename F, typename Arg>
       Matrix(const Matrix & a, F f, const Arg & t1)
-      : Matrix_base<T>(a.size()), d1(a.d1)
+      : Matrix_base<T>(a.size(), uninitialized), d1(a.d1)
       {
         for (Index i = 0; i < this->sz; ++i)
           this->elem[i] = f(a.elem[i], t1); 
@@ -371,6 +572,55 @@ private:
       return *this;
     }
 
+    // move assignment: let the base swap or copy
+    Matrix &
+    operator=(Matrix && a)
+    {
+      if (d1 != a.d1)
+        error("length error in 1D=");
+      this->base_move(a);
+      return *this;
+    }
+
+    //  elementwise expressions and matrices of the same shape:
+    template<typename E>
+      Matrix &
+      operator=(const Matrix_expr<T, 1, E> & e)
+      {
+        if (d1 != e.dim(0))
+          error("length error in 1D=");
+        this->base_eval(Assign<T>(), e);
+        return *this;
+      }
+
+    template<typename E>
+      Matrix &
+      operator+=(const Matrix_expr<T, 1, E> & e)
+      {
+        if (d1 != e.dim(0))
+          error("length error in 1D=");
+        this->base_eval(Add_assign<T>(), e);
+        return *this;
+      }
+
+    template<typename E>
+      Matrix &
+      operator-=(const Matrix_expr<T, 1, E> & e)
+      {
+        if (d1 != e.dim(0))
+          error("length error in 1D=");
+        this->base_eval(Minus_assign<T>(), e);
+        return *this;
+      }
+
+    Matrix &
+    operator+=(const Matrix & a)
+    { return *this += as_expr(a); }
+
+    Matrix &
+    operator-=(const Matrix & a)
+    { return *this -= as_expr(a); }
+
     ~Matrix() { }
 
     Index
@@ -557,20 +807,20 @@ private:
 
     Matrix
     operator!()
-    { return xfer(Matrix(*this, Not<T>())); }
+    { return Matrix(*this, Not<T>()); }
 
     Matrix
     operator-()
-    { return xfer(Matrix(*this, Unary_minus<T>())); }
+    { return Matrix(*this, Unary_minus<T>()); }
 
     Matrix
     operator~()
-    { return xfer(Matrix(*this, Complement<T>()));  }
+    { return Matrix(*this, Complement<T>());  }
 
     template<typename F>
       Matrix
       apply_new(F f)
-      { return xfer(Matrix(*this, f)); }
+      { return Matrix(*this, f); }
 
     //  swap_rows() uses a row's worth of memory for better run-time performance
     //  if you want pairwise swap, just write it yourself
@@ -614,6 +864,12 @@ template<typename T>
       d1(n1), d2(n2)
     { }
 
+    //  elements left uninitialized
+    Matrix(Index n1, Index n2, Uninitialized u)
+    : Matrix_base<T>(n1 * n2, u),
+      d1(n1), d2(n2)
+    { }
+
     Matrix(Row<T, 2> & a)
     : Matrix_base<T>(a.dim1() * a.dim2(), a.p),
       d1(a.dim1()), d2(a.dim2())
@@ -625,10 +881,24 @@ template<typename T>
       d1(a.d1), d2(a.d2)
     { this->base_copy(a); }
 
+    //  move constructor: take the elements of a temporary
+    Matrix(Matrix && a)
+    : Matrix_base<T>(std::move(a)),
+      d1(a.d1), d2(a.d2)
+    { }
+
+    //  evaluate an elementwise expression such as a * 2 + b - c
+    //  in one loop into the new elements
+    template<typename E>
+      Matrix(const Matrix_expr<T, 2, E> & e)
+      : Matrix_base<T>(e.size(), uninitialized),
+        d1(e.dim(0)), d2(e.dim(1))
+      { this->base_eval(Assign<T>(), e); }
+
     //  deduce "n1", "n2" (and "T"), Matrix_base allocates T[n1*n2]
     template<int n1, int n2> 
       Matrix(const T (&a)[n1][n2])
-      : Matrix_base<T>(n1 * n2),
+      : Matrix_base<T>(n1 * n2, uninitialized),
         d1(n1), d2(n2)
       {
         for (Index i = 0; i < n1; ++i)
@@ -641,7 +911,7 @@ template<typename T>
     //  T f(const T&) would be a typical type for f
     template<typename F>
       Matrix(const Matrix& a, F f)
-      : Matrix_base<T>(a.size()),
+      : Matrix_base<T>(a.size(), uninitialized),
         d1(a.d1), d2(a.d2)
       {
         for (Index i = 0; i < this->sz; ++i)
@@ -653,7 +923,7 @@ template<typename T>
     //  T f(const T&, const Arg&) would be a typical type for f
     template<typename F, typename Arg>
       Matrix(const Matrix & a, F f, const Arg & t1)
-      : Matrix_base<T>(a.size()),
+      : Matrix_base<T>(a.size(), uninitialized),
         d1(a.d1), d2(a.d2)
       {
         for (Index i = 0; i < this->sz; ++i)
@@ -670,6 +940,55 @@ template<typename T>
       return *this;
     }
 
+    //  move assignment: let the base swap or copy
+    Matrix &
+    operator=(Matrix && a)
+    {
+      if (d1 != a.d1 || d2 != a.d2)
+        error("length error in 2D =");
+      this->base_move(a);
+      return *this;
+    }
+
+    //  elementwise expressions and matrices of the same shape:
+    template<typename E>
+      Matrix &
+      operator=(const Matrix_expr<T, 2, E> & e)
+      {
+        if (d1 != e.dim(0) || d2 != e.dim(1))
+          error("length error in 2D =");
+        this->base_eval(Assign<T>(), e);
+        return *this;
+      }
+
+    template<typename E>
+      Matrix &
+      operator+=(const Matrix_expr<T, 2, E> & e)
+      {
+        if (d1 != e.dim(0) || d2 != e.dim(1))
+          error("length error in 2D =");
+        this->base_eval(Add_assign<T>(), e);
+        return *this;
+      }
+
+    template<typename E>
+      Matrix &
+      operator-=(const Matrix_expr<T, 2, E> & e)
+      {
+        if (d1 != e.dim(0) || d2 != e.dim(1))
+          error("length error in 2D =");
+        this->base_eval(Minus_assign<T>(), e);
+        return *this;
+      }
+
+    Matrix &
+    operator+=(const Matrix & a)
+    { return *this += as_expr(a); }
+
+    Matrix &
+    operator-=(const Matrix & a)
+    { return *this -= as_expr(a); }
+
     ~Matrix()
     { }
 
@@ -847,19 +1166,19 @@ template<typename T>
 
     Matrix
     operator!()
-    { return xfer(Matrix(*this, Not<T>())); }
+    { return Matrix(*this, Not<T>()); }
 
     Matrix
     operator-()
-    { return xfer(Matrix(*this, Unary_minus<T>())); }
+    { return Matrix(*this, Unary_minus<T>()); }
 
     Matrix
     operator~()
-    { return xfer(Matrix(*this, Complement<T>()));  }
+    { return Matrix(*this, Complement<T>());  }
 
     template<typename F>
       Matrix apply_new(F f)
-      { return xfer(Matrix(*this, f)); }
+      { return Matrix(*this, f); }
     
     //  swap_rows() uses a row's worth of memory for better run-time performance
     //  if you want pairwise swap, just write it yourself
@@ -903,6 +1222,12 @@ template<typename T>
       d1(n1), d2(n2), d3(n3)
     { }
 
+    //  elements left uninitialized
+    Matrix(Index n1, Index n2, Index n3, Uninitialized u)
+    : Matrix_base<T>(n1 * n2 * n3, u),
+      d1(n1), d2(n2), d3(n3)
+    { }
+
     Matrix(Row<T, 3> & a)
     : Matrix_base<T>(a.dim1() * a.dim2() * a.dim3(), a.p),
       d1(a.dim1()), d2(a.dim2()), d3(a.dim3())
@@ -914,10 +1239,24 @@ template<typename T>
       d1(a.d1), d2(a.d2), d3(a.d3)
     { this->base_copy(a); }
 
+    //  move constructor: take the elements of a temporary
+    Matrix(Matrix && a)
+    : Matrix_base<T>(std::move(a)),
+      d1(a.d1), d2(a.d2), d3(a.d3)
+    { }
+
+    //  evaluate an elementwise expression such as a * 2 + b - c
+    //  in one loop into the new elements
+    template<typename E>
+      Matrix(const Matrix_expr<T, 3, E> & e)
+      : Matrix_base<T>(e.size(), uninitialized),
+        d1(e.dim(0)), d2(e.dim(1)), d3(e.dim(2))
+      { this->base_eval(Assign<T>(), e); }
+
     //  deduce "n1", "n2", "n3" (and "T"), Matrix_base allocates T[n1*n2*n3]
     template<int n1, int n2, int n3> 
       Matrix(const T (&a)[n1][n2][n3])
-      : Matrix_base<T>(n1 * n2),
+      : Matrix_base<T>(n1 * n2 * n3, uninitialized),
         d1(n1), d2(n2), d3(n3)
       {
         for (Index i = 0; i < n1; ++i)
@@ -931,7 +1270,7 @@ template<typename T>
       //  T f(const T&) would be a typical type for f
     template<typename F>
       Matrix(const Matrix & a, F f)
-      : Matrix_base<T>(a.size()), d1(a.d1), d2(a.d2), d3(a.d3)
+      : Matrix_base<T>(a.size(), uninitialized), d1(a.d1), d2(a.d2), d3(a.d3)
       {
         for (Index i = 0; i < this->sz; ++i)
           this->elem[i] = f(a.elem[i]); 
@@ -942,7 +1281,7 @@ template<typename T>
     //  T f(const T&, const Arg&) would be a typical type for f
     template<typename F, typename Arg>
       Matrix(const Matrix & a, F f, const Arg & t1)
-      : Matrix_base<T>(a.size()), d1(a.d1), d2(a.d2), d3(a.d3)
+      : Matrix_base<T>(a.size(), uninitialized), d1(a.d1), d2(a.d2), d3(a.d3)
       {
         for (Index i = 0; i < this->sz; ++i)
           this->elem[i] = f(a.elem[i], t1); 
@@ -953,11 +1292,60 @@ template<typename T>
     operator=(const Matrix & a)
     {
       if (d1 != a.d1 || d2 != a.d2 || d3 != a.d3)
-        error("length error in 2D =");
+        error("length error in 3D =");
       this->base_assign(a);
       return *this;
     }
 
+    //  move assignment: let the base swap or copy
+    Matrix &
+    operator=(Matrix && a)
+    {
+      if (d1 != a.d1 || d2 != a.d2 || d3 != a.d3)
+        error("length error in 3D =");
+      this->base_move(a);
+      return *this;
+    }
+
+    //  elementwise expressions and matrices of the same shape:
+    template<typename E>
+      Matrix &
+      operator=(const Matrix_expr<T, 3, E> & e)
+      {
+        if (d1 != e.dim(0) || d2 != e.dim(1) || d3 != e.dim(2))
+          error("length error in 3D =");
+        this->base_eval(Assign<T>(), e);
+        return *this;
+      }
+
+    template<typename E>
+      Matrix &
+      operator+=(const Matrix_expr<T, 3, E> & e)
+      {
+        if (d1 != e.dim(0) || d2 != e.dim(1) || d3 != e.dim(2))
+          error("length error in 3D =");
+        this->base_eval(Add_assign<T>(), e);
+        return *this;
+      }
+
+    template<typename E>
+      Matrix &
+      operator-=(const Matrix_expr<T, 3, E> & e)
+      {
+        if (d1 != e.dim(0) || d2 != e.dim(1) || d3 != e.dim(2))
+          error("length error in 3D =");
+        this->base_eval(Minus_assign<T>(), e);
+        return *this;
+      }
+
+    Matrix &
+    operator+=(const Matrix & a)
+    { return *this += as_expr(a); }
+
+    Matrix &
+    operator-=(const Matrix & a)
+    { return *this -= as_expr(a); }
+
     ~Matrix()
     { }
 
@@ -1155,20 +1543,20 @@ template<typename T>
 
     Matrix
     operator!()
-    { return xfer(Matrix(*this, Not<T>())); }
+    { return Matrix(*this, Not<T>()); }
 
     Matrix
     operator-()
-    { return xfer(Matrix(*this, Unary_minus<T>())); }
+    { return Matrix(*this, Unary_minus<T>()); }
 
     Matrix
     operator~()
-    { return xfer(Matrix(*this, Complement<T>()));  }
+    { return Matrix(*this, Complement<T>());  }
 
     template<typename F>
       Matrix
       apply_new(F f)
-      { return xfer(Matrix(*this, f)); }
+      { return Matrix(*this, f); }
     
     // swap_rows() uses a row's worth of memory for better run-time performance
     // if you want pairwise swap, just write it yourself
@@ -1271,6 +1659,11 @@ template<typename T>
     Matrix<T, 1>&
     operator=(const Matrix<T, 1> & a)
     { return *static_cast<Matrix<T, 1>*>(this) = a; }
+
+    template<typename E>
+      Matrix<T, 1> &
+      operator=(const Matrix_expr<T, 1, E> & e)
+      { return *static_cast<Matrix<T, 1>*>(this) = e; }
   };
 
 //-----------------------------------------------------------------------------
@@ -1291,6 +1684,11 @@ template<typename T>
     Matrix<T, 2> &
     operator=(const Matrix<T, 2> & a)
     { return *static_cast<Matrix<T, 2>*>(this) = a; }
+
+    template<typename E>
+      Matrix<T, 2> &
+      operator=(const Matrix_expr<T, 2, E> & e)
+      { return *static_cast<Matrix<T, 2>*>(this) = e; }
   };
 
 //-----------------------------------------------------------------------------
@@ -1314,6 +1712,11 @@ template<typename T>
     Matrix<T, 3> &
     operator=(const Matrix<T,3> & a)
     { return *static_cast<Matrix<T,3>*>(this) = a; }
+
+    template<typename E>
+      Matrix<T, 3> &
+      operator=(const Matrix_expr<T, 3, E> & e)
+      { return *static_cast<Matrix<T, 3>*>(this) = e; }
   };
 
 //-----------------------------------------------------------------------------
@@ -1332,44 +1735,523 @@ template<typename T, int N>
 
 //-----------------------------------------------------------------------------
 
+//  Elementwise arithmetic.
+//
+//  a * 2 + b - c does not compute a * 2 and a * 2 + b as temporaries:
+//  + and - between matrices and +, -, * and / with a scalar build a small
+//  expression object describing the computation, and the Matrix
+//  constructor or assignment that receives it evaluates every element in
+//  one fused loop.  An expression refers to the elements of its named
+//  Matrix and Row operands and holds scalars by value; a temporary Matrix
+//  operand is not referred to but has the rest of the operation computed
+//  in its own elements.  An expression kept in an auto variable sees later
+//  changes to the matrices it refers to.
+
+template<typename T>
+  struct Expr_ref
+  {
+    const T * p;
+    Index n;
+
+    T
+    operator[](Index i) const
+    { return p[i]; }
+
+    //  reading p[i] while writing q[i] is safe; any other overlap is not
+    bool
+    overlaps(const T * q, Index m) const
+    {
+      std::less<const T *> lt;
+      return p != q && lt(p, q + m) && lt(q, p + n);
+    }
+  };
+
+//  a scalar operand, held by value
+template<typename T>
+  struct Expr_scalar
+  {
+    T c;
+
+    T
+    operator[](Index) const
+    { return c; }
+
+    bool
+    overlaps(const T *, Index) const
+    { return false; }
+  };
+
+struct Expr_plus
+{
+  template<typename T>
+    static T
+    apply(const T & a, const T & b)
+    { return a + b; }
+};
+
+struct Expr_minus
+{
+  template<typename T>
+    static T
+    apply(const T & a, const T & b)
+    { return a - b; }
+};
+
+struct Expr_multiplies
+{
+  template<typename T>
+    static T
+    apply(const T & a, const T & b)
+    { return a * b; }
+};
+
+struct Expr_divides
+{
+  template<typename T>
+    static T
+    apply(const T & a, const T & b)
+    { return a / b; }
+};
+
+template<typename T, typename Op, typename L, typename R>
+  struct Expr_binary
+  {
+    L l;
+    R r;
+
+    T
+    operator[](Index i) const
+    { return Op::apply(l[i], r[i]); }
+
+    bool
+    overlaps(const T * q, Index m) const
+    { return l.overlaps(q, m) || r.overlaps(q, m); }
+  };
+
+template<typename T, typename E>
+  struct Expr_negate
+  {
+    E e;
+
+    T
+    operator[](Index i) const
+    { return -e[i]; }
+
+    bool
+    overlaps(const T * q, Index m) const
+    { return e.overlaps(q, m); }
+  };
+
+//  An elementwise expression of rank D with the shape of its operands.
+template<typename T, int D, typename E>
+  class Matrix_expr
+  {
+  public:
+    Matrix_expr(const E & e, const Index * d)
+    : ex(e)
+    { std::copy(d, d + D, dims); }
+
+    T
+    operator[](Index i) const
+    { return ex[i]; }
+
+    Index
+    dim(int k) const
+    { return dims[k]; }
+
+    const Index *
+    dim() const
+    { return dims; }
+
+    Index
+    size() const
+    {
+      Index n = 1;
+      for (int k = 0; k < D; ++k)
+        n *= dims[k];
+      return n;
+    }
+
+    const E &
+    expr() const
+    { return ex; }
+
+    bool
+    overlaps(const T * q, Index m) const
+    { return ex.overlaps(q, m); }
+
+  private:
+    E ex;
+    Index dims[D];
+  };
+
+//  Expr_traits maps the operands of elementwise operators
+//  (Matrix, Row and Matrix_expr) to their expression nodes.
+//  It is empty for anything else so those operators don't apply.
+template<typename X>
+  struct Expr_traits
+  { };
+
+template<typename T>
+  struct Expr_traits<Matrix<T, 1>>
+  {
+    typedef T value_type;
+    static const int rank = 1;
+    typedef Expr_ref<T> expr_type;
+
+    static Matrix_expr<T, 1, expr_type>
+    expr(const Matrix<T, 1> & m)
+    {
+      Index d[1] = { m.dim1() };
+      return Matrix_expr<T, 1, expr_type>(expr_type{m.data(), m.size()}, d);
+    }
+  };
+
+template<typename T>
+  struct Expr_traits<Matrix<T, 2>>
+  {
+    typedef T value_type;
+    static const int rank = 2;
+    typedef Expr_ref<T> expr_type;
+
+    static Matrix_expr<T, 2, expr_type>
+    expr(const Matrix<T, 2> & m)
+    {
+      Index d[2] = { m.dim1(), m.dim2() };
+      return Matrix_expr<T, 2, expr_type>(expr_type{m.data(), m.size()}, d);
+    }
+  };
+
+template<typename T>
+  struct Expr_traits<Matrix<T, 3>>
+  {
+    typedef T value_type;
+    static const int rank = 3;
+    typedef Expr_ref<T> expr_type;
+
+    static Matrix_expr<T, 3, expr_type>
+    expr(const Matrix<T, 3> & m)
+    {
+      Index d[3] = { m.dim1(), m.dim2(), m.dim3() };
+      return Matrix_expr<T, 3, expr_type>(expr_type{m.data(), m.size()}, d);
+    }
+  };
+
+template<typename T, int D>
+  struct Expr_traits<Row<T, D>>
+  : Expr_traits<Matrix<T, D>>
+  { };
+
+template<typename T, int D, typename E>
+  struct Expr_traits<Matrix_expr<T, D, E>>
+  {
+    typedef T value_type;
+    static const int rank = D;
+    typedef E expr_type;
+
+    static const Matrix_expr<T, D, E> &
+    expr(const Matrix_expr<T, D, E> & e)
+    { return e; }
+  };
+
+//  view a Matrix (or Row) as an expression
+template<typename T, int D>
+  Matrix_expr<T, D, Expr_ref<T>>
+  as_expr(const Matrix<T, D> & m)
+  { return Expr_traits<Matrix<T, D>>::expr(m); }
+
+//  the type of op(l, r) for two operands of the same rank and element type
+template<typename Op, typename L, typename R>
+  using Expr_binary_t
+    = typename std::enable_if<Expr_traits<L>::rank == Expr_traits<R>::rank
+         && std::is_same<typename Expr_traits<L>::value_type,
+                         typename Expr_traits<R>::value_type>::value,
+         Matrix_expr<typename Expr_traits<L>::value_type,
+                     Expr_traits<L>::rank,
+                     Expr_binary<typename Expr_traits<L>::value_type, Op,
+                                 typename Expr_traits<L>::expr_type,
+                                 typename Expr_traits<R>::expr_type>>>::type;
+
+template<typename Op, typename L, typename R>
+  Expr_binary_t<Op, L, R>
+  make_binary_expr(const L & l, const R & r)
+  {
+    typedef Expr_traits<L> TL;
+    typedef Expr_traits<R> TR;
+    typedef typename TL::value_type T;
+    const auto & el = TL::expr(l);
+    const auto & er = TR::expr(r);
+    for (int k = 0; k < TL::rank; ++k)
+      if (el.dim(k) != er.dim(k))
+        error("sizes wrong for elementwise operation");
+    typedef Expr_binary<T, Op, typename TL::expr_type, typename TR::expr_type> B;
+    return Expr_binary_t<Op, L, R>(B{el.expr(), er.expr()}, el.dim());
+  }
+
+template<typename L, typename R>
+  Expr_binary_t<Expr_plus, L, R>
+  operator+(const L & l, const R & r)
+  { return make_binary_expr<Expr_plus>(l, r); }
+
+template<typename L, typename R>
+  Expr_binary_t<Expr_minus, L, R>
+  operator-(const L & l, const R & r)
+  { return make_binary_expr<Expr_minus>(l, r); }
+
+//  Matrix<T, D> if X is an operand of rank D with elements of type T
+template<typename T, int D, typename X>
+  using Expr_result_t
+    = typename std::enable_if<Expr_traits<X>::rank == D
+         && std::is_same<typename Expr_traits<X>::value_type, T>::value,
+         Matrix<T, D>>::type;
+
+//  A temporary Matrix operand would be gone before an expression referring
+//  to it is evaluated: the result is computed in its elements instead.
+
+template<typename T, int D, typename R>
+  Expr_result_t<T, D, R>
+  operator+(Matrix<T, D> && l, const R & r)
+  {
+    Matrix<T, D> m(std::move(l));
+    m += Expr_traits<R>::expr(r);
+    return m;
+  }
+
+template<typename L, typename T, int D>
+  Expr_result_t<T, D, L>
+  operator+(const L & l, Matrix<T, D> && r)
+  {
+    Matrix<T, D> m(std::move(r));
+    m += Expr_traits<L>::expr(l);
+    return m;
+  }
+
 template<typename T, int D>
   Matrix<T, D>
-  operator*(const Matrix<T, D> & m, const T & c)
+  operator+(Matrix<T, D> && l, Matrix<T, D> && r)
+  { return std::move(l) + as_expr(r); }
+
+template<typename T, int D, typename R>
+  Expr_result_t<T, D, R>
+  operator-(Matrix<T, D> && l, const R & r)
   {
-    Matrix<T, D> r(m);
-    return r *= c;
+    Matrix<T, D> m(std::move(l));
+    m -= Expr_traits<R>::expr(r);
+    return m;
+  }
+
+template<typename L, typename T, int D>
+  Expr_result_t<T, D, L>
+  operator-(const L & l, Matrix<T, D> && r)
+  {
+    Matrix<T, D> m(std::move(r));
+    m = make_binary_expr<Expr_minus>(l, m);
+    return m;
   }
 
 template<typename T, int D>
   Matrix<T, D>
-  operator/(const Matrix<T, D> & m, const T & c)
+  operator-(Matrix<T, D> && l, Matrix<T, D> && r)
+  { return std::move(l) - as_expr(r); }
+
+//  unary minus of an expression (Matrix has its own member operator-())
+template<typename T, int D, typename E>
+  Matrix_expr<T, D, Expr_negate<T, E>>
+  operator-(const Matrix_expr<T, D, E> & e)
+  { return Matrix_expr<T, D, Expr_negate<T, E>>(Expr_negate<T, E>{e.expr()}, e.dim()); }
+
+//-----------------------------------------------------------------------------
+
+//  Arithmetic with a scalar builds an expression holding the scalar by
+//  value, so a * 2 + b - c runs as one loop.  The result of an operation
+//  on a temporary Matrix is computed in its elements instead, as for + and -
+//  (a temporary Row or slice is copied: its elements belong to another
+//  Matrix).
+
+//  the scalar operand of +, -, * and /: not deduced, so a * 2 works
+//  for a Matrix<double>
+template<typename T>
+  using Scalar = typename Expr_traits<Matrix<T, 1>>::value_type;
+
+//  the types of op(e, c) and op(c, e) for an expression e and a scalar c
+template<typename T, int D, typename Op, typename E>
+  using Expr_scalar_right_t
+    = Matrix_expr<T, D, Expr_binary<T, Op, E, Expr_scalar<T>>>;
+
+template<typename T, int D, typename Op, typename E>
+  using Expr_scalar_left_t
+    = Matrix_expr<T, D, Expr_binary<T, Op, Expr_scalar<T>, E>>;
+
+template<typename Op, typename T, int D, typename E>
+  Expr_scalar_right_t<T, D, Op, E>
+  make_scalar_right_expr(const Matrix_expr<T, D, E> & e, const T & c)
+  {
+    typedef Expr_binary<T, Op, E, Expr_scalar<T>> B;
+    return Expr_scalar_right_t<T, D, Op, E>(B{e.expr(), Expr_scalar<T>{c}},
+                                            e.dim());
+  }
+
+template<typename Op, typename T, int D, typename E>
+  Expr_scalar_left_t<T, D, Op, E>
+  make_scalar_left_expr(const T & c, const Matrix_expr<T, D, E> & e)
   {
-    Matrix<T,D> r(m);
-    return r /= c;
+    typedef Expr_binary<T, Op, Expr_scalar<T>, E> B;
+    return Expr_scalar_left_t<T, D, Op, E>(B{Expr_scalar<T>{c}, e.expr()},
+                                           e.dim());
   }
 
 template<typename T, int D>
-  Matrix<T,D>
-  operator%(const Matrix<T, D> & m, const T & c)
+  Expr_scalar_right_t<T, D, Expr_plus, Expr_ref<T>>
+  operator+(const Matrix<T, D> & m, const Scalar<T> & c)
+  { return make_scalar_right_expr<Expr_plus>(as_expr(m), c); }
+
+template<typename T, int D>
+  Matrix<T, D>
+  operator+(Matrix<T, D> && m, const Scalar<T> & c)
   {
-    Matrix<T,D> r(m);
-    return r %= c;
+    Matrix<T, D> r(std::move(m));
+    r += c;
+    return r;
   }
 
+template<typename T, int D, typename E>
+  Expr_scalar_right_t<T, D, Expr_plus, E>
+  operator+(const Matrix_expr<T, D, E> & e, const Scalar<T> & c)
+  { return make_scalar_right_expr<Expr_plus>(e, c); }
+
+template<typename T, int D>
+  Expr_scalar_right_t<T, D, Expr_minus, Expr_ref<T>>
+  operator-(const Matrix<T, D> & m, const Scalar<T> & c)
+  { return make_scalar_right_expr<Expr_minus>(as_expr(m), c); }
+
 template<typename T, int D>
   Matrix<T, D>
-  operator+(const Matrix<T, D> & m, const T & c)
+  operator-(Matrix<T, D> && m, const Scalar<T> & c)
   {
-    Matrix<T, D> r(m);
-    return r += c;
+    Matrix<T, D> r(std::move(m));
+    r -= c;
+    return r;
+  }
+
+template<typename T, int D, typename E>
+  Expr_scalar_right_t<T, D, Expr_minus, E>
+  operator-(const Matrix_expr<T, D, E> & e, const Scalar<T> & c)
+  { return make_scalar_right_expr<Expr_minus>(e, c); }
+
+template<typename T, int D>
+  Expr_scalar_right_t<T, D, Expr_multiplies, Expr_ref<T>>
+  operator*(const Matrix<T, D> & m, const Scalar<T> & c)
+  { return make_scalar_right_expr<Expr_multiplies>(as_expr(m), c); }
+
+template<typename T, int D>
+  Matrix<T, D>
+  operator*(Matrix<T, D> && m, const Scalar<T> & c)
+  {
+    Matrix<T, D> r(std::move(m));
+    r *= c;
+    return r;
+  }
+
+template<typename T, int D, typename E>
+  Expr_scalar_right_t<T, D, Expr_multiplies, E>
+  operator*(const Matrix_expr<T, D, E> & e, const Scalar<T> & c)
+  { return make_scalar_right_expr<Expr_multiplies>(e, c); }
+
+template<typename T, int D>
+  Expr_scalar_right_t<T, D, Expr_divides, Expr_ref<T>>
+  operator/(const Matrix<T, D> & m, const Scalar<T> & c)
+  { return make_scalar_right_expr<Expr_divides>(as_expr(m), c); }
+
+template<typename T, int D>
+  Matrix<T, D>
+  operator/(Matrix<T, D> && m, const Scalar<T> & c)
+  {
+    Matrix<T, D> r(std::move(m));
+    r /= c;
+    return r;
+  }
+
+template<typename T, int D, typename E>
+  Expr_scalar_right_t<T, D, Expr_divides, E>
+  operator/(const Matrix_expr<T, D, E> & e, const Scalar<T> & c)
+  { return make_scalar_right_expr<Expr_divides>(e, c); }
+
+template<typename T, int D>
+  Expr_scalar_left_t<T, D, Expr_plus, Expr_ref<T>>
+  operator+(const Scalar<T> & c, const Matrix<T, D> & m)
+  { return make_scalar_left_expr<Expr_plus>(c, as_expr(m)); }
+
+template<typename T, int D>
+  Matrix<T, D>
+  operator+(const Scalar<T> & c, Matrix<T, D> && m)
+  {
+    Matrix<T, D> r(std::move(m));
+    r += c;
+    return r;
+  }
+
+template<typename T, int D, typename E>
+  Expr_scalar_left_t<T, D, Expr_plus, E>
+  operator+(const Scalar<T> & c, const Matrix_expr<T, D, E> & e)
+  { return make_scalar_left_expr<Expr_plus>(c, e); }
+
+template<typename T, int D>
+  Expr_scalar_left_t<T, D, Expr_minus, Expr_ref<T>>
+  operator-(const Scalar<T> & c, const Matrix<T, D> & m)
+  { return make_scalar_left_expr<Expr_minus>(c, as_expr(m)); }
+
+template<typename T, int D>
+  Matrix<T, D>
+  operator-(const Scalar<T> & c, Matrix<T, D> && m)
+  {
+    Matrix<T, D> r(std::move(m));
+    r.apply([&c](T & x){ x = c - x; });
+    return r;
+  }
+
+template<typename T, int D, typename E>
+  Expr_scalar_left_t<T, D, Expr_minus, E>
+  operator-(const Scalar<T> & c, const Matrix_expr<T, D, E> & e)
+  { return make_scalar_left_expr<Expr_minus>(c, e); }
+
+template<typename T, int D>
+  Expr_scalar_left_t<T, D, Expr_multiplies, Expr_ref<T>>
+  operator*(const Scalar<T> & c, const Matrix<T, D> & m)
+  { return make_scalar_left_expr<Expr_multiplies>(c, as_expr(m)); }
+
+template<typename T, int D>
+  Matrix<T, D>
+  operator*(const Scalar<T> & c, Matrix<T, D> && m)
+  {
+    Matrix<T, D> r(std::move(m));
+    r.apply([&c](T & x){ x = c * x; });
+    return r;
   }
 
+template<typename T, int D, typename E>
+  Expr_scalar_left_t<T, D, Expr_multiplies, E>
+  operator*(const Scalar<T> & c, const Matrix_expr<T, D, E> & e)
+  { return make_scalar_left_expr<Expr_multiplies>(c, e); }
+
+//  %, &, | and ^ take a scalar of the element type.
+
+
 template<typename T, int D>
   Matrix<T, D>
-  operator-(const Matrix<T, D> & m, const T & c)
+  operator%(const Matrix<T, D> & m, const T & c)
   {
     Matrix<T, D> r(m);
-    return r -= c;
+    r %= c;
+    return r;
+  }
+
+template<typename T, int D>
+  Matrix<T, D>
+  operator%(Matrix<T, D> && m, const T & c)
+  {
+    Matrix<T, D> r(std::move(m));
+    r %= c;
+    return r;
   }
 
 template<typename T, int D>
@@ -1377,7 +2259,17 @@ template<typename T, int D>
   operator&(const Matrix<T, D> & m, const T & c)
   {
     Matrix<T, D> r(m);
-    return r &= c;
+    r &= c;
+    return r;
+  }
+
+template<typename T, int D>
+  Matrix<T, D>
+  operator&(Matrix<T, D> && m, const T & c)
+  {
+    Matrix<T, D> r(std::move(m));
+    r &= c;
+    return r;
   }
 
 template<typename T, int D>
@@ -1385,15 +2277,35 @@ template<typename T, int D>
   operator|(const Matrix<T, D> & m, const T & c)
   {
     Matrix<T, D> r(m);
-    return r |= c;
+    r |= c;
+    return r;
+  }
+
+template<typename T, int D>
+  Matrix<T, D>
+  operator|(Matrix<T, D> && m, const T & c)
+  {
+    Matrix<T, D> r(std::move(m));
+    r |= c;
+    return r;
   }
 
 template<typename T, int D>
   Matrix<T, D>
   operator^(const Matrix<T, D> & m, const T & c)
   {
-    Matrix<T,D> r(m);
-    return r ^= c;
+    Matrix<T, D> r(m);
+    r ^= c;
+    return r;
+  }
+
+template<typename T, int D>
+  Matrix<T, D>
+  operator^(Matrix<T, D> && m, const T & c)
+  {
+    Matrix<T, D> r(std::move(m));
+    r ^= c;
+    return r;
   }
 
 //-----------------------------------------------------------------------------
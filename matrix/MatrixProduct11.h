@@ -0,0 +1,332 @@
+/*
+    Matrix-matrix and matrix-vector products for the C++11 Matrix library.
+
+    The products work directly on the row-major storage of Matrix<T,2>
+    and on its Row and slice views (which share that storage) so no
+    operand is copied.  The matrix-matrix product follows the usual
+    high performance layout:
+      - the operands are cut into cache sized blocks,
+      - each block is packed into contiguous panels,
+      - a register blocked micro-kernel accumulates a small tile of the result,
+      - the rows of the result are optionally split across threads.
+*/
+
+
+#ifndef MATRIX_PRODUCT_LIB
+#define MATRIX_PRODUCT_LIB
+
+
+#include <vector>
+#include <thread>
+#include "Matrix11.h"
+
+
+namespace Numeric_lib
+{
+
+//-----------------------------------------------------------------------------
+
+//  Blocking parameters for the matrix product.
+//  The micro-kernel keeps an MR x NR tile of the result in registers;
+//  a KC x NR panel of b is meant to stay in L1, an MC x KC block of a in L2
+//  and a KC x NC block of b in L3.
+template<typename T>
+  struct Gemm_blocking
+  {
+    static constexpr Index MR = 4;
+    static constexpr Index NR = 8;
+    static constexpr Index MC = 128;
+    static constexpr Index KC = 256;
+    static constexpr Index NC = 4096;
+  };
+
+template<typename T> constexpr Index Gemm_blocking<T>::MR;
+template<typename T> constexpr Index Gemm_blocking<T>::NR;
+template<typename T> constexpr Index Gemm_blocking<T>::MC;
+template<typename T> constexpr Index Gemm_blocking<T>::KC;
+template<typename T> constexpr Index Gemm_blocking<T>::NC;
+
+namespace detail
+{
+
+  //  Pack an mc x kc block of a (leading dimension lda) into row panels
+  //  of height MR, each stored k-major.  Short panels are zero padded.
+  template<typename T>
+    void
+    gemm_pack_a(Index mc, Index kc, const T * a, Index lda, T * ap)
+    {
+      constexpr Index MR = Gemm_blocking<T>::MR;
+      for (Index i = 0; i < mc; i += MR)
+        {
+          Index mr = std::min(MR, mc - i);
+          for (Index k = 0; k < kc; ++k)
+            {
+              for (Index ir = 0; ir < mr; ++ir)
+                ap[ir] = a[(i + ir) * lda + k];
+              for (Index ir = mr; ir < MR; ++ir)
+                ap[ir] = T();
+              ap += MR;
+            }
+        }
+    }
+
+  //  Pack a kc x nc block of b (leading dimension ldb) into column panels
+  //  of width NR, each stored k-major.  Short panels are zero padded.
+  template<typename T>
+    void
+    gemm_pack_b(Index kc, Index nc, const T * b, Index ldb, T * bp)
+    {
+      constexpr Index NR = Gemm_blocking<T>::NR;
+      for (Index j = 0; j < nc; j += NR)
+        {
+          Index nr = std::min(NR, nc - j);
+          for (Index k = 0; k < kc; ++k)
+            {
+              const T * brow = b + k * ldb + j;
+              for (Index jr = 0; jr < nr; ++jr)
+                bp[jr] = brow[jr];
+              for (Index jr = nr; jr < NR; ++jr)
+                bp[jr] = T();
+              bp += NR;
+            }
+        }
+    }
+
+  //  c[0:mr, 0:nr] += alpha * ap * bp for one MR x NR tile.
+  //  The fixed size accumulator lets the compiler keep it in vector registers.
+  template<typename T>
+    void
+    gemm_micro_kernel(Index kc, T alpha, const T * ap, const T * bp,
+                      T * c, Index ldc, Index mr, Index nr)
+    {
+      constexpr Index MR = Gemm_blocking<T>::MR;
+      constexpr Index NR = Gemm_blocking<T>::NR;
+
+      T acc[MR][NR] = {};
+      for (Index k = 0; k < kc; ++k)
+        {
+          for (Index i = 0; i < MR; ++i)
+            for (Index j = 0; j < NR; ++j)
+              acc[i][j] += ap[i] * bp[j];
+          ap += MR;
+          bp += NR;
+        }
+
+      if (mr == MR && nr == NR)
+        {
+          for (Index i = 0; i < MR; ++i)
+            for (Index j = 0; j < NR; ++j)
+              c[i * ldc + j] += alpha * acc[i][j];
+        }
+      else
+        {
+          for (Index i = 0; i < mr; ++i)
+            for (Index j = 0; j < nr; ++j)
+              c[i * ldc + j] += alpha * acc[i][j];
+        }
+    }
+
+  //  c[0:m, 0:n] = alpha * a[0:m, 0:k] * b[0:k, 0:n] + beta * c[0:m, 0:n]
+  //  on raw row-major storage, single threaded.
+  template<typename T>
+    void
+    gemm_serial(Index m, Index n, Index k, T alpha,
+                const T * a, Index lda, const T * b, Index ldb,
+                T beta, T * c, Index ldc)
+    {
+      typedef Gemm_blocking<T> B;
+
+      if (beta != T(1))
+        for (Index i = 0; i < m; ++i)
+          for (Index j = 0; j < n; ++j)
+            c[i * ldc + j] = (beta == T() ? T() : beta * c[i * ldc + j]);
+      if (m == 0 || n == 0 || k == 0 || alpha == T())
+        return;
+
+      const Index mc_max = std::min(B::MC, (m + B::MR - 1) / B::MR * B::MR);
+      const Index nc_max = std::min(B::NC, (n + B::NR - 1) / B::NR * B::NR);
+      std::vector<T> ap(mc_max * B::KC);
+      std::vector<T> bp(B::KC * nc_max);
+
+      for (Index jc = 0; jc < n; jc += B::NC)
+        {
+          Index nc = std::min(B::NC, n - jc);
+          for (Index pc = 0; pc < k; pc += B::KC)
+            {
+              Index kc = std::min(B::KC, k - pc);
+              gemm_pack_b(kc, nc, b + pc * ldb + jc, ldb, bp.data());
+              for (Index ic = 0; ic < m; ic += B::MC)
+                {
+                  Index mc = std::min(B::MC, m - ic);
+                  gemm_pack_a(mc, kc, a + ic * lda + pc, lda, ap.data());
+                  for (Index jr = 0; jr < nc; jr += B::NR)
+                    for (Index ir = 0; ir < mc; ir += B::MR)
+                      gemm_micro_kernel(kc, alpha,
+                                        ap.data() + ir * kc,
+                                        bp.data() + jr * kc,
+                                        c + (ic + ir) * ldc + jc + jr, ldc,
+                                        std::min(B::MR, mc - ir),
+                                        std::min(B::NR, nc - jr));
+                }
+            }
+        }
+    }
+
+  //  y[0:m] = alpha * a[0:m, 0:n] * x[0:n] + beta * y[0:m]
+  //  on raw row-major storage, single threaded.
+  //  Four rows are done at a time so each load of x is reused.
+  template<typename T>
+    void
+    gemv_serial(Index m, Index n, T alpha, const T * a, Index lda,
+                const T * x, T beta, T * y)
+    {
+      Index i = 0;
+      for (; i + 4 <= m; i += 4)
+        {
+          const T * a0 = a + i * lda;
+          const T * a1 = a0 + lda;
+          const T * a2 = a1 + lda;
+          const T * a3 = a2 + lda;
+          T s0 = T(), s1 = T(), s2 = T(), s3 = T();
+          for (Index j = 0; j < n; ++j)
+            {
+              s0 += a0[j] * x[j];
+              s1 += a1[j] * x[j];
+              s2 += a2[j] * x[j];
+              s3 += a3[j] * x[j];
+            }
+          y[i + 0] = alpha * s0 + (beta == T() ? T() : beta * y[i + 0]);
+          y[i + 1] = alpha * s1 + (beta == T() ? T() : beta * y[i + 1]);
+          y[i + 2] = alpha * s2 + (beta == T() ? T() : beta * y[i + 2]);
+          y[i + 3] = alpha * s3 + (beta == T() ? T() : beta * y[i + 3]);
+        }
+      for (; i < m; ++i)
+        {
+          const T * ai = a + i * lda;
+          T s = T();
+          for (Index j = 0; j < n; ++j)
+            s += ai[j] * x[j];
+          y[i] = alpha * s + (beta == T() ? T() : beta * y[i]);
+        }
+    }
+
+  //  Split the rows [0:m) into num_threads bands (multiples of MR)
+  //  and run f(row_begin, row_end) on each band in its own thread.
+  //  Zero threads is taken as one.
+  template<typename T, typename F>
+    void
+    for_row_blocks(Index m, unsigned num_threads, F f)
+    {
+      constexpr Index MR = Gemm_blocking<T>::MR;
+      if (num_threads < 1)
+        num_threads = 1;
+      Index band = (m + num_threads - 1) / num_threads;
+      band = (band + MR - 1) / MR * MR;
+      if (num_threads < 2 || band >= m)
+        {
+          f(Index(0), m);
+          return;
+        }
+
+      std::vector<std::thread> threads;
+      for (Index r = 0; r < m; r += band)
+        threads.emplace_back(f, r, std::min(m, r + band));
+      for (auto & t : threads)
+        t.join();
+    }
+
+}  //  namespace detail
+
+//-----------------------------------------------------------------------------
+
+//  c = alpha * a * b + beta * c
+//  The rows of c are split among num_threads threads.
+//  Any of a, b, c may be a Row or a slice of a larger matrix;
+//  c must not share storage with a or b.
+template<typename T>
+  void
+  gemm(T alpha, const Matrix<T, 2> & a, const Matrix<T, 2> & b,
+       T beta, Matrix<T, 2> & c, unsigned num_threads = 1)
+  {
+    if (a.dim2() != b.dim1() || c.dim1() != a.dim1() || c.dim2() != b.dim2())
+      error("sizes wrong for gemm()");
+
+    const Index k = a.dim2();
+    const Index n = b.dim2();
+    const T * pa = a.data();
+    const T * pb = b.data();
+    T * pc = c.data();
+    detail::for_row_blocks<T>(a.dim1(), num_threads,
+      [=](Index r0, Index r1)
+      {
+        detail::gemm_serial(r1 - r0, n, k, alpha, pa + r0 * k, k,
+                            pb, n, beta, pc + r0 * n, n);
+      });
+  }
+
+//  Overload so that a temporary view such as c.slice(i, j) can be the target.
+template<typename T>
+  void
+  gemm(T alpha, const Matrix<T, 2> & a, const Matrix<T, 2> & b,
+       T beta, Row<T, 2> && c, unsigned num_threads = 1)
+  { gemm(alpha, a, b, beta, static_cast<Matrix<T, 2> &>(c), num_threads); }
+
+//-----------------------------------------------------------------------------
+
+//  y = alpha * a * x + beta * y
+//  The rows of a are split among num_threads threads.
+template<typename T>
+  void
+  gemv(T alpha, const Matrix<T, 2> & a, const Matrix<T, 1> & x,
+       T beta, Matrix<T, 1> & y, unsigned num_threads = 1)
+  {
+    if (a.dim2() != x.dim1() || y.dim1() != a.dim1())
+      error("sizes wrong for gemv()");
+
+    const Index n = a.dim2();
+    const T * pa = a.data();
+    const T * px = x.data();
+    T * py = y.data();
+    detail::for_row_blocks<T>(a.dim1(), num_threads,
+      [=](Index r0, Index r1)
+      {
+        detail::gemv_serial(r1 - r0, n, alpha, pa + r0 * n, n,
+                            px, beta, py + r0);
+      });
+  }
+
+//  Overload so that a temporary view such as m[i] can be the target.
+template<typename T>
+  void
+  gemv(T alpha, const Matrix<T, 2> & a, const Matrix<T, 1> & x,
+       T beta, Row<T, 1> && y, unsigned num_threads = 1)
+  { gemv(alpha, a, x, beta, static_cast<Matrix<T, 1> &>(y), num_threads); }
+
+//-----------------------------------------------------------------------------
+
+//  The matrix product a * b.
+template<typename T>
+  Matrix<T, 2>
+  matrix_product(const Matrix<T, 2> & a, const Matrix<T, 2> & b,
+                 unsigned num_threads = 1)
+  {
+    Matrix<T, 2> res(a.dim1(), b.dim2());
+    gemm(T(1), a, b, T(), res, num_threads);
+    return res.xfer();
+  }
+
+//  The matrix-vector product a * x.
+template<typename T>
+  Matrix<T>
+  matrix_vector_product(const Matrix<T, 2> & a, const Matrix<T> & x,
+                        unsigned num_threads = 1)
+  {
+    Matrix<T> res(a.dim1());
+    gemv(T(1), a, x, T(), res, num_threads);
+    return res.xfer();
+  }
+
+//-----------------------------------------------------------------------------
+
+}
+#endif
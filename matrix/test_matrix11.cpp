@@ -0,0 +1,141 @@
+// $HOME/bin/bin/g++ -std=c++14 -O3 -march=native -o test_matrix11 test_matrix11.cpp
+
+#include <iostream>
+#include <cassert>
+#include <utility>
+#include <type_traits>
+#include <limits>
+#include <new>
+
+#include "Matrix11.h"
+
+using Numeric_lib::Index;
+using Numeric_lib::Matrix;
+using Numeric_lib::Matrix_expr;
+
+template<typename X>
+  struct is_expr
+  : std::false_type
+  { };
+
+template<typename T, int D, typename E>
+  struct is_expr<Matrix_expr<T, D, E>>
+  : std::true_type
+  { };
+
+Matrix<double, 2>
+filled(double x)
+{
+  Matrix<double, 2> m(3, 4);
+  m = x;
+  return m;
+}
+
+template<typename T, int N>
+  bool
+  all_equal(const Matrix<T, N> & a, const T & c)
+  {
+    for (Index i = 0; i < a.size(); ++i)
+      if (a.data()[i] != c)
+        return false;
+    return true;
+  }
+
+int
+main()
+{
+  //  A moved-from matrix keeps its shape and may be assigned to again.
+  {
+    Matrix<double, 2> a(3, 4), b(3, 4);
+    a = 1.0;
+    b = 2.0;
+    Matrix<double, 2> m(std::move(a));
+    assert(all_equal(m, 1.0));
+    a = b;
+    assert(all_equal(a, 2.0));
+
+    Matrix<double, 2> c(std::move(a));
+    a = std::move(b);
+    assert(all_equal(a, 2.0));
+
+    Matrix<double, 2> d(std::move(a));
+    a = 3.0;
+    assert(all_equal(a, 3.0));
+
+    Matrix<double, 2> e(std::move(a));
+    a = m + c;
+    assert(all_equal(a, 3.0));
+  }
+  {
+    Matrix<double> a(5), b(5);
+    b = 4.0;
+    Matrix<double> m(std::move(a));
+    a = b;
+    assert(all_equal(a, 4.0));
+  }
+  {
+    Matrix<double, 3> a(2, 3, 4), b(2, 3, 4);
+    b = 5.0;
+    Matrix<double, 3> m(std::move(a));
+    a = b;
+    assert(all_equal(a, 5.0));
+  }
+
+  //  Arithmetic with a scalar builds an expression on named operands and
+  //  a * 2 + b - c is one; an expression never refers to a temporary Matrix.
+  {
+    Matrix<double, 2> a = filled(1.0), b = filled(2.0), c = filled(4.0);
+
+    auto m = a * 2;
+    static_assert(is_expr<decltype(m)>::value, "a * 2 is an expression");
+    assert(all_equal(Matrix<double, 2>(m), 2.0));
+    a = 10.0;
+    assert(all_equal(Matrix<double, 2>(m), 20.0));
+
+    auto e = a * 2 + b - c;
+    static_assert(is_expr<decltype(e)>::value,
+                  "a * 2 + b - c is an expression");
+    Matrix<double, 2> r = e;
+    assert(all_equal(r, 18.0));
+    r = 0.5 * (a / 2 - 1) + 3;
+    assert(all_equal(r, 5.0));
+    r = 20 - a * 2;
+    assert(all_equal(r, 0.0));
+
+    auto v = filled(3.0) * 2;
+    static_assert(std::is_same<decltype(v), Matrix<double, 2>>::value,
+                  "a temporary operand is not referred to");
+    assert(all_equal(v, 6.0));
+    r = 2 * a - filled(4.0) / 2 + 3;
+    assert(all_equal(r, 21.0));
+    r = 1 - (b + c) * 0.5;
+    assert(all_equal(r, -2.0));
+
+    auto s = filled(3.0) + b;
+    static_assert(std::is_same<decltype(s), Matrix<double, 2>>::value,
+                  "a temporary operand is not referred to");
+    assert(all_equal(s, 5.0));
+    auto t = b - filled(3.0);
+    assert(all_equal(t, -1.0));
+    auto u = filled(3.0) - filled(1.0);
+    assert(all_equal(u, 2.0));
+    r = b - (filled(1.0) - c);
+    assert(all_equal(r, 5.0));
+  }
+
+  //  A size whose byte count wraps is refused, not under-allocated.
+  {
+    bool thrown = false;
+    try
+      {
+        Matrix<double> m(std::numeric_limits<Index>::max() / 2);
+      }
+    catch (const std::bad_array_new_length &)
+      {
+        thrown = true;
+      }
+    assert(thrown);
+  }
+
+  std::cout << "ok\n";
+}
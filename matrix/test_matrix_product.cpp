@@ -0,0 +1,122 @@
+// $HOME/bin/bin/g++ -std=c++14 -O3 -march=native -o test_matrix_product test_matrix_product.cpp -lpthread
+// ./test_matrix_product [max_size [num_threads]]
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+
+#include "MatrixProduct11.h"
+#include "../timer.h"
+
+using Numeric_lib::Index;
+using Numeric_lib::Matrix;
+
+template<typename T>
+  void
+  naive_product(const Matrix<T, 2> & a, const Matrix<T, 2> & b, Matrix<T, 2> & c)
+  {
+    for (Index i = 0; i < a.dim1(); ++i)
+      for (Index j = 0; j < b.dim2(); ++j)
+        {
+          T sum = T();
+          for (Index k = 0; k < a.dim2(); ++k)
+            sum += a(i, k) * b(k, j);
+          c(i, j) = sum;
+        }
+  }
+
+template<typename T>
+  T
+  max_diff(const Matrix<T, 2> & a, const Matrix<T, 2> & b)
+  {
+    T diff = T();
+    for (Index i = 0; i < a.size(); ++i)
+      diff = std::max(diff, std::abs(a.data()[i] - b.data()[i]));
+    return diff;
+  }
+
+int
+main(int n_app_args, char ** app_args)
+{
+  Index max_size = 1024;
+  if (n_app_args > 1)
+    max_size = std::atol(app_args[1]);
+  unsigned num_threads = std::thread::hardware_concurrency();
+  if (n_app_args > 2)
+    num_threads = std::atoi(app_args[2]);
+
+  std::mt19937 re;
+  std::uniform_real_distribution<double> ud(-1.0, 1.0);
+
+  //  Odd shapes and views exercise the edge handling of the kernels.
+  {
+    Matrix<double, 2> a(37, 53), b(53, 29), c(37, 29), d(37, 29);
+    a.apply([&](double & x){ x = ud(re); });
+    b.apply([&](double & x){ x = ud(re); });
+    naive_product(a, b, c);
+    Numeric_lib::gemm(1.0, a, b, 0.0, d, 3);
+    std::cout << "37x53 * 53x29 max diff: " << max_diff(c, d) << '\n';
+    Numeric_lib::gemm(1.0, a, b, 0.0, d, 0);
+    std::cout << "zero threads max diff:   " << max_diff(c, d) << '\n';
+
+    Matrix<double, 2> e(20, 29);
+    Numeric_lib::gemm(1.0, a.slice(10, 30), b, 0.0, e);
+    double diff = 0.0;
+    for (Index i = 0; i < 20; ++i)
+      for (Index j = 0; j < 29; ++j)
+        diff = std::max(diff, std::abs(e(i, j) - c(i + 10, j)));
+    std::cout << "slice product max diff:  " << diff << '\n';
+
+    Matrix<double> x(53), y(37);
+    x.apply([&](double & v){ v = ud(re); });
+    Numeric_lib::gemv(1.0, a, x, 0.0, y);
+    diff = 0.0;
+    for (Index i = 0; i < 37; ++i)
+      {
+        double s = 0.0;
+        for (Index k = 0; k < 53; ++k)
+          s += a(i, k) * x(k);
+        diff = std::max(diff, std::abs(s - y(i)));
+      }
+    std::cout << "gemv max diff:           " << diff << '\n';
+  }
+
+  std::cout << '\n' << std::setw(6) << "n"
+            << std::setw(12) << "naive ms"
+            << std::setw(12) << "gemm ms"
+            << std::setw(12) << "threads ms"
+            << std::setw(14) << "max diff" << '\n';
+  for (Index n = 64; n <= max_size; n *= 2)
+    {
+      Matrix<double, 2> a(n, n), b(n, n), c(n, n), d(n, n), e(n, n);
+      a.apply([&](double & x){ x = ud(re); });
+      b.apply([&](double & x){ x = ud(re); });
+
+      Timer timer;
+
+      timer.start();
+      naive_product(a, b, c);
+      timer.stop();
+      long t_naive = timer.time_elapsed();
+
+      timer.start();
+      Numeric_lib::gemm(1.0, a, b, 0.0, d);
+      timer.stop();
+      long t_gemm = timer.time_elapsed();
+
+      timer.start();
+      Numeric_lib::gemm(1.0, a, b, 0.0, e, num_threads);
+      timer.stop();
+      long t_par = timer.time_elapsed();
+
+      std::cout << std::setw(6) << n
+                << std::setw(12) << t_naive
+                << std::setw(12) << t_gemm
+                << std::setw(12) << t_par
+                << std::setw(14) << std::max(max_diff(c, d), max_diff(c, e))
+                << '\n';
+    }
+}
@@ -5,10 +5,17 @@
 #include <cmath>
 #include <stdexcept>
 #include <limits>
+#include <algorithm>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <memory>
+#include <mutex>
 
 
 #define EPS 1.0e-15
 #define MAXIT 40
+#define GLR_MIN_ORDER 20
 
 
 /*
@@ -50,8 +57,216 @@ template<typename RealTp>
 
 
 
+/**
+ *  Gauss-Legendre abscissas and weights on -1 < x < +1 in O(n) operations.
+ *
+ *  Following Glaser, Liu and Rokhlin the roots are found in order outward from the origin
+ *  by Newton's method on the Taylor series of P_n about the previous root.
+ *  The Taylor coefficients follow from Legendre's differential equation
+ *  so each root costs O(1) instead of the O(n) of the recursion relation.
+ *  The radius of convergence shrinks towards the singular points at +-1 so the
+ *  last few roots are found with the recursion relation in the angle theta = acos(x).
+ *  The abscissas are returned in increasing order.
+ */
+template<typename RealTp>
+  void
+  gauss_legendre_glr(int n, RealTp *x, RealTp *w)
+  {
+    using namespace std::constants::math_constants;
+    const int NTERMS = 30;
+    const int NEDGE = 8;
+
+    if (n <= 2 * NEDGE)
+      throw std::logic_error("order too small in gauss_legendre_glr");
+
+    const auto m = n / 2;
+    const auto lambda = RealTp(n) * (n + 1);
+    const auto rho = n + RealTp(0.5);
+
+    //  Store the positive root z with 1 - z and the product (1 - z^2) P_n'(z)
+    //  which is stationary at the roots; the weight is 2(1 - z^2)/[(1 - z^2) P_n'(z)]^2.
+    //  The k-th positive root counting in from x = +1 goes to x[n - k].
+    auto store = [&](int k, RealTp z, RealTp omz, RealTp s)
+    {
+      x[n - k] = z;
+      x[k - 1] = -z;
+      w[n - k] = w[k - 1] = 2 * omz * (2 - omz) / (s * s);
+    };
+
+    //  Start at the origin with P_n(0) and P_n'(0) from the double factorials.
+    //  The lgamma ratio loses about n epsilon; the march is renormalized below.
+    auto c = std::exp(std::lgamma(RealTp(n + 1) / 2) - std::lgamma(RealTp(n) / 2 + 1))
+           / std::sqrt(m_pi<RealTp>);
+    RealTp x0 = 0, u[NTERMS + 1];
+    RealTp omz = 1, s_march = 1;
+    if (n % 2 == 0)
+      {
+        u[0] = (m % 2 == 0 ? c : -c);
+        u[1] = 0;
+      }
+    else
+      {
+        u[0] = 0;
+        u[1] = (m % 2 == 0 ? 2 : -2) / (m_pi<RealTp> * c);
+        s_march = u[1];
+        x[m] = 0;
+        w[m] = 2 / (u[1] * u[1]);
+      }
+
+    //  Taylor series of P_n and P_n' about x0 at t = x - x0.
+    //  The coefficients u[j] are scaled by h^j with h the local spacing of the roots
+    //  so that they neither overflow nor underflow near the endpoints.
+    RealTp h = 1;
+    auto eval = [&](RealTp t, RealTp & p, RealTp & dp)
+    {
+      const auto s = t / h;
+      p = u[NTERMS];
+      dp = NTERMS * u[NTERMS];
+      for (int j = NTERMS - 1; j >= 1; --j)
+        {
+          p = p * s + u[j];
+          dp = dp * s + j * u[j];
+        }
+      p = p * s + u[0];
+      dp /= h;
+    };
+
+    //  The Taylor coefficients satisfy, from (1 - x^2) y'' - 2 x y' + n(n + 1) y = 0,
+    //  (1 - x0^2) (j + 2)(j + 1) u[j+2] = 2 x0 (j + 1)^2 u[j+1] + (j(j + 1) - n(n + 1)) u[j].
+    //  Any factor that rounds the same way at every root, like 1/(j + 2)(j + 1) or h^2/(1 - x0^2),
+    //  biases the derivative and the error then grows linearly along the march.
+    RealTp ca[NTERMS - 1], cb[NTERMS - 1], cd[NTERMS - 1];
+    for (int j = 0; j < NTERMS - 1; ++j)
+      {
+        ca[j] = 2 * (j + 1) * (j + 1);
+        cb[j] = j * (j + 1) - lambda;
+        cd[j] = (j + 2) * (j + 1);
+      }
+
+    for (int k = m; k > NEDGE; --k)
+      {
+        const auto omx2 = (1 - x0) * (1 + x0);
+        h = std::sqrt(omx2) / rho;
+        u[1] *= h;
+        for (int j = 0; j < NTERMS - 1; ++j)
+          u[j + 2] = h * (x0 * ca[j] * u[j + 1] + h * cb[j] * u[j]) / (omx2 * cd[j]);
+
+        //  Tricomi's approximation for the initial guess.
+        const auto theta = m_pi<RealTp> * (4 * k - 1) / (4 * n + 2);
+        const auto sin2 = std::sin(theta) * std::sin(theta);
+        const RealTp nn = n;
+        const auto z = (1 - (nn - 1) / (8 * nn * nn * nn)
+                          - (39 - 28 / sin2) / (384 * nn * nn * nn * nn)) * std::cos(theta);
+        auto t = z - x0;
+        RealTp p, dp;
+        int its = 0;
+        while (its++ < MAXIT)
+          {
+            eval(t, p, dp);
+            const auto dt = p / dp;
+            t -= dt;
+            if (std::abs(dt) <= EPS)
+              break;
+          }
+        if (its >= MAXIT)
+          throw std::logic_error("too many iterations in gauss_legendre_glr");
+
+        //  Recenter on the rounded root so that the next series is consistent.
+        //  The derivative there serves for the weight since (1 - x^2) P_n' is stationary.
+        const auto x1 = x0 + t;
+        eval(x1 - x0, p, dp);
+        omz = 1 - x1;
+        s_march = omz * (2 - omz) * dp;
+        store(k, x1, (1 - x0) - t, s_march);
+        x0 = x1;
+        u[0] = p;
+        u[1] = dp;
+      }
+
+    //  Rescale the marched weights to the recursion at the last marched root.
+    {
+      RealTp p = RealTp(1), d = RealTp(0);
+      for (int j = 1; j <= n; ++j)
+        {
+          d = ((j - 1) * d - (2 * j - 1) * omz * p) / j;
+          p += d;
+        }
+      const auto ratio = s_march / (n * (omz * p - d));
+      const auto scale = ratio * ratio;
+      for (int k = NEDGE + 1; k <= m; ++k)
+        {
+          w[n - k] *= scale;
+          w[k - 1] *= scale;
+        }
+      if (n % 2 == 1)
+        w[m] *= scale;
+    }
+
+    //  Olver's approximation from McMahon's expansion of the Bessel zeros j_{0,k}
+    //  for the last roots.  These are polished together so that the O(n) recursion
+    //  runs over NEDGE independent lanes.
+    RealTp theta[NEDGE], y[NEDGE], p[NEDGE], d[NEDGE];
+    for (int r = 0; r < NEDGE; ++r)
+      {
+        const auto beta = m_pi<RealTp> * (r + RealTp(0.75));
+        const auto b8 = 1 / (8 * beta);
+        const auto j0k = beta + b8 - RealTp(124) / 3 * b8 * b8 * b8
+                       + RealTp(120928) / 15 * b8 * b8 * b8 * b8 * b8;
+        const auto psi = j0k / rho;
+        theta[r] = psi + (psi / std::tan(psi) - 1) / (8 * rho * rho * psi);
+      }
+
+    //  Run the recursion on y = 1 - x and d_j = P_j - P_{j-1} since x itself
+    //  cannot resolve the roots near x = 1 to full relative precision in 1 - x.
+    bool polish = false;
+    int its = 0;
+    while (its++ < MAXIT)
+      {
+        for (int r = 0; r < NEDGE; ++r)
+          {
+            const auto st = std::sin(theta[r] / 2);
+            y[r] = 2 * st * st;
+            p[r] = RealTp(1);
+            d[r] = RealTp(0);
+          }
+        for (int j = 1; j <= n; ++j)
+          {
+            const auto aj = RealTp(j - 1) / j;
+            const auto bj = RealTp(2 * j - 1) / j;
+            for (int r = 0; r < NEDGE; ++r)
+              {
+                d[r] = aj * d[r] - bj * y[r] * p[r];
+                p[r] += d[r];
+              }
+          }
+        //  d/dtheta P_n(cos theta) = n [d_n - y P_n] / sin(theta).
+        RealTp err = 0;
+        for (int r = 0; r < NEDGE; ++r)
+          {
+            const auto dtheta = p[r] * std::sin(theta[r]) / (n * (d[r] - y[r] * p[r]));
+            theta[r] -= dtheta;
+            err = std::max(err, std::abs(dtheta) / theta[r]);
+          }
+        //  Rounding limits the relative accuracy of theta to about sqrt(n) epsilon
+        //  so take one more step once Newton's method has started to converge.
+        if (polish)
+          break;
+        polish = err <= std::sqrt(EPS);
+      }
+    if (its >= MAXIT)
+      throw std::logic_error("too many iterations in gauss_legendre_glr");
+
+    for (int r = 0; r < NEDGE; ++r)
+      {
+        const auto st = std::sin(theta[r] / 2);
+        store(r + 1, std::cos(theta[r]), 2 * st * st, n * (y[r] * p[r] - d[r]));
+      }
+  }
+
+
 /**
  *  This routine calculates wieghts and grid points for gaussian quadrature integration.
+ *  Large orders are delegated to the O(n) gauss_legendre_glr.
  */
 template<typename RealTp>
   void
@@ -62,9 +277,20 @@ template<typename RealTp>
     auto bpa = (b + a) / 2;
     auto bma = (b - a) / 2;
 
+    if (n > GLR_MIN_ORDER)
+      {
+        gauss_legendre_glr(n, x, w);
+        for (int i = 0; i < n; ++i)
+          {
+            x[i] = bpa + bma * x[i];
+            w[i] *= bma;
+          }
+        return;
+      }
+
     for (int i = 0; i < m; ++i)
       {
-	auto z = std::cos(m_pi<RealTp> * (i + 0.25) / (n + 0.5));    /*    Clever approximation of root.    */
+	auto z = std::cos(m_pi<RealTp> * (i + 0.75) / (n + 0.5));    /*    Clever approximation of root.    */
 	auto k = 0;
 	RealTp pp, z1;
 	do
@@ -102,16 +328,16 @@ template<typename RealTp>
   void
   gauss_laguerre(RealTp *x, RealTp *w, int n, RealTp alpha)
   {
+    RealTp z{};
     for (int i = 0; i < n; ++i)
       {
-	RealTp z;
 	if (i == 0)
           z = (1.0 + alpha) * (3.0 + 0.92 * alpha) / (1.0 + 2.4 * n + 1.8 * alpha);
-	else if (1 == 1)
+	else if (i == 1)
           z += (15.0 + 6.25 * alpha) / (1.0 + 2.5 * n + 0.9 * alpha);
 	else
           {
-            auto ai = i - RealTp(2);
+            auto ai = i - RealTp(1);
             z += ((1.0 + 2.55 * ai) / (1.9 * ai)
         	+ 1.26 * ai * alpha / (1.0 + 3.5 * ai))
                * (z - x[i - 2]) / (1.0 + 0.3 * alpha);
@@ -132,7 +358,7 @@ template<typename RealTp>
             pp = (n * p1 - (n + alpha) * p2) / z;
             auto z1 = z;
             z = z1 - p1 / pp;
-            if (std::abs(z - z1) <= 100 * EPS)
+            if (std::abs(z - z1) <= 100 * EPS * (1 + z))
               break;
           }
 
@@ -154,17 +380,17 @@ template<typename RealTp>
   {
     using namespace std::constants::math_constants;
     auto m = (n + 1) / 2;
+    RealTp z{};
     for (int i = 0; i < m; ++i)
       {
-	RealTp z;
 	if (i == 0)
           z = std::sqrt(2.0 * n + 1) - 1.85575 * std::pow(2 * n + 1, -1.0 / 6);
 	else if (i == 1)
           z -= 1.14 * std::pow(n, 0.426) / z;
 	else if (i == 2)
-          z = 1.86 * z - 0.86 * x[1];
+          z = 1.86 * z - 0.86 * x[0];
 	else if (i == 3)
-          z = 1.91 * z - 0.91 * x[2];
+          z = 1.91 * z - 0.91 * x[1];
 	else
           z = 2 * z - x[i - 2];
 
@@ -172,9 +398,9 @@ template<typename RealTp>
 	int its = 0;
 	while (its++ < MAXIT)
           {
-            auto p1 = m_pi_4<RealTp>;
+            auto p1 = std::sqrt(m_1_sqrt_pi<RealTp>);
             p2 = RealTp(0);
-            for (int j = 0; j < n; ++j)
+            for (int j = 1; j <= n; ++j)
               {
         	auto p3 = p2;
         	p2 = p1;
@@ -183,7 +409,7 @@ template<typename RealTp>
             pp = std::sqrt(RealTp(2) * n) * p2;
             auto z1 = z;
             z = z1 - p1 / pp;
-            if (std::abs(z - z1) <= EPS)
+            if (std::abs(z - z1) <= EPS * (1 + std::abs(z)))
               break;
           }
 
@@ -205,9 +431,9 @@ template<typename RealTp>
   void
   gauss_jacobi(RealTp *x, RealTp *w, int n, RealTp alpha, RealTp beta)
   {
+    RealTp z{};
     for (int i = 0; i < n; ++i)
       {
-	RealTp z;
 	if (i == 0)
           {
             auto an = alpha / n;
@@ -228,31 +454,32 @@ template<typename RealTp>
             auto r1 = (1.67 + 0.28 * alpha) / (1.0 + 0.37 * alpha);
             auto r2 = 1.0 + 0.22 * (n - 8.0) / n;
             auto r3 = 1.0 + 8.0 * beta/((6.28 + beta) * n * n);
-            z -= (x[1] - z) * r1 * r2 * r3;
+            z -= (x[0] - z) * r1 * r2 * r3;
           }
 	else if (i == n - 2)
           {
             auto r1 = (1.0 + 0.235 * beta) / (0.766 + 0.119 * beta);
             auto r2 = 1.0 / (1.0 + 0.639 * (n - 4.0)/(1.0 + 0.71 * (n - 4.0)));
             auto r3 = 1.0 / (1.0 + 20.0 * alpha / ((7.5 + alpha) * n * n));
-            z += (z - x[n - 3]) * r1 * r2 * r3;
+            z += (z - x[n - 4]) * r1 * r2 * r3;
           }
 	else if (i == n - 1)
           {
             auto r1 = (1.0 + 0.37 * beta) / (1.67 + 0.28 * beta);
             auto r2 = 1.0/(1.0 + 0.22 * (n - 8.0) / n);
             auto r3 = 1.0/(1.0 + 8.0 * alpha / ((6.28 + alpha) * n * n));
-            z += (z - x[n-2]) * r1 * r2 * r3;
+            z += (z - x[n - 3]) * r1 * r2 * r3;
           }
 	else
           z = 3 * x[i - 1] - 3 * x[i - 2] + x[i - 3];
 
 	RealTp p2, pp;
 	auto alphabeta = alpha + beta;
-	auto temp = 2 + alphabeta;
+	RealTp temp;
 	int its = 0;
 	while (its++ < MAXIT)
           {
+            temp = 2 + alphabeta;
             auto p1 = (alpha - beta + temp * z) / 2;
             p2 = 1;
             for (int j = 2; j <= n; ++j)
@@ -269,7 +496,7 @@ template<typename RealTp>
         	+ RealTp(2) * (n + alpha) * (n + beta) * p2)
                /(temp * (1 - z * z));
             auto z1 = z;
-            auto z = z1 - p1 / pp;
+            z = z1 - p1 / pp;
             if (std::abs(z - z1) <= EPS)
               break;
           }
@@ -299,12 +526,166 @@ template<typename RealTp>
     auto m = (n + 1) / 2;
     for (int i = 0; i < m; ++i)
       {
-	x[n - i] = -(x[i] = std::cos(m_pi<RealTp> * (i + 0.5) / n));
-	w[n - i] = w[i] = m_pi<RealTp> / n;
+	x[n - 1 - i] = -(x[i] = std::cos(m_pi<RealTp> * (i + 0.5) / n));
+	w[n - 1 - i] = w[i] = m_pi<RealTp> / n;
       }
   }
 
 
+/**
+ *  The weight functions of the tabulated Gauss rules.
+ */
+enum class gauss_family
+{
+  legendre,   //  1 on [-1, +1]
+  laguerre,   //  x^alpha e^{-x} on [0, inf)
+  hermite,    //  e^{-x^2} on (-inf, inf)
+  jacobi,     //  (1 - x)^alpha (1 + x)^beta on [-1, +1]
+  chebyshev   //  (1 - x^2)^{-1/2} on [-1, +1]
+};
+
+
+/**
+ *  Abscissas and weights of an n-point Gauss rule on the standard interval of its family.
+ */
+template<typename RealTp>
+  struct gauss_rule
+  {
+    std::vector<RealTp> x;
+    std::vector<RealTp> w;
+
+    int
+    size() const
+    { return x.size(); }
+  };
+
+
+/**
+ *  Build a Gauss rule.  Parameters that the family does not use are ignored.
+ */
+template<typename RealTp>
+  gauss_rule<RealTp>
+  make_gauss_rule(gauss_family family, int n,
+                  RealTp alpha = RealTp(0), RealTp beta = RealTp(0))
+  {
+    if (n <= 0)
+      throw std::logic_error("non-positive order in make_gauss_rule");
+
+    gauss_rule<RealTp> rule;
+    rule.x.resize(n);
+    rule.w.resize(n);
+    switch (family)
+      {
+      case gauss_family::legendre:
+        gauss_legendre(n, RealTp(-1), RealTp(1), rule.x.data(), rule.w.data());
+        break;
+      case gauss_family::laguerre:
+        gauss_laguerre(rule.x.data(), rule.w.data(), n, alpha);
+        break;
+      case gauss_family::hermite:
+        gauss_hermite(rule.x.data(), rule.w.data(), n);
+        break;
+      case gauss_family::jacobi:
+        gauss_jacobi(rule.x.data(), rule.w.data(), n, alpha, beta);
+        break;
+      case gauss_family::chebyshev:
+        gauss_chebyshev(rule.x.data(), rule.w.data(), n);
+        break;
+      }
+    return rule;
+  }
+
+
+/**
+ *  Process-wide cache of Gauss rules keyed by family, order and parameters.
+ *
+ *  Lookups are thread safe.  A rule is built outside the lock on the first request
+ *  and shared by all later ones; the returned pointer keeps the rule alive
+ *  across a clear().
+ */
+template<typename RealTp>
+  class gauss_rule_cache
+  {
+  public:
+
+    using rule_ptr = std::shared_ptr<const gauss_rule<RealTp>>;
+
+    static rule_ptr
+    get(gauss_family family, int n, RealTp alpha = RealTp(0), RealTp beta = RealTp(0))
+    {
+      if (family != gauss_family::laguerre && family != gauss_family::jacobi)
+        alpha = RealTp(0);
+      if (family != gauss_family::jacobi)
+        beta = RealTp(0);
+      const key_type key{family, n, alpha, beta};
+
+      auto & st = state();
+      {
+        std::lock_guard<std::mutex> lock(st.mtx);
+        auto it = st.rules.find(key);
+        if (it != st.rules.end())
+          return it->second;
+      }
+
+      //  Another thread may have built the same rule meanwhile; the first one in wins.
+      rule_ptr rule = std::make_shared<const gauss_rule<RealTp>>(
+                        make_gauss_rule(family, n, alpha, beta));
+      std::lock_guard<std::mutex> lock(st.mtx);
+      return st.rules.emplace(key, std::move(rule)).first->second;
+    }
+
+    static void
+    clear()
+    {
+      auto & st = state();
+      std::lock_guard<std::mutex> lock(st.mtx);
+      st.rules.clear();
+    }
+
+    static std::size_t
+    size()
+    {
+      auto & st = state();
+      std::lock_guard<std::mutex> lock(st.mtx);
+      return st.rules.size();
+    }
+
+  private:
+
+    using key_type = std::tuple<gauss_family, int, RealTp, RealTp>;
+
+    struct cache_state
+    {
+      std::mutex mtx;
+      std::map<key_type, rule_ptr> rules;
+    };
+
+    static cache_state &
+    state()
+    {
+      static cache_state st;
+      return st;
+    }
+  };
+
+
+/**
+ *  Integrate func over a < x < b with a Legendre rule from gauss_rule_cache.
+ */
+template<typename Func, typename RealTp>
+  RealTp
+  quad_gauss(Func func, RealTp a, RealTp b, const gauss_rule<RealTp> & rule)
+  {
+    auto bpa = (b + a) / 2;
+    auto bma = (b - a) / 2;
+
+    RealTp sum{};
+    for (int i = 0; i < rule.size(); ++i)
+      sum += rule.w[i] * func(bpa + bma * rule.x[i]);
+    return bma * sum;
+  }
+
+
 /**
  *  
  */
@@ -3,9 +3,278 @@
 
 
 #include <cmath>
+#include <cstddef>
 #include <stdexcept>
 #include <vector>
 #include <limits>
+#include <utility>
+#include <type_traits>
+#include <algorithm>
+
+
+/**
+ *    Integrands are either ordinary callables, func(x), or batch callables,
+ *    func(x, fx, n), that fill fx[0..n-1] with the integrand at x[0..n-1].
+ *    A batch integrand is handed each refinement level of the trapezoid and midpoint
+ *    rules in blocks of points so that its loop can be vectorized.
+ */
+template<typename Func, typename = void>
+  struct is_batch_integrand
+  : std::false_type
+  { };
+
+template<typename Func>
+  struct is_batch_integrand<Func,
+                            decltype(void(std::declval<Func &>()(std::declval<const double *>(),
+                                                                  std::declval<double *>(),
+                                                                  std::size_t{})))>
+  : std::true_type
+  { };
+
+
+/**
+ *    Changes of variables for the extended midpoint rule.  Each gives the limits
+ *    of the new variable x for the original limits aa and bb, the original variable
+ *    var(x) and the Jacobian jac(x).
+ */
+struct midpoint_map
+{
+  double lower(double aa, double) const { return aa; }
+  double upper(double, double bb) const { return bb; }
+  double var(double x, double, double) const { return x; }
+  double jac(double) const { return 1.0; }
+};
+
+/**
+ *    Points evenly spaced in 1/x.  aa and bb must have the same sign.
+ */
+struct midpoint_inv_map
+{
+  double lower(double, double bb) const { return 1 / bb; }
+  double upper(double aa, double) const { return 1 / aa; }
+  double var(double x, double, double) const { return 1 / x; }
+  double jac(double x) const { return 1 / (x * x); }
+};
+
+/**
+ *    An inverse square root singularity at the lower limit aa.
+ */
+struct midpoint_inv_sqrt_lower_map
+{
+  double lower(double, double) const { return 0.0; }
+  double upper(double aa, double bb) const { return std::sqrt(bb - aa); }
+  double var(double x, double aa, double) const { return aa + x * x; }
+  double jac(double x) const { return 2 * x; }
+};
+
+/**
+ *    An inverse square root singularity at the upper limit bb.
+ */
+struct midpoint_inv_sqrt_upper_map
+{
+  double lower(double, double) const { return 0.0; }
+  double upper(double aa, double bb) const { return std::sqrt(bb - aa); }
+  double var(double x, double, double bb) const { return bb - x * x; }
+  double jac(double x) const { return 2 * x; }
+};
+
+/**
+ *    An infinite upper limit for an exponentially decreasing integrand; bb is not used.
+ */
+struct midpoint_exp_map
+{
+  double lower(double, double) const { return 0.0; }
+  double upper(double aa, double) const { return std::exp(-aa); }
+  double var(double x, double, double) const { return -std::log(x); }
+  double jac(double x) const { return 1 / x; }
+};
+
+/**
+ *    A logarithmic singularity at 0; aa is not used.
+ */
+struct midpoint_log_map
+{
+  double lower(double, double bb) const { return -std::log(bb); }
+  double upper(double, double) const { return -std::log(0.01); }
+  double var(double x, double, double) const { return std::exp(-x); }
+  double jac(double x) const { return -x; }
+};
+
+
+/**
+ *    The integrand at one point.
+ */
+template<typename Func>
+  inline double
+  integrand_eval(Func & func, double x, std::false_type)
+  { return func(x); }
+
+template<typename Func>
+  inline double
+  integrand_eval(Func & func, double x, std::true_type)
+  {
+    double fx;
+    func(&x, &fx, 1);
+    return fx;
+  }
+
+
+/**
+ *    The sum of jac(x) func(var(x)) over the n points x = x0, x0 + dx, ..., x0 + (n - 1)dx.
+ *    A batch integrand is called on blocks of points; an ordinary one is called
+ *    in the loop where it can be inlined.  The sums are split over LANES partial sums
+ *    so that the additions do not wait on each other.
+ */
+template<typename Func, typename Map>
+  double
+  integrand_sum(Func & func, const Map & map, double aa, double bb,
+                double x0, double dx, long n, std::false_type)
+  {
+    constexpr int LANES = 4;
+    double part[LANES] = {};
+    long j = 0;
+    for (; j + LANES <= n; j += LANES)
+      for (int l = 0; l < LANES; ++l)
+        {
+          const auto x = x0 + (j + l) * dx;
+          part[l] += map.jac(x) * func(map.var(x, aa, bb));
+        }
+    for (; j < n; ++j)
+      {
+        const auto x = x0 + j * dx;
+        part[0] += map.jac(x) * func(map.var(x, aa, bb));
+      }
+    return (part[0] + part[1]) + (part[2] + part[3]);
+  }
+
+template<typename Func, typename Map>
+  double
+  integrand_sum(Func & func, const Map & map, double aa, double bb,
+                double x0, double dx, long n, std::true_type)
+  {
+    constexpr long BLOCK = 512;
+    constexpr int LANES = 8;
+    double t[BLOCK], ft[BLOCK];
+    double part[LANES] = {};
+    for (long j0 = 0; j0 < n; j0 += BLOCK)
+      {
+        const auto m = std::min(BLOCK, n - j0);
+        for (long j = 0; j < m; ++j)
+          t[j] = map.var(x0 + (j0 + j) * dx, aa, bb);
+        func(static_cast<const double *>(t), ft, std::size_t(m));
+        long j = 0;
+        for (; j + LANES <= m; j += LANES)
+          for (int l = 0; l < LANES; ++l)
+            part[l] += map.jac(x0 + (j0 + j + l) * dx) * ft[j + l];
+        for (; j < m; ++j)
+          part[0] += map.jac(x0 + (j0 + j) * dx) * ft[j];
+      }
+    auto sum = 0.0;
+    for (int l = 0; l < LANES; ++l)
+      sum += part[l];
+    return sum;
+  }
+
+
+/**
+ *    Successive refinements of the extended trapezoid rule for the integral
+ *    of func from a to b.  The first call to next() returns the crudest estimate
+ *    and each later call doubles the number of intervals.
+ */
+template<typename Func>
+  class trapezoid_stage
+  {
+  public:
+
+    trapezoid_stage(Func func, double a, double b)
+    : m_func(func), m_a(a), m_b(b)
+    { }
+
+    double
+    next()
+    {
+      using batch = is_batch_integrand<Func>;
+      if (m_it == 0)
+        {
+          m_s = 0.5 * (m_b - m_a) * (integrand_eval(m_func, m_a, batch{})
+                                   + integrand_eval(m_func, m_b, batch{}));
+          m_it = 1;
+        }
+      else
+        {
+          const auto del = (m_b - m_a) / m_it;
+          const auto sum = integrand_sum(m_func, midpoint_map{}, m_a, m_b,
+                                         m_a + 0.5 * del, del, m_it, batch{});
+          m_s = 0.5 * (m_s + (m_b - m_a) * sum / m_it);
+          m_it *= 2;
+        }
+      return m_s;
+    }
+
+  private:
+
+    Func m_func;
+    double m_a;
+    double m_b;
+    double m_s = 0.0;
+    long m_it = 0;
+  };
+
+
+/**
+ *    Successive refinements of the extended midpoint rule for the integral of func
+ *    from aa to bb after the change of variables map.  The first call to next()
+ *    returns the crudest estimate and each later call triples the number of intervals.
+ */
+template<typename Func, typename Map = midpoint_map>
+  class midpoint_stage
+  {
+  public:
+
+    midpoint_stage(Func func, double aa, double bb, Map map = Map{})
+    : m_func(func), m_map(map), m_aa(aa), m_bb(bb),
+      m_a(map.lower(aa, bb)), m_b(map.upper(aa, bb))
+    { }
+
+    double
+    next()
+    {
+      using batch = is_batch_integrand<Func>;
+      if (m_it == 0)
+        {
+          const auto x = 0.5 * (m_a + m_b);
+          m_s = (m_b - m_a) * m_map.jac(x)
+              * integrand_eval(m_func, m_map.var(x, m_aa, m_bb), batch{});
+          m_it = 1;
+        }
+      else
+        {
+          //  The added points alternate in spacing between del and ddel
+          //  so they are two progressions with step 3 del.
+          const auto del = (m_b - m_a) / (3 * m_it);
+          const auto sum = integrand_sum(m_func, m_map, m_aa, m_bb,
+                                         m_a + 0.5 * del, 3 * del, m_it, batch{})
+                         + integrand_sum(m_func, m_map, m_aa, m_bb,
+                                         m_a + 2.5 * del, 3 * del, m_it, batch{});
+
+          //  The new sum is combined with the old integral to give a refined integral.
+          m_s = (m_s + (m_b - m_a) * sum / m_it) / 3;
+          m_it *= 3;
+        }
+      return m_s;
+    }
+
+  private:
+
+    Func m_func;
+    Map m_map;
+    double m_aa;
+    double m_bb;
+    double m_a;
+    double m_b;
+    double m_s = 0.0;
+    long m_it = 0;
+  };
 
 
 /**
@@ -15,12 +284,17 @@
  *    With n = 1, the crudest estimate of the integral is returned.
  *    With successive calls with n = 2, 3, ... (in order) accuracy will be improved
  *    by adding 2^(n-2) interior points.
+ *
+ *    Func defaults to a function pointer so that overloaded functions like std::cos
+ *    can be passed by name.  The drivers below use trapezoid_stage directly.
  */
+template<typename Func = double (*)(double)>
   double
-  trapezoid(double (*func)(double), double a, double b, int n)
+  trapezoid(Func func, double a, double b, int n)
   {
     static thread_local double s;
-    static thread_local int lastn, it;
+    static thread_local int lastn;
+    static thread_local long it;
 
     if (n <= 0)
       throw std::logic_error("non-positive order in trapezoid");
@@ -28,18 +302,16 @@
       throw std::logic_error("order out of sequence in trapezoid");
     lastn = n;
 
+    using batch = is_batch_integrand<Func>;
     if (n == 1)
       {
-	s = 0.5 * (b - a) * (func(a) + func(b));
+	s = 0.5 * (b - a) * (integrand_eval(func, a, batch{}) + integrand_eval(func, b, batch{}));
 	it = 1;
       }
     else
       {
 	auto del = (b - a) / it;
-	auto x = a + 0.5 * del;
-	auto sum = 0.0;
-	for (int j = 1; j <= it; ++j, x += del)
-          sum += func(x);
+	auto sum = integrand_sum(func, midpoint_map{}, a, b, a + 0.5 * del, del, it, batch{});
 	s = 0.5 * (s + (b - a) * sum / it);
 	it *= 2;
       }
@@ -49,17 +321,15 @@
 
 
 /**
- *    Modified midpoint integration.
- *
- *    This routine implements the nth stage of refinement of a modified midpoint integration.
- *    With n = 1, the crudest estimate of the integral is returned.
- *    With successive calls with n = 2, 3, ... (in order) accuracy will be improved
- *    by adding (2/3)^(n-1) interior points.
+ *    The nth stage of refinement of the extended midpoint rule after the change
+ *    of variables map, with the state of the sequence of calls kept per map.
  */
+template<typename Func, typename Map>
   double
-  midpoint(double (*func)(double), double a, double b, int n)
+  midpoint_nth(Func func, double aa, double bb, int n, Map map)
   {
     static thread_local int lastn;
+    static thread_local long it;
     static thread_local double s;
 
     if (n <= 0)
@@ -68,38 +338,45 @@
       throw std::logic_error("order out of sequence in midpoint");
     lastn = n;
 
+    using batch = is_batch_integrand<Func>;
+    const auto a = map.lower(aa, bb);
+    const auto b = map.upper(aa, bb);
+
     if (n == 1)
       {
 	auto x = 0.5 * (a + b);
-	return s = (b - a) * func(x);
+	it = 1;
+	return s = (b - a) * map.jac(x) * integrand_eval(func, map.var(x, aa, bb), batch{});
       }
     else
       {
-	auto it = 1;
-	for (int j = 1; j < n - 1; ++j)
-          it *= 3;
-	auto tnm = it;
-
 	//  The added points alternate in spacing between del and ddel.
-	auto del = (b - a) / (3 * tnm);
-	auto ddel = 2 * del;
-
-	auto x = a + 0.5 * del;
-	auto sum = 0.0;
-	for (int j = 1; j <= it; ++j)
-          {
-            sum += func(x);
-            x += ddel;
-            sum += func(x);
-            x += del;
-          }
+	auto del = (b - a) / (3 * it);
+	auto sum = integrand_sum(func, map, aa, bb, a + 0.5 * del, 3 * del, it, batch{})
+	         + integrand_sum(func, map, aa, bb, a + 2.5 * del, 3 * del, it, batch{});
 
 	//  The new sum is combined with the old integral to give a refined integral.
-	return s = (s + (b - a) * sum / tnm) / 3;
-    }
+	s = (s + (b - a) * sum / it) / 3;
+	it *= 3;
+	return s;
+      }
   }
 
 
+/**
+ *    Modified midpoint integration.
+ *
+ *    This routine implements the nth stage of refinement of a modified midpoint integration.
+ *    With n = 1, the crudest estimate of the integral is returned.
+ *    With successive calls with n = 2, 3, ... (in order) accuracy will be improved
+ *    by adding (2/3)^(n-1) interior points.
+ */
+template<typename Func = double (*)(double)>
+  double
+  midpoint(Func func, double a, double b, int n)
+  { return midpoint_nth(func, a, b, n, midpoint_map{}); }
+
+
 /**
  *    This routine is an exact replacement of midpoint except that the
  *    points are evenly spaced in 1/x rather than x.  This allows the
@@ -107,151 +384,30 @@
  *    bb to be as large and positive as the computer allows but not both.
  *    aa and bb must have the same sign.
  */
+template<typename Func = double (*)(double)>
   double
-  midpoint_inv(double (*func)(double), double aa, double bb, int n)
-  {
-    static thread_local int lastn;
-    static thread_local double s;
-
-    if (n <= 0)
-      throw std::logic_error("non-positive order in midpoint");
-    if (n != 1 && n != lastn + 1)
-      throw std::logic_error("order out of sequence in midpoint");
-    lastn = n;
-
-    auto a = 1 / aa;
-    auto b = 1 / bb;
-
-    if (n == 1)
-      {
-	auto x = 0.5 * (a + b);
-	return s = (b - a) * func(1 / x) / (x * x);
-      }
-    else
-      {
-	auto it = 1;
-	for (int j = 1; j < n - 1; ++j)
-          it *= 3;
-	auto tnm = it;
-
-	//  The added points alternate in spacing between del and ddel.
-	auto del = (b - a) / (3 * tnm);
-	auto ddel = 2 * del;
-
-	auto x = a + 0.5 * del;
-	auto sum = 0.0;
-	for (int j = 1; j <= it; ++j)
-          {
-            sum += func(1 / x) / (x * x);
-            x += ddel;
-            sum += func(1 / x) / (x * x);
-            x += del;
-          }
-
-	//  The new sum is combined with the old integral to give a refined integral.
-	return s = (s + (b - a) * sum / tnm) / 3;
-      }
-  }
+  midpoint_inv(Func func, double aa, double bb, int n)
+  { return midpoint_nth(func, aa, bb, n, midpoint_inv_map{}); }
 
 
 /**
  *    This routine is an exact replacement of midpoint except that it allows
- *    for an inverse square root singularity at the upper limit bb.
+ *    for an inverse square root singularity at the lower limit aa.
  */
+template<typename Func = double (*)(double)>
   double
-  midpoint_inv_sqrt_lower(double (*func)(double), double aa, double bb, int n)
-  {
-    static thread_local int lastn;
-    static thread_local double s;
-
-    if (n <= 0)
-      throw std::logic_error("non-positive order in midpoint");
-    if (n != 1 && n != lastn + 1)
-      throw std::logic_error("order out of sequence in midpoint");
-    lastn = n;
-
-    auto a = 0.0;
-    auto b = std::sqrt(bb - aa);
-
-    if (n == 1)
-      {
-	auto x = 0.5 * (a + b);
-	return s = (b - a) * 2 * x * func(aa + x * x);
-      }
-    else
-      {
-	auto it = 1;
-	for (int j = 1; j < n - 1; ++j)
-          it *= 3;
-	auto tnm = it;
-
-	//  The added points alternate in spacing between del and ddel.
-	auto del = (b - a) / (3 * tnm);
-	auto ddel = 2 * del;
-
-	auto x = a + 0.5 * del;
-	auto sum = 0.0;
-	for (int j = 1; j <= it; ++j)
-          {
-            sum += 2 * x * func(aa + x * x);
-            x += ddel;
-            sum += 2 * x * func(aa + x * x);
-            x += del;
-          }
-	//  The new sum is combined with the old integral to give a refined integral.
-	return s = (s + (b - a) * sum / tnm) / 3;
-      }
-  }
+  midpoint_inv_sqrt_lower(Func func, double aa, double bb, int n)
+  { return midpoint_nth(func, aa, bb, n, midpoint_inv_sqrt_lower_map{}); }
 
 
 /**
  *    This routine is an exact replacement of midpoint except that it allows
  *    for an inverse square root singularity at the upper limit bb.
  */
+template<typename Func = double (*)(double)>
   double
-  midpoint_inv_sqrt_upper(double (*func)(double), double aa, double bb, int n)
-  {
-    static thread_local int lastn;
-    static thread_local double s;
-
-    if (n <= 0)
-      throw std::logic_error("non-positive order in midpoint");
-    if (n != 1 && n != lastn + 1)
-      throw std::logic_error("order out of sequence in midpoint");
-    lastn = n;
-
-    auto a = 0.0;
-    auto b = std::sqrt(bb - aa);
-
-    if (n == 1)
-      {
-	auto x = 0.5 * (a + b);
-	return s = (b - a) * 2 * x * func(bb - x*x);
-      }
-    else
-      {
-	auto it = 1;
-	for (int j = 1; j < n - 1; ++j)
-          it *= 3;
-	auto tnm = it;
-
-	//  The added points alternate in spacing between del and ddel.
-	auto del = (b - a) / (3 * tnm);
-	auto ddel = 2 * del;
-
-	auto x = a + 0.5 * del;
-	auto sum = 0.0;
-	for (int j = 1; j <= it; ++j)
-          {
-            sum += 2 * x * func(bb - x * x);
-            x += ddel;
-            sum += 2 * x * func(bb - x * x);
-            x += del;
-          }
-	//  The new sum is combined with the old integral to give a refined integral.
-	return s = (s + (b - a) * sum / tnm) / 3;
-      }
-  }
+  midpoint_inv_sqrt_upper(Func func, double aa, double bb, int n)
+  { return midpoint_nth(func, aa, bb, n, midpoint_inv_sqrt_upper_map{}); }
 
 
 /**
@@ -259,51 +415,10 @@
  *    to be infinite (input value is not actually used).  It is assumed that the
  *    function func decreases exponentially rapidly at infinity.
  */
+template<typename Func = double (*)(double)>
   double
-  midpoint_exp(double (*func)(double), double aa, double bb, int n)
-  {
-    static thread_local int lastn;
-    static thread_local double s;
-
-    if (n <= 0)
-      throw std::logic_error("non-positive order in midpoint");
-    if (n != 1 && n != lastn + 1)
-      throw std::logic_error("order out of sequence in midpoint");
-    lastn = n;
-
-    auto a = 0.0;
-    auto b = std::exp(-aa);
-
-    if (n == 1)
-      {
-	auto x = 0.5 * (a + b);
-	return (s = (b - a) * func(-std::log(x)) / x);
-      }
-    else 
-      {
-	auto it = 1;
-	for (int j = 1; j < n - 1; ++j)
-          it *= 3;
-	auto tnm = it;
-
-	//  The added points alternate in spacing between del and ddel.
-	auto del = (b - a) / (3 * tnm);
-	auto ddel = 2 * del;
-
-	auto x = a + 0.5 * del;
-	auto sum = 0.0;
-	for (int j = 1; j <= it; ++j)
-          {
-            sum += func(-std::log(x)) / x;
-            x += ddel;
-            sum += func(-std::log(x)) / x;
-            x += del;
-          }
-
-	//  The new sum is combined with the old integral to give a refined integral.
-	return s = (s + (b - a) * sum / tnm) / 3;
-      }
-  }
+  midpoint_exp(Func func, double aa, double bb, int n)
+  { return midpoint_nth(func, aa, bb, n, midpoint_exp_map{}); }
 
 
 /**
@@ -311,68 +426,66 @@
  *    to be zero (input value is not actually used).  It is assumed that the
  *    function func has a logarithmic singularity at 0.
  */
+template<typename Func = double (*)(double)>
   double
-  midpoint_log(double (*func)(double), double aa, double bb, int n)
-  {
-    static thread_local int lastn;
-    static thread_local double s;
-
-    if (n <= 0)
-      throw std::logic_error("non-positive order in midpoint");
-    if (n != 1 && n != lastn + 1)
-      throw std::logic_error("order out of sequence in midpoint");
-    lastn = n;
+  midpoint_log(Func func, double aa, double bb, int n)
+  { return midpoint_nth(func, aa, bb, n, midpoint_log_map{}); }
 
-    auto a = -std::log(bb);
-    auto b = -std::log(0.01);
-
-    if (n == 1)
-      {
-	auto x = (a + b) / 2;
-	return (s = -(b - a) * x * func(std::exp(-x)));
-      }
-    else
-      {
-	auto it = 1;
-	for (int j = 1; j < n - 1; ++j)
-          it *= 3;
-	auto tnm = it;
-
-	//  The added points alternate in spacing between del and ddel.
-	auto del = (b - a) / (3 * tnm);
-	auto ddel = 2 * del;
-
-	auto x = a + 0.5 * del;
-	auto sum = 0.0;
-	for (int j = 1; j <= it; ++j)
-          {
-            sum += x * func(std::exp(-x));
-            x += ddel;
-            sum += x * func(std::exp(-x));
-            x += del;
-          }
 
-	//  The new sum is combined with the old integral to give a refined integral.
-	return s = (s - (b - a) * sum / tnm) / 3;
-      }
-  }
+/**
+ *    Polynomial extrapolation to h = 0 of the k estimates s[i] at h[i]
+ *    by Neville's algorithm.  Returns the extrapolated value in ss and the
+ *    last correction, an error estimate, in dss.
+ */
+inline void
+romberg_extrapolate(const double * h, const double * s, int k, double & ss, double & dss)
+{
+  const int KMAX = 16;
+  double c[KMAX], d[KMAX];
+  int ns = 0;
+  auto dif = std::abs(h[0]);
+  for (int i = 0; i < k; ++i)
+    {
+      if (std::abs(h[i]) < dif)
+        {
+          ns = i;
+          dif = std::abs(h[i]);
+        }
+      c[i] = d[i] = s[i];
+    }
+  ss = s[ns--];
+  dss = 0.0;
+  for (int m = 1; m < k; ++m)
+    {
+      for (int i = 0; i < k - m; ++i)
+        {
+          const auto w = (c[i + 1] - d[i]) / (h[i] - h[i + m]);
+          d[i] = h[i + m] * w;
+          c[i] = h[i] * w;
+        }
+      dss = (2 * (ns + 1) < k - m ? c[ns + 1] : d[ns--]);
+      ss += dss;
+    }
+}
 
 
 /**
  *    Runs through n steps of the trapezoid rule integration
  *    of a function func of one real variable from a to b.
  */
+template<typename Func = double (*)(double)>
   double
-  dumb_trapezoid(double (*func)(double), double a, double b, int n, int JMAX = 20)
+  dumb_trapezoid(Func func, double a, double b, int n, int JMAX = 20)
   {
     if (n <= 0)
       throw std::logic_error("non-positive order in dumb_trapezoid");
     if (n > JMAX)
       throw std::logic_error("order too large in dumb_trapezoid");
 
+    trapezoid_stage<Func> stage(func, a, b);
     double s;
     for (int j = 1; j <= n; ++j)
-      s = trapezoid(func, a, b, j);
+      s = stage.next();
 
     return s;
   }
@@ -383,16 +496,18 @@
  *    using trapezoid rule integration.  Integration steps are taken until
  *    the difference between successive steps is less than eps.
  */
+template<typename Func = double (*)(double)>
   double
-  quad_trapezoid(double (*func)(double), double a, double b, double eps, int JMAX = 20)
+  quad_trapezoid(Func func, double a, double b, double eps, int JMAX = 20)
   {
     if (eps <= 0.0)
       throw std::logic_error("error tolerance eps must be greater than 0 in quad_trapezoid");
 
+    trapezoid_stage<Func> stage(func, a, b);
     auto olds = -std::numeric_limits<double>::max();
     for (int j = 1; j <= JMAX; ++j)
       {
-	auto s = trapezoid(func, a, b, j);
+	auto s = stage.next();
 	if (std::abs(s - olds) < eps * std::abs(olds))
           return s;
 	if (std::abs(s) < eps && std::abs(olds) < eps && j > 6)
@@ -410,19 +525,21 @@
  *    Runs through n steps of the Simpson rule integration
  *    of a function func of one real variable from a to b.
  */
+template<typename Func = double (*)(double)>
   double
-  dumb_simpson(double (*func)(double), double a, double b, int n, int JMAX = 20)
+  dumb_simpson(Func func, double a, double b, int n, int JMAX = 20)
   {
     if (n <= 0)
       throw std::logic_error("non-positive order in dumb_simpson");
     if (n > JMAX)
       throw std::logic_error("order too large in dumb_simpson");
 
+    trapezoid_stage<Func> stage(func, a, b);
     auto s = 0.0;
-    auto ost = trapezoid(func, a, b, 1);
+    auto ost = stage.next();
     for (int j = 2; j <= n; ++j)
       {
-	auto st = trapezoid(func, a, b, j);
+	auto st = stage.next();
 	s = (4 * st - ost) / 3;
 	ost = st;
       }
@@ -436,19 +553,21 @@
  *    using Simpson rule integration.  Integration steps are taken until
  *    the difference between successive steps is less than eps.
  */
+template<typename Func = double (*)(double)>
   double
-  quad_simpson(double (*func)(double), double a, double b, double eps)
+  quad_simpson(Func func, double a, double b, double eps)
   {
     const int JMAX = 20;
 
     if (eps <= 0.0)
       throw std::logic_error("error tolerance eps must be greater than 0 in quad_simpson");
 
+    trapezoid_stage<Func> stage(func, a, b);
     auto oldst = -1.0e30;
     auto olds = -1.0e30;
     for (int j = 1; j <= JMAX; ++j)
       {
-	auto st = trapezoid(func, a, b, j);
+	auto st = stage.next();
 	auto s = (4 * st - oldst) / 3;
 	if (std::abs(s - olds) < eps * std::abs(olds))
           return s;
@@ -468,32 +587,32 @@
  *    Runs through n steps of the Romberg integration
  *    of a function func of one real variable from a to b.
  */
+template<typename Func = double (*)(double)>
   double
-  dumb_romberg(double (*func)(double), double a, double b, int n)
+  dumb_romberg(Func func, double a, double b, int n)
   {
     const int K = 5;
     const int JMAX = 20;
 
-    if (n <= 0)
-      throw std::logic_error("non-positive order in dumb_romberg");
+    if (n < K)
+      throw std::logic_error("order too small in dumb_romberg");
     if (n > JMAX)
       throw std::logic_error("order too large in dumb_romberg");
 
     std::vector<double> s(JMAX);
     std::vector<double> h(JMAX + 1);
 
+    trapezoid_stage<Func> stage(func, a, b);
     h[0] = 1.0;
-    double ss, dss;
     for (int j = 0; j < n; ++j)
       {
-	s[j] = trapezoid(func, a, b, j);
-	if (j >= K)
-          {
-            poly_interp(&h[j - K], &s[j - K], K, 0.0, &ss, &dss);
-          }
+	s[j] = stage.next();
 	h[j + 1] = h[j] / 4;
       }
 
+    double ss, dss;
+    romberg_extrapolate(&h[n - K], &s[n - K], K, ss, dss);
+
     return ss;
   }
 
@@ -503,8 +622,9 @@
  *    using Romberg integration.  Integration steps are taken until the
  *    difference between successive steps is less than eps.
  */
+template<typename Func = double (*)(double)>
   double
-  quad_romberg(double (*func)(double), double a, double b, double eps, int JMAX = 20)
+  quad_romberg(Func func, double a, double b, double eps, int JMAX = 20)
   {
     const int K = 5;
 
@@ -514,14 +634,15 @@
     std::vector<double> s(JMAX);
     std::vector<double> h(JMAX + 1);
 
+    trapezoid_stage<Func> stage(func, a, b);
     h[0] = 1.0;
     for (int j = 0; j < JMAX; ++j)
       {
-	s[j] = trapezoid(func, a, b, j);
-	if (j >= K)
+	s[j] = stage.next();
+	if (j + 1 >= K)
           {
             double ss, dss;
-            poly_interp(h.begin() + j - K, s.begin() + j - K, K, 0.0, ss, dss);
+            romberg_extrapolate(&h[j + 1 - K], &s[j + 1 - K], K, ss, dss);
             if (std::abs(dss) < eps * std::abs(ss))
               return ss;
             if (std::abs(dss) < eps && std::abs(ss) < eps && j > 6)
@@ -538,16 +659,15 @@
 
 /**
  *    Romberg integration on an open interval.  Returns the integral of a function
- *    func from a to b using any specified integration routine choose and Romberg's method.
- *    Normally, choose will be an open formula, not evaluating the function at the endpoints.
- *    It is assumed that choose triples the number of steps on each call, and that
- *    it's error series contains only even powers of the steps.  The routines
- *    midpoint, midpoint_inv, midpoint_inv_sqrt_lower, midpoint_inv_sqrt_upper, and
- *    midpoint_exp are possible choices for choose.
+ *    func from a to b using the extended midpoint rule after the change of variables map
+ *    and Romberg's method.  The midpoint rule triples the number of steps on each stage
+ *    and its error series contains only even powers of the steps.  The maps
+ *    midpoint_map, midpoint_inv_map, midpoint_inv_sqrt_lower_map,
+ *    midpoint_inv_sqrt_upper_map, midpoint_exp_map and midpoint_log_map are available.
  */
+template<typename Func = double (*)(double), typename Map = midpoint_map>
   double
-  quad_romberg_open(double (*func)(double), double a, double b, double eps, int JMAX = 14,
-                    double (*choose)(double (*)(double), double, double, int))
+  quad_romberg_open(Func func, double a, double b, double eps, Map map = Map{}, int JMAX = 14)
   {
     const int K = 5;
 
@@ -557,14 +677,15 @@
     std::vector<double> s(JMAX);
     std::vector<double> h(JMAX + 1);
 
+    midpoint_stage<Func, Map> stage(func, a, b, map);
     h[0] = 1.0;
     for (int j = 0; j < JMAX; ++j)
       {
-	s[j] = (*choose)(func, a, b, j);
-	if (j >= K)
+	s[j] = stage.next();
+	if (j + 1 >= K)
           {
             double ss, dss;
-            poly_interp(h.begin() + j - K, s.begin() + j - K, K, 0.0, ss, dss);
+            romberg_extrapolate(&h[j + 1 - K], &s[j + 1 - K], K, ss, dss);
             if (std::abs(dss) < eps * std::abs(ss))
               return ss;
             if (std::abs(dss) < eps && std::abs(ss) < eps && j > K + 1)
@@ -579,4 +700,46 @@
   }
 
 
+/**
+ *    Romberg integration on an open interval with any specified integration routine choose.
+ *    Normally, choose will be an open formula, not evaluating the function at the endpoints.
+ *    It is assumed that choose triples the number of steps on each call, and that
+ *    it's error series contains only even powers of the steps.  The routines
+ *    midpoint, midpoint_inv, midpoint_inv_sqrt_lower, midpoint_inv_sqrt_upper, and
+ *    midpoint_exp are possible choices for choose.
+ */
+inline double
+quad_romberg_open(double (*func)(double), double a, double b, double eps,
+                  double (*choose)(double (*)(double), double, double, int), int JMAX = 14)
+{
+  const int K = 5;
+
+  if (eps <= 0.0)
+    throw std::logic_error("error tolerance eps must be greater than 0 in quad_romberg_open");
+
+  std::vector<double> s(JMAX);
+  std::vector<double> h(JMAX + 1);
+
+  h[0] = 1.0;
+  for (int j = 0; j < JMAX; ++j)
+    {
+      s[j] = (*choose)(func, a, b, j + 1);
+      if (j + 1 >= K)
+        {
+          double ss, dss;
+          romberg_extrapolate(&h[j + 1 - K], &s[j + 1 - K], K, ss, dss);
+          if (std::abs(dss) < eps * std::abs(ss))
+            return ss;
+          if (std::abs(dss) < eps && std::abs(ss) < eps && j > K + 1)
+            return ss;
+        }
+      h[j + 1] = h[j] / 9;
+    }
+
+  throw std::logic_error("too many steps in quad_romberg_open");
+
+  return 0.0;
+}
+
+
 #endif  //  INTEGRATION_TCC
@@ -3,19 +3,25 @@
 
 
 #include <vector>
+#include <array>
 #include <limits>
 #include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
 #include <experimental/optional>
 
 
 /**
- *  
+ *  Given arrays xa[0..n-1] and ya[0..n-1], and given a value x, this routine returns
+ *  a value of y and an accuracy estimate dy.  The value returned is that of the
+ *  polynomial of degree n - 1 through the n points (xa[i], ya[i]), i = 0..n-1.
  */
 template<typename RealTp>
   void
-  polynomial_interp(RealTp *xa, RealTp *ya, int n, RealTp x, RealTp & y, RealTp & dy)
+  polynomial_interp(const RealTp *xa, const RealTp *ya, int n, RealTp x, RealTp & y, RealTp & dy)
   {
-    int ns = 1;
+    int ns = 0;
 
     std::vector<RealTp> c(n);
     std::vector<RealTp> d(n);
@@ -23,7 +29,7 @@ template<typename RealTp>
     auto dif = std::fabs(x - xa[0]);
 
     //  Here we find the index of the closest table entry,
-    for (i = 0; i < n; ++i)
+    for (int i = 0; i < n; ++i)
       {
         auto dift = std::fabs(x - xa[i]);
         if (dift < dif)
@@ -37,9 +43,10 @@ template<typename RealTp>
 
     //  This is the initial approximation to y.
     y = ya[ns--];
+    dy = RealTp(0);
 
     //  For each column of the tableau, loop over the current c's and d's and update them.
-    for (int m = 0; m < n - 1; ++m)
+    for (int m = 1; m < n; ++m)
       {
         for (int i = 0; i < n - m; ++i)
           {
@@ -55,7 +62,7 @@ template<typename RealTp>
             d[i] = hp * den;
             c[i] = ho * den;
         }
-        y += (dy = (2 * ns < (n - m) ? c[ns + 1] : d[ns--]));
+        y += (dy = (2 * (ns + 1) < (n - m) ? c[ns + 1] : d[ns--]));
       }
 
     return;
@@ -64,26 +71,26 @@ template<typename RealTp>
 
 
 /**
- *    Given arrays xa[1..n] and ya[1..n], and given a value x, this routine returns
- *    a value of y and an accuracy estimate dy.  The value returned is that of the 
+ *    Given arrays xa[0..n-1] and ya[0..n-1], and given a value x, this routine returns
+ *    a value of y and an accuracy estimate dy.  The value returned is that of the
  *    diagonal rational function, evaluated at x, which passes through the
- *    n points (xa[i], ya[i]), i = 1..n.
+ *    n points (xa[i], ya[i]), i = 0..n-1.
  */
 template<typename RealTp>
   void
-  rational_interp(RealTp *xa, RealTp *ya, int n, RealTp x, RealTp & y, RealTp & dy)
+  rational_interp(const RealTp *xa, const RealTp *ya, int n, RealTp x, RealTp & y, RealTp & dy)
   {
 
-    int ns = 1;
+    int ns = 0;
     const RealTp TINY = 1.0e-25;
 
     std::vector<RealTp> c(n);
     std::vector<RealTp> d(n);
 
-    auto hh = std::fabs(x - xa[1]);
-    for (i = 1; i <= n; ++i)
+    auto hh = std::fabs(x - xa[0]);
+    for (int i = 0; i < n; ++i)
       {
-        h = std::fabs(x - xa[i]);
+        auto h = std::fabs(x - xa[i]);
         if (h == 0)
           {
             y = ya[i];
@@ -100,15 +107,16 @@ template<typename RealTp>
         d[i] = ya[i] + TINY;
       }
     y = ya[ns--];
+    dy = RealTp(0);
     for (int m = 1; m < n; ++m)
       {
-        for (int i = 1; i <= n - m; ++i)
+        for (int i = 0; i < n - m; ++i)
           {
             auto w = c[i + 1] - d[i];
             auto h = xa[i + m] - x;
             auto t = (xa[i] - x) * d[i] / h;
             auto dd = t - c[i + 1];
-            //  This error condition indicated that the interpolating function has a pole 
+            //  This error condition indicated that the interpolating function has a pole
             //  at the requested value of x.
             if (dd == 0)
               throw std::logic_error("error in rational_interp");
@@ -116,7 +124,7 @@ template<typename RealTp>
             d[i] = c[i + 1] * dd;
             c[i] = t * dd;
           }
-        y += (dy = (2 * ns < (n - m) ? c[ns + 1] : d[ns--]));
+        y += (dy = (2 * (ns + 1) < (n - m) ? c[ns + 1] : d[ns--]));
       }
 
     return;
@@ -124,28 +132,28 @@ template<typename RealTp>
 
 
 /**
- *  Given arrays x[1..n] and y[1..n] containing a tabulated function, i.e. y[i] = f(x[i]), with monatonically increasing
- *  values of x[i], and given the values yp1, and ypn for the first derivatives of the function at points 1 and n 
- *  respectively, this routine returns the an array ypp[1..n] that contains the second derivatives of the interpolating 
- *  function at the tabulated points x[i].  If yp1 and/or ypn are equal to 1.0e30 or larger, the routine is signalled to 
+ *  Given arrays x[0..n-1] and y[0..n-1] containing a tabulated function, i.e. y[i] = f(x[i]), with monatonically increasing
+ *  values of x[i], and given the optional values yp1, and ypn for the first derivatives of the function at points 0 and n-1
+ *  respectively, this routine returns the an array ypp[0..n-1] that contains the second derivatives of the interpolating
+ *  function at the tabulated points x[i].  If yp1 and/or ypn are empty, the routine is signalled to
  *  set the corresponding boundary condition for a natural spline, with zero second derivative at that boundary.
  */
 template<typename RealTp>
   void
-  cubic_spline(RealTp *x, RealTp *y, int n,
+  cubic_spline(const RealTp *x, const RealTp *y, int n,
          std::experimental::optional<RealTp> yp1,
          std::experimental::optional<RealTp> ypn, RealTp *ypp)
   {
-    std::vector<RealTp> u(n - 2);
+    std::vector<RealTp> u(n - 1);
 
     //  The lower boundary condition is set to either the natural one or
     //  to match a specified first derivative.
-    if (yp1)
+    if (!yp1)
       ypp[0] = u[0] = 0;
     else
       {
         ypp[0] = -0.5;
-        u[0] = (3 / (x[1] - x[0])) * ((y[1] - y[0]) / (x[1] - x[0]) - yp1);
+        u[0] = (3 / (x[1] - x[0])) * ((y[1] - y[0]) / (x[1] - x[0]) - *yp1);
       }
 
     //  Decomposition of the tridiagonal system.
@@ -160,16 +168,14 @@ template<typename RealTp>
 
     //  The upper boundary condition is set to either the natural one or
     //  to match a specified first derivative.
-    RealTp qn, un;
+    RealTp qn = 0, un = 0;
     if (ypn)
-      ypp[n - 1] = 0;
-    else
       {
-        auto qn = 0.5;
-        auto un = (3 / (x[n - 1] - x[n - 2]))
-                * (ypn - (y[n - 1] - y[n - 2]) / (x[n - 1] - x[n - 2]));
-        ypp[n - 1] = (un - qn * u[n - 2]) / (qn * ypp[n - 2] + 1);
+        qn = 0.5;
+        un = (3 / (x[n - 1] - x[n - 2]))
+           * (*ypn - (y[n - 1] - y[n - 2]) / (x[n - 1] - x[n - 2]));
       }
+    ypp[n - 1] = (un - qn * u[n - 2]) / (qn * ypp[n - 2] + 1);
 
     //  This is the backsubstitution loop of the tridiagonal algorithm.
     for (int j = n - 2; j >= 0; --j)
@@ -178,45 +184,25 @@ template<typename RealTp>
 
 
 /**
- *  Given the arrays xa[1..na], ya[1..na] which tabulate a function (with the x[i]'s in order), and given the array 
- *  yapp[1..na] which is the output from cubic_spline above, and given a value of x, this routine returns a cubic-spline 
- *  interpolated value y.
+ *  Given the arrays xa[0..na-1], ya[0..na-1] which tabulate a function (with the x[i]'s in order), and given the array
+ *  yapp[0..na-1] which is the output from cubic_spline above, and given a value of x, this routine returns a cubic-spline
+ *  interpolated value y.  The table is bisected on every call; use cubic_spline_interpolator below
+ *  for repeated queries into the same table.
  */
 template<typename RealTp>
   RealTp
-  cubic_spline_interp(RealTp *xa, RealTp *ya, RealTp *yapp, int na, RealTp x)
+  cubic_spline_interp(const RealTp *xa, const RealTp *ya, const RealTp *yapp, int na, RealTp x)
   {
-    //  Store the last values of klo and khi to see if they still work on subsequent calls.
-    //  Also store the last number of points to watch out for new spline data.
-    //  If the old points don't work reset them to the endpoints.
-    //  In either case, refine klo and khi with bisection.
-    static int naold = 0;
-    static int kloold;
-    static int khiold;
-
-    //  If the number of points has changed then spline was rerun or a new set of points
-    //  is being provided.  To prevent the arrays being indexed to an illegal value and
-    // to reflect the arrival of new data reset the values of kloold and khiold and naold.
-    if (naold != na)
-      {
-        naold = na;
-        kloold = 1;
-        khiold = na;
-      }
-
-    int klo = (x > xa[kloold] ? kloold : 1);
-    int khi = (x < xa[khiold] ? khiold : na);
+    int klo = 0;
+    int khi = na - 1;
     while (khi - klo > 1)
       {
-
         auto k = (khi + klo) >> 1;
         if (xa[k] > x)
           khi = k;
         else
           klo = k;
       }
-    kloold = klo;
-    khiold = khi;
 
     auto h = xa[khi] - xa[klo];
     if (h == 0)
@@ -233,57 +219,428 @@ template<typename RealTp>
 
 
 /**
- *  Given the arrays xa[1..na], ya[1..na] which tabulate a function (with the xa's in order), 
+ *  Given the arrays xa[0..na-1], ya[0..na-1] which tabulate a function (with the xa's in order),
  *  and given a value of x, this routine returns a simple linear interpolated value y.
+ *  The table is bisected on every call; use linear_interpolator below for repeated queries.
  */
 template<typename RealTp>
   RealTp
-  linear_interp(RealTp *xa, RealTp *ya, int na, RealTp x)
+  linear_interp(const RealTp *xa, const RealTp *ya, int na, RealTp x)
   {
-    int k, klo, khi;
-    RealTp h, b, a;
-
-    //  Store the last values of klo and khi to see if they still work.
-    //  Also store the last number of points to watch out for new spline data.
-    //  If the old points don't work reset them to the endpoints.
-    //  In either case, refine klo and khi with bisection.
-    static int naold = 0;
-    static int kloold;
-    static int khiold;
-
-    //  If the number of points has changed then spline was rerun or a new set of points
-    //  is being provided.  To prevent the arrays being indexed to an illegal value and
-    //  to reflect the arrival of new data reset the values of kloold and khiold and naold.
-    if (naold != na)
-      {
-        naold = na;
-        kloold = 1;
-        khiold = na;
-      }
-
-    klo = (x > xa[kloold] ? kloold : 1);
-    khi = (x < xa[khiold] ? khiold : na);
+    int klo = 0;
+    int khi = na - 1;
     while (khi - klo > 1)
       {
-
-        k = (khi + klo) >> 1;
+        auto k = (khi + klo) >> 1;
         if (xa[k] > x)
           khi = k;
         else
           klo = k;
       }
-    kloold = klo;
-    khiold = khi;
 
-    h = xa[khi] - xa[klo];
+    auto h = xa[khi] - xa[klo];
 
     if (h == 0)
       throw std::logic_error("bad xa input to linear_interp");
 
-    a = (xa[khi] - x) / h;
-    b = (x - xa[klo]) / h;
+    auto a = (xa[khi] - x) / h;
+    auto b = (x - xa[klo]) / h;
     return a * ya[klo] + b * ya[khi];
   }
 
 
+/**
+ *  The abscissas of an interpolation table and the search for the interval
+ *  [x[j], x[j+1]] to use for a query point.
+ *
+ *  Each search starts from the interval found by the previous one and hunts
+ *  outward from it, so a monotone stream of queries costs O(1) per point
+ *  instead of the O(log n) of a fresh bisection.  When successive queries are
+ *  found to be uncorrelated the search reverts to bisection of the whole table
+ *  until they are local again.  An equally spaced table is
+ *  detected at construction and located by direct division.
+ *  Points outside the table use the first or last interval.
+ *
+ *  The cursor makes the search stateful: a grid must not be shared between threads.
+ */
+template<typename RealTp>
+  class interp_grid
+  {
+  public:
+
+    interp_grid(const RealTp *x, int n)
+    : m_x(x, x + n)
+    {
+      if (n < 2)
+        throw std::logic_error("interp_grid: at least two points are required");
+      for (int i = 1; i < n; ++i)
+        if (!(m_x[i] > m_x[i - 1]))
+          throw std::logic_error("interp_grid: abscissas must be strictly increasing");
+
+      //  The direct estimate may be off by one interval; locate() corrects that.
+      const RealTp h = (m_x[n - 1] - m_x[0]) / (n - 1);
+      this->m_uniform = true;
+      for (int i = 1; i < n - 1; ++i)
+        if (std::abs(m_x[i] - (m_x[0] + i * h)) > h / 100)
+          {
+            this->m_uniform = false;
+            break;
+          }
+      this->m_inv_h = 1 / h;
+      this->m_dj = std::max(1, int(std::pow(RealTp(n), RealTp(0.25))));
+    }
+
+    int
+    size() const
+    { return this->m_x.size(); }
+
+    bool
+    uniform() const
+    { return this->m_uniform; }
+
+    const RealTp *
+    data() const
+    { return this->m_x.data(); }
+
+    /**
+     *  Return the index j, 0 <= j <= n - 2, of the interval containing x.
+     */
+    int
+    locate(RealTp x)
+    {
+      if (this->m_uniform)
+        return this->direct(x);
+      else
+        return this->search(x);
+    }
+
+    /**
+     *  Locate each of the n points in x, writing the interval indices to j.
+     */
+    void
+    locate(const RealTp *x, int *j, std::size_t n)
+    {
+      if (this->m_uniform)
+        for (std::size_t i = 0; i < n; ++i)
+          j[i] = this->direct(x[i]);
+      else
+        for (std::size_t i = 0; i < n; ++i)
+          j[i] = this->search(x[i]);
+    }
+
+  private:
+
+    /**
+     *  O(1) location in an equally spaced table.
+     *  The clamp is done in floating point so that NaN and huge x stay in range.
+     */
+    int
+    direct(RealTp x) const
+    {
+      const int jmax = this->size() - 2;
+      const RealTp *xa = this->m_x.data();
+      RealTp t = (x - xa[0]) * this->m_inv_h;
+      t = std::min(std::max(RealTp(0), t), RealTp(jmax));
+      int j = int(t);
+      j -= int(x < xa[j]) & int(j > 0);
+      j += int(x >= xa[j + 1]) & int(j < jmax);
+      return j;
+    }
+
+    /**
+     *  Hunt from the last interval if the recent queries were close together
+     *  and bisect the whole table otherwise.
+     */
+    int
+    search(RealTp x)
+    {
+      const int j = this->m_cor ? this->hunt(x) : this->bisect(x, 0, this->size() - 1);
+      this->m_cor = std::abs(j - this->m_jsav) <= this->m_dj;
+      return this->m_jsav = j;
+    }
+
+    /**
+     *  Bisect the bracket xa[jl] <= x < xa[ju].
+     */
+    int
+    bisect(RealTp x, int jl, int ju) const
+    {
+      const RealTp *xa = this->m_x.data();
+      while (ju - jl > 1)
+        {
+          int jm = (ju + jl) >> 1;
+          if (x >= xa[jm])
+            jl = jm;
+          else
+            ju = jm;
+        }
+      return jl;
+    }
+
+    /**
+     *  Search outward from the last interval with steps 1, 2, 4, ...
+     *  until x is bracketed, then bisect the bracket.
+     */
+    int
+    hunt(RealTp x) const
+    {
+      const int jmax = this->size() - 2;
+      const RealTp *xa = this->m_x.data();
+      int jl = this->m_jsav;
+      int ju;
+      if (x >= xa[jl + 1])
+        {
+          if (jl == jmax)
+            return jl;
+          ++jl;
+          int inc = 1;
+          while (true)
+            {
+              ju = jl + inc;
+              if (ju >= jmax + 1)
+                {
+                  ju = jmax + 1;
+                  if (x >= xa[ju])
+                    return jmax;
+                  break;
+                }
+              if (x < xa[ju])
+                break;
+              jl = ju;
+              inc += inc;
+            }
+        }
+      else if (x < xa[jl])
+        {
+          if (jl == 0)
+            return jl;
+          ju = jl;
+          int inc = 1;
+          while (true)
+            {
+              jl = ju - inc;
+              if (jl <= 0)
+                {
+                  jl = 0;
+                  break;
+                }
+              if (x >= xa[jl])
+                break;
+              ju = jl;
+              inc += inc;
+            }
+        }
+      else
+        return jl;
+
+      return this->bisect(x, jl, ju);
+    }
+
+    std::vector<RealTp> m_x;
+    RealTp m_inv_h;
+    bool m_uniform;
+    int m_dj;
+    int m_jsav = 0;
+    bool m_cor = false;
+  };
+
+
+/**
+ *  Horner's rule for the power series c[0][j] + t * (c[1][j] + ...), unrolled at compile time
+ *  so that a loop over points with K constant vectorizes.
+ */
+template<typename RealTp, int K>
+  struct interp_horner
+  {
+    static RealTp
+    eval(const RealTp *const *c, int j, RealTp t, RealTp s)
+    { return interp_horner<RealTp, K - 1>::eval(c, j, t, s * t + c[K - 1][j]); }
+  };
+
+template<typename RealTp>
+  struct interp_horner<RealTp, 0>
+  {
+    static RealTp
+    eval(const RealTp *const *, int, RealTp, RealTp s)
+    { return s; }
+  };
+
+
+/**
+ *  A piecewise polynomial of degree Degree on the intervals of an interp_grid,
+ *  stored as the coefficients of a power series in (x - x[j]) for each interval j.
+ *
+ *  The batch evaluate() locates a block of points first and then evaluates
+ *  the polynomials in a separate loop which the compiler can vectorize with gathers.
+ */
+template<typename RealTp, int Degree>
+  class piecewise_poly_interpolator
+  {
+  public:
+
+    /**
+     *  Return the interpolated value at x.
+     */
+    RealTp
+    operator()(RealTp x)
+    { return this->eval(this->m_grid.locate(x), x); }
+
+    /**
+     *  Interpolate the n points in x into y.
+     */
+    void
+    evaluate(const RealTp *x, RealTp *y, std::size_t n)
+    {
+      const std::size_t BLOCK = 256;
+      int j[BLOCK];
+      for (std::size_t i0 = 0; i0 < n; i0 += BLOCK)
+        {
+          const std::size_t nb = std::min(BLOCK, n - i0);
+          this->m_grid.locate(x + i0, j, nb);
+          this->eval(j, x + i0, y + i0, nb);
+        }
+    }
+
+    const interp_grid<RealTp> &
+    grid() const
+    { return this->m_grid; }
+
+  protected:
+
+    piecewise_poly_interpolator(const RealTp *x, int n)
+    : m_grid(x, n)
+    {
+      for (auto & c : this->m_coef)
+        c.resize(n - 1);
+    }
+
+    RealTp
+    eval(int j, RealTp x) const
+    {
+      const RealTp t = x - this->m_grid.data()[j];
+      RealTp y = this->m_coef[Degree][j];
+      for (int k = Degree - 1; k >= 0; --k)
+        y = y * t + this->m_coef[k][j];
+      return y;
+    }
+
+    void
+    eval(const int *j, const RealTp *x, RealTp *y, std::size_t n) const
+    {
+      const RealTp *xa = this->m_grid.data();
+      const RealTp *c[Degree + 1];
+      for (int k = 0; k <= Degree; ++k)
+        c[k] = this->m_coef[k].data();
+      for (std::size_t i = 0; i < n; ++i)
+        {
+          const int jj = j[i];
+          y[i] = interp_horner<RealTp, Degree>::eval(c, jj, x[i] - xa[jj], c[Degree][jj]);
+        }
+    }
+
+    interp_grid<RealTp> m_grid;
+    std::array<std::vector<RealTp>, Degree + 1> m_coef;
+  };
+
+
+/**
+ *  Linear interpolation in the table (x[i], y[i]), i = 0..n-1.
+ */
+template<typename RealTp>
+  class linear_interpolator
+  : public piecewise_poly_interpolator<RealTp, 1>
+  {
+  public:
+
+    linear_interpolator(const RealTp *x, const RealTp *y, int n)
+    : piecewise_poly_interpolator<RealTp, 1>(x, n)
+    {
+      for (int j = 0; j < n - 1; ++j)
+        {
+          this->m_coef[0][j] = y[j];
+          this->m_coef[1][j] = (y[j + 1] - y[j]) / (x[j + 1] - x[j]);
+        }
+    }
+  };
+
+
+/**
+ *  Cubic spline interpolation in the table (x[i], y[i]), i = 0..n-1.
+ *  The optional yp1 and ypn are the first derivatives at the ends, as in cubic_spline;
+ *  an empty one gives the natural boundary condition.
+ *  The second derivatives are converted to per-interval cubics once at construction.
+ */
+template<typename RealTp>
+  class cubic_spline_interpolator
+  : public piecewise_poly_interpolator<RealTp, 3>
+  {
+  public:
+
+    cubic_spline_interpolator(const RealTp *x, const RealTp *y, int n,
+                              std::experimental::optional<RealTp> yp1 = {},
+                              std::experimental::optional<RealTp> ypn = {})
+    : piecewise_poly_interpolator<RealTp, 3>(x, n)
+    {
+      std::vector<RealTp> ypp(n);
+      cubic_spline(x, y, n, yp1, ypn, ypp.data());
+      for (int j = 0; j < n - 1; ++j)
+        {
+          const RealTp h = x[j + 1] - x[j];
+          this->m_coef[0][j] = y[j];
+          this->m_coef[1][j] = (y[j + 1] - y[j]) / h - h * (2 * ypp[j] + ypp[j + 1]) / 6;
+          this->m_coef[2][j] = ypp[j] / 2;
+          this->m_coef[3][j] = (ypp[j + 1] - ypp[j]) / (6 * h);
+        }
+    }
+  };
+
+
+/**
+ *  Local polynomial interpolation of order m (degree m - 1) in the table (x[i], y[i]), i = 0..n-1,
+ *  using the m table points centred on the query as in polynomial_interp.
+ *  The error estimate of the last query is available from error().
+ */
+template<typename RealTp>
+  class polynomial_interpolator
+  {
+  public:
+
+    polynomial_interpolator(const RealTp *x, const RealTp *y, int n, int m)
+    : m_grid(x, n), m_y(y, y + n), m_m(m)
+    {
+      if (m < 2 || m > n)
+        throw std::logic_error("polynomial_interpolator: order out of range");
+    }
+
+    RealTp
+    operator()(RealTp x)
+    {
+      const int n = this->m_grid.size();
+      const int j = this->m_grid.locate(x);
+      const int jl = std::max(0, std::min(n - this->m_m, j - (this->m_m - 2) / 2));
+      RealTp y;
+      polynomial_interp(this->m_grid.data() + jl, this->m_y.data() + jl, this->m_m, x, y, this->m_dy);
+      return y;
+    }
+
+    void
+    evaluate(const RealTp *x, RealTp *y, std::size_t n)
+    {
+      for (std::size_t i = 0; i < n; ++i)
+        y[i] = (*this)(x[i]);
+    }
+
+    RealTp
+    error() const
+    { return this->m_dy; }
+
+  private:
+
+    interp_grid<RealTp> m_grid;
+    std::vector<RealTp> m_y;
+    int m_m;
+    RealTp m_dy = RealTp(0);
+  };
+
+
 #endif // INTERPOLATION_TCC
@@ -123,6 +123,8 @@ template<typename Tp>
 
 }  //  namespace matrix
 
+#include "matrix_triangular_solve.tcc"
+
 #include "matrix_lu_decomp.tcc"
 
 #include "matrix_qr_decomp.tcc"
@@ -131,3 +133,5 @@ template<typename Tp>
 
 #include "matrix_cholesky_decomp.tcc"
 
+#include "matrix_batched_solve.tcc"
+
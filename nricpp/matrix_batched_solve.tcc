@@ -0,0 +1,361 @@
+#ifndef BATCHED_SOLVE_TCC
+#define BATCHED_SOLVE_TCC 1
+
+
+#include <cstdlib>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+
+namespace matrix
+{
+
+
+/**
+ *  The number of small systems solved together by the batched solvers.
+ *  One cache line of each matrix element is held across the systems
+ *  so the loops over the systems map onto full vector registers.
+ */
+template<typename NumTp>
+  constexpr std::size_t batch_lanes = 64 / sizeof(NumTp) < 4 ? 4 : 64 / sizeof(NumTp);
+
+
+/**
+ *  Solve the N x N system a.x = b in place by LU decomposition with partial pivoting.
+ *  The size is a template parameter so all loops have fixed trip counts and
+ *  the compiler unrolls them and keeps a small matrix in registers.
+ *  a[0..N-1][0..N-1] is destroyed and b[0..N-1] is replaced by the solution.
+ *  Returns false if a zero pivot was found (it is replaced by a tiny number
+ *  as in lu_decomp()).
+ */
+template<std::size_t N, typename NumTp>
+  bool
+  lu_solve_small(NumTp (&a)[N][N], NumTp (&b)[N])
+  {
+    const NumTp TINY = NumTp(1.0e-20L);
+
+    bool ok = true;
+    for (std::size_t k = 0; k < N; ++k)
+      {
+        std::size_t p = k;
+        NumTp big = std::abs(a[k][k]);
+        for (std::size_t i = k + 1; i < N; ++i)
+          if (std::abs(a[i][k]) > big)
+            {
+              big = std::abs(a[i][k]);
+              p = i;
+            }
+        if (p != k)
+          {
+            for (std::size_t j = k; j < N; ++j)
+              std::swap(a[k][j], a[p][j]);
+            std::swap(b[k], b[p]);
+          }
+        if (a[k][k] == NumTp(0))
+          {
+            a[k][k] = TINY;
+            ok = false;
+          }
+
+        const NumTp rpiv = NumTp(1) / a[k][k];
+        for (std::size_t i = k + 1; i < N; ++i)
+          {
+            const NumTp f = a[i][k] * rpiv;
+            for (std::size_t j = k + 1; j < N; ++j)
+              a[i][j] -= f * a[k][j];
+            b[i] -= f * b[k];
+          }
+      }
+
+    for (std::size_t i = N; i-- > 0; )
+      {
+        NumTp sum = b[i];
+        for (std::size_t j = i + 1; j < N; ++j)
+          sum -= a[i][j] * b[j];
+        b[i] = sum / a[i][i];
+      }
+
+    return ok;
+  }
+
+
+/**
+ *  Solve the N x N symmetric positive definite system a.x = b in place
+ *  by Cholesky decomposition.  Only the lower triangle of a is used and it is
+ *  overwritten by the factor.  Returns false, leaving b unchanged,
+ *  if the matrix is not positive definite.
+ */
+template<std::size_t N, typename NumTp>
+  bool
+  cholesky_solve_small(NumTp (&a)[N][N], NumTp (&b)[N])
+  {
+    for (std::size_t k = 0; k < N; ++k)
+      {
+        NumTp sum = a[k][k];
+        for (std::size_t p = 0; p < k; ++p)
+          sum -= a[k][p] * a[k][p];
+        if (!(sum > NumTp(0)))
+          return false;
+        a[k][k] = std::sqrt(sum);
+        const NumTp rdiag = NumTp(1) / a[k][k];
+        for (std::size_t i = k + 1; i < N; ++i)
+          {
+            NumTp s = a[i][k];
+            for (std::size_t p = 0; p < k; ++p)
+              s -= a[i][p] * a[k][p];
+            a[i][k] = s * rdiag;
+          }
+      }
+
+    for (std::size_t i = 0; i < N; ++i)
+      {
+        NumTp sum = b[i];
+        for (std::size_t k = 0; k < i; ++k)
+          sum -= a[i][k] * b[k];
+        b[i] = sum / a[i][i];
+      }
+    for (std::size_t i = N; i-- > 0; )
+      {
+        NumTp sum = b[i];
+        for (std::size_t k = i + 1; k < N; ++k)
+          sum -= a[k][i] * b[k];
+        b[i] = sum / a[i][i];
+      }
+
+    return true;
+  }
+
+
+/**
+ *  Solve count independent N x N systems a_s.x_s = b_s by LU decomposition
+ *  with partial pivoting.  The matrices are stored one after another row-major
+ *  in a[0..count*N*N-1] and the right-hand sides in b[0..count*N-1] which
+ *  is replaced by the solutions.
+ *
+ *  The systems are done batch_lanes at a time: each group is transposed
+ *  so that element (i, j) of every system in the group is contiguous and
+ *  the elimination runs across the systems.  Each system still gets its own
+ *  pivot and its rows are interchanged one system at a time.
+ *  A short last group is padded with identity systems.
+ *  Returns the number of systems in which a zero pivot was found
+ *  (it is replaced by a tiny number as in lu_decomp()).
+ */
+template<std::size_t N, typename NumTp>
+  std::size_t
+  lu_solve_batch(std::size_t count, const NumTp * a, NumTp * b)
+  {
+    constexpr std::size_t L = batch_lanes<NumTp>;
+    const NumTp TINY = NumTp(1.0e-20L);
+
+    std::size_t num_singular = 0;
+    for (std::size_t s0 = 0; s0 < count; s0 += L)
+      {
+        const std::size_t nl = std::min(L, count - s0);
+        const NumTp * as = a + s0 * N * N;
+        NumTp * bs = b + s0 * N;
+
+        alignas(64) NumTp aa[N][N][L];
+        alignas(64) NumTp bb[N][L];
+        for (std::size_t i = 0; i < N; ++i)
+          {
+            for (std::size_t j = 0; j < N; ++j)
+              {
+                for (std::size_t l = 0; l < nl; ++l)
+                  aa[i][j][l] = as[l * N * N + i * N + j];
+                for (std::size_t l = nl; l < L; ++l)
+                  aa[i][j][l] = NumTp(i == j ? 1 : 0);
+              }
+            for (std::size_t l = 0; l < nl; ++l)
+              bb[i][l] = bs[l * N + i];
+            for (std::size_t l = nl; l < L; ++l)
+              bb[i][l] = NumTp(0);
+          }
+
+        alignas(64) NumTp sing[L] = {};
+        for (std::size_t k = 0; k < N; ++k)
+          {
+            //  Find the pivot row of each system.
+            alignas(64) NumTp big[L];
+            alignas(64) NumTp piv[L];
+            for (std::size_t l = 0; l < L; ++l)
+              {
+                big[l] = std::abs(aa[k][k][l]);
+                piv[l] = NumTp(k);
+              }
+            for (std::size_t i = k + 1; i < N; ++i)
+              for (std::size_t l = 0; l < L; ++l)
+                {
+                  const NumTp t = std::abs(aa[i][k][l]);
+                  const NumTp gt = NumTp(t > big[l]);
+                  big[l] = std::max(t, big[l]);
+                  piv[l] += gt * (NumTp(i) - piv[l]);
+                }
+
+            //  Interchange rows k and piv in each system.  At most one row moves
+            //  in each system so this is done system by system: a masked blend
+            //  over all the rows would cost as much as the elimination.
+            for (std::size_t l = 0; l < L; ++l)
+              {
+                const std::size_t p = std::size_t(piv[l]);
+                if (p != k)
+                  {
+                    for (std::size_t j = k; j < N; ++j)
+                      std::swap(aa[k][j][l], aa[p][j][l]);
+                    std::swap(bb[k][l], bb[p][l]);
+                  }
+              }
+
+            alignas(64) NumTp rpiv[L];
+            for (std::size_t l = 0; l < L; ++l)
+              {
+                const NumTp zero = NumTp(aa[k][k][l] == NumTp(0));
+                sing[l] = std::max(sing[l], zero);
+                aa[k][k][l] += zero * TINY;
+                rpiv[l] = NumTp(1) / aa[k][k][l];
+              }
+
+            //  Eliminate below the pivot.  The pivot row is copied out first:
+            //  updating rows of the same array would need runtime overlap checks,
+            //  which the cheap vectorizer of -O2 does not add.
+            alignas(64) NumTp prow[N][L];
+            alignas(64) NumTp pb[L];
+            for (std::size_t j = k + 1; j < N; ++j)
+              for (std::size_t l = 0; l < L; ++l)
+                prow[j][l] = aa[k][j][l];
+            for (std::size_t l = 0; l < L; ++l)
+              pb[l] = bb[k][l];
+            for (std::size_t i = k + 1; i < N; ++i)
+              {
+                alignas(64) NumTp f[L];
+                for (std::size_t l = 0; l < L; ++l)
+                  f[l] = aa[i][k][l] * rpiv[l];
+                for (std::size_t j = k + 1; j < N; ++j)
+                  for (std::size_t l = 0; l < L; ++l)
+                    aa[i][j][l] -= f[l] * prow[j][l];
+                for (std::size_t l = 0; l < L; ++l)
+                  bb[i][l] -= f[l] * pb[l];
+              }
+          }
+
+        //  Back substitution, accumulated apart from bb for the same reason.
+        for (std::size_t i = N; i-- > 0; )
+          {
+            alignas(64) NumTp sum[L];
+            for (std::size_t l = 0; l < L; ++l)
+              sum[l] = bb[i][l];
+            for (std::size_t j = i + 1; j < N; ++j)
+              for (std::size_t l = 0; l < L; ++l)
+                sum[l] -= aa[i][j][l] * bb[j][l];
+            for (std::size_t l = 0; l < L; ++l)
+              bb[i][l] = sum[l] / aa[i][i][l];
+          }
+
+        for (std::size_t i = 0; i < N; ++i)
+          for (std::size_t l = 0; l < nl; ++l)
+            bs[l * N + i] = bb[i][l];
+        for (std::size_t l = 0; l < nl; ++l)
+          num_singular += sing[l] != NumTp(0);
+      }
+
+    return num_singular;
+  }
+
+
+/**
+ *  Solve count independent N x N symmetric positive definite systems
+ *  a_s.x_s = b_s by Cholesky decomposition.  The storage and batching are
+ *  as for lu_solve_batch(); only the lower triangle of each matrix is read.
+ *  The solution of a system that is not positive definite is set to NaN.
+ *  Returns the number of such systems.
+ */
+template<std::size_t N, typename NumTp>
+  std::size_t
+  cholesky_solve_batch(std::size_t count, const NumTp * a, NumTp * b)
+  {
+    constexpr std::size_t L = batch_lanes<NumTp>;
+
+    std::size_t num_failed = 0;
+    for (std::size_t s0 = 0; s0 < count; s0 += L)
+      {
+        const std::size_t nl = std::min(L, count - s0);
+        const NumTp * as = a + s0 * N * N;
+        NumTp * bs = b + s0 * N;
+
+        alignas(64) NumTp aa[N][N][L];
+        alignas(64) NumTp bb[N][L];
+        for (std::size_t i = 0; i < N; ++i)
+          {
+            for (std::size_t j = 0; j <= i; ++j)
+              {
+                for (std::size_t l = 0; l < nl; ++l)
+                  aa[i][j][l] = as[l * N * N + i * N + j];
+                for (std::size_t l = nl; l < L; ++l)
+                  aa[i][j][l] = NumTp(i == j ? 1 : 0);
+              }
+            for (std::size_t l = 0; l < nl; ++l)
+              bb[i][l] = bs[l * N + i];
+            for (std::size_t l = nl; l < L; ++l)
+              bb[i][l] = NumTp(0);
+          }
+
+        //  Factor; a failed system gets a unit pivot so the others are unaffected.
+        bool failed[L] = {};
+        for (std::size_t k = 0; k < N; ++k)
+          {
+            alignas(64) NumTp sum[L];
+            alignas(64) NumTp rdiag[L];
+            for (std::size_t l = 0; l < L; ++l)
+              sum[l] = aa[k][k][l];
+            for (std::size_t p = 0; p < k; ++p)
+              for (std::size_t l = 0; l < L; ++l)
+                sum[l] -= aa[k][p][l] * aa[k][p][l];
+            for (std::size_t l = 0; l < L; ++l)
+              {
+                const bool bad = !(sum[l] > NumTp(0));
+                failed[l] = failed[l] || bad;
+                aa[k][k][l] = std::sqrt(bad ? NumTp(1) : sum[l]);
+                rdiag[l] = NumTp(1) / aa[k][k][l];
+              }
+            for (std::size_t i = k + 1; i < N; ++i)
+              {
+                for (std::size_t p = 0; p < k; ++p)
+                  for (std::size_t l = 0; l < L; ++l)
+                    aa[i][k][l] -= aa[i][p][l] * aa[k][p][l];
+                for (std::size_t l = 0; l < L; ++l)
+                  aa[i][k][l] *= rdiag[l];
+              }
+          }
+
+        //  Solve L.y = b and then Lt.x = y.
+        for (std::size_t i = 0; i < N; ++i)
+          {
+            for (std::size_t k = 0; k < i; ++k)
+              for (std::size_t l = 0; l < L; ++l)
+                bb[i][l] -= aa[i][k][l] * bb[k][l];
+            for (std::size_t l = 0; l < L; ++l)
+              bb[i][l] /= aa[i][i][l];
+          }
+        for (std::size_t i = N; i-- > 0; )
+          {
+            for (std::size_t k = i + 1; k < N; ++k)
+              for (std::size_t l = 0; l < L; ++l)
+                bb[i][l] -= aa[k][i][l] * bb[k][l];
+            for (std::size_t l = 0; l < L; ++l)
+              bb[i][l] /= aa[i][i][l];
+          }
+
+        const NumTp nan = std::numeric_limits<NumTp>::quiet_NaN();
+        for (std::size_t i = 0; i < N; ++i)
+          for (std::size_t l = 0; l < nl; ++l)
+            bs[l * N + i] = failed[l] ? nan : bb[i][l];
+        for (std::size_t l = 0; l < nl; ++l)
+          num_failed += failed[l];
+      }
+
+    return num_failed;
+  }
+
+}  //  namespace matrix
+
+#endif  //  BATCHED_SOLVE_TCC
@@ -7,6 +7,8 @@
 #include <stdexcept>
 #include <vector>
 
+#include "matrix_triangular_solve.tcc"
+
 
 namespace matrix
 {
@@ -34,6 +36,9 @@ template<typename SquareMatrix, typename Vector>
       backsubstitution(InVecIter b_begin, InVecIter b_end,
                        OutVecIter x_begin) const;
 
+    template<typename Matrix2>
+      void backsubstitute(std::size_t m, Matrix2 & b) const;
+
     template<typename SquareMatrix2>
       void inverse(SquareMatrix2 & a_inv) const;
 
@@ -98,6 +103,40 @@ template<typename SquareMatrix, typename Vector>
   }
 
 
+/**
+ *  Solve a.X = B for m right-hand sides at once given the Cholesky decomposition
+ *  a[0..n-1][0..n-1], d[0..n-1] from cholesky_decomp().  b[0..n-1][0..m-1] holds
+ *  the right-hand sides as columns and is replaced by the solutions.
+ *  Only the lower triangle of a is used.
+ */
+template<typename SquareMatrix, typename Vector, typename Matrix>
+  void
+  cholesky_backsub_multi(std::size_t n, const SquareMatrix & a, const Vector & d,
+                         Matrix & b, std::size_t m)
+  {
+    using NumTp = std::decay_t<decltype(a[0][0])>;
+
+    //  Solve L.Y = B and then Lt.X = Y.
+    trsm_lower(n, m,
+               [&a](std::size_t i, std::size_t k) -> NumTp { return a[i][k]; },
+               [&d](std::size_t i) -> NumTp { return d[i]; }, b);
+    trsm_upper(n, m,
+               [&a](std::size_t i, std::size_t k) -> NumTp { return a[k][i]; },
+               [&d](std::size_t i) -> NumTp { return d[i]; }, b);
+  }
+
+
+/**
+ *  Solve for the m columns of b[0..n-1][0..m-1] in place.
+ */
+template<typename SquareMatrix, typename Vector>
+  template<typename Matrix2>
+    void
+    cholesky_decomposition<SquareMatrix, Vector>::
+    backsubstitute(std::size_t m, Matrix2 & b) const
+    { cholesky_backsub_multi(m_n, m_a, m_d, b, m); }
+
+
 /**
  *  
  */
@@ -7,8 +7,12 @@
 #include <vector>
 #include <cmath>
 #include <limits>
+#include <stdexcept>
+#include <algorithm>
+#include <thread>
 
 #include "matrix_util.h"
+#include "matrix_triangular_solve.tcc"
 
 namespace matrix
 {
@@ -36,6 +40,9 @@ template<typename NumTp, typename SquareMatrix>
       backsubstitution(InVecIter b_begin, InVecIter b_end,
                        OutVecIter x_begin) const;
 
+    template<typename Matrix2>
+      void backsubstitute(std::size_t m, Matrix2 & b) const;
+
     template<typename SquareMatrix2, typename Vector, typename VectorOut>
       void
       improve(const SquareMatrix2 & a_orig,
@@ -153,7 +160,7 @@ template<typename NumTp, typename SquareMatrix, typename Vector>
         //
         if (j != n - 1)
           {
-            auto scale = NumTp(1) / std::abs(a[j][j]);  //  Changed this to 1/abs(a) from simple 1/a.
+            auto scale = NumTp(1) / a[j][j];
             for (std::size_t i = j + 1; i < n; ++i)
               a[i][j] *= scale;
           }
@@ -163,6 +170,169 @@ template<typename NumTp, typename SquareMatrix, typename Vector>
   }
 
 
+/**
+ *  Unit lower triangular solve and Schur complement update used by the
+ *  blocked LU decomposition.  With columns [c0, c1) already factored
+ *  this overwrites rows [c0, c1) of columns [j0, j1) with L11^{-1} A12
+ *  and then subtracts A21 A12 from rows [c1, n) of those columns.
+ *  The update is done a tile of columns at a time with the innermost
+ *  loop along a row so it streams through memory and vectorizes.
+ *  The rows of the update are split across num_threads threads.
+ */
+template<typename SquareMatrix>
+  void
+  lu_update(const std::size_t n, SquareMatrix & a,
+            std::size_t c0, std::size_t c1, std::size_t j0, std::size_t j1,
+            unsigned num_threads = 1)
+  {
+    if (j0 >= j1)
+      return;
+
+    //  A12 <- L11^{-1} A12
+    for (std::size_t i = c0 + 1; i < c1; ++i)
+      for (std::size_t k = c0; k < i; ++k)
+        {
+          const auto lik = a[i][k];
+          for (std::size_t j = j0; j < j1; ++j)
+            a[i][j] -= lik * a[k][j];
+        }
+
+    //  A22 <- A22 - A21 A12
+    const std::size_t tile = 256;
+    auto update = [&a, c0, c1, j0, j1, tile](std::size_t r0, std::size_t r1)
+    {
+      for (std::size_t jj = j0; jj < j1; jj += tile)
+        {
+          const std::size_t jend = std::min(j1, jj + tile);
+          for (std::size_t i = r0; i < r1; ++i)
+            for (std::size_t k = c0; k < c1; ++k)
+              {
+                const auto lik = a[i][k];
+                for (std::size_t j = jj; j < jend; ++j)
+                  a[i][j] -= lik * a[k][j];
+              }
+        }
+    };
+
+    const std::size_t rows = n - c1;
+    const std::size_t work = rows * (c1 - c0) * (j1 - j0);
+    if (num_threads < 2 || work < (std::size_t(1) << 18))
+      update(c1, n);
+    else
+      {
+        std::vector<std::thread> threads;
+        const std::size_t band = (rows + num_threads - 1) / num_threads;
+        for (std::size_t r = c1; r < n; r += band)
+          threads.emplace_back(update, r, std::min(n, r + band));
+        for (auto & t : threads)
+          t.join();
+      }
+  }
+
+
+/**
+ *  Recursive LU decomposition with partial pivoting of the panel of
+ *  columns [c0, c1) of rows [c0, n).  The left half of the panel is factored,
+ *  the right half is updated, then the right half is factored.
+ *  Rows are interchanged across the whole matrix as pivots are found.
+ */
+template<typename NumTp, typename SquareMatrix, typename Vector>
+  void
+  lu_panel_decomp(const std::size_t n, SquareMatrix & a,
+                  std::size_t c0, std::size_t c1,
+                  Vector & index, NumTp & parity, std::vector<NumTp> & scale)
+  {
+    const NumTp TINY = NumTp(1.0e-20L);
+
+    if (c1 - c0 == 1)
+      {
+        const std::size_t j = c0;
+
+        //  Search for the largest scaled pivot.
+        std::size_t imax = j;
+        NumTp big = NumTp(0);
+        for (std::size_t i = j; i < n; ++i)
+          {
+            NumTp dummy = scale[i] * std::abs(a[i][j]);
+            if (dummy >= big)
+              {
+                big = dummy;
+                imax = i;
+              }
+          }
+
+        //  Interchange rows if required.
+        if (j != imax)
+          {
+            for (std::size_t k = 0; k < n; ++k)
+              std::swap(a[imax][k], a[j][k]);
+            parity = -parity;
+            std::swap(scale[imax], scale[j]);
+          }
+        index[j] = imax;
+        if (a[j][j] == NumTp(0))
+          a[j][j] = TINY;
+
+        const auto rpiv = NumTp(1) / a[j][j];
+        for (std::size_t i = j + 1; i < n; ++i)
+          a[i][j] *= rpiv;
+        return;
+      }
+
+    const std::size_t mid = c0 + (c1 - c0) / 2;
+    lu_panel_decomp(n, a, c0, mid, index, parity, scale);
+    lu_update(n, a, c0, mid, mid, c1);
+    lu_panel_decomp(n, a, mid, c1, index, parity, scale);
+  }
+
+
+/**
+ *  Blocked right-looking LU decomposition with partial pivoting.
+ *  This computes the same decomposition as lu_decomp() (up to rounding) -
+ *  the same packed L and U in a[][], the same row interchanges in index[]
+ *  and the same parity - so the results can be given to lu_backsub(),
+ *  lu_invert() and lu_determinant().
+ *
+ *  Each panel of block_size columns is factored recursively.
+ *  The remaining (trailing) submatrix is then updated with a matrix-matrix
+ *  product whose rows are split across num_threads threads.
+ *  Rows of a[][] should be contiguous for the update to be efficient.
+ */
+template<typename NumTp, typename SquareMatrix, typename Vector>
+  bool
+  lu_decomp_blocked(const std::size_t n, SquareMatrix & a,
+                    Vector & index, NumTp & parity,
+                    unsigned num_threads = 1, std::size_t block_size = 64)
+  {
+    std::vector<NumTp> scale(n);
+
+    parity = NumTp(1);
+
+    //  Loop over rows to get the implicit scaling information.
+    for (std::size_t i = 0; i < n; ++i)
+      {
+        NumTp big(0);
+        for (std::size_t j = 0; j < n; ++j)
+          big = std::max(big, NumTp(std::abs(a[i][j])));
+        if (big == NumTp(0))
+          throw std::logic_error("lu_decomp_blocked: singular matrix");
+        scale[i] = NumTp(1) / big;
+      }
+
+    if (block_size == 0)
+      block_size = 1;
+
+    for (std::size_t kb = 0; kb < n; kb += block_size)
+      {
+        const std::size_t ke = std::min(n, kb + block_size);
+        lu_panel_decomp(n, a, kb, ke, index, parity, scale);
+        lu_update(n, a, kb, ke, ke, n, num_threads);
+      }
+
+    return true;
+  }
+
+
 /**
  *  Solve the set of n linear equations a.x = b.  Here a[0..n-1][0..n-1] is input, not as the original matrix a but as 
  *  its LU decomposition, determined by the routine lu_decomp().  b[0..n-1] is input as the right hand side vector b 
@@ -209,6 +379,51 @@ template<typename SquareMatrix, typename VectorInt, typename Vector>
   }
 
 
+/**
+ *  Solve the set of n linear equations a.X = B for m right-hand sides at once.
+ *  Here a[0..n-1][0..n-1] and index[0..n-1] are the LU decomposition from lu_decomp()
+ *  or lu_decomp_blocked().  b[0..n-1][0..m-1] holds the right-hand sides as columns
+ *  and is replaced by the solutions.  The permutation is applied to whole rows of b
+ *  and the two triangular solves are blocked with trsm_lower() and trsm_upper()
+ *  so this is much faster than m calls to lu_backsub().
+ */
+template<typename SquareMatrix, typename VectorInt, typename Matrix>
+  void
+  lu_backsub_multi(const std::size_t n,
+                   const SquareMatrix & a,
+                   const VectorInt & index,
+                   Matrix & b, const std::size_t m)
+  {
+    using NumTp = std::decay_t<decltype(a[0][0])>;
+
+    for (std::size_t i = 0; i < n; ++i)
+      {
+        const std::size_t i_perm = index[i];
+        if (i_perm != i)
+          for (std::size_t j = 0; j < m; ++j)
+            std::swap(b[i][j], b[i_perm][j]);
+      }
+
+    trsm_lower(n, m,
+               [&a](std::size_t i, std::size_t k) -> NumTp { return a[i][k]; },
+               [](std::size_t) { return NumTp(1); }, b);
+    trsm_upper(n, m,
+               [&a](std::size_t i, std::size_t k) -> NumTp { return a[i][k]; },
+               [&a](std::size_t i) -> NumTp { return a[i][i]; }, b);
+  }
+
+
+/**
+ *  Solve for the m columns of b[0..n-1][0..m-1] in place.
+ */
+template<typename NumTp, typename SquareMatrix>
+  template<typename Matrix2>
+    void
+    lu_decomposition<NumTp, SquareMatrix>::
+    backsubstitute(std::size_t m, Matrix2 & b) const
+    { lu_backsub_multi(m_n, m_a, m_index, b, m); }
+
+
 /**
  *  Improves a solution vector x of the linear set A.x = b.  The matrix a and the
  *  LU decomposition of a a_lu (with its row permutation vector index) and the
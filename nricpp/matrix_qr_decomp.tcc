@@ -6,6 +6,12 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <algorithm>
+#include <type_traits>
+#include <thread>
+#include <stdexcept>
+
+#include "matrix_triangular_solve.tcc"
 
 
 namespace matrix
@@ -35,6 +41,9 @@ template<typename NumTp, typename Matrix>
       backsubstitution(InVecIter b_begin, InVecIter b_end,
                        OutVecIter x_begin) const;
 
+    template<typename Matrix2>
+      void backsubstitute(std::size_t m, Matrix2 & b) const;
+
     template<typename Matrix2>
       void inverse(Matrix2 & a_inv);
 
@@ -58,12 +67,23 @@ template<typename NumTp, typename Matrix>
   };
 
 
+/**
+ *  The number of Householder matrices in the QR decomposition of an n_rows x n_cols matrix.
+ *  A square matrix needs one fewer than it has columns.
+ */
+inline std::size_t
+qr_num_reflections(std::size_t n_rows, std::size_t n_cols)
+{ return n_rows > n_cols ? n_cols : n_cols - 1; }
+
+
 /**
  *  Constructs the QR decomposition of a[0..n_rows - 1][0..n_cols - 1].  The upper triangular matrix R
  *  is returned in the upper triangle of a except the diagonal elements of R which are returned
  *  in d[0..n_cols - 1].  The orthogonal matrix Q is represented as a product of n - 1 Householder
  *  matrices Q_0...Q_n-2 where Q_j = 1 - u_j x u_j/c_j.  The ith component of u_j is zero for
  *  i = 
+ *  If n_rows > n_cols the last column gets a Householder matrix too so there are
+ *  qr_num_reflections() of them.
  */
 template<typename Matrix, typename Vector>
   void
@@ -80,7 +100,7 @@ template<typename Matrix, typename Vector>
     //d.resize(n);
 
     singular = false;
-    for (std::size_t k = 0; k < n_cols - 1; ++k)
+    for (std::size_t k = 0; k < qr_num_reflections(n_rows, n_cols); ++k)
       {
 	//  See if the matrix is singular in this column.
 	NumTp scale = NumTp(0);
@@ -118,11 +138,276 @@ template<typename Matrix, typename Vector>
               }
           }
       }
-    c[n_cols - 1] = NumTp(0);
-    d[n_cols - 1] = a[n_cols - 1][n_cols - 1];
+    if (n_rows == n_cols)
+      {
+        c[n_cols - 1] = NumTp(0);
+        d[n_cols - 1] = a[n_cols - 1][n_cols - 1];
+      }
+
+    if (d[n_cols - 1] == NumTp(0))
+      singular = true;
+
+    return;
+  }
+
+
+/**
+ *  Compute the Householder matrix for column k of a[0..n_rows - 1][] and apply it to
+ *  columns k + 1 up to j_end.  The conventions for c[k] and d[k] are those of qr_decomp().
+ *  Returns false if the column is zero below the diagonal.
+ */
+template<typename Matrix, typename Vector>
+  bool
+  qr_householder(std::size_t n_rows, std::size_t k, std::size_t j_end,
+                 Matrix & a, Vector & c, Vector & d)
+  {
+    using NumTp = std::decay_t<decltype(a[0][0])>;
+
+    NumTp scale = NumTp(0);
+    for (std::size_t i = k; i < n_rows; ++i)
+      scale = std::max(scale, NumTp(std::abs(a[i][k])));
+    if (scale == NumTp(0))
+      {
+        c[k] = d[k] = NumTp(0);
+        return false;
+      }
+
+    NumTp sum = NumTp(0);
+    for (std::size_t i = k; i < n_rows; ++i)
+      {
+        a[i][k] /= scale;
+        sum += a[i][k] * a[i][k];
+      }
+    NumTp sigma = std::sqrt(sum);
+    if (a[k][k] < NumTp(0))
+      sigma = -sigma;
+    a[k][k] += sigma;
+    c[k] = sigma * a[k][k];
+    d[k] = -scale * sigma;
+
+    //  Apply to the rest of the panel a row at a time.
+    std::vector<NumTp> tau(j_end > k + 1 ? j_end - k - 1 : 0);
+    for (std::size_t i = k; i < n_rows; ++i)
+      {
+        const NumTp aik = a[i][k];
+        for (std::size_t j = k + 1; j < j_end; ++j)
+          tau[j - k - 1] += aik * a[i][j];
+      }
+    for (auto & t : tau)
+      t /= c[k];
+    for (std::size_t i = k; i < n_rows; ++i)
+      {
+        const NumTp aik = a[i][k];
+        for (std::size_t j = k + 1; j < j_end; ++j)
+          a[i][j] -= tau[j - k - 1] * aik;
+      }
+
+    return true;
+  }
+
+
+/**
+ *  Form the upper triangular factor t[0..kb - 1][0..kb - 1] of the compact WY representation
+ *    Q_k0 Q_k0+1 ... Q_k1-1 = 1 - V T Vt
+ *  of the Householder matrices in columns [k0, k1) of a from qr_decomp().
+ *  The columns of V are the Householder vectors u_j and t is stored row-major
+ *  in a vector of length kb * kb with kb = k1 - k0.
+ */
+template<typename Matrix, typename Vector, typename NumTp>
+  void
+  qr_block_reflector(std::size_t n_rows, std::size_t k0, std::size_t k1,
+                     const Matrix & a, const Vector & c,
+                     std::vector<NumTp> & t)
+  {
+    const std::size_t kb = k1 - k0;
+    t.assign(kb * kb, NumTp(0));
+
+    //  The Gram matrix Vt V; u_i is zero above row k0 + i.
+    std::vector<NumTp> g(kb * kb, NumTp(0));
+    for (std::size_t r = k0; r < n_rows; ++r)
+      {
+        const std::size_t p_end = std::min(kb, r - k0 + 1);
+        for (std::size_t p = 0; p < p_end; ++p)
+          {
+            const NumTp vp = a[r][k0 + p];
+            for (std::size_t q = p + 1; q < p_end; ++q)
+              g[p * kb + q] += vp * a[r][k0 + q];
+          }
+      }
+
+    for (std::size_t j = 0; j < kb; ++j)
+      {
+        const NumTp tau = c[k0 + j] == NumTp(0) ? NumTp(0) : NumTp(1) / c[k0 + j];
+        for (std::size_t i = 0; i < j; ++i)
+          {
+            NumTp sum = NumTp(0);
+            for (std::size_t p = i; p < j; ++p)
+              sum += t[i * kb + p] * g[p * kb + j];
+            t[i * kb + j] = -tau * sum;
+          }
+        t[j * kb + j] = tau;
+      }
+  }
+
+
+/**
+ *  Apply the block reflector 1 - V T Vt for columns [k0, k1) of a (trans == false)
+ *  or its transpose (trans == true) to rows [k0, n_rows) and columns [j0, j1) of b.
+ *  b may be a itself as long as [j0, j1) does not overlap [k0, k1).
+ *  The columns of b are split among num_threads threads.
+ */
+template<typename Matrix, typename NumTp, typename Matrix2>
+  void
+  qr_apply_block_reflector(std::size_t n_rows, std::size_t k0, std::size_t k1,
+                           const Matrix & a, const std::vector<NumTp> & t,
+                           bool trans, Matrix2 & b,
+                           std::size_t j0, std::size_t j1,
+                           unsigned num_threads = 1)
+  {
+    const std::size_t kb = k1 - k0;
+
+    auto apply = [&](std::size_t c0, std::size_t c1)
+    {
+      const std::size_t nc = c1 - c0;
+      if (nc == 0)
+        return;
+
+      //  W = Vt B
+      std::vector<NumTp> w(kb * nc, NumTp(0));
+      for (std::size_t r = k0; r < n_rows; ++r)
+        {
+          const std::size_t p_end = std::min(kb, r - k0 + 1);
+          const auto & br = b[r];
+          for (std::size_t p = 0; p < p_end; ++p)
+            {
+              const NumTp vp = a[r][k0 + p];
+              NumTp * wp = &w[p * nc];
+              for (std::size_t j = 0; j < nc; ++j)
+                wp[j] += vp * br[c0 + j];
+            }
+        }
+
+      //  W = T W or W = Tt W
+      std::vector<NumTp> tw(kb * nc, NumTp(0));
+      for (std::size_t i = 0; i < kb; ++i)
+        for (std::size_t p = 0; p < kb; ++p)
+          {
+            const NumTp tip = trans ? t[p * kb + i] : t[i * kb + p];
+            if (tip == NumTp(0))
+              continue;
+            for (std::size_t j = 0; j < nc; ++j)
+              tw[i * nc + j] += tip * w[p * nc + j];
+          }
+
+      //  B -= V W
+      for (std::size_t r = k0; r < n_rows; ++r)
+        {
+          const std::size_t p_end = std::min(kb, r - k0 + 1);
+          auto & br = b[r];
+          for (std::size_t p = 0; p < p_end; ++p)
+            {
+              const NumTp vp = a[r][k0 + p];
+              const NumTp * wp = &tw[p * nc];
+              for (std::size_t j = 0; j < nc; ++j)
+                br[c0 + j] -= vp * wp[j];
+            }
+        }
+    };
+
+    const std::size_t n = j1 - j0;
+    const std::size_t work = (n_rows - k0) * kb * n;
+    if (num_threads < 2 || n < 2 * num_threads || work < (std::size_t(1) << 18))
+      {
+        apply(j0, j1);
+        return;
+      }
+
+    std::vector<std::thread> threads;
+    const std::size_t band = (n + num_threads - 1) / num_threads;
+    for (std::size_t c0 = j0; c0 < j1; c0 += band)
+      threads.emplace_back(apply, c0, std::min(j1, c0 + band));
+    for (auto & th : threads)
+      th.join();
+  }
+
+
+/**
+ *  Constructs the QR decomposition of a[0..n_rows - 1][0..n_cols - 1] with the same
+ *  conventions for a, c and d as qr_decomp() so the result may be given to
+ *  qr_backsub() and friends.
+ *
+ *  The columns are factored block_size at a time.  The Householder matrices of
+ *  a panel are aggregated into the compact WY form 1 - V T Vt so the rest of the matrix
+ *  is updated with matrix-matrix products, split across num_threads threads.
+ */
+template<typename Matrix, typename Vector>
+  void
+  qr_decomp_blocked(std::size_t n_rows, std::size_t n_cols,
+                    Matrix & a,
+                    Vector & c, Vector & d, bool & singular,
+                    unsigned num_threads = 1, std::size_t block_size = 32)
+  {
+    using NumTp = std::decay_t<decltype(a[0][0])>;
+
+    if (block_size == 0)
+      throw std::logic_error("zero block size in qr_decomp_blocked");
+
+    const std::size_t k_end = qr_num_reflections(n_rows, n_cols);
+
+    singular = false;
+    std::vector<NumTp> t;
+    for (std::size_t k0 = 0; k0 < k_end; k0 += block_size)
+      {
+        const std::size_t k1 = std::min(k_end, k0 + block_size);
+
+        for (std::size_t k = k0; k < k1; ++k)
+          if (!qr_householder(n_rows, k, k1, a, c, d))
+            singular = true;
+
+        if (k1 < n_cols)
+          {
+            qr_block_reflector(n_rows, k0, k1, a, c, t);
+            qr_apply_block_reflector(n_rows, k0, k1, a, t, true,
+                                     a, k1, n_cols, num_threads);
+          }
+      }
+
+    if (n_rows == n_cols)
+      {
+        c[n_cols - 1] = NumTp(0);
+        d[n_cols - 1] = a[n_cols - 1][n_cols - 1];
+      }
 
     if (d[n_cols - 1] == NumTp(0))
       singular = true;
+  }
+
+
+/**
+ *  This routine solves the set of equations Rx = b where R is the upper triangular
+ *  matrix stored in a[0..n_rows - 1][0..n_cols - 1] and d[0..n_cols - 1].
+ *  Here n_rows >= n_cols.
+ */
+template<typename Matrix, typename Vector>
+  void
+  r_backsub(std::size_t n_rows, std::size_t n_cols,
+            const Matrix & a,
+            const Vector & d,
+            Vector & b)
+  {
+    using NumTp = std::decay_t<decltype(a[0][0])>;
+
+    if (n_rows < n_cols)
+      throw std::logic_error("more columns than rows in r_backsub");
+
+    b[n_cols - 1] /= d[n_cols - 1];
+    for (int i = n_cols - 2; i >= 0; --i)
+      {
+        NumTp sum = NumTp(0);
+        for (std::size_t j = i + 1; j < n_cols; ++j)
+          sum += a[i][j] * b[j];
+        b[i] = (b[i] - sum) / d[i];
+      }
 
     return;
   }
@@ -142,10 +427,10 @@ template<typename Matrix, typename Vector>
              const Vector & c, const Vector & d,
              Vector & b)
   {
-    using NumTp = std::remove_reference_t<decltype(a[0][0])>;
+    using NumTp = std::decay_t<decltype(a[0][0])>;
 
     //  Form Qt.b.
-    for (std::size_t j = 0; j < n_cols - 1; ++j)
+    for (std::size_t j = 0; j < qr_num_reflections(n_rows, n_cols); ++j)
       {
 	NumTp sum = NumTp(0);
 	for (std::size_t i = j; i < n_rows; ++i)
@@ -163,32 +448,65 @@ template<typename Matrix, typename Vector>
 
 
 /**
- *  This routine solves the set of equations Rx = b where R is the upper triangular
- *  matrix stored in a[0..n_rows - 1][0..n_cols - 1] and d[0..n_cols - 1].
- *  Here n_rows >= n_cols.
+ *  This routine solves the set of equations A.X = B for m right-hand sides at once.
+ *  The inputs are the QR decomposition of the matrix in a[0..n_rows - 1][0..n_cols - 1],
+ *  c[0..n_cols - 1], and d[0..n_cols - 1].
+ *  The matrix b[0..n_rows - 1][0..m - 1] holds the right-hand sides as columns;
+ *  on output the solutions are in its first n_cols rows.
+ *  Each Householder reflection is applied to all the columns in one sweep down the rows
+ *  and R.X = Qt.B is solved with trsm_upper().
  */
-template<typename Matrix, typename Vector>
+template<typename Matrix, typename Vector, typename Matrix2>
   void
-  r_backsub(std::size_t n_rows, std::size_t n_cols,
-            const Matrix & a,
-            const Vector & d,
-            Vector & b)
+  qr_backsub_multi(const std::size_t n_rows, const std::size_t n_cols,
+                   const Matrix & a,
+                   const Vector & c, const Vector & d,
+                   Matrix2 & b, const std::size_t m)
   {
-    using NumTp = std::remove_reference_t<decltype(a[0][0])>;
+    using NumTp = std::decay_t<decltype(a[0][0])>;
 
-    b[n_cols - 1] /= d[n_cols - 1];
-    for (int i = n_cols - 2; i >= 0; --i)
+    //  Form Qt.B.
+    std::vector<NumTp> tau(m);
+    for (std::size_t j = 0; j < qr_num_reflections(n_rows, n_cols); ++j)
       {
-        NumTp sum = NumTp(0);
-        for (std::size_t j = i + 1; j < n_rows; ++j)
-          sum += a[i][j] * b[j];
-        b[i] = (b[i] - sum) / d[i];
+        std::fill(tau.begin(), tau.end(), NumTp(0));
+        for (std::size_t i = j; i < n_rows; ++i)
+          {
+            const NumTp aij = a[i][j];
+            const auto & bi = b[i];
+            for (std::size_t k = 0; k < m; ++k)
+              tau[k] += aij * bi[k];
+          }
+        const NumTp rc = NumTp(1) / c[j];
+        for (std::size_t k = 0; k < m; ++k)
+          tau[k] *= rc;
+        for (std::size_t i = j; i < n_rows; ++i)
+          {
+            const NumTp aij = a[i][j];
+            auto & bi = b[i];
+            for (std::size_t k = 0; k < m; ++k)
+              bi[k] -= tau[k] * aij;
+          }
       }
 
-    return;
+    //  Solve R.X = Qt.B
+    trsm_upper(n_cols, m,
+               [&a](std::size_t i, std::size_t k) -> NumTp { return a[i][k]; },
+               [&d](std::size_t i) -> NumTp { return d[i]; }, b);
   }
 
 
+/**
+ *  Solve for the m columns of b[0..n_rows - 1][0..m - 1] in place.
+ */
+template<typename NumTp, typename Matrix>
+  template<typename Matrix2>
+    void
+    qr_decomposition<NumTp, Matrix>::
+    backsubstitute(std::size_t m, Matrix2 & b) const
+    { qr_backsub_multi(m_n_rows, m_n_cols, m_a, m_c, m_d, b, m); }
+
+
 /**
  *  Inverts a matrix given the QR decomposed matrix.
  *  The inverse matrix is allocated in this routine so make sure the pointer is freed first.
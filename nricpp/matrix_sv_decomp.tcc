@@ -7,6 +7,13 @@
 #include <sstream>
 #include <vector>
 #include <cmath>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <thread>
+
+#include "matrix_qr_decomp.tcc"
 
 
 namespace matrix
@@ -415,6 +422,211 @@ template<typename Matrix, typename Vector>
     return;
   }
 
+
+/**
+ *  Computes the singular value decomposition a = u.w.vt of a[0..n_rows - 1][0..n_cols - 1]
+ *  by one-sided Jacobi rotations.  The output conventions are those of sv_decomp():
+ *  u replaces a, the singular values are returned in w[0..n_cols - 1] and the matrix v
+ *  (not its transpose) in v[0..n_cols - 1][0..n_cols - 1].  Here n_rows >= n_cols.
+ *
+ *  Pairs of columns are orthogonalized by plane rotations until all pairs are orthogonal
+ *  to working precision.  Each sweep visits the pairs in round-robin order in which
+ *  the n_cols/2 pairs of a round are disjoint so they are split among num_threads threads.
+ *  The columns are held contiguously during the iteration.
+ *  The results are accurate to high relative precision even for small singular values.
+ */
+template<typename Matrix, typename Vector, typename Matrix2>
+  void
+  sv_decomp_jacobi(const std::size_t n_rows, const std::size_t n_cols,
+                   Matrix & a, Vector & w, Matrix2 & v,
+                   unsigned num_threads = 1)
+  {
+    using NumTp = std::decay_t<decltype(a[0][0])>;
+
+    const int MAX_SWEEPS = 60;
+    const auto eps = std::numeric_limits<NumTp>::epsilon();
+
+    std::vector<std::vector<NumTp>> ac(n_cols, std::vector<NumTp>(n_rows));
+    std::vector<std::vector<NumTp>> vc(n_cols, std::vector<NumTp>(n_cols));
+    for (std::size_t i = 0; i < n_rows; ++i)
+      for (std::size_t j = 0; j < n_cols; ++j)
+        ac[j][i] = a[i][j];
+    for (std::size_t j = 0; j < n_cols; ++j)
+      vc[j][j] = NumTp(1);
+
+    //  Orthogonalize columns p and q; return true if they were rotated.
+    auto rotate = [&](std::size_t p, std::size_t q) -> bool
+    {
+      auto & ap = ac[p];
+      auto & aq = ac[q];
+      NumTp alpha = NumTp(0), beta = NumTp(0), gamma = NumTp(0);
+      for (std::size_t i = 0; i < n_rows; ++i)
+        {
+          alpha += ap[i] * ap[i];
+          beta += aq[i] * aq[i];
+          gamma += ap[i] * aq[i];
+        }
+      if (std::abs(gamma) <= eps * std::sqrt(alpha * beta))
+        return false;
+
+      const NumTp zeta = (beta - alpha) / (NumTp(2) * gamma);
+      const NumTp t = std::copysign(NumTp(1), zeta)
+                    / (std::abs(zeta) + std::sqrt(NumTp(1) + zeta * zeta));
+      const NumTp c = NumTp(1) / std::sqrt(NumTp(1) + t * t);
+      const NumTp s = c * t;
+      for (std::size_t i = 0; i < n_rows; ++i)
+        {
+          const NumTp x = ap[i];
+          const NumTp y = aq[i];
+          ap[i] = c * x - s * y;
+          aq[i] = s * x + c * y;
+        }
+      auto & vp = vc[p];
+      auto & vq = vc[q];
+      for (std::size_t i = 0; i < n_cols; ++i)
+        {
+          const NumTp x = vp[i];
+          const NumTp y = vq[i];
+          vp[i] = c * x - s * y;
+          vq[i] = s * x + c * y;
+        }
+      return true;
+    };
+
+    //  Round-robin tournament; an odd number of columns gets a bye.
+    const std::size_t m = n_cols + n_cols % 2;
+    std::vector<std::size_t> player(m);
+    for (std::size_t j = 0; j < m; ++j)
+      player[j] = j;
+
+    const bool threaded = num_threads > 1 && m / 2 > 1
+                       && n_rows * n_cols >= (std::size_t(1) << 16);
+    const unsigned n_threads = threaded ? std::min<std::size_t>(num_threads, m / 2) : 1;
+    std::vector<std::size_t> rotations(n_threads);
+
+    int sweep = 0;
+    for (; sweep < MAX_SWEEPS; ++sweep)
+      {
+        std::fill(rotations.begin(), rotations.end(), 0);
+        for (std::size_t round = 0; round + 1 < m; ++round)
+          {
+            auto do_pairs = [&](unsigned id, std::size_t t0, std::size_t t1)
+            {
+              for (std::size_t t = t0; t < t1; ++t)
+                {
+                  const auto p = std::min(player[t], player[m - 1 - t]);
+                  const auto q = std::max(player[t], player[m - 1 - t]);
+                  if (q < n_cols && rotate(p, q))
+                    ++rotations[id];
+                }
+            };
+
+            if (n_threads < 2)
+              do_pairs(0, 0, m / 2);
+            else
+              {
+                std::vector<std::thread> threads;
+                const std::size_t band = (m / 2 + n_threads - 1) / n_threads;
+                unsigned id = 0;
+                for (std::size_t t0 = 0; t0 < m / 2; t0 += band, ++id)
+                  threads.emplace_back(do_pairs, id, t0, std::min(m / 2, t0 + band));
+                for (auto & th : threads)
+                  th.join();
+              }
+
+            //  Keep player[0] fixed and rotate the rest.
+            std::rotate(player.begin() + 1, player.end() - 1, player.end());
+          }
+
+        std::size_t total = 0;
+        for (auto r : rotations)
+          total += r;
+        if (total == 0)
+          break;
+      }
+    if (sweep == MAX_SWEEPS)
+      throw std::logic_error("sv_decomp_jacobi: No convergence in 60 sweeps.");
+
+    for (std::size_t j = 0; j < n_cols; ++j)
+      {
+        NumTp norm = NumTp(0);
+        for (std::size_t i = 0; i < n_rows; ++i)
+          norm += ac[j][i] * ac[j][i];
+        w[j] = std::sqrt(norm);
+        const NumTp rw = w[j] == NumTp(0) ? NumTp(0) : NumTp(1) / w[j];
+        for (std::size_t i = 0; i < n_rows; ++i)
+          a[i][j] = ac[j][i] * rw;
+        for (std::size_t i = 0; i < n_cols; ++i)
+          v[i][j] = vc[j][i];
+      }
+
+    return;
+  }
+
+
+/**
+ *  Computes the singular value decomposition a = u.w.vt of a tall, skinny matrix
+ *  a[0..n_rows - 1][0..n_cols - 1] with n_rows >= n_cols.  The output conventions
+ *  are those of sv_decomp().
+ *
+ *  The matrix is first reduced to the n_cols x n_cols upper triangular R by
+ *  qr_decomp_blocked(), the small SVD R = ur.w.vt is done by sv_decomp_jacobi()
+ *  and finally u = Q.ur is formed by applying the blocked Householder matrices.
+ *  All but the small SVD work with matrix-matrix products over the long dimension.
+ */
+template<typename Matrix, typename Vector, typename Matrix2>
+  void
+  sv_decomp_tall(const std::size_t n_rows, const std::size_t n_cols,
+                 Matrix & a, Vector & w, Matrix2 & v,
+                 unsigned num_threads = 1, std::size_t block_size = 32)
+  {
+    using NumTp = std::decay_t<decltype(a[0][0])>;
+
+    if (block_size == 0)
+      throw std::logic_error("zero block size in sv_decomp_tall");
+
+    std::vector<NumTp> c(n_cols), d(n_cols);
+    bool singular;
+    qr_decomp_blocked(n_rows, n_cols, a, c, d, singular, num_threads, block_size);
+
+    std::vector<std::vector<NumTp>> r(n_cols, std::vector<NumTp>(n_cols));
+    for (std::size_t i = 0; i < n_cols; ++i)
+      {
+        r[i][i] = d[i];
+        for (std::size_t j = i + 1; j < n_cols; ++j)
+          r[i][j] = a[i][j];
+      }
+    sv_decomp_jacobi(n_cols, n_cols, r, w, v, num_threads);
+
+    //  u = Q_0...Q_k-1 [ur; 0]
+    std::vector<std::vector<NumTp>> u(n_rows, std::vector<NumTp>(n_cols));
+    for (std::size_t i = 0; i < n_cols; ++i)
+      for (std::size_t j = 0; j < n_cols; ++j)
+        u[i][j] = r[i][j];
+
+    const std::size_t k_end = qr_num_reflections(n_rows, n_cols);
+    std::vector<NumTp> t;
+    for (std::size_t k0 = (k_end == 0 ? 0 : (k_end - 1) / block_size * block_size); ;
+         k0 -= block_size)
+      {
+        const std::size_t k1 = std::min(k_end, k0 + block_size);
+        if (k1 > k0)
+          {
+            qr_block_reflector(n_rows, k0, k1, a, c, t);
+            qr_apply_block_reflector(n_rows, k0, k1, a, t, false,
+                                     u, 0, n_cols, num_threads);
+          }
+        if (k0 == 0)
+          break;
+      }
+
+    for (std::size_t i = 0; i < n_rows; ++i)
+      for (std::size_t j = 0; j < n_cols; ++j)
+        a[i][j] = u[i][j];
+
+    return;
+  }
+
 }  //  namespace matrix
 
 
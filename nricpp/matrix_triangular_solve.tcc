@@ -0,0 +1,129 @@
+#ifndef TRIANGULAR_SOLVE_TCC
+#define TRIANGULAR_SOLVE_TCC 1
+
+
+#include <cstdlib>
+#include <algorithm>
+#include <type_traits>
+
+
+namespace matrix
+{
+
+
+/**
+ *  Solve L X = B in place for the n x m right-hand side matrix b[0..n-1][0..m-1]
+ *  where L is lower triangular with elements l(i, k), k < i, and diagonal diag(i).
+ *
+ *  The columns of B are done a tile at a time and the rows a block at a time:
+ *  the diagonal block is solved and then the rows below are updated with
+ *  a matrix-matrix product.  The innermost loops run along the rows of b
+ *  so the elements of all right-hand sides are swept contiguously.
+ */
+template<typename Lower, typename Diag, typename Matrix>
+  void
+  trsm_lower(const std::size_t n, const std::size_t m,
+             Lower l, Diag diag, Matrix & b,
+             std::size_t block_size = 64, std::size_t tile = 256)
+  {
+    using NumTp = std::decay_t<decltype(b[0][0])>;
+
+    for (std::size_t jj = 0; jj < m; jj += tile)
+      {
+        const std::size_t je = std::min(m, jj + tile);
+        for (std::size_t i0 = 0; i0 < n; i0 += block_size)
+          {
+            const std::size_t i1 = std::min(n, i0 + block_size);
+
+            //  Solve the diagonal block.
+            for (std::size_t i = i0; i < i1; ++i)
+              {
+                auto & bi = b[i];
+                for (std::size_t k = i0; k < i; ++k)
+                  {
+                    const NumTp lik = l(i, k);
+                    const auto & bk = b[k];
+                    for (std::size_t j = jj; j < je; ++j)
+                      bi[j] -= lik * bk[j];
+                  }
+                const NumTp rdiag = NumTp(1) / diag(i);
+                if (rdiag != NumTp(1))
+                  for (std::size_t j = jj; j < je; ++j)
+                    bi[j] *= rdiag;
+              }
+
+            //  Update the rows below.
+            for (std::size_t i = i1; i < n; ++i)
+              {
+                auto & bi = b[i];
+                for (std::size_t k = i0; k < i1; ++k)
+                  {
+                    const NumTp lik = l(i, k);
+                    const auto & bk = b[k];
+                    for (std::size_t j = jj; j < je; ++j)
+                      bi[j] -= lik * bk[j];
+                  }
+              }
+          }
+      }
+  }
+
+
+/**
+ *  Solve U X = B in place for the n x m right-hand side matrix b[0..n-1][0..m-1]
+ *  where U is upper triangular with elements u(i, k), k > i, and diagonal diag(i).
+ *  The blocking is as for trsm_lower() working up from the last row.
+ */
+template<typename Upper, typename Diag, typename Matrix>
+  void
+  trsm_upper(const std::size_t n, const std::size_t m,
+             Upper u, Diag diag, Matrix & b,
+             std::size_t block_size = 64, std::size_t tile = 256)
+  {
+    using NumTp = std::decay_t<decltype(b[0][0])>;
+
+    for (std::size_t jj = 0; jj < m; jj += tile)
+      {
+        const std::size_t je = std::min(m, jj + tile);
+        for (std::size_t i1 = n; i1 > 0; )
+          {
+            const std::size_t i0 = i1 > block_size ? i1 - block_size : 0;
+
+            //  Solve the diagonal block.
+            for (std::size_t i = i1; i-- > i0; )
+              {
+                auto & bi = b[i];
+                for (std::size_t k = i + 1; k < i1; ++k)
+                  {
+                    const NumTp uik = u(i, k);
+                    const auto & bk = b[k];
+                    for (std::size_t j = jj; j < je; ++j)
+                      bi[j] -= uik * bk[j];
+                  }
+                const NumTp rdiag = NumTp(1) / diag(i);
+                if (rdiag != NumTp(1))
+                  for (std::size_t j = jj; j < je; ++j)
+                    bi[j] *= rdiag;
+              }
+
+            //  Update the rows above.
+            for (std::size_t i = 0; i < i0; ++i)
+              {
+                auto & bi = b[i];
+                for (std::size_t k = i0; k < i1; ++k)
+                  {
+                    const NumTp uik = u(i, k);
+                    const auto & bk = b[k];
+                    for (std::size_t j = jj; j < je; ++j)
+                      bi[j] -= uik * bk[j];
+                  }
+              }
+
+            i1 = i0;
+          }
+      }
+  }
+
+}  //  namespace matrix
+
+#endif  //  TRIANGULAR_SOLVE_TCC
@@ -3,41 +3,379 @@
 
 
 #include <cmath>
+#include <cstddef>
+#include <array>
 #include <vector>
 #include <iterator>
+#include <algorithm>
+#include <stdexcept>
+
+#include "roots.tcc"
 
 
 /**
- *    Given values for n dependent variables y and their derivatives dydx known at x,
- *    use fourth-order Runge-Kutta method to advance the solution over an interval h and returns
- *    the incremented variables as yout, (which need not be a distinct array from y).
+ *  State vectors are anything with size() and operator[] - std::array, std::vector,
+ *  std::valarray.  The integrators below do all their arithmetic in place on
+ *  buffers they own so that a fixed-size state such as std::array<double, 6> never
+ *  touches the heap.  The derivative is any callable deriv(y, x, dydx) that writes
+ *  dy/dx at (x, y) into dydx.
+ *
+ *  The buffers of a stepper are copies of a prototype state; for a fixed-size state
+ *  the prototype can be omitted.
+ */
+template<typename StateVec>
+  inline std::size_t
+  state_size(const StateVec & y)
+  { return y.size(); }
+
+
+/**
+ *  This stepper holds the stage buffers for the classical fourth-order Runge-Kutta step.
  */
+template<typename StateVec, typename RealTp = double>
+  class runge_kutta_4_stepper
+  {
+  public:
+
+    runge_kutta_4_stepper() = default;
+
+    explicit
+    runge_kutta_4_stepper(const StateVec & proto)
+    : m_dym(proto), m_dyt(proto), m_yt(proto),
+      m_y_sav(proto), m_y_temp(proto), m_y_mid(proto), m_dy_mid(proto)
+    { }
+
+    /**
+     *  Advance y with derivative dydx at x over the interval h into y_out
+     *  (which need not be distinct from y).
+     */
+    template<typename Deriv>
+      void
+      step(Deriv & deriv, const StateVec & y, const StateVec & dydx,
+           RealTp x, RealTp h, StateVec & y_out)
+      {
+        const auto n = state_size(y);
+        const auto h2 = h / 2;
+        const auto h6 = h / 6;
+        const auto xh = x + h2;
+
+        for (std::size_t i = 0; i < n; ++i)
+          m_yt[i] = y[i] + h2 * dydx[i];
+        deriv(m_yt, xh, m_dyt);
+
+        for (std::size_t i = 0; i < n; ++i)
+          m_yt[i] = y[i] + h2 * m_dyt[i];
+        deriv(m_yt, xh, m_dym);
+
+        for (std::size_t i = 0; i < n; ++i)
+          {
+            m_yt[i] = y[i] + h * m_dym[i];
+            m_dym[i] += m_dyt[i];
+          }
+        deriv(m_yt, x + h, m_dyt);
+
+        for (std::size_t i = 0; i < n; ++i)
+          y_out[i] = y[i] + h6 * (dydx[i] + m_dyt[i] + 2 * m_dym[i]);
+      }
+
+    /**
+     *  Fourth-order Runge-Kutta step with step doubling to monitor the local
+     *  truncation error and adjust the stepsize.  The arguments are as for
+     *  cash_karp_stepper::quad_step().
+     */
+    template<typename Deriv>
+      void
+      quad_step(Deriv & deriv, StateVec & y, const StateVec & dydx, RealTp & x,
+                RealTp h_try, RealTp eps, const StateVec & yscale,
+                RealTp & h_final, RealTp & h_next);
+
+    /**
+     *  Give the state and derivative at the middle of the last step taken
+     *  by quad_step() to the dense output.  They come from the two half steps.
+     */
+    template<typename DenseOutput>
+      void
+      dense_midpoint(DenseOutput & dense) const
+      { dense.set_midpoint(m_y_mid, m_dy_mid); }
+
+  private:
+
+    StateVec m_dym;
+    StateVec m_dyt;
+    StateVec m_yt;
+
+    StateVec m_y_sav;
+    StateVec m_y_temp;
+    StateVec m_y_mid;
+    StateVec m_dy_mid;
+  };
+
+
 template<typename StateVec, typename RealTp>
-  StateVec
-  runge_kutta_4(const StateVec & y, const StateVec & dydx,
-        	RealTp x, RealTp h)
+  template<typename Deriv>
+    void
+    runge_kutta_4_stepper<StateVec, RealTp>::
+    quad_step(Deriv & deriv, StateVec & y, const StateVec & dydx, RealTp & x,
+              RealTp h_try, RealTp eps, const StateVec & yscale,
+              RealTp & h_final, RealTp & h_next)
+    {
+      constexpr RealTp POW_GROW = -0.20;
+      constexpr RealTp POW_SHRINK = -0.25;
+      constexpr RealTp F_CORR = 1.0 / 15.0;
+      constexpr RealTp F_SAFETY = 0.9;
+      //  ERR_COND = (4 / F_SAFETY)^(1 / POW_GROW)
+      constexpr RealTp ERR_COND = 6.0e-4;
+
+      const auto n = state_size(y);
+
+      for (std::size_t i = 0; i < n; ++i)
+        m_y_sav[i] = y[i];
+      const auto x_sav = x;
+
+      //  Set stepsize to the initial trial value.
+      auto h = h_try;
+      while (true)
+        {
+          //  Take two half steps.
+          const auto h2 = h / 2;
+          step(deriv, m_y_sav, dydx, x_sav, h2, m_y_mid);
+          x = x_sav + h2;
+          deriv(m_y_mid, x, m_dy_mid);
+          step(deriv, m_y_mid, m_dy_mid, x, h2, y);
+          x = x_sav + h;
+          if (x == x_sav)
+            throw std::logic_error("step size too small in quad_runge_kutta");
+
+          //  Take the large step.
+          step(deriv, m_y_sav, dydx, x_sav, h, m_y_temp);
+
+          //  Evaluate accuracy.  Put the error estimate into m_y_temp.
+          auto errmax = RealTp(0);
+          for (std::size_t i = 0; i < n; ++i)
+            {
+              m_y_temp[i] = y[i] - m_y_temp[i];
+              errmax = std::max(errmax, std::abs(m_y_temp[i] / yscale[i]));
+            }
+
+          //  Scale relative to required tolerance.
+          errmax /= eps;
+          if (errmax <= RealTp(1))
+            {
+              //  Step succeeded.  Compute size of next step.
+              h_final = h;
+              h_next = (errmax > ERR_COND ? F_SAFETY * h * std::pow(errmax, POW_GROW) : 4 * h);
+              break;
+            }
+          //  Truncation error too large, reduce stepsize.
+          h = F_SAFETY * h * std::pow(errmax, POW_SHRINK);
+        }
+
+      //  Mop up fifth order truncation error.
+      for (std::size_t i = 0; i < n; ++i)
+        y[i] += F_CORR * m_y_temp[i];
+    }
+
+
+/**
+ *  This stepper holds the stage buffers for the embedded fifth-order Cash-Karp
+ *  Runge-Kutta step and its adaptive driver.
+ */
+template<typename StateVec, typename RealTp = double>
+  class cash_karp_stepper
   {
-    auto n = std::distance(std::begin(y), std::end(y));
-    std::vector<RealTp> dym(n);
-    std::vector<RealTp> dyt(n);
-    std::vector<RealTp> yt(n);
+  public:
+
+    cash_karp_stepper() = default;
+
+    explicit
+    cash_karp_stepper(const StateVec & proto)
+    : m_ak2(proto), m_ak3(proto), m_ak4(proto), m_ak5(proto), m_ak6(proto),
+      m_y_temp(proto), m_y_err(proto)
+    { }
+
+    /**
+     *  Take one Cash-Karp step of size h from (x, y) with derivative dydx.
+     *  The fifth-order result is put in y_out and the error estimate in y_err.
+     *  y_out must be distinct from y.
+     */
+    template<typename Deriv>
+      void
+      step(Deriv & deriv, const StateVec & y, const StateVec & dydx,
+           RealTp x, RealTp h, StateVec & y_out, StateVec & y_err);
+
+    /**
+     *  Fifth-order Runge-Kutta step with monitoring of local truncation error to ensure
+     *  accuracy and adjust stepsize.  Input are the dependent variable vector y
+     *  and its derivative dydx at the starting value of the independent variable x.
+     *  Also input are the first guess for the stepsize h_try, the requred accuracy eps, and the
+     *  vector yscale against which the error is scaled independently for each dependent variable.
+     *  On output, x and y are replaced by thier new values, h_final is the stepsize which was actually
+     *  accomplished, and h_next is the estimated next stepsize.
+     */
+    template<typename Deriv>
+      void
+      quad_step(Deriv & deriv, StateVec & y, const StateVec & dydx, RealTp & x,
+                RealTp h_try, RealTp eps, const StateVec & yscale,
+                RealTp & h_final, RealTp & h_next);
+
+    /**
+     *  Give the state at the middle of the last step taken by quad_step()
+     *  to the dense output.  It is a fourth-order combination of the stages
+     *  of the step and the derivative at its end, so costs no calls of deriv.
+     */
+    template<typename DenseOutput>
+      void
+      dense_midpoint(DenseOutput & dense);
+
+  private:
+
+    StateVec m_ak2;
+    StateVec m_ak3;
+    StateVec m_ak4;
+    StateVec m_ak5;
+    StateVec m_ak6;
+    StateVec m_y_temp;
+    StateVec m_y_err;
+  };
 
-    auto h2 = h / 2;
-    auto h6 = h / 6;
-    auto xh = x + h2;
 
-    yt = y + h2 * dydx;
-    dyt = deriv(yt, xh);
+template<typename StateVec, typename RealTp>
+  template<typename Deriv>
+    void
+    cash_karp_stepper<StateVec, RealTp>::
+    step(Deriv & deriv, const StateVec & y, const StateVec & dydx,
+         RealTp x, RealTp h, StateVec & y_out, StateVec & y_err)
+    {
+      static constexpr RealTp
+        a2 = 0.2, a3 = 0.3, a4 = 0.6, a5 = 1.0, a6 = 0.875,
+        b21 = 0.2,
+        b31 = 3.0/40.0, b32 = 9.0/40.0,
+        b41 = 0.3, b42 = -0.9, b43 = 1.2,
+        b51 = -11.0/54.0, b52 = 2.5, b53 = -70.0/27.0, b54 = 35.0/27.0,
+        b61 = 1631.0/55296.0, b62 = 175.0/512.0, b63 = 575.0/13824.0, b64 = 44275.0/110592.0, b65 = 253.0/4096.0,
+        c1 = 37.0/378.0, c3 = 250.0/621.0, c4 = 125.0/594.0, c6 = 512.0/1771.0,
+        dc5 = -277.0/14336.0;
+      static constexpr RealTp dc1 = c1 - 2825.0/27648.0, dc3 = c3 - 18575.0/48384.0,
+                              dc4 = c4 - 13525.0/55296.0, dc6 = c6 - 0.25;
+
+      const auto n = state_size(y);
+
+      for (std::size_t i = 0; i < n; ++i)
+        m_y_temp[i] = y[i] + h * b21 * dydx[i];
+      deriv(m_y_temp, x + a2 * h, m_ak2);
+
+      for (std::size_t i = 0; i < n; ++i)
+        m_y_temp[i] = y[i] + h * (b31 * dydx[i] + b32 * m_ak2[i]);
+      deriv(m_y_temp, x + a3 * h, m_ak3);
+
+      for (std::size_t i = 0; i < n; ++i)
+        m_y_temp[i] = y[i] + h * (b41 * dydx[i] + b42 * m_ak2[i] + b43 * m_ak3[i]);
+      deriv(m_y_temp, x + a4 * h, m_ak4);
+
+      for (std::size_t i = 0; i < n; ++i)
+        m_y_temp[i] = y[i] + h * (b51 * dydx[i] + b52 * m_ak2[i] + b53 * m_ak3[i]
+                                + b54 * m_ak4[i]);
+      deriv(m_y_temp, x + a5 * h, m_ak5);
+
+      for (std::size_t i = 0; i < n; ++i)
+        m_y_temp[i] = y[i] + h * (b61 * dydx[i] + b62 * m_ak2[i] + b63 * m_ak3[i]
+                                + b64 * m_ak4[i] + b65 * m_ak5[i]);
+      deriv(m_y_temp, x + a6 * h, m_ak6);
+
+      for (std::size_t i = 0; i < n; ++i)
+        {
+          y_out[i] = y[i] + h * (c1 * dydx[i] + c3 * m_ak3[i] + c4 * m_ak4[i]
+                               + c6 * m_ak6[i]);
+          y_err[i] = h * (dc1 * dydx[i] + dc3 * m_ak3[i] + dc4 * m_ak4[i]
+                        + dc5 * m_ak5[i] + dc6 * m_ak6[i]);
+        }
+    }
+
+
+template<typename StateVec, typename RealTp>
+  template<typename Deriv>
+    void
+    cash_karp_stepper<StateVec, RealTp>::
+    quad_step(Deriv & deriv, StateVec & y, const StateVec & dydx, RealTp & x,
+              RealTp h_try, RealTp eps, const StateVec & yscale,
+              RealTp & h_final, RealTp & h_next)
+    {
+      constexpr RealTp POW_GROW = -0.20;
+      constexpr RealTp POW_SHRINK = -0.25;
+      constexpr RealTp F_SAFETY = 0.9;
+      //  ERR_COND = (5 / F_SAFETY)^(1 / POW_GROW)
+      constexpr RealTp ERR_COND = 1.89e-4;
+
+      const auto n = state_size(y);
+
+      RealTp errmax;
+      auto h = h_try;
+      while (true)
+        {
+          step(deriv, y, dydx, x, h, m_y_temp, m_y_err);
+          errmax = RealTp(0);
+          for (std::size_t i = 0; i < n; ++i)
+            errmax = std::max(errmax, std::abs(m_y_err[i] / yscale[i]));
+          errmax /= eps;
+          if (errmax <= RealTp(1))
+            break;
+          auto h_temp = F_SAFETY * h * std::pow(errmax, POW_SHRINK);
+          h = (h > 0 ? std::max(h_temp, RealTp(0.1) * h)
+                     : std::min(h_temp, RealTp(0.1) * h));
+          auto x_new = x + h;
+          if (x_new == x)
+            throw std::logic_error("Stepsize underflow in quad_cash_karp_rk");
+        }
+
+      if (errmax > ERR_COND)
+        h_next = F_SAFETY * h * std::pow(errmax, POW_GROW);
+      else
+        h_next = 5 * h;
+      x += h_final = h;
+      for (std::size_t i = 0; i < n; ++i)
+        y[i] = m_y_temp[i];
+    }
 
-    yt = y + h2 * dyt;
-    dym = deriv(yt, xh);
 
-    yt = y + h * dym;
-    dym += dyt;
+template<typename StateVec, typename RealTp>
+  template<typename DenseOutput>
+    void
+    cash_karp_stepper<StateVec, RealTp>::
+    dense_midpoint(DenseOutput & dense)
+    {
+      //  Weights of f0, k3, k4, k6 and f1 satisfying the fourth-order
+      //  conditions for the solution at half the step.
+      static constexpr RealTp
+        d1 = 331.0/3024.0, d3 = 875.0/2484.0, d4 = 625.0/9504.0,
+        d6 = -104.0/1771.0, d7 = 1.0/32.0;
+
+      const auto & y0 = dense.y_begin();
+      const auto & f0 = dense.dydx_begin();
+      const auto & f1 = dense.dydx_end();
+      const auto h = dense.x_end() - dense.x_begin();
+      const auto n = state_size(y0);
+      for (std::size_t i = 0; i < n; ++i)
+        m_y_temp[i] = y0[i] + h * (d1 * f0[i] + d3 * m_ak3[i] + d4 * m_ak4[i]
+                                 + d6 * m_ak6[i] + d7 * f1[i]);
+      dense.set_midpoint(m_y_temp);
+    }
 
-    dyt = deriv(yt, x + h);
 
-    return y + h6 * (dydx + dyt + 2 * dym);
+/**
+ *    Given values for n dependent variables y and their derivatives dydx known at x,
+ *    use fourth-order Runge-Kutta method to advance the solution over an interval h and returns
+ *    the incremented variables.
+ *    For repeated steps construct a runge_kutta_4_stepper once and call its step().
+ */
+template<typename StateVec, typename RealTp, typename Deriv>
+  StateVec
+  runge_kutta_4(const StateVec & y, const StateVec & dydx,
+        	RealTp x, RealTp h, Deriv deriv)
+  {
+    runge_kutta_4_stepper<StateVec, RealTp> rk4(y);
+    StateVec y_out = y;
+    rk4.step(deriv, y, dydx, x, h, y_out);
+    return y_out;
   }
 
 
@@ -50,29 +388,32 @@ template<typename StateVec, typename RealTp>
  *  through a back inserter.
  */
 template<typename StateVec, typename RealTpOutIter,
-         typename RealTp, typename StateVecOutIter>
+         typename RealTp, typename StateVecOutIter, typename Deriv>
   void
   dumb_runge_kutta(const StateVec & y1, RealTp x1, RealTp x2, int n_step,
-                   RealTpOutIter x_tab, StateVecOutIter y_tab)
+                   RealTpOutIter x_tab, StateVecOutIter y_tab, Deriv deriv)
   {
+    runge_kutta_4_stepper<StateVec, RealTp> rk4(y1);
+
     //  Load starting values of dependant variables.
     StateVec y = y1;
-    y_tab[0] = y;
-    x_tab[0] = x1;
+    StateVec dydx = y1;
+    *y_tab++ = y;
+    *x_tab++ = x1;
     auto x = x1;
     auto h = (x2 - x1) / n_step;
 
     //  Take nstep steps in the independant variable x.
     for (int k = 1; k <= n_step; ++k)
       {
-	auto y_out = runge_kutta_4(y, deriv(y, x), x, h);
+	deriv(y, x, dydx);
+	rk4.step(deriv, y, dydx, x, h, y);
 	if (x + h == x)
           throw std::logic_error("step size too small in dumb_runge_kutta");
 	x += h;
 	//  Store intermediate results.
-	x_tab[k] = x;
-	y = y_out;
-	y_tab[k] = y;
+	*x_tab++ = x;
+	*y_tab++ = y;
       }
   }
 
@@ -80,149 +421,54 @@ template<typename StateVec, typename RealTpOutIter,
 
 
 /**
- *    Fifth-order Runge-Kutta step with monitoring of local truncation error to ensure
+ *    Fourth-order Runge-Kutta step with monitoring of local truncation error to ensure
  *    accuracy and adjust stepsize.  Input are the dependent variable state vector y
  *    and its derivative dydx at the starting value of the independent variable x.
  *    Also input are the first guess for the stepsize h_try, the requred accuracy eps, and the
- *    vector yscale[1..n] against which the error is scaled independently for each dependent variable.
+ *    vector yscale against which the error is scaled independently for each dependent variable.
  *    On output, x and y are replaced by thier new values, h_final is the stepsize which was actually
  *    accomplished, and h_next is the estimated next stepsize.
+ *    For repeated steps construct a runge_kutta_4_stepper once and call its quad_step().
  */
-template<typename StateVec, typename RealTp>
-void
-  quad_runge_kutta(StateVec & y, StateVec & dydx, RealTp & x, RealTp h_try,
-                   double eps, StateVec & yscale, RealTp & h_final, RealTp & h_next)
+template<typename StateVec, typename RealTp, typename Deriv>
+  void
+  quad_runge_kutta(StateVec & y, const StateVec & dydx, RealTp & x, RealTp h_try,
+                   RealTp eps, const StateVec & yscale, RealTp & h_final, RealTp & h_next,
+                   Deriv deriv)
   {
-    constexpr double POW_GROW = 10000;
-    constexpr double POW_SHRINK = 1.0e-30;
-    constexpr double F_CORR = 1.0 / 15.0;
-    constexpr double F_SAFETY = 0.9;
-    constexpr double ERR_COND = std::pow((4.0 / F_SAFETY), (1.0 / POW_GROW));
-
-    auto dysav = dydx;
-    auto ysav = y;
-    auto xsav = x;
-
-    //  Set stepsize to the initial trial value.
-    auto h = h_try;
-    while (true)
-      {
-	//  Take two half steps.
-	auto h2 = h / 2;
-	auto ytemp = runge_kutta_4(ysav, dysav, xsav, h2);
-	x = xsav + h2;
-	dydx = deriv(ytemp, x);
-	y = runge_kutta_4(ytemp, dydx, x, h2);
-	x = xsav + h;
-	if (x == xsav)
-          throw std::logic_error("step size too small in quad_runge_kutta");
-
-	//  Take the large step.
-	ytemp = runge_kutta_4(ysav, dysav, xsav, h);
-
-	//  Evaluate accuracy.  Put the error estimate into ytemp.
-	ytemp = y - ytemp;
-	auto errmax = max(abs(ytemp[i] / yscale[i]));
-
-	//  Scale relative to required tolerance.
-	errmax /= eps;
-	if (errmax <= 1.0)
-          {
-            //  Step succeeded.  Compute size of next step.
-            h_final = h;
-            h_next = (errmax > ERR_COND ? F_SAFETY * std::exp(POW_GROW * std::log(errmax)) : 4 * h);
-            break;
-          }
-	//  Truncation error too large, reduce stepsize.
-	h = F_SAFETY * h * std::exp(POW_SHRINK * std::log(errmax));
-      }
-    //  Mop up fifth order truncation error.
-    y += F_CORR * ytemp;
+    runge_kutta_4_stepper<StateVec, RealTp> rk4(y);
+    rk4.quad_step(deriv, y, dydx, x, h_try, eps, yscale, h_final, h_next);
   }
 
 
-
 /**
  * Cash-Carp Runge-Kutta algorithm.
+ * For repeated steps construct a cash_karp_stepper once and call its step().
  */
-template<typename StateVec, typename RealTp>
+template<typename StateVec, typename RealTp, typename Deriv>
   void
   cash_karp_rk(const StateVec & y, const StateVec & dydx,
-               RealTp x, RealTp h, StateVec & y_out, StateVec & y_err)
+               RealTp x, RealTp h, StateVec & y_out, StateVec & y_err,
+               Deriv deriv)
   {
-    static constexpr RealTp
-      a2 = 0.2, a3 = 0.3, a4 = 0.6, a5 = 1.0, a6 = 0.875,
-      b21 = 0.2,
-      b31 = 3.0/40.0, b32 = 9.0/40.0,
-      b41 = 0.3, b42 = -0.9, b43 = 1.2,
-      b51 = -11.0/54.0, b52 = 2.5, b53 = -70.0/27.0, b54 = 35.0/27.0,
-      b61 = 1631.0/55296.0, b62 = 175.0/512.0, b63 = 575.0/13824.0, b64 = 44275.0/110592.0, b65 = 253.0/4096.0,
-      c1 = 37.0/378.0, c3 = 250.0/621.0, c4 = 125.0/594.0, c6 = 512.0/1771.0,
-      dc5 = -277.0/14336.0;
-    static constexpr RealTp dc1 = c1 - 2825.0/27648.0, dc3 = c3 - 18575.0/48384.0,
-                            dc4 = c4 - 13525.0/55296.0, dc6 = c6 - 0.25;
-
-    y_temp = y + h * b21 * dydx;
-
-    ak2 = deriv(y_temp, x + a2 * h);
-    y_temp = y + h * (b31 * dydx + b32 * ak2);
-
-    ak3 = deriv(y_temp, x + a3 * h);
-    y_temp = y + h * (b41 * dydx + b42 * ak2 + b43 * ak3);
-
-    ak4 = deriv(y_temp, x + a4 * h);
-    y_temp = y + h * (b51 * dydx + b52 * ak2 + b53 * ak3 + b54 * ak4);
-
-    ak5 = deriv(y_temp, x + a5 * h);
-    ytemp = y + h * (b61 * dydx + b62 * ak2 + b63 * ak3 + b64 * ak4 + b65 * ak5);
-
-    ak6 = deriv(ytemp, x + a6 * h);
-    f_yout = y + h * (c1 * dydx + c3 * ak3 + c4 * ak4 + c6 * ak6);
-
-    y_err = h * (dc1 * dydx + dc3 * ak3 + dc4 * ak4 + dc5 * ak5 + dc6 * ak6);
+    cash_karp_stepper<StateVec, RealTp> ck(y);
+    ck.step(deriv, y, dydx, x, h, y_out, y_err);
   }
 
 
 /**
  *    Fifth-order Runge-Kutta step with monitoring of local truncation error to ensure
- *    accuracy and adjust stepsize.  Input are the dependent variable vector y
- *    and its derivative dydx at the starting value of the independent variable x.
- *    Also input are the first guess for the stepsize h_try, the requred accuracy eps, and the
- *    vector yscale against which the error is scaled independently for each dependent variable.
- *    On output, x and y are replaced by thier new values, h_final is the stepsize which was actually
- *    accomplished, and h_next is the estimated next stepsize.
+ *    accuracy and adjust stepsize.  See cash_karp_stepper::quad_step().
+ *    For repeated steps construct a cash_karp_stepper once and call its quad_step().
  */
-template<typename StateVec, typename RealTp>
+template<typename StateVec, typename RealTp, typename Deriv>
 void
-  quad_cash_karp_rk(StateVec & y, StateVec & dydx, RealTp & x, RealTp h_try,
-                    RealTp eps, StateVec & yscale, RealTp & h_final, RealTp & h_next)
+  quad_cash_karp_rk(StateVec & y, const StateVec & dydx, RealTp & x, RealTp h_try,
+                    RealTp eps, const StateVec & yscale, RealTp & h_final, RealTp & h_next,
+                    Deriv deriv)
   {
-    constexpr double POW_GROW = -0.20;
-    constexpr double POW_SHRINK = -0.25;
-    constexpr double F_SAFETY = 0.9;
-    constexpr double ERR_COND = std::pow(5 / F_SAFETY, 1 / POW_GROW);
-
-    auto h = h_try;
-    while (true)
-      {
-	cash_karp_rk(y, dydx, x, h, ytemp, yerr);
-	auto errmax = std::max(std::abs(yerr[i] / yscale[i]));
-	errmax /= eps;
-	if (errmax <= 1.0)
-          break;
-	auto h_temp = F_SAFETY * h * std::pow(errmax, POW_SHRINK);
-	h = (h > 0 ? std::max(h_temp, 0.1 * h) : std::min(h_temp, 0.1 * h));
-	auto x_new= x + h;
-	if (x_new == x)
-          throw std::logic_error("Stepsize underflow in quad_cash_karp_rk");
-      }
-
-    if (errmax > ERR_COND)
-      h_next = F_SAFETY * h * std::pow(errmax, POW_GROW);
-    else
-      h_next = 5 * h;
-    x += h_final = h;
-    y = ytemp;
+    cash_karp_stepper<StateVec, RealTp> ck(y);
+    ck.quad_step(deriv, y, dydx, x, h_try, eps, yscale, h_final, h_next);
   }
 
 
@@ -238,67 +484,70 @@ double ode_dxsave = 0;
 
 /**
  *    ODE driver with adaptive stepsize control.  Integrate starting with values
- *    y1[1..nvar] from x1 to x2 with accuracy eps, storing intermediate results
+ *    y1 from x1 to x2 with accuracy eps, storing intermediate results
  *    in global variables ode_xp, ode_yp, ode_max, ode_count, ode_dxsave.  If ode_max == 0 no intermediate results
  *    will be stored and the pointers ode_xp and ode_yp can be set to zero.
  *    h1 should be set as a first guess initial stepsize, hmin is the minimum stepsize (can be zero).
  *    On output nok and nbad are the numbers of good and bad (but retried and fixed) steps taken.
  *    y1 is replaced by stepped values at the end of the integration interval.
- *    stepper is the name of the integration stepper to be used (e.g. quad_runge_kutta or bulirsch_stoer).
+ *    stepper is the integration stepper to be used (e.g. a cash_karp_stepper or
+ *    a bulirsch_stoer_stepper); it is reused for every step so the integration
+ *    does not allocate for a fixed-size state.
  */
-template<typename StateVec, typename RealTp>
+template<typename StateVec, typename RealTp, typename Stepper, typename Deriv>
   void
-  ode_integrate(double *y1, RealTp x1, RealTp x2,
+  ode_integrate(StateVec & y1, RealTp x1, RealTp x2,
         	RealTp eps, RealTp h1, RealTp hmin,
-        	int *nok, int *nbad,
-        	void (*stepper)(StateVec &, StateVec &, RealTp &, RealTp,
-                        	RealTp, RealTp &, RealTp &, RealTp &))
+        	int & nok, int & nbad,
+        	Stepper & stepper, Deriv deriv)
   {
-    double xsave, h_next, h_final;
-
     constexpr int MAXSTEP = 10000;
-    constexpr double TINY = 1.0e-30;
+    constexpr RealTp TINY = 1.0e-30;
 
-    std::vector<double> yscale(nvar);
-    std::vector<double> y(nvar);
-    std::vector<double> dydx(nvar);
+    const auto n = state_size(y1);
+    StateVec & y = y1;
+    StateVec yscale = y1;
+    StateVec dydx = y1;
 
+    RealTp h_next, h_final;
     auto x = x1;
-    auto h = (x2 > x1) ? std::fabs(h1) : -std::fabs(h1);
+    auto h = (x2 > x1) ? std::abs(h1) : -std::abs(h1);
     nok = nbad = ode_count = 0;
-    y = y1;
-    if (ode_max > 0)
-      xsave = x - 2 * ode_dxsave;
+    auto xsave = x - 2 * ode_dxsave;
     for (int nstep = 0; nstep < MAXSTEP; ++nstep)
      {
-	dydx = deriv(y, x);
-	yscale = std::abs(y) + std::abs(dydx) + TINY;
+	deriv(y, x, dydx);
+	for (std::size_t i = 0; i < n; ++i)
+	  yscale[i] = std::abs(y[i]) + std::abs(h * dydx[i]) + TINY;
 	if (ode_max)
           if (std::abs(x - xsave) > std::abs(ode_dxsave))
             if (ode_count < ode_max - 1)
               {
-        	ode_xp[++ode_count] = x;
-        	ode_yp][ode_count] = y;
+        	ode_xp[ode_count] = x;
+        	for (std::size_t i = 0; i < n; ++i)
+        	  ode_yp[ode_count][i] = y[i];
+        	++ode_count;
         	xsave = x;
               }
-	if ((x + h - x2) * (x + h - x1) > 0.0)
+	if ((x + h - x2) * (x + h - x1) > RealTp(0))
           h = x2 - x;
-	stepper(y, dydx, x, h, eps, yscale, h_final, h_next);
+	stepper.quad_step(deriv, y, dydx, x, h, eps, yscale, h_final, h_next);
 	if (h_final == h)
-          ++(*nok);
+          ++nok;
 	else
-          ++(*nbad);
-	if ((x - x2) * (x2 - x1) >= 0.0)
+          ++nbad;
+	if ((x - x2) * (x2 - x1) >= RealTp(0))
           {
-            y1 = y; 
             if (ode_max)
               {
-        	ode_xp[++ode_count] = x;
-        	ode_yp[ode_count] = y;
+        	ode_xp[ode_count] = x;
+        	for (std::size_t i = 0; i < n; ++i)
+        	  ode_yp[ode_count][i] = y[i];
+        	++ode_count;
               }
             return;
           }
-	if (std::fabs(h_next) <= hmin)
+	if (std::abs(h_next) <= hmin)
           throw std::logic_error("Step size to small in ode_integrate");
 	h = h_next;
     }
@@ -306,275 +555,794 @@ template<typename StateVec, typename RealTp>
   }
 
 
+/**
+ *  Continuous output over one step of an adaptive stepper.  The solution between
+ *  accepted points (x0, y0) and (x1, y1) is the Hermite interpolant that matches
+ *  the states and the derivatives f0, f1 at both ends and, if the stepper supplies it,
+ *  the state (and derivative) at the middle of the step.  The end derivatives are those
+ *  the driver evaluates anyway to start each step, so sampling costs no calls of deriv.
+ *  The interpolant is cubic with no midpoint, quartic with a midpoint state
+ *  and quintic with a midpoint state and derivative.
+ */
+template<typename StateVec, typename RealTp = double>
+  class ode_dense_output
+  {
+  public:
+
+    ode_dense_output() = default;
+
+    explicit
+    ode_dense_output(const StateVec & proto)
+    : m_y0(proto), m_f0(proto), m_y1(proto), m_f1(proto), m_ym(proto), m_fm(proto)
+    { }
+
+    /**
+     *  Record the start of a step.
+     */
+    void
+    begin_step(RealTp x0, const StateVec & y0, const StateVec & f0)
+    {
+      const auto n = state_size(y0);
+      m_x0 = x0;
+      for (std::size_t i = 0; i < n; ++i)
+        {
+          m_y0[i] = y0[i];
+          m_f0[i] = f0[i];
+        }
+    }
+
+    /**
+     *  Record the end of an accepted step.
+     */
+    void
+    end_step(RealTp x1, const StateVec & y1, const StateVec & f1)
+    {
+      const auto n = state_size(y1);
+      m_x1 = x1;
+      for (std::size_t i = 0; i < n; ++i)
+        {
+          m_y1[i] = y1[i];
+          m_f1[i] = f1[i];
+        }
+      m_mid = 0;
+    }
+
+    /**
+     *  Record the state at the middle of the step.
+     */
+    void
+    set_midpoint(const StateVec & ym)
+    {
+      const auto n = state_size(ym);
+      for (std::size_t i = 0; i < n; ++i)
+        m_ym[i] = ym[i];
+      m_mid = 1;
+    }
+
+    /**
+     *  Record the state and derivative at the middle of the step.
+     */
+    void
+    set_midpoint(const StateVec & ym, const StateVec & fm)
+    {
+      const auto n = state_size(ym);
+      for (std::size_t i = 0; i < n; ++i)
+        {
+          m_ym[i] = ym[i];
+          m_fm[i] = fm[i];
+        }
+      m_mid = 2;
+    }
+
+    /**
+     *  Estimate the interpolation error over the step relative to yscale.
+     *  This is the largest contribution of the midpoint derivative to the quintic,
+     *  which is what the long steps of bulirsch_stoer_stepper rely on.
+     *  For the lower-order interpolants the estimate is zero.
+     */
+    RealTp
+    error(const StateVec & yscale) const
+    {
+      const auto n = state_size(m_y0);
+      const auto h = m_x1 - m_x0;
+      RealTp err = 0;
+      if (m_mid == 2)
+        for (std::size_t i = 0; i < n; ++i)
+          {
+            //  max |t^2 (t - 1)^2 (t - 1/2)| = 1 / (125 sqrt(5)) at t = 1/2 + 1/sqrt(20).
+            const auto dy_half = RealTp(1.5) * (m_y1[i] - m_y0[i]) - h * (m_f0[i] + m_f1[i]) / 4;
+            err = std::max(err, std::abs(RealTp(16.0 / (125.0 * std::sqrt(5.0)))
+                                         * (h * m_fm[i] - dy_half) / yscale[i]));
+          }
+      return err;
+    }
+
+    const StateVec &
+    y_begin() const
+    { return m_y0; }
+
+    const StateVec &
+    dydx_begin() const
+    { return m_f0; }
+
+    const StateVec &
+    dydx_end() const
+    { return m_f1; }
+
+    RealTp
+    x_begin() const
+    { return m_x0; }
+
+    RealTp
+    x_end() const
+    { return m_x1; }
+
+    /**
+     *  Put the interpolated state at x (in the current step) into y.
+     */
+    void
+    interpolate(RealTp x, StateVec & y) const
+    {
+      const auto n = state_size(m_y0);
+      const auto h = m_x1 - m_x0;
+      const auto t = (x - m_x0) / h;
+      const auto t1 = t - 1;
+      //  The correction t^2 (t - 1)^2 (a + b (t - 1/2)) vanishes with its slope
+      //  at both ends; a and b fit the midpoint state and derivative.
+      const auto w = t * t * t1 * t1;
+      for (std::size_t i = 0; i < n; ++i)
+        {
+          const auto dy = m_y1[i] - m_y0[i];
+          y[i] = m_y0[i] + t * dy
+               + t * t1 * ((1 - 2 * t) * dy + t1 * h * m_f0[i] + t * h * m_f1[i]);
+          if (m_mid > 0)
+            {
+              const auto y_half = (m_y0[i] + m_y1[i]) / 2 + h * (m_f0[i] - m_f1[i]) / 8;
+              auto c = 16 * (m_ym[i] - y_half);
+              if (m_mid > 1)
+                {
+                  const auto dy_half = RealTp(1.5) * dy - h * (m_f0[i] + m_f1[i]) / 4;
+                  c += 16 * (h * m_fm[i] - dy_half) * (t - RealTp(0.5));
+                }
+              y[i] += w * c;
+            }
+        }
+    }
+
+  private:
+
+    RealTp m_x0 = 0;
+    RealTp m_x1 = 0;
+    int m_mid = 0;
+    StateVec m_y0;
+    StateVec m_f0;
+    StateVec m_y1;
+    StateVec m_f1;
+    StateVec m_ym;
+    StateVec m_fm;
+  };
+
+
+/**
+ *  An event function that never changes sign.
+ */
+struct ode_no_event
+{
+  template<typename StateVec, typename RealTp>
+    RealTp
+    operator()(RealTp, const StateVec &) const
+    { return RealTp(1); }
+};
+
+
+/**
+ *  ODE driver with adaptive stepsize control, dense output and event detection.
+ *  The arguments up to deriv are as for ode_integrate().
+ *
+ *  Instead of the states at the accepted steps, the states at the abscissas
+ *  [x_out_first, x_out_last), sorted in the direction of integration, are written
+ *  to y_out.  They are interpolated within each step with ode_dense_output so
+ *  the stepsize is chosen by the accuracy of the steps rather than by the outputs.
+ *  The stepper supplies the midpoint of each step through dense_midpoint();
+ *  runge_kutta_4_stepper, cash_karp_stepper and bulirsch_stoer_stepper all do.
+ *  A step whose interpolation error is estimated to be more than ten times eps
+ *  is taken again with a smaller stepsize (and counted in nbad).
+ *
+ *  The integration stops at the first zero of event(x, y) if it comes before x2.
+ *  The zero is bracketed by a sign change over an accepted step and found with
+ *  root_brent on the interpolant to within x_tol.  Only the output abscissas up
+ *  to the stop are written.  y1 is replaced by the state at the stop, which
+ *  is returned.  Neither the output nor the event search calls deriv.
+ */
+template<typename StateVec, typename RealTp, typename Stepper, typename Deriv,
+         typename RealTpIter, typename StateVecOutIter, typename Event = ode_no_event>
+  RealTp
+  ode_integrate_dense(StateVec & y1, RealTp x1, RealTp x2,
+                      RealTp eps, RealTp h1, RealTp hmin,
+                      int & nok, int & nbad,
+                      Stepper & stepper, Deriv deriv,
+                      RealTpIter x_out_first, RealTpIter x_out_last,
+                      StateVecOutIter y_out,
+                      Event event = Event{}, RealTp x_tol = RealTp(0))
+  {
+    constexpr int MAXSTEP = 10000;
+    constexpr RealTp TINY = 1.0e-30;
+    constexpr RealTp ERR_DENSE = 10;
+    constexpr RealTp F_SAFETY = 0.9;
+
+    const auto n = state_size(y1);
+    StateVec & y = y1;
+    StateVec yscale = y1;
+    StateVec dydx = y1;
+    StateVec y_temp = y1;
+    ode_dense_output<StateVec, RealTp> dense(y1);
+
+    //  An output abscissa is due once the integration has reached it.
+    const RealTp dir = (x2 > x1) ? RealTp(1) : RealTp(-1);
+    auto due = [&](RealTp x)
+    { return x_out_first != x_out_last && (*x_out_first - x) * dir <= RealTp(0); };
+
+    RealTp h_next, h_final;
+    auto x = x1;
+    auto h = dir * std::abs(h1);
+    nok = nbad = 0;
+
+    while (due(x))
+      {
+        *y_out++ = y;
+        ++x_out_first;
+      }
+
+    RealTp g = event(x, y);
+    deriv(y, x, dydx);
+    for (int nstep = 0; nstep < MAXSTEP; ++nstep)
+      {
+	for (std::size_t i = 0; i < n; ++i)
+	  yscale[i] = std::abs(y[i]) + std::abs(h * dydx[i]) + TINY;
+	if ((x + h - x2) * (x + h - x1) > RealTp(0))
+          h = x2 - x;
+	dense.begin_step(x, y, dydx);
+	stepper.quad_step(deriv, y, dydx, x, h, eps, yscale, h_final, h_next);
+	if (h_final == h)
+          ++nok;
+	else
+          ++nbad;
+
+	//  The derivative at the new point ends this step and starts the next one.
+	deriv(y, x, dydx);
+	dense.end_step(x, y, dydx);
+	stepper.dense_midpoint(dense);
+
+	//  A step too long for the interpolant is taken again, shorter.
+	const RealTp err_dense = dense.error(yscale) / eps;
+	if (err_dense > ERR_DENSE)
+	  {
+	    x = dense.x_begin();
+	    for (std::size_t i = 0; i < n; ++i)
+	      {
+		y[i] = dense.y_begin()[i];
+		dydx[i] = dense.dydx_begin()[i];
+	      }
+	    h = h_final * std::max(RealTp(0.2), F_SAFETY * std::pow(ERR_DENSE / err_dense, RealTp(0.2)));
+	    ++nbad;
+	    continue;
+	  }
+
+	const RealTp g_new = event(x, y);
+	const bool stop = (g > RealTp(0) && g_new <= RealTp(0))
+		       || (g < RealTp(0) && g_new >= RealTp(0));
+	g = g_new;
+	RealTp x_stop = x;
+	if (stop)
+	  {
+	    auto g_dense = [&](RealTp xx)
+	    {
+	      dense.interpolate(xx, y_temp);
+	      return RealTp(event(xx, y_temp));
+	    };
+	    x_stop = (g_new == RealTp(0))
+		   ? x : root_brent(g_dense, dense.x_begin(), x, x_tol);
+	  }
+
+	while (due(x_stop))
+	  {
+	    dense.interpolate(*x_out_first, y_temp);
+	    *y_out++ = y_temp;
+	    ++x_out_first;
+	  }
+
+	if (stop)
+	  {
+	    if (x_stop != x)
+	      dense.interpolate(x_stop, y);
+	    return x_stop;
+	  }
+	if ((x - x2) * (x2 - x1) >= RealTp(0))
+          return x;
+	if (std::abs(h_next) <= hmin)
+          throw std::logic_error("Step size to small in ode_integrate_dense");
+	h = h_next;
+      }
+    throw std::logic_error("Too many steps in ode_integrate_dense");
+  }
+
+
 /**
  *   Modified midpoint step.  At xs, input the dependent variable vector y,
  *   and its derivative dydx.  Also input is htot, the total step to be made,
  *   and nstep, the number of interior steps to be used.  The output is returned as 
- *   yout, which need not be distinct from y[1..nvar]; if it is distinct
+ *   yout, which need not be distinct from y; if it is distinct
  *   however, then y and dydx will be returned undamaged.  Derivs is the user-supplied
  *   routine for calculating the right-hand side derivative.
+ *   The work vectors ym and yn must be the size of y.
+ *   If y_half is given (and nstep is even) the state and derivative
+ *   at the interior point xs + htot/2 are copied to y_half and dydx_half.
  */
-template<typename StateVec, typename RealTp>
+template<typename StateVec, typename RealTp, typename Deriv>
   void
-  modified_midpoint(double *y, double *dydx, double xs,
-                    double htot, int nstep, double *yout)
+  modified_midpoint(const StateVec & y, const StateVec & dydx, RealTp xs,
+                    RealTp htot, int nstep, StateVec & yout, Deriv & deriv,
+                    StateVec & ym, StateVec & yn,
+                    StateVec * y_half = nullptr, StateVec * dydx_half = nullptr)
   {
-    auto h = htot / nstep;
-    auto ym = y;
-    auto yn = y + h * dydx;
+    const auto n = state_size(y);
+    const auto h = htot / nstep;
+    for (std::size_t i = 0; i < n; ++i)
+      {
+        ym[i] = y[i];
+        yn[i] = y[i] + h * dydx[i];
+      }
     auto x = xs + h;
-    auto yout = deriv(yn, x);
-    auto h2 = 2.0 * h;
-    for (int n = 1; n < nstep; ++n)
+    deriv(yn, x, yout);
+    const auto h2 = 2 * h;
+    for (int k = 1; k <= nstep; ++k)
       {
-	auto swap = ym + h2 * yout;
-	ym = yn;
-	yn = swap;
+	if (y_half != nullptr && 2 * k == nstep)
+	  for (std::size_t i = 0; i < n; ++i)
+	    {
+	      (*y_half)[i] = yn[i];
+	      (*dydx_half)[i] = yout[i];
+	    }
+	if (k == nstep)
+	  break;
+	for (std::size_t i = 0; i < n; ++i)
+	  {
+	    const auto swap = ym[i] + h2 * yout[i];
+	    ym[i] = yn[i];
+	    yn[i] = swap;
+	  }
 	x += h;
-	yout = deriv(yn, x);
+	deriv(yn, x, yout);
       }
-    yout = (ym + yn + h * yout) / 2;
+    for (std::size_t i = 0; i < n; ++i)
+      yout[i] = (ym[i] + yn[i] + h * yout[i]) / 2;
+  }
 
-    return yout;
+template<typename StateVec, typename RealTp, typename Deriv>
+  void
+  modified_midpoint(const StateVec & y, const StateVec & dydx, RealTp xs,
+                    RealTp htot, int nstep, StateVec & yout, Deriv deriv)
+  {
+    StateVec ym = y, yn = y;
+    modified_midpoint(y, dydx, xs, htot, nstep, yout, deriv, ym, yn);
   }
 
 
+
+
 /**
  *   Stoermer's rule for integrating second order conservative systems of the form
- *   y'' = f(x,y) for a system of n = nv/2 equations.  On input y[1..nv] contains
+ *   y'' = f(x,y) for a system of n = nv/2 equations.  On input y contains
  *   y in the first n elements and y' in the second n elements all evaluated at xs.
- *   d2y[1..nv] contains the right hand side function f (also evaluated at xs) in
+ *   d2y contains the right hand side function f (also evaluated at xs) in
  *   its first n elements (the second n elements are not referenced).  Also input
  *   is htot, the total step to be taken and nstep, the number of substeps to be used.
- *   The output is returned as yout[1..nv], with the same storage arrangement as y.
- *   derivvs is the user-supplied routine that calculates f.
+ *   The output is returned as y_out, with the same storage arrangement as y.
+ *   deriv(y, x, f) is the user-supplied routine that writes f into the first
+ *   n elements of its last argument.
+ *   The work vector y_temp must be the size of y.
  *
  *   This routine can replace modified_midpoint above.
  */
-template<typename StateVec, typename RealTp>
-void
-stoermer(const StateVec & y, const StateVec & d2y, RealTp xs,
-         RealTp h_tot, int n_step, StateVec & y_out)
-{
-  auto nv = std::size(y);
-  std::vector<RealTp> y_temp(nv);
+template<typename StateVec, typename RealTp, typename Deriv>
+  void
+  stoermer(const StateVec & y, const StateVec & d2y, RealTp xs,
+           RealTp h_tot, int n_step, StateVec & y_out, Deriv & deriv,
+           StateVec & y_temp)
+  {
+    const auto n_eqns = state_size(y) / 2;
 
-  auto h = h_tot / n_step;
-  auto hh = h / 2;
-  auto n_eqns = nv / 2;
-  for (int i = 0; i < n_eqns; ++i)
-    {
-      n = n_eqns + i;
-      ytemp[i] = y[i] + (y_temp[n] = h * (y[n] + hh * d2y[i]));
-    }
-  auto x = xs + h;
-  yout = deriv(y_temp, x);
-  auto h2 = 2 * h;
-  for (int nn = 1; nn < n_step; ++nn)
+    const auto h = h_tot / n_step;
+    const auto hh = h / 2;
+    for (std::size_t i = 0; i < n_eqns; ++i)
+      {
+	const auto n = n_eqns + i;
+	y_temp[i] = y[i] + (y_temp[n] = h * (y[n] + hh * d2y[i]));
+      }
+    auto x = xs + h;
+    deriv(y_temp, x, y_out);
+    const auto h2 = 2 * h;
+    for (int nn = 1; nn < n_step; ++nn)
+      {
+	for (std::size_t i = 0; i < n_eqns; ++i)
+          y_temp[i] += (y_temp[n_eqns + i] += h2 * y_out[i]);
+	x += h;
+	deriv(y_temp, x, y_out);
+      }
+    for (std::size_t i = 0; i < n_eqns; ++i)
+      { 
+	const auto n = n_eqns + i;
+	y_out[n] = y_temp[n] / h + hh * y_out[i];
+	y_out[i] = y_temp[i];
+      }
+  }
+
+template<typename StateVec, typename RealTp, typename Deriv>
+  void
+  stoermer(const StateVec & y, const StateVec & d2y, RealTp xs,
+           RealTp h_tot, int n_step, StateVec & y_out, Deriv deriv)
+  {
+    StateVec y_temp = y;
+    stoermer(y, d2y, xs, h_tot, n_step, y_out, deriv, y_temp);
+  }
+
+
+/**
+ *  This stepper holds the state and work space for the Bulirsch-Stoer method:
+ *  the extrapolation tableau, the modified midpoint buffers and the order and
+ *  step size control which persists between calls.  Use one stepper per trajectory.
+ *  The extrapolation is polynomial by default or rational if requested.
+ */
+template<typename StateVec, typename RealTp = double>
+  class bulirsch_stoer_stepper
+  {
+  public:
+
+    static constexpr int KMAXX = 8;
+    static constexpr int IMAXX = KMAXX + 1;
+
+    bulirsch_stoer_stepper() = default;
+
+    explicit
+    bulirsch_stoer_stepper(const StateVec & proto, bool rational = false)
+    : m_rational(rational),
+      m_y_err(proto), m_y_sav(proto), m_y_seq(proto), m_ym(proto), m_yn(proto),
+      m_c(proto)
     {
-      for (int i = 0; i < n_eqns; ++i)
-        y_temp[i] += (ytemp[(n = n_eqns + i)] += h2 * y_out[i]);
-      x += h;
-      y_out = deriv(y_temp, x);
+      m_d.fill(proto);
+      m_y_mid.fill(proto);
+      m_dy_mid.fill(proto);
     }
-  for (int i = 0; i < n_eqns; ++i)
-    { 
-      auto n = n_eqns + i;
-      y_out[n] = y_temp[n] / h + hh * y_out[i];
-      y_out[i] = y_temp[i];
-    }
-}
 
+    /**
+     *  Bulirsch-Stoer step with monitoring of local truncation error to ensure accuracy
+     *  and adjust stepsize.  Input are the dependent variables y and the derivatives dydx
+     *  at the starting value of the independent variable xx.  Also input are the stepsize
+     *  to be attempted h_try, the required accuracy eps, and the vector yscale against which
+     *  the error is scaled.  On output, y and xx are replaced by their new values,
+     *  h_final is the stepsize that was actually accomplished, and h_next is the estimated
+     *  next stepsize.
+     */
+    template<typename Deriv>
+      void
+      quad_step(Deriv & deriv, StateVec & y, const StateVec & dydx, RealTp & xx,
+                RealTp h_try, RealTp eps, const StateVec & yscale,
+                RealTp & h_final, RealTp & h_next);
+
+    /**
+     *  Give the state and derivative at the middle of the last step taken
+     *  by quad_step() to the dense output.  The modified midpoint sequences
+     *  with a multiple of four substeps pass the middle of the step at an even
+     *  substep, where the error is even in the substep size; their values there
+     *  are extrapolated to zero substep size like the end point.
+     */
+    template<typename DenseOutput>
+      void
+      dense_midpoint(DenseOutput & dense);
+
+  private:
+
+    void poly_extrap(int iest, RealTp xest, const StateVec & yest,
+                     StateVec & yz, StateVec & dy);
+
+    void rat_extrap(int iest, RealTp xest, const StateVec & yest,
+                    StateVec & yz, StateVec & dy);
+
+    bool m_rational = false;
+
+    bool m_first = true;
+    int m_kmax = 0;
+    int m_kopt = 0;
+    RealTp m_epsold = -1;
+    RealTp m_xnew = 0;
+    RealTp m_h_next = 0;
+    std::array<RealTp, IMAXX + 1> m_a{};
+    std::array<std::array<RealTp, KMAXX + 1>, KMAXX + 1> m_alf{};
+    std::array<RealTp, KMAXX + 1> m_err{};
+
+    //  The abscissas and columns of the extrapolation tableau.
+    std::array<RealTp, KMAXX + 1> m_x{};
+    std::array<StateVec, KMAXX + 1> m_d{};
+
+    StateVec m_y_err;
+    StateVec m_y_sav;
+    StateVec m_y_seq;
+    StateVec m_ym;
+    StateVec m_yn;
+    StateVec m_c;
+
+    //  The midpoint values of the sequences with nseq[k] % 4 == 0.
+    static constexpr int MAX_MID = 4;
+    int m_n_mid = 0;
+    std::array<RealTp, MAX_MID> m_x_mid{};
+    std::array<StateVec, MAX_MID> m_y_mid{};
+    std::array<StateVec, MAX_MID> m_dy_mid{};
+  };
 
-/*
- *    Global variables for the storage of extrapolation results for bulirsch_stoer.
- */
-static double *bs_xx, **bs_yy;
 
-static void bs_rat_extrap(int iest, double xest, double *yest,
-                          double *yz, double *dy, int nv);
+template<typename StateVec, typename RealTp>
+  template<typename Deriv>
+    void
+    bulirsch_stoer_stepper<StateVec, RealTp>::
+    quad_step(Deriv & deriv, StateVec & y, const StateVec & dydx, RealTp & xx,
+              RealTp h_try, RealTp eps, const StateVec & yscale,
+              RealTp & h_final, RealTp & h_next)
+    {
+      static constexpr int nseq[IMAXX + 1] = { 0, 2, 4, 6, 8, 10, 12, 14, 16, 18 };
+      constexpr RealTp SAFE1 = 0.25;
+      constexpr RealTp SAFE2 = 0.7;
+      constexpr RealTp REDMAX = 1.0e-5;
+      constexpr RealTp REDMIN = 0.7;
+      constexpr RealTp TINY = 1.0e-30;
+      constexpr RealTp SCALEMAX = 0.1;
+
+      const auto n = state_size(y);
+
+      if (eps != m_epsold)
+        {
+          m_h_next = m_xnew = RealTp(-1.0e29);
+          const auto eps1 = SAFE1 * eps;
+          m_a[1] = nseq[1] + 1;
+          for (int k = 1; k <= KMAXX; ++k)
+            m_a[k + 1] = m_a[k] + nseq[k + 1];
+          for (int iq = 2; iq <= KMAXX; ++iq)
+            for (int k = 1; k < iq; ++k)
+              m_alf[k][iq] = std::pow(eps1, (m_a[k + 1] - m_a[iq + 1])
+                                          / ((m_a[iq + 1] - m_a[1] + 1) * (2 * k + 1)));
+          m_epsold = eps;
+          for (m_kopt = 2; m_kopt < KMAXX; ++m_kopt)
+            if (m_a[m_kopt + 1] > m_a[m_kopt] * m_alf[m_kopt - 1][m_kopt])
+              break;
+          m_kmax = m_kopt;
+        }
+
+      auto h = h_try;
+      for (std::size_t i = 0; i < n; ++i)
+        m_y_sav[i] = y[i];
+      if (xx != m_xnew || h != m_h_next)
+        {
+          m_first = true;
+          m_kopt = m_kmax;
+        }
+
+      bool reduct = false;
+      int k = 0, km = 0;
+      RealTp red = RealTp(1);
+      while (true)
+        {
+          bool exitflag = false;
+          for (k = 1; k <= m_kmax; ++k)
+            {
+              m_xnew = xx + h;
+              if (m_xnew == xx)
+                throw std::logic_error("step size underflow in bulirsch_stoer");
+              const auto xest = (h / nseq[k]) * (h / nseq[k]);
+              if (k == 1)
+                m_n_mid = 0;
+              if (nseq[k] % 4 == 0 && m_n_mid < MAX_MID)
+                {
+                  modified_midpoint(m_y_sav, dydx, xx, h, nseq[k], m_y_seq, deriv, m_ym, m_yn,
+                                    &m_y_mid[m_n_mid], &m_dy_mid[m_n_mid]);
+                  m_x_mid[m_n_mid++] = xest;
+                }
+              else
+                modified_midpoint(m_y_sav, dydx, xx, h, nseq[k], m_y_seq, deriv, m_ym, m_yn);
+              if (m_rational)
+                rat_extrap(k, xest, m_y_seq, y, m_y_err);
+              else
+                poly_extrap(k, xest, m_y_seq, y, m_y_err);
+              if (k != 1)
+                {
+                  auto errmax = TINY;
+                  for (std::size_t i = 0; i < n; ++i)
+                    errmax = std::max(errmax, std::abs(m_y_err[i] / yscale[i]));
+                  errmax /= eps;
+                  km = k - 1;
+                  m_err[km] = std::pow(errmax / SAFE1, RealTp(1) / (2 * km + 1));
+                  if (k >= m_kopt - 1 || m_first)
+                    {
+                      if (errmax < RealTp(1))
+                        {
+                          exitflag = true;
+                          break;
+                        }
+                      if (k == m_kmax || k == m_kopt + 1)
+                        {
+                          red = SAFE2 / m_err[km];
+                          break;
+                        }
+                      else if (k == m_kopt && m_alf[m_kopt - 1][m_kopt] < m_err[km])
+                        {
+                          red = RealTp(1) / m_err[km];
+                          break;
+                        }
+                      else if (m_kopt == m_kmax && m_alf[km][m_kmax - 1] < m_err[km])
+                        {
+                          red = m_alf[km][m_kmax - 1] * SAFE2 / m_err[km];
+                          break;
+                        }
+                      else if (m_alf[km][m_kopt] < m_err[km])
+                        {
+                          red = m_alf[km][m_kopt - 1] / m_err[km];
+                          break;
+                        }
+                    }
+                }
+            }
+          if (exitflag)
+            break;
+          red = std::min(red, REDMIN);
+          red = std::max(red, REDMAX);
+          h *= red;
+          reduct = true;
+        }
+
+      xx = m_xnew;
+      h_final = h;
+      m_first = false;
+      auto workmin = RealTp(1.0e35);
+      auto scale = RealTp(1);
+      for (int kk = 1; kk <= km; ++kk)
+        {
+          const auto fact = std::max(m_err[kk], SCALEMAX);
+          const auto work = fact * m_a[kk + 1];
+          if (work < workmin)
+            {
+              scale = fact;
+              workmin = work;
+              m_kopt = kk + 1;
+            }
+        }
+      h_next = h / scale;
+      if (m_kopt >= k && m_kopt != m_kmax && !reduct)
+        {
+          const auto fact = std::max(scale / m_alf[m_kopt - 1][m_kopt], SCALEMAX);
+          if (m_a[m_kopt + 1] * fact <= workmin)
+            {
+              h_next = h / fact;
+              ++m_kopt;
+            }
+        }
+      m_h_next = h_next;
+    }
 
-static void bs_poly_extrap(int iest, double xest, double *yest,
-                           double *yz, double *dy, int nv);
 
+template<typename StateVec, typename RealTp>
+  template<typename DenseOutput>
+    void
+    bulirsch_stoer_stepper<StateVec, RealTp>::
+    dense_midpoint(DenseOutput & dense)
+    {
+      //  One midpoint value is only second order; the cubic is better.
+      if (m_n_mid < 2)
+        return;
+
+      const auto n = state_size(m_y_sav);
+      for (std::size_t i = 0; i < n; ++i)
+        {
+          RealTp ty[MAX_MID], tf[MAX_MID];
+          for (int j = 0; j < m_n_mid; ++j)
+            {
+              ty[j] = m_y_mid[j][i];
+              tf[j] = m_dy_mid[j][i];
+            }
+          //  Neville's algorithm evaluated at zero substep size.
+          for (int m = 1; m < m_n_mid; ++m)
+            for (int j = m_n_mid - 1; j >= m; --j)
+              {
+                const auto r = m_x_mid[j - m] / m_x_mid[j] - 1;
+                ty[j] += (ty[j] - ty[j - 1]) / r;
+                tf[j] += (tf[j] - tf[j - 1]) / r;
+              }
+          m_ym[i] = ty[m_n_mid - 1];
+          m_yn[i] = tf[m_n_mid - 1];
+        }
+      dense.set_midpoint(m_ym, m_yn);
+    }
 
-constexpr int KMAXX = 9;
-constexpr int IMAXX = KMAXX + 1;
-constexpr double SAFE1 = 0.25;
-constexpr double SAFE2 = 0.7;
-constexpr double REDMAX = 1.0e-5;
-constexpr double REDMIN = 0.7;
-constexpr double TINY = 1.0e-30;
-constexpr double SCALEMAX = 0.1;
 
 /**
- *  Bulirsch-Stoer step with monitoring of local truncation error to ensure accuracy
- *  and adjust stepsize.  Input are the dependent variables y and the derivatives dydx
- *  at the starting value of the independent variable x.
+ *  Polynomial extrapolation used by bulirsch_stoer to evaluate the nv functions
+ *  at x = 0 by fitting a polynomial to a sequence of estimates with progressively
+ *  smaller values x = xest and corresponding vectors yest.  This call is number iest
+ *  in the sequence of calls.  Extrapolated values are output as yz and their estimated
+ *  error is output as dy.
  */
 template<typename StateVec, typename RealTp>
   void
-  bulirsch_stoer(const StateVec & y, const StateVec & dydx, RealTp & xx,
-        	 RealTp h_try, RealTp eps, StateVec & yscale,
-        	 RealTp & h_final, RealTp & h_next)
+  bulirsch_stoer_stepper<StateVec, RealTp>::
+  poly_extrap(int iest, RealTp xest, const StateVec & yest,
+              StateVec & yz, StateVec & dy)
   {
-    int kk, km;
-    bool exitflag = false;
-    double errmax, fact, red, scale, work, workmin, xest, *err, *yerr, *ysav, *yseq;
-
-    static bool m_first = true;
-    static int m_kmax;
-    static int m_kopt;
-    static int m_nseq[IMAXX + 1] = { 0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20 };
-
-    static double m_epsold = -1.0;
-    static double m_xnew;
-    static double m_a[IMAXX + 1];
-    static double m_alf[KMAXX + 1][KMAXX + 1];
-
-    std::vector<double> bs_xx(KMAXX);
-    std::vector<double> bs_yy = dmatrix(1, nv, 1, KMAXX);
-    std::vector<double> err(KMAXX);
-    std::vector<double> yerr(nv);
-    std::vector<double> ysav(nv);
-    std::vector<double> yseq(nv);
-
-    if (eps != m_epsold)
-      {
-	h_next = m_xnew = -1.0e29;
-	auto eps1 = SAFE1 * eps;
-	m_a[0] = m_nseq[0] + 1;
-	for (int k = 0; k < KMAXX; ++k)
-          m_a[k + 1] = m_a[k] + m_nseq[k + 1];
-	for (int iq = 1; iq < KMAXX; ++iq)
-          for (int k = 1; k < iq; ++k) // Didn't touch!
-            m_alf[k][iq] = std::pow(eps1, (m_a[k + 1] - m_a[iq + 1])
-                                       / ((m_a[iq + 1] - m_a[1]) * (2 * k + 1)));
-	m_epsold = eps;
-	for (int m_kopt = 2; m_kopt < KMAXX; ++m_kopt)
-          if (m_a[m_kopt + 1] > m_a[m_kopt] * m_alf[m_kopt - 1][m_kopt])
-            break;
-	m_kmax = m_kopt;
-      }
-    auto h = h_try;
-    ysav = y;
-    if (xx != m_xnew || h != h_next)
-      {
-	m_first = true;
-	m_kopt = m_kmax;
-      }
-    bool reduct = false;
-    while (true)
+    const auto n = state_size(yest);
+
+    m_x[iest] = xest;
+    for (std::size_t j = 0; j < n; ++j)
+      dy[j] = yz[j] = yest[j];
+    if (iest == 1)
+      for (std::size_t j = 0; j < n; ++j)
+        m_d[1][j] = yest[j];
+    else
       {
-	for (int k = 0; k < m_kmax; ++k)
+	for (std::size_t j = 0; j < n; ++j)
+          m_c[j] = yest[j];
+	for (int k1 = 1; k1 < iest; ++k1)
           {
-            m_xnew = xx + h;
-            if (m_xnew == xx)
-              throw std::logic_error("step size underflow in bulirsch_stoer");
-            yseq = modified_midpoint(ysav, dydx, xx, h, m_nseq[k]);
-            xest = dsqr(h / m_nseq[k]);
-            bs_poly_extrap(k, xest, yseq, y, yerr);
-            if (k != 0)
+            auto delta = RealTp(1) / (m_x[iest - k1] - xest);
+            const auto f1 = xest * delta;
+            const auto f2 = m_x[iest - k1] * delta;
+            auto & d = m_d[k1];
+            for (std::size_t j = 0; j < n; ++j)
               {
-        	errmax = TINY;
-        	for (i = 0; i < nv; ++i)
-                  errmax = std::max(errmax, std::fabs(yerr[i] / yscale[i]));
-        	errmax /= eps;
-        	auto km = kk - 1;
-        	err[km] = std::pow(errmax / SAFE1, 1.0 / (2 * k + 1));
-        	if (k >= m_kopt - 1 || m_first)
-        	  {
-        	    if (errmax < 1.0)
-                      {
-                	exitflag = true;
-                	break;
-                      }
-        	    if (k == m_kmax || k == m_kopt + 1)
-                      {
-                	red = SAFE2 / err[km];
-                	break;
-                      }
-        	    else if (k == m_kopt && m_alf[m_kopt - 1][m_kopt] < err[km])
-                      {
-                	red = 1.0 / err[km];
-                	break;
-                      }
-        	    else if (k == m_kopt && m_alf[km][m_kmax - 1] < err[km])
-                      {
-                	red = m_alf[km][m_kopt - 1] / err[km];
-                	break;
-                      }
-        	  }
+        	const auto q = d[j];
+        	d[j] = dy[j];
+        	delta = m_c[j] - q;
+        	dy[j] = f1 * delta;
+        	m_c[j] = f2 * delta;
+        	yz[j] += dy[j];
               }
           }
-	if (exitflag)
-          break;
-	red = std::min(red, REDMIN);
-	red = std::max(red, REDMAX);
-	h *= red;
-	reduct = true;
-      }
-    xx = m_xnew;
-    h_final = h;
-    m_first = false;
-    workmin = 1.0e35;
-    for (int kk = 0; kk < km; ++kk)
-      {
-	fact = dmax(err[kk], SCALEMAX);
-	work = fact * m_a[kk + 1];
-	if (work < workmin)
-          {
-            scale = fact;
-            workmin = work;
-            m_kopt = kk + 1;
-          }
-      }
-    h_next = h / scale;
-    if (m_kopt >= k && m_kopt != m_kmax && !reduct)
-      {
-	fact = std::max(scale / alf[m_kopt - 1][m_kopt], SCALEMAX);
-	if (fact * m_a[m_kopt + 1] <= workmin)
-          {
-            h_next = h / fact;
-            ++m_kopt;
-          }
+	for (std::size_t j = 0; j < n; ++j)
+          m_d[iest][j] = dy[j];
       }
   }
 
 
-
-
 /**
- *  Routine used by bulirsch_stoer to perform rational function extrapolation.
+ *  Rational function extrapolation used by bulirsch_stoer.
+ *  The arguments are as for poly_extrap().
  */
 template<typename StateVec, typename RealTp>
-  static void
-  bs_rat_extrap(int iest, double xest, double *yest, 
-        	double *yz, double *dy)
+  void
+  bulirsch_stoer_stepper<StateVec, RealTp>::
+  rat_extrap(int iest, RealTp xest, const StateVec & yest,
+             StateVec & yz, StateVec & dy)
   {
-    std::vector<double> fx(iest);
+    const auto n = state_size(yest);
 
-    bs_xx[iest] = xest;
-    if (iest == 0)
-      dy = bs_yy[1] = yz = yest;
+    m_x[iest] = xest;
+    if (iest == 1)
+      for (std::size_t j = 0; j < n; ++j)
+        yz[j] = m_d[1][j] = dy[j] = yest[j];
     else
       {
 	//  Evaluate next diagonal in the tableau.
-	for (int k = 0; k < iest - 1; ++k)
-          fx[k + 1] = bs_xx[iest - k] / xest;
-	for (int j = 0; j < nv; ++j)
+	std::array<RealTp, KMAXX + 2> fx;
+	for (int k = 1; k < iest; ++k)
+          fx[k + 1] = m_x[iest - k] / xest;
+	for (std::size_t j = 0; j < n; ++j)
           {
-            double v = bs_yy[1][j];
-            double yy, c;
-            bs_yy[1] = yest;
-            c = yy = yest[j];
-            for (int k = 1; k < iest; ++k)
+            auto v = m_d[1][j];
+            auto c = yest[j];
+            auto yy = c;
+            m_d[1][j] = c;
+            auto ddy = RealTp(0);
+            for (int k = 2; k <= iest; ++k)
               {
-        	double b1 = fx[k] * v;
-        	double b = b1 - c;
+        	const auto b1 = fx[k] * v;
+        	auto b = b1 - c;
         	//  Watch division by zero.
-        	double ddy;
-        	if (b)
+        	if (b != RealTp(0))
         	  {
                     b = (c - v) / b;
                     ddy = c * b;
@@ -583,8 +1351,8 @@ template<typename StateVec, typename RealTp>
         	else
         	  ddy = v;
         	if (k != iest)
-        	  v = bs_yy[k][j];
-        	bs_yy[k][j] = ddy;
+        	  v = m_d[k][j];
+        	m_d[k][j] = ddy;
         	yy += ddy;
               }
             dy[j] = ddy;
@@ -595,40 +1363,25 @@ template<typename StateVec, typename RealTp>
 
 
 /**
- *  Routine used by bulirsch_stoer to perform polynomial function extrapolation.
+ *  Bulirsch-Stoer step with monitoring of local truncation error to ensure accuracy
+ *  and adjust stepsize.  See bulirsch_stoer_stepper::quad_step().
+ *  The order and stepsize control is kept between calls in a per-thread stepper
+ *  for each state type; for several trajectories use one bulirsch_stoer_stepper each.
  */
-template<typename StateVec, typename RealTp>
-  static void
-  bs_poly_extrap(int iest, double xest, double *yest, 
-        	 double *yz, double *dy, int nv)
+template<typename StateVec, typename RealTp, typename Deriv>
+  void
+  bulirsch_stoer(StateVec & y, const StateVec & dydx, RealTp & xx,
+        	 RealTp h_try, RealTp eps, const StateVec & yscale,
+        	 RealTp & h_final, RealTp & h_next, Deriv deriv)
   {
-    std::vector<double> c(nv);
-
-    bs_xx[iest] = xest;
-    dy = yz = yest;
-    if (iest == 1)
-      bs_yy[1][j] = yest[j];
-    else
+    static thread_local bulirsch_stoer_stepper<StateVec, RealTp> bs;
+    static thread_local std::size_t n = 0;
+    if (n != state_size(y))
       {
-	for (int j = 0; j < nv; ++j)
-          c[j] = yest[j];
-	for (int k = 0; k < nv; ++k)
-          {
-            auto delta = 1 / (bs_xx[iest-k] - xest);
-            auto f1 = delta * xest;
-            auto f2 = delta * bs_xx[iest - k];
-            for (int j = 0; j < nv; ++j)
-              {
-        	auto q = bs_yy[k][j];
-        	bs_yy[k][j] = dy[j];
-        	delta = c[j] - q;
-        	dy[j] = delta * f1;
-        	c[j] = delta * f2;
-        	yz[j] += dy[j];
-              }
-          }
-	bs_yy[iest] = dy;
+        bs = bulirsch_stoer_stepper<StateVec, RealTp>(y);
+        n = state_size(y);
       }
+    bs.quad_step(deriv, y, dydx, xx, h_try, eps, yscale, h_final, h_next);
   }
 
 
@@ -0,0 +1,324 @@
+#ifndef ODE_ENSEMBLE_TCC
+#define ODE_ENSEMBLE_TCC 1
+
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <algorithm>
+#include <vector>
+#include <atomic>
+#include <thread>
+
+
+/**
+ *  The number of trajectories advanced together by ode_integrate_ensemble.
+ *  One cache line of each state component is held across the trajectories
+ *  so the loops over the trajectories map onto full vector registers.
+ */
+template<typename RealTp>
+  constexpr std::size_t ode_ensemble_lanes = 64 / sizeof(RealTp) < 4 ? 4 : 64 / sizeof(RealTp);
+
+
+/**
+ *  Integrate the trajectories [first, last) of an ensemble with adaptive
+ *  Cash-Karp steps, L = ode_ensemble_lanes<RealTp> at a time.
+ *  This is the work done by one thread of ode_integrate_ensemble();
+ *  the arguments are as for that function.
+ *
+ *  Every lane has its own x and stepsize.  Each pass evaluates the derivative and
+ *  the Runge-Kutta stages for all lanes, then each lane either accepts its step,
+ *  or shrinks its stepsize and retries on the next pass.  A lane whose trajectory
+ *  has reached x2 (or failed) is refilled with the next trajectory so the
+ *  lanes stay busy although the trajectories need different numbers of steps.
+ *  A lane left with no trajectory keeps a stepsize of zero until the others finish.
+ *  Returns the number of failed trajectories.
+ */
+template<std::size_t N, typename RealTp, typename DerivBatch>
+  std::size_t
+  ode_integrate_ensemble_range(std::size_t first, std::size_t last, RealTp * y,
+                               RealTp x1, RealTp x2, RealTp eps, RealTp h1, RealTp hmin,
+                               DerivBatch & deriv)
+  {
+    constexpr std::size_t L = ode_ensemble_lanes<RealTp>;
+    constexpr std::size_t NONE = std::numeric_limits<std::size_t>::max();
+
+    constexpr int MAXSTEP = 10000;
+    constexpr RealTp TINY = 1.0e-30;
+    constexpr RealTp POW_GROW = -0.20;
+    constexpr RealTp POW_SHRINK = -0.25;
+    constexpr RealTp F_SAFETY = 0.9;
+    constexpr RealTp ERR_COND = 1.89e-4;
+
+    constexpr RealTp
+      a2 = 0.2, a3 = 0.3, a4 = 0.6, a5 = 1.0, a6 = 0.875,
+      b21 = 0.2,
+      b31 = 3.0/40.0, b32 = 9.0/40.0,
+      b41 = 0.3, b42 = -0.9, b43 = 1.2,
+      b51 = -11.0/54.0, b52 = 2.5, b53 = -70.0/27.0, b54 = 35.0/27.0,
+      b61 = 1631.0/55296.0, b62 = 175.0/512.0, b63 = 575.0/13824.0, b64 = 44275.0/110592.0, b65 = 253.0/4096.0,
+      c1 = 37.0/378.0, c3 = 250.0/621.0, c4 = 125.0/594.0, c6 = 512.0/1771.0,
+      dc5 = -277.0/14336.0;
+    constexpr RealTp dc1 = c1 - 2825.0/27648.0, dc3 = c3 - 18575.0/48384.0,
+                     dc4 = c4 - 13525.0/55296.0, dc6 = c6 - 0.25;
+
+    alignas(64) RealTp yy[N][L];
+    alignas(64) RealTp dydx[N][L];
+    alignas(64) RealTp yscale[N][L];
+    alignas(64) RealTp y_temp[N][L];
+    alignas(64) RealTp ak2[N][L];
+    alignas(64) RealTp ak3[N][L];
+    alignas(64) RealTp ak4[N][L];
+    alignas(64) RealTp ak5[N][L];
+    alignas(64) RealTp ak6[N][L];
+    alignas(64) RealTp x[L];
+    alignas(64) RealTp xs[L];
+    alignas(64) RealTp h[L];
+    alignas(64) RealTp errmax[L];
+    alignas(64) RealTp h_next[L];
+    bool accept[L];
+
+    //  The trajectory in each lane, the number of steps it has taken and
+    //  whether its last step was accepted (so yscale must be recomputed).
+    std::size_t traj[L];
+    int n_step[L];
+    bool fresh[L];
+
+    const RealTp h_start = (x2 > x1) ? std::abs(h1) : -std::abs(h1);
+
+    std::size_t next = first;
+    std::size_t num_active = 0;
+    std::size_t num_failed = 0;
+
+    auto fill = [&](std::size_t l)
+    {
+      if (next < last)
+        {
+          traj[l] = next++;
+          for (std::size_t i = 0; i < N; ++i)
+            yy[i][l] = y[traj[l] * N + i];
+          x[l] = x1;
+          h[l] = h_start;
+          n_step[l] = 0;
+          fresh[l] = true;
+          ++num_active;
+        }
+      else
+        {
+          //  Park the lane on a copy of a live state so the derivative stays finite:
+          //  the state of a failed trajectory need not be.
+          traj[l] = NONE;
+          h[l] = RealTp(0);
+          fresh[l] = false;
+          for (std::size_t m = 0; m < L; ++m)
+            if (traj[m] != NONE)
+              {
+                for (std::size_t i = 0; i < N; ++i)
+                  yy[i][l] = yy[i][m];
+                x[l] = x[m];
+                break;
+              }
+        }
+    };
+
+    auto retire = [&](std::size_t l, bool ok)
+    {
+      for (std::size_t i = 0; i < N; ++i)
+        y[traj[l] * N + i] = ok ? yy[i][l] : std::numeric_limits<RealTp>::quiet_NaN();
+      num_failed += !ok;
+      --num_active;
+      fill(l);
+    };
+
+    for (std::size_t i = 0; i < N; ++i)
+      for (std::size_t l = 0; l < L; ++l)
+        yscale[i][l] = RealTp(1);
+    for (std::size_t l = 0; l < L; ++l)
+      traj[l] = NONE;
+    for (std::size_t l = 0; l < L; ++l)
+      fill(l);
+    if (num_active == 0)
+      return 0;
+
+    while (num_active > 0)
+      {
+        deriv(yy, x, dydx);
+
+        //  Lanes starting a new step set their error scale and stop at x2.
+        for (std::size_t l = 0; l < L; ++l)
+          if (fresh[l])
+            {
+              for (std::size_t i = 0; i < N; ++i)
+                yscale[i][l] = std::abs(yy[i][l]) + std::abs(h[l] * dydx[i][l]) + TINY;
+              if ((x[l] + h[l] - x2) * (x[l] + h[l] - x1) > RealTp(0))
+                h[l] = x2 - x[l];
+              fresh[l] = false;
+            }
+
+        //  The Cash-Karp stages across all lanes.
+        for (std::size_t i = 0; i < N; ++i)
+          for (std::size_t l = 0; l < L; ++l)
+            y_temp[i][l] = yy[i][l] + h[l] * b21 * dydx[i][l];
+        for (std::size_t l = 0; l < L; ++l)
+          xs[l] = x[l] + a2 * h[l];
+        deriv(y_temp, xs, ak2);
+
+        for (std::size_t i = 0; i < N; ++i)
+          for (std::size_t l = 0; l < L; ++l)
+            y_temp[i][l] = yy[i][l] + h[l] * (b31 * dydx[i][l] + b32 * ak2[i][l]);
+        for (std::size_t l = 0; l < L; ++l)
+          xs[l] = x[l] + a3 * h[l];
+        deriv(y_temp, xs, ak3);
+
+        for (std::size_t i = 0; i < N; ++i)
+          for (std::size_t l = 0; l < L; ++l)
+            y_temp[i][l] = yy[i][l] + h[l] * (b41 * dydx[i][l] + b42 * ak2[i][l]
+                                            + b43 * ak3[i][l]);
+        for (std::size_t l = 0; l < L; ++l)
+          xs[l] = x[l] + a4 * h[l];
+        deriv(y_temp, xs, ak4);
+
+        for (std::size_t i = 0; i < N; ++i)
+          for (std::size_t l = 0; l < L; ++l)
+            y_temp[i][l] = yy[i][l] + h[l] * (b51 * dydx[i][l] + b52 * ak2[i][l]
+                                            + b53 * ak3[i][l] + b54 * ak4[i][l]);
+        for (std::size_t l = 0; l < L; ++l)
+          xs[l] = x[l] + a5 * h[l];
+        deriv(y_temp, xs, ak5);
+
+        for (std::size_t i = 0; i < N; ++i)
+          for (std::size_t l = 0; l < L; ++l)
+            y_temp[i][l] = yy[i][l] + h[l] * (b61 * dydx[i][l] + b62 * ak2[i][l]
+                                            + b63 * ak3[i][l] + b64 * ak4[i][l]
+                                            + b65 * ak5[i][l]);
+        for (std::size_t l = 0; l < L; ++l)
+          xs[l] = x[l] + a6 * h[l];
+        deriv(y_temp, xs, ak6);
+
+        //  The fifth-order result goes in y_temp and the scaled error in errmax.
+        for (std::size_t l = 0; l < L; ++l)
+          errmax[l] = RealTp(0);
+        for (std::size_t i = 0; i < N; ++i)
+          for (std::size_t l = 0; l < L; ++l)
+            {
+              y_temp[i][l] = yy[i][l] + h[l] * (c1 * dydx[i][l] + c3 * ak3[i][l]
+                                              + c4 * ak4[i][l] + c6 * ak6[i][l]);
+              const RealTp err = h[l] * (dc1 * dydx[i][l] + dc3 * ak3[i][l]
+                                       + dc4 * ak4[i][l] + dc5 * ak5[i][l]
+                                       + dc6 * ak6[i][l]);
+              errmax[l] = std::max(errmax[l], std::abs(err / yscale[i][l]));
+            }
+
+        //  The next stepsize of each lane: grow it after an accepted step
+        //  or shrink it and retry.
+        for (std::size_t l = 0; l < L; ++l)
+          {
+            const RealTp e = errmax[l] / eps;
+            accept[l] = e <= RealTp(1);
+            const RealTp p = std::pow(e, accept[l] ? POW_GROW : POW_SHRINK);
+            const RealTp h_shrink = (h[l] > 0 ? std::max(F_SAFETY * h[l] * p, RealTp(0.1) * h[l])
+                                              : std::min(F_SAFETY * h[l] * p, RealTp(0.1) * h[l]));
+            const RealTp h_grow = (e > ERR_COND ? F_SAFETY * h[l] * p : 5 * h[l]);
+            h_next[l] = accept[l] ? h_grow : h_shrink;
+          }
+
+        //  Commit the accepted steps under the mask.
+        for (std::size_t i = 0; i < N; ++i)
+          for (std::size_t l = 0; l < L; ++l)
+            yy[i][l] = accept[l] ? y_temp[i][l] : yy[i][l];
+        for (std::size_t l = 0; l < L; ++l)
+          x[l] = accept[l] ? x[l] + h[l] : x[l];
+
+        for (std::size_t l = 0; l < L; ++l)
+          {
+            if (traj[l] == NONE)
+              continue;
+            if (accept[l])
+              {
+                if ((x[l] - x2) * (x2 - x1) >= RealTp(0))
+                  retire(l, true);
+                else if (std::abs(h_next[l]) <= hmin || ++n_step[l] >= MAXSTEP)
+                  retire(l, false);
+                else
+                  {
+                    h[l] = h_next[l];
+                    fresh[l] = true;
+                  }
+              }
+            else
+              {
+                h[l] = h_next[l];
+                if (x[l] + h[l] == x[l])
+                  retire(l, false);
+              }
+          }
+      }
+
+    return num_failed;
+  }
+
+
+/**
+ *  Integrate an ensemble of count trajectories of the same system of N ODEs
+ *  from x1 to x2 with accuracy eps.  The states are stored one after the other
+ *  in y[0..count*N-1] and are replaced by their values at x2.
+ *  h1 is the first guess stepsize and hmin the minimum stepsize (can be zero)
+ *  as for ode_integrate().
+ *
+ *  The trajectories are advanced L = ode_ensemble_lanes<RealTp> at a time
+ *  in structure-of-arrays layout so that the right hand side is evaluated for
+ *  L trajectories per call:
+ *
+ *    deriv(const RealTp (&y)[N][L], const RealTp (&x)[L], RealTp (&dydx)[N][L])
+ *
+ *  writes dy_i/dx for lane l into dydx[i][l] and should be written as loops over
+ *  the lanes so that it vectorizes (calls such as std::sqrt only vectorize
+ *  with -fno-math-errno).  Each lane has its own adaptive Cash-Karp
+ *  stepsize as in cash_karp_stepper::quad_step().
+ *
+ *  The ensemble is cut into chunks of chunk_size trajectories which
+ *  num_threads threads take in turn until none are left, so that
+ *  threads that draw easy trajectories pick up more chunks.
+ *  A trajectory whose stepsize underflows or which needs too many steps
+ *  is set to NaN.  Returns the number of such trajectories.
+ */
+template<std::size_t N, typename RealTp, typename DerivBatch>
+  std::size_t
+  ode_integrate_ensemble(std::size_t count, RealTp * y,
+                         RealTp x1, RealTp x2, RealTp eps, RealTp h1, RealTp hmin,
+                         DerivBatch deriv, unsigned num_threads = 1,
+                         std::size_t chunk_size = 1024)
+  {
+    chunk_size = std::max(chunk_size, ode_ensemble_lanes<RealTp>);
+    const std::size_t num_chunks = (count + chunk_size - 1) / chunk_size;
+    num_threads = std::max(1u, std::min<unsigned>(num_threads, num_chunks));
+
+    std::atomic<std::size_t> next_chunk(0);
+    std::atomic<std::size_t> num_failed(0);
+    auto work = [&]()
+    {
+      //  Each thread has its own copy of the derivative functor.
+      auto d = deriv;
+      std::size_t failed = 0;
+      for (std::size_t c = next_chunk++; c < num_chunks; c = next_chunk++)
+        {
+          const std::size_t first = c * chunk_size;
+          const std::size_t last = std::min(count, first + chunk_size);
+          failed += ode_integrate_ensemble_range<N>(first, last, y,
+                                                    x1, x2, eps, h1, hmin, d);
+        }
+      num_failed += failed;
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < num_threads; ++t)
+      threads.emplace_back(work);
+    work();
+    for (auto & thr : threads)
+      thr.join();
+
+    return num_failed;
+  }
+
+
+#endif  //  ODE_ENSEMBLE_TCC
@@ -3,6 +3,9 @@
 
 
 #include <cmath>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
 
 
 /**
@@ -20,7 +23,7 @@ template<typename RealTp>
     int i;
     RealTp f1, f2;
 
-    const RealTp FACTOR = GOLD;
+    const RealTp FACTOR = 1.6;
 
     if (x1 >= x2)
       throw std::logic_error("bad initial range in bracket");
@@ -44,15 +47,15 @@ template<typename RealTp>
  *  subdivides the interval into n equally spaced segments, and searches
  *  for zero crossings of the function.  nb is the maximum number of roots
  *  sought, and is reset to the number of bracketing pairs
- *  xb1[1..nb], xb2[1..nb] that are found.
+ *  xb1[0..nb-1], xb2[0..nb-1] that are found.
  */
 template<typename RealTp>
   void
   root_brackets(RealTp (*func)(RealTp),
         	RealTp x1, RealTp x2, int n,
-        	RealTp & xb1, RealTp & xb2, int & nb)
+        	RealTp * xb1, RealTp * xb2, int & nb)
   {
-    RealTp x, fp, fc, dx;
+    RealTp x;
 
     int nbb = 0;
     auto dx = (x2 - x1) / n;
@@ -62,9 +65,9 @@ template<typename RealTp>
 	auto fc = func(x += dx);
 	if (fc * fp <= 0)
           {
-            xb1[++nbb] = x - dx;
+            xb1[nbb] = x - dx;
             xb2[nbb] = x;
-            if (nb == nbb)
+            if (nb == ++nbb)
               return;
           }
 	fp = fc;
@@ -93,7 +96,8 @@ template<typename RealTp>
     auto x = f < 0 ? (dx = x2 - x1, x1) : (dx = x1 - x2, x2);
     for (int i = 1; i <= IMAX; ++i)
       {
-        fmid = func(xmid = x + (dx *= 0.5));
+        auto xmid = x + (dx *= 0.5);
+        fmid = func(xmid);
         if (fmid < 0)
           x = xmid;
         if (std::fabs(dx) < eps || fmid == 0)
@@ -126,7 +130,7 @@ template<typename RealTp>
       }
     else
       {
-        xl = x;
+        xl = x1;
         x = x2;
       }
 
@@ -235,19 +239,19 @@ template<typename RealTp>
             auto fnew = func(ans = xnew);
             if (fnew == 0)
               return ans;
-            if (dsign(fm, fnew) != fm)
+            if (std::copysign(fm, fnew) != fm)
               {
                 xl = xm;
                 fl = fm;
                 xh = xnew;
                 fh = fnew;
               }
-            else if (dsign(fl, fnew) != fl)
+            else if (std::copysign(fl, fnew) != fl)
               {
                 xh = xnew;
                 fh = fnew;
               }
-            else if (dsign(fh, fnew) != fh)
+            else if (std::copysign(fh, fnew) != fh)
               {
                 xl = xnew;
                 fl = fnew;
@@ -278,24 +282,25 @@ template<typename RealTp>
 /**
  *  Using Brent's method, find the root of a function func known to lie between x1 and x2.
  *  The root, returned as brent, will be refined until it's accuracy is eps.
+ *  func is any callable taking and returning RealTp.
  */
-template<typename RealTp>
+template<typename Func, typename RealTp>
   RealTp
-  root_brent(RealTp (*func)(RealTp), RealTp x1, RealTp x2, RealTp eps,
+  root_brent(Func func, RealTp x1, RealTp x2, RealTp eps,
              int ITMAX = 100, RealTp EPS = 1.0e-12)
   {
     auto a = x1;
     auto b = x2;
-    auto c = x2
-    auto fa = func(a);
-    auto fb = func(b);
+    auto c = x2;
+    RealTp fa = func(a);
+    RealTp fb = func(b);
 
     if (fb * fa > 0)
       throw std::logic_error("root must be bracketed in root_brent");
     auto fc = fb;
+    RealTp d = b - a, e = d;
     for (int iter = 1; iter <= ITMAX; ++iter)
       {
-        RealTp  d, e;
         if (fb * fc > 0)
           {
             c = a;
@@ -336,7 +341,7 @@ template<typename RealTp>
             p = std::fabs(p);
             auto min1 = 3 * xm * q - std::fabs(tol1 * q);
             auto min2 = std::fabs(e * q);
-            if (2 * p < dmin(min1, min2))
+            if (2 * p < std::min(min1, min2))
               {
                 e = d;
                 d = p / q;
@@ -357,7 +362,7 @@ template<typename RealTp>
         if (std::fabs(d) > tol1)
           b += d;
         else
-          b += dsign(tol1, xm);
+          b += std::copysign(tol1, xm);
         fb = func(b);
       }
     throw std::logic_error("maximum number of iterations exceeded in root_brent");
@@ -402,18 +407,19 @@ template<typename RealTp>
  *  funcd is a user-supplied routine that provides both the function and the first derivative
  *  of the function at the point x.
  */
-RealTp
-root_safe(void (*func)(RealTp, RealTp *, RealTp *), RealTp x1, RealTp x2, RealTp eps)
-{
-    RealTp df, dx, fh, fl;
+template<typename RealTp>
+  RealTp
+  root_safe(void (*func)(RealTp, RealTp *, RealTp *), RealTp x1, RealTp x2, RealTp eps)
+  {
+    RealTp df, f, fh, fl;
 
     const int IMAX = 100;
 
     func(x1, &fl, &df);
     func(x2, &fh, &df);
 
-    if (fl * fh < 0)
-      throw std::logic_error"root must be bracketed in root_safe");
+    if (fl * fh > 0)
+      throw std::logic_error("root must be bracketed in root_safe");
 
     if (fl == 0)
       return x1;
@@ -435,21 +441,23 @@ root_safe(void (*func)(RealTp, RealTp *, RealTp *), RealTp x1, RealTp x2, RealTp
     auto x = 0.5 * (x1 + x2);
     auto dxold = std::fabs(x2 - x1);
     auto dx = dxold;
+    func(x, &f, &df);
     for (int i = 1; i <= IMAX; ++i)
       {
         if (((x - xh) * df - f)
-           * ((x - xl) * df - f) >= 0
+           * ((x - xl) * df - f) > 0
          || std::fabs(2 * f) > std::fabs(dxold * df))
           {
             dxold = dx;
             dx = 0.5 * (xh - xl);
             x = xl + dx;
-            if (x = xl) return x;
+            if (xl == x)
+              return x;
           }
         else
           {
             dxold = dx;
-            dx = f/df;
+            dx = f / df;
             auto temp = x;
             x -= dx;
             if (temp == x)
@@ -458,7 +466,6 @@ root_safe(void (*func)(RealTp, RealTp *, RealTp *), RealTp x1, RealTp x2, RealTp
         if (std::fabs(dx) < eps)
           return x;
 
-        RealTp f;
         func(x, &f, &df);
         if (f < 0)
           xl = x;
@@ -469,7 +476,7 @@ root_safe(void (*func)(RealTp, RealTp *, RealTp *), RealTp x1, RealTp x2, RealTp
     throw std::logic_error("maximum number of iterations in root_safe");
 
     return 0;
-}
+  }
 
 
 #endif  //  ROOTS_TCC
@@ -0,0 +1,349 @@
+#ifndef ROOTS_BATCH_TCC
+#define ROOTS_BATCH_TCC 1
+
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <algorithm>
+
+
+/**
+ *  The number of problems iterated together by the batched root finders.
+ *  Eight cache lines of each iterate are held across the problems: with fewer
+ *  lanes GCC unrolls the loops over the lanes completely before it tries to
+ *  vectorize them, and the function calls in them then stay scalar.
+ */
+template<typename RealTp>
+  constexpr std::size_t root_batch_lanes = 512 / sizeof(RealTp);
+
+
+/**
+ *  Using Brent's method, find the roots of count independent functions,
+ *  the i-th known to lie between x1[i] and x2[i], L = root_batch_lanes<RealTp> at a time.
+ *  The roots are written to root[0..count-1]; eps, ITMAX and EPS are as for root_brent()
+ *  and each root agrees with the one root_brent() returns.
+ *
+ *  The functions are evaluated for all lanes in one loop per pass:
+ *
+ *    func(std::size_t i, RealTp x)
+ *
+ *  returns the i-th function at x and should be inlinable so that the loop over
+ *  the lanes vectorizes (calls such as std::sin only vectorize with -ffast-math).
+ *  The Brent step is then taken in all lanes at once with each branch replaced by
+ *  a per-lane select.  A lane whose problem has converged (or failed) is refilled
+ *  with the next problem, which spends its first two passes evaluating the ends
+ *  of its bracket.  A lane left with no problem repeats its last evaluation
+ *  until the others finish.
+ *
+ *  A problem whose root is not bracketed or which needs more than ITMAX iterations
+ *  has its root set to NaN.  Returns the number of such problems.
+ */
+template<typename RealTp, typename Func>
+  std::size_t
+  root_brent_batch(Func func, std::size_t count,
+                   const RealTp * x1, const RealTp * x2, RealTp * root,
+                   RealTp eps, int ITMAX = 100, RealTp EPS = 1.0e-12)
+  {
+    constexpr std::size_t L = root_batch_lanes<RealTp>;
+    enum : int { LOWER, UPPER, STEP, PARKED };
+
+    alignas(64) RealTp a[L], b[L], c[L];
+    alignas(64) RealTp fa[L], fb[L], fc[L];
+    alignas(64) RealTp d[L], e[L];
+    alignas(64) RealTp x[L], f[L], r[L];
+    //  The masks are int rather than bool so that they vectorize with the doubles.
+    int act[L];
+    int done[L];
+    std::size_t prob[L];
+    int phase[L];
+    int iter[L];
+
+    if (count == 0)
+      return 0;
+
+    std::size_t next = 0;
+    std::size_t num_active = 0;
+    std::size_t num_failed = 0;
+
+    auto fill = [&](std::size_t l)
+    {
+      if (next < count)
+        {
+          prob[l] = next++;
+          a[l] = x[l] = x1[prob[l]];
+          b[l] = x2[prob[l]];
+          phase[l] = LOWER;
+          iter[l] = 0;
+          ++num_active;
+        }
+      else
+        phase[l] = PARKED;
+    };
+
+    auto retire = [&](std::size_t l, bool ok, RealTp value)
+    {
+      root[prob[l]] = ok ? value : std::numeric_limits<RealTp>::quiet_NaN();
+      num_failed += !ok;
+      --num_active;
+      fill(l);
+    };
+
+    for (std::size_t l = 0; l < L; ++l)
+      {
+        prob[l] = 0;
+        x[l] = x1[0];
+        fill(l);
+      }
+
+    while (num_active > 0)
+      {
+        for (std::size_t l = 0; l < L; ++l)
+          f[l] = func(prob[l], x[l]);
+
+        //  The lanes still evaluating the ends of their brackets.
+        for (std::size_t l = 0; l < L; ++l)
+          {
+            act[l] = false;
+            if (phase[l] == STEP)
+              {
+                fb[l] = f[l];
+                act[l] = true;
+              }
+            else if (phase[l] == LOWER)
+              {
+                fa[l] = f[l];
+                x[l] = b[l];
+                phase[l] = UPPER;
+              }
+            else if (phase[l] == UPPER)
+              {
+                fb[l] = f[l];
+                if (fa[l] * fb[l] > 0)
+                  retire(l, false, RealTp(0));
+                else
+                  {
+                    c[l] = b[l];
+                    fc[l] = fb[l];
+                    d[l] = e[l] = b[l] - a[l];
+                    phase[l] = STEP;
+                    act[l] = true;
+                  }
+              }
+          }
+
+        //  One Brent step in every active lane.
+        for (std::size_t l = 0; l < L; ++l)
+          {
+            RealTp A = a[l], B = b[l], C = c[l];
+            RealTp FA = fa[l], FB = fb[l], FC = fc[l];
+            RealTp D = d[l], E = e[l];
+
+            const bool restart = FB * FC > 0;
+            C = restart ? A : C;
+            FC = restart ? FA : FC;
+            D = restart ? B - A : D;
+            E = restart ? D : E;
+
+            const bool swap = std::abs(FC) < std::abs(FB);
+            const RealTp B0 = B, FB0 = FB;
+            A = swap ? B0 : A;
+            B = swap ? C : B;
+            C = swap ? B0 : C;
+            FA = swap ? FB0 : FA;
+            FB = swap ? FC : FB;
+            FC = swap ? FB0 : FC;
+
+            const RealTp tol1 = 2 * EPS * std::abs(B) + RealTp(0.5) * eps;
+            const RealTp xm = RealTp(0.5) * (C - B);
+            done[l] = std::abs(xm) <= tol1 || FB == 0;
+            r[l] = B;
+
+            //  Inverse quadratic interpolation, or the secant if only two points are distinct.
+            const RealTp s = FB / FA;
+            const bool secant = A == C;
+            const RealTp qq = FA / FC;
+            const RealTp rr = FB / FC;
+            RealTp p = secant ? 2 * xm * s : s * (2 * xm * qq * (qq - rr) - (B - A) * (rr - 1));
+            RealTp q = secant ? 1 - s : (qq - 1) * (rr - 1) * (s - 1);
+            q = p > 0 ? -q : q;
+            p = std::abs(p);
+            const RealTp min1 = 3 * xm * q - std::abs(tol1 * q);
+            const RealTp min2 = std::abs(E * q);
+            const bool interp = std::abs(E) >= tol1 && std::abs(FA) > std::abs(FB)
+                             && 2 * p < std::min(min1, min2);
+            const RealTp Dn = interp ? p / q : xm;
+            const RealTp En = interp ? D : xm;
+            const RealTp Bn = B + (std::abs(Dn) > tol1 ? Dn : std::copysign(tol1, xm));
+
+            if (act[l])
+              {
+                a[l] = B;
+                fa[l] = FB;
+                b[l] = x[l] = Bn;
+                c[l] = C;
+                fc[l] = FC;
+                d[l] = Dn;
+                e[l] = En;
+              }
+          }
+
+        for (std::size_t l = 0; l < L; ++l)
+          if (act[l])
+            {
+              if (done[l])
+                retire(l, true, r[l]);
+              else if (++iter[l] >= ITMAX)
+                retire(l, false, RealTp(0));
+            }
+      }
+
+    return num_failed;
+  }
+
+
+/**
+ *  Using a combination of Newton-Raphson and bisection, find the roots of count
+ *  independent functions, the i-th known to lie between x1[i] and x2[i],
+ *  L = root_batch_lanes<RealTp> at a time.  The roots are written to root[0..count-1]
+ *  and are refined until their accuracy is known within +/- eps, as in root_safe().
+ *
+ *    funcd(std::size_t i, RealTp x, RealTp * f, RealTp * df)
+ *
+ *  provides the i-th function and its first derivative at x and is called for all
+ *  lanes in one loop per pass, as the function in root_brent_batch().
+ *  A problem whose root is not bracketed or which needs more than IMAX iterations
+ *  has its root set to NaN.  Returns the number of such problems.
+ */
+template<typename RealTp, typename FuncD>
+  std::size_t
+  root_safe_batch(FuncD funcd, std::size_t count,
+                  const RealTp * x1, const RealTp * x2, RealTp * root,
+                  RealTp eps, int IMAX = 100)
+  {
+    constexpr std::size_t L = root_batch_lanes<RealTp>;
+    enum : int { LOWER, UPPER, MIDPOINT, STEP, PARKED };
+
+    alignas(64) RealTp xl[L], xh[L], fl[L];
+    alignas(64) RealTp dx[L], dxold[L];
+    alignas(64) RealTp x[L], f[L], df[L];
+    //  The masks are int rather than bool so that they vectorize with the doubles.
+    int act[L];
+    int done[L];
+    std::size_t prob[L];
+    int phase[L];
+    int iter[L];
+
+    if (count == 0)
+      return 0;
+
+    std::size_t next = 0;
+    std::size_t num_active = 0;
+    std::size_t num_failed = 0;
+
+    auto fill = [&](std::size_t l)
+    {
+      if (next < count)
+        {
+          prob[l] = next++;
+          x[l] = x1[prob[l]];
+          phase[l] = LOWER;
+          iter[l] = 0;
+          ++num_active;
+        }
+      else
+        phase[l] = PARKED;
+    };
+
+    auto retire = [&](std::size_t l, bool ok, RealTp value)
+    {
+      root[prob[l]] = ok ? value : std::numeric_limits<RealTp>::quiet_NaN();
+      num_failed += !ok;
+      --num_active;
+      fill(l);
+    };
+
+    for (std::size_t l = 0; l < L; ++l)
+      {
+        prob[l] = 0;
+        x[l] = x1[0];
+        fill(l);
+      }
+
+    while (num_active > 0)
+      {
+        for (std::size_t l = 0; l < L; ++l)
+          funcd(prob[l], x[l], &f[l], &df[l]);
+
+        //  The lanes still evaluating the ends of their brackets.
+        for (std::size_t l = 0; l < L; ++l)
+          {
+            act[l] = phase[l] == STEP || phase[l] == MIDPOINT;
+            if (phase[l] == LOWER)
+              {
+                fl[l] = f[l];
+                x[l] = x2[prob[l]];
+                phase[l] = UPPER;
+              }
+            else if (phase[l] == UPPER)
+              {
+                const RealTp lo = x1[prob[l]], hi = x2[prob[l]];
+                const RealTp fh = f[l];
+                if (fl[l] * fh > 0)
+                  retire(l, false, RealTp(0));
+                else if (fl[l] == 0)
+                  retire(l, true, lo);
+                else if (fh == 0)
+                  retire(l, true, hi);
+                else
+                  {
+                    //  Orient the search so that f(xl) < 0.
+                    xl[l] = fl[l] < 0 ? lo : hi;
+                    xh[l] = fl[l] < 0 ? hi : lo;
+                    x[l] = RealTp(0.5) * (lo + hi);
+                    dxold[l] = dx[l] = std::abs(hi - lo);
+                    phase[l] = MIDPOINT;
+                  }
+              }
+          }
+
+        //  One Newton or bisection step in every active lane.
+        for (std::size_t l = 0; l < L; ++l)
+          {
+            const RealTp X = x[l], F = f[l], DF = df[l];
+            const bool update = phase[l] == STEP;
+            const RealTp XL = update && F < 0 ? X : xl[l];
+            const RealTp XH = update && !(F < 0) ? X : xh[l];
+
+            const bool bisect = ((X - XH) * DF - F) * ((X - XL) * DF - F) > 0
+                             || std::abs(2 * F) > std::abs(dxold[l] * DF);
+            const RealTp DX = bisect ? RealTp(0.5) * (XH - XL) : F / DF;
+            const RealTp Xn = bisect ? XL + DX : X - DX;
+            done[l] = (bisect ? XL == Xn : X == Xn) || std::abs(DX) < eps;
+
+            if (act[l])
+              {
+                xl[l] = XL;
+                xh[l] = XH;
+                dxold[l] = dx[l];
+                dx[l] = DX;
+                x[l] = Xn;
+              }
+          }
+
+        for (std::size_t l = 0; l < L; ++l)
+          if (act[l])
+            {
+              phase[l] = STEP;
+              if (done[l])
+                retire(l, true, x[l]);
+              else if (++iter[l] >= IMAX)
+                retire(l, false, RealTp(0));
+            }
+      }
+
+    return num_failed;
+  }
+
+
+#endif  //  ROOTS_BATCH_TCC
@@ -0,0 +1,113 @@
+// $HOME/bin/bin/g++ -std=c++14 -O3 -march=native -o test_gauss_quad test_gauss_quad.cpp -lpthread
+
+// ./test_gauss_quad [max_order]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <cstdlib>
+
+#include "cmath_variable_template"
+#include "gauss_quad.tcc"
+#include "../timer.h"
+
+int
+main(int n_app_args, char ** app_args)
+{
+  int max_order = 1000000;
+  if (n_app_args > 1)
+    max_order = std::atoi(app_args[1]);
+
+  //  The O(n) march against the Newton iteration on the recursion relation.
+  std::cout << "gauss_legendre_glr versus the recursion\n";
+  for (int n : {17, 18, 19, 20})
+    {
+      std::vector<double> x1(n), w1(n), x2(n), w2(n);
+      gauss_legendre(n, -1.0, 1.0, x1.data(), w1.data());
+      gauss_legendre_glr(n, x2.data(), w2.data());
+      double dx = 0.0, dw = 0.0;
+      for (int i = 0; i < n; ++i)
+        {
+          dx = std::max(dx, std::abs(x1[i] - x2[i]));
+          dw = std::max(dw, std::abs(w1[i] - w2[i]) / w1[i]);
+        }
+      std::cout << "  n = " << std::setw(4) << n
+                << "  max abscissa diff " << std::setw(12) << dx
+                << "  max relative weight diff " << std::setw(12) << dw << '\n';
+    }
+
+  //  Large rules; the weights should sum to 2 and integrate cos over [-1, +1] to 2 sin(1).
+  Timer timer;
+  std::cout << '\n' << std::setw(10) << "n"
+            << std::setw(10) << "ms"
+            << std::setw(14) << "sum w - 2"
+            << std::setw(14) << "cos err" << '\n';
+  for (int n = 1000; n <= max_order; n *= 10)
+    {
+      std::vector<double> x(n), w(n);
+      timer.start();
+      gauss_legendre(n, -1.0, 1.0, x.data(), w.data());
+      timer.stop();
+      long double sum = 0, cos = 0;
+      for (int i = 0; i < n; ++i)
+        {
+          sum += w[i];
+          cos += w[i] * std::cos(x[i]);
+        }
+      std::cout << std::setw(10) << n
+                << std::setw(10) << timer.time_elapsed()
+                << std::setw(14) << double(sum - 2)
+                << std::setw(14) << double(cos - 2 * std::sin(1.0L)) << '\n';
+    }
+
+  //  The rule cache.
+  const int n_cache = 100000;
+  std::cout << "\ngauss_rule_cache, n = " << n_cache << '\n';
+  timer.start();
+  auto rule = gauss_rule_cache<double>::get(gauss_family::legendre, n_cache);
+  timer.stop();
+  std::cout << "  first request    " << timer.time_elapsed() << " ms\n";
+
+  const int n_get = 1000000;
+  timer.start();
+  for (int k = 0; k < n_get; ++k)
+    if (gauss_rule_cache<double>::get(gauss_family::legendre, n_cache) != rule)
+      std::cout << "  cache returned a different rule\n";
+  timer.stop();
+  std::cout << "  " << n_get << " repeats  " << timer.time_elapsed() << " ms\n";
+
+  //  Concurrent first requests for the same rules all see one copy.
+  std::vector<std::thread> workers;
+  std::vector<gauss_rule_cache<double>::rule_ptr> seen(8);
+  for (int t = 0; t < 8; ++t)
+    workers.emplace_back([&seen, t]
+    { seen[t] = gauss_rule_cache<double>::get(gauss_family::jacobi, 40, 0.5, -0.5); });
+  for (auto & worker : workers)
+    worker.join();
+  int n_distinct = 0;
+  for (int t = 0; t < 8; ++t)
+    n_distinct += (seen[t] != seen[0]);
+  std::cout << "  threads with a different jacobi rule: " << n_distinct << '\n';
+
+  std::cout << "  integral of cos over [0, pi/2]: " << std::setprecision(16)
+            << quad_gauss([](double x){ return std::cos(x); }, 0.0, M_PI / 2, *rule)
+            << std::setprecision(6) << '\n';
+
+  //  Sums of weights for the other families.
+  auto sum_w = [](gauss_family family, int n, double alpha, double beta)
+  {
+    auto r = gauss_rule_cache<double>::get(family, n, alpha, beta);
+    double sum = 0.0;
+    for (auto w : r->w)
+      sum += w;
+    return sum;
+  };
+  std::cout << "\nsum of weights, n = 40\n";
+  std::cout << "  hermite    " << sum_w(gauss_family::hermite, 40, 0.0, 0.0) - std::sqrt(M_PI) << '\n';
+  std::cout << "  laguerre   " << sum_w(gauss_family::laguerre, 40, 1.0, 0.0) - 1.0 << '\n';
+  std::cout << "  jacobi     " << sum_w(gauss_family::jacobi, 40, 1.5, -0.5)
+                                  - 4 * std::tgamma(2.5) * std::tgamma(0.5) / std::tgamma(3.0) << '\n';
+  std::cout << "  chebyshev  " << sum_w(gauss_family::chebyshev, 40, 0.0, 0.0) - M_PI << '\n';
+  std::cout << "  cached rules: " << gauss_rule_cache<double>::size() << '\n';
+}
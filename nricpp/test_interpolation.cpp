@@ -0,0 +1,116 @@
+// $HOME/bin/bin/g++ -std=c++14 -O3 -march=native -o test_interpolation test_interpolation.cpp
+
+// ./test_interpolation [num_queries]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <cstdlib>
+
+#include "interpolation.tcc"
+#include "../timer.h"
+
+int
+main(int n_app_args, char ** app_args)
+{
+  std::size_t n_query = 10000000;
+  if (n_app_args > 1)
+    n_query = std::atol(app_args[1]);
+
+  //  A uniform and a graded table of sin(x) on [0, 10].
+  const int n = 1000;
+  std::vector<double> xu(n), xg(n), yu(n), yg(n);
+  for (int i = 0; i < n; ++i)
+    {
+      const double s = double(i) / (n - 1);
+      xu[i] = 10 * s;
+      xg[i] = 10 * s * s;
+      yu[i] = std::sin(xu[i]);
+      yg[i] = std::sin(xg[i]);
+    }
+
+  //  A sorted stream of queries and a shuffled copy of it.
+  std::vector<double> xq(n_query), xr(n_query), yq(n_query), yref(n_query);
+  for (std::size_t i = 0; i < n_query; ++i)
+    xq[i] = 10 * (i + 0.5) / n_query;
+  xr = xq;
+  std::shuffle(xr.begin(), xr.end(), std::mt19937_64(42));
+
+  Timer timer;
+  for (int graded = 0; graded < 2; ++graded)
+    {
+      const auto & x = graded ? xg : xu;
+      const auto & y = graded ? yg : yu;
+      std::cout << (graded ? "\ngraded table" : "uniform table") << ", n = " << n
+                << ", " << n_query << " queries\n";
+
+      std::vector<double> ypp(n);
+      cubic_spline(x.data(), y.data(), n, {}, {}, ypp.data());
+      cubic_spline_interpolator<double> spline(x.data(), y.data(), n);
+      linear_interpolator<double> linear(x.data(), y.data(), n);
+      std::cout << "  grid detected as uniform: " << spline.grid().uniform() << '\n';
+
+      for (int shuffled = 0; shuffled < 2; ++shuffled)
+        {
+          const auto & xs = shuffled ? xr : xq;
+          std::cout << (shuffled ? "  shuffled queries\n" : "  sorted queries\n");
+
+          timer.start();
+          for (std::size_t i = 0; i < n_query; ++i)
+            yref[i] = cubic_spline_interp(x.data(), y.data(), ypp.data(), n, xs[i]);
+          timer.stop();
+          std::cout << "    cubic_spline_interp       " << std::setw(8) << timer.time_elapsed() << " ms\n";
+
+          timer.start();
+          for (std::size_t i = 0; i < n_query; ++i)
+            yq[i] = spline(xs[i]);
+          timer.stop();
+          double err = 0.0;
+          for (std::size_t i = 0; i < n_query; ++i)
+            err = std::max(err, std::abs(yq[i] - yref[i]));
+          std::cout << "    spline operator()         " << std::setw(8) << timer.time_elapsed() << " ms"
+                    << "  max diff " << err << '\n';
+
+          timer.start();
+          spline.evaluate(xs.data(), yq.data(), n_query);
+          timer.stop();
+          err = 0.0;
+          double err_sin = 0.0;
+          for (std::size_t i = 0; i < n_query; ++i)
+            {
+              err = std::max(err, std::abs(yq[i] - yref[i]));
+              err_sin = std::max(err_sin, std::abs(yq[i] - std::sin(xs[i])));
+            }
+          std::cout << "    spline evaluate           " << std::setw(8) << timer.time_elapsed() << " ms"
+                    << "  max diff " << err << "  max error " << err_sin << '\n';
+
+          timer.start();
+          for (std::size_t i = 0; i < n_query; ++i)
+            yref[i] = linear_interp(x.data(), y.data(), n, xs[i]);
+          timer.stop();
+          std::cout << "    linear_interp             " << std::setw(8) << timer.time_elapsed() << " ms\n";
+
+          timer.start();
+          linear.evaluate(xs.data(), yq.data(), n_query);
+          timer.stop();
+          err = 0.0;
+          for (std::size_t i = 0; i < n_query; ++i)
+            err = std::max(err, std::abs(yq[i] - yref[i]));
+          std::cout << "    linear evaluate           " << std::setw(8) << timer.time_elapsed() << " ms"
+                    << "  max diff " << err << '\n';
+        }
+    }
+
+  //  Local polynomial interpolation and the out of range and clamped end behaviour.
+  polynomial_interpolator<double> poly(xu.data(), yu.data(), n, 6);
+  double err = 0.0;
+  for (double x : {0.0, 0.001, 3.3333, 9.9999, 10.0})
+    err = std::max(err, std::abs(poly(x) - std::sin(x)));
+  std::cout << "\npolynomial_interpolator, order 6, max error " << err
+            << ", last error estimate " << poly.error() << '\n';
+
+  std::vector<double> ends{-1.0, 11.0};
+  cubic_spline_interpolator<double> clamped(xu.data(), yu.data(), n, 1.0, std::cos(10.0));
+  std::cout << "clamped spline at -1 and 11: " << clamped(ends[0]) << ' ' << clamped(ends[1]) << '\n';
+}
@@ -0,0 +1,104 @@
+// $HOME/bin/bin/g++ -std=c++14 -O3 -march=native -o test_lu_decomp test_lu_decomp.cpp -lpthread
+
+// ./test_lu_decomp [max_size [num_threads]]
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <cstdlib>
+#include <thread>
+
+#include "matrix_lu_decomp.tcc"
+#include "../timer.h"
+
+using Mat = std::vector<std::vector<double>>;
+
+//  Return max |a.x - b| for the original matrix a.
+double
+residual(const Mat & a, const std::vector<double> & x, const std::vector<double> & b)
+{
+  double res = 0.0;
+  for (std::size_t i = 0; i < a.size(); ++i)
+    {
+      double s = -b[i];
+      for (std::size_t j = 0; j < a.size(); ++j)
+        s += a[i][j] * x[j];
+      res = std::max(res, std::abs(s));
+    }
+  return res;
+}
+
+int
+main(int n_app_args, char ** app_args)
+{
+  std::size_t max_size = 1000;
+  if (n_app_args > 1)
+    max_size = std::atol(app_args[1]);
+  unsigned num_threads = std::thread::hardware_concurrency();
+  if (n_app_args > 2)
+    num_threads = std::atoi(app_args[2]);
+
+  std::mt19937 re;
+  std::uniform_real_distribution<double> ud(-1.0, 1.0);
+
+  std::cout << std::setw(6) << "n"
+            << std::setw(12) << "crout ms"
+            << std::setw(12) << "blocked ms"
+            << std::setw(12) << "threads ms"
+            << std::setw(14) << "crout res"
+            << std::setw(14) << "blocked res"
+            << std::setw(14) << "det ratio" << '\n';
+  for (std::size_t n : {100, 200, 500, 1000, 2000, 4000})
+    {
+      if (n > max_size)
+        break;
+
+      Mat a(n, std::vector<double>(n));
+      for (auto & row : a)
+        for (auto & x : row)
+          x = ud(re);
+      std::vector<double> b(n);
+      for (auto & x : b)
+        x = ud(re);
+
+      Mat a1 = a, a2 = a, a3 = a;
+      std::vector<int> i1(n), i2(n), i3(n);
+      double p1, p2, p3;
+
+      Timer timer;
+
+      timer.start();
+      matrix::lu_decomp(n, a1, i1, p1);
+      timer.stop();
+      long t_crout = timer.time_elapsed();
+
+      timer.start();
+      matrix::lu_decomp_blocked(n, a2, i2, p2);
+      timer.stop();
+      long t_blocked = timer.time_elapsed();
+
+      timer.start();
+      matrix::lu_decomp_blocked(n, a3, i3, p3, num_threads);
+      timer.stop();
+      long t_par = timer.time_elapsed();
+
+      std::vector<double> x1 = b, x2 = b, x3 = b;
+      matrix::lu_backsub(n, a1, i1, x1);
+      matrix::lu_backsub(n, a2, i2, x2);
+      matrix::lu_backsub(n, a3, i3, x3);
+
+      //  Compare determinants through their ratio to avoid overflow.
+      double ratio = p1 * p2;
+      for (std::size_t i = 0; i < n; ++i)
+        ratio *= a2[i][i] / a1[i][i];
+
+      std::cout << std::setw(6) << n
+                << std::setw(12) << t_crout
+                << std::setw(12) << t_blocked
+                << std::setw(12) << t_par
+                << std::setw(14) << residual(a, x1, b)
+                << std::setw(14) << std::max(residual(a, x2, b), residual(a, x3, b))
+                << std::setw(14) << ratio << '\n';
+    }
+}
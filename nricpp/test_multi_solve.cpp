@@ -0,0 +1,260 @@
+// $HOME/bin/bin/g++ -std=c++14 -O3 -march=native -o test_multi_solve test_multi_solve.cpp
+
+// ./test_multi_solve [n [num_rhs [num_small]]]
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <cstdlib>
+
+#include "matrix_lu_decomp.tcc"
+#include "matrix_qr_decomp.tcc"
+#include "matrix_cholesky_decomp.tcc"
+#include "matrix_batched_solve.tcc"
+#include "../timer.h"
+
+using Mat = std::vector<std::vector<double>>;
+
+//  Return max |a.X - B| over all columns for the original matrix a.
+double
+residual(const Mat & a, const Mat & x, const Mat & b)
+{
+  const std::size_t n = a.size(), m = b[0].size();
+  double res = 0.0;
+  for (std::size_t i = 0; i < n; ++i)
+    for (std::size_t j = 0; j < m; ++j)
+      {
+        double s = -b[i][j];
+        for (std::size_t k = 0; k < n; ++k)
+          s += a[i][k] * x[k][j];
+        res = std::max(res, std::abs(s));
+      }
+  return res;
+}
+
+template<std::size_t N>
+  void
+  test_small(std::size_t count, std::mt19937 & re)
+  {
+    std::uniform_real_distribution<double> ud(-1.0, 1.0);
+
+    //  General matrices for LU and diagonally dominant symmetric ones for Cholesky.
+    std::vector<double> a(count * N * N), s(count * N * N), b(count * N);
+    for (std::size_t c = 0; c < count; ++c)
+      {
+        double * ac = &a[c * N * N];
+        double * sc = &s[c * N * N];
+        for (std::size_t i = 0; i < N * N; ++i)
+          ac[i] = ud(re);
+        for (std::size_t i = 0; i < N; ++i)
+          for (std::size_t j = 0; j <= i; ++j)
+            sc[i * N + j] = sc[j * N + i] = (i == j ? N : ud(re));
+      }
+    for (auto & x : b)
+      x = ud(re);
+
+    Timer timer;
+
+    std::vector<double> x1 = b;
+    timer.start();
+    for (std::size_t c = 0; c < count; ++c)
+      {
+        double ac[N][N], bc[N];
+        std::copy(&a[c * N * N], &a[c * N * N] + N * N, &ac[0][0]);
+        std::copy(&x1[c * N], &x1[c * N] + N, bc);
+        matrix::lu_solve_small(ac, bc);
+        std::copy(bc, bc + N, &x1[c * N]);
+      }
+    timer.stop();
+    long t_small = timer.time_elapsed();
+
+    std::vector<double> x2 = b;
+    timer.start();
+    auto num_singular = matrix::lu_solve_batch<N>(count, a.data(), x2.data());
+    timer.stop();
+    long t_batch = timer.time_elapsed();
+
+    std::vector<double> x3 = b;
+    timer.start();
+    auto num_failed = matrix::cholesky_solve_batch<N>(count, s.data(), x3.data());
+    timer.stop();
+    long t_chol = timer.time_elapsed();
+
+    //  The LU solutions are compared by their residuals relative to the size
+    //  of the solution: the random matrices include ill-conditioned ones whose
+    //  solutions differ by more than rounding between two correct solvers.
+    double lu_res1 = 0.0, lu_res2 = 0.0, res = 0.0;
+    for (std::size_t c = 0; c < count; ++c)
+      {
+        double xmax1 = 1.0, xmax2 = 1.0;
+        for (std::size_t i = 0; i < N; ++i)
+          {
+            xmax1 = std::max(xmax1, std::abs(x1[c * N + i]));
+            xmax2 = std::max(xmax2, std::abs(x2[c * N + i]));
+          }
+        for (std::size_t i = 0; i < N; ++i)
+          {
+            double r1 = -b[c * N + i], r2 = -b[c * N + i], r = -b[c * N + i];
+            for (std::size_t j = 0; j < N; ++j)
+              {
+                r1 += a[c * N * N + i * N + j] * x1[c * N + j];
+                r2 += a[c * N * N + i * N + j] * x2[c * N + j];
+                r += s[c * N * N + i * N + j] * x3[c * N + j];
+              }
+            lu_res1 = std::max(lu_res1, std::abs(r1) / xmax1);
+            lu_res2 = std::max(lu_res2, std::abs(r2) / xmax2);
+            res = std::max(res, std::abs(r));
+          }
+      }
+
+    std::cout << std::setw(4) << N
+              << std::setw(12) << t_small
+              << std::setw(12) << t_batch
+              << std::setw(12) << t_chol
+              << std::setw(14) << lu_res1
+              << std::setw(14) << lu_res2
+              << std::setw(14) << res
+              << std::setw(6) << num_singular + num_failed << '\n';
+  }
+
+int
+main(int n_app_args, char ** app_args)
+{
+  std::size_t n = 500;
+  if (n_app_args > 1)
+    n = std::atol(app_args[1]);
+  std::size_t m = 1000;
+  if (n_app_args > 2)
+    m = std::atol(app_args[2]);
+  std::size_t count = 1000000;
+  if (n_app_args > 3)
+    count = std::atol(app_args[3]);
+
+  std::mt19937 re;
+  std::uniform_real_distribution<double> ud(-1.0, 1.0);
+
+  Mat a(n, std::vector<double>(n));
+  for (auto & row : a)
+    for (auto & x : row)
+      x = ud(re);
+  Mat spd(n, std::vector<double>(n));
+  for (std::size_t i = 0; i < n; ++i)
+    for (std::size_t j = 0; j <= i; ++j)
+      spd[i][j] = spd[j][i] = (i == j ? double(n) : ud(re));
+  Mat b(n, std::vector<double>(m));
+  for (auto & row : b)
+    for (auto & x : row)
+      x = ud(re);
+
+  Timer timer;
+
+  //  LU: one vector at a time versus all columns at once.
+  Mat a_lu = a;
+  std::vector<int> index(n);
+  double parity;
+  matrix::lu_decomp_blocked(n, a_lu, index, parity);
+
+  Mat x1 = b;
+  timer.start();
+  std::vector<double> col(n);
+  for (std::size_t j = 0; j < m; ++j)
+    {
+      for (std::size_t i = 0; i < n; ++i)
+        col[i] = b[i][j];
+      matrix::lu_backsub(n, a_lu, index, col);
+      for (std::size_t i = 0; i < n; ++i)
+        x1[i][j] = col[i];
+    }
+  timer.stop();
+  long t_lu_vec = timer.time_elapsed();
+
+  Mat x2 = b;
+  timer.start();
+  matrix::lu_backsub_multi(n, a_lu, index, x2, m);
+  timer.stop();
+  long t_lu_multi = timer.time_elapsed();
+
+  //  Cholesky.
+  Mat a_ch = spd;
+  std::vector<double> d(n);
+  matrix::cholesky_decomp(n, a_ch, d);
+
+  Mat x3(n, std::vector<double>(m));
+  std::vector<double> bcol(n), xcol(n);
+  timer.start();
+  for (std::size_t j = 0; j < m; ++j)
+    {
+      for (std::size_t i = 0; i < n; ++i)
+        bcol[i] = b[i][j];
+      matrix::cholesky_backsub(n, a_ch, d, bcol, xcol);
+      for (std::size_t i = 0; i < n; ++i)
+        x3[i][j] = xcol[i];
+    }
+  timer.stop();
+  long t_ch_vec = timer.time_elapsed();
+
+  Mat x4 = b;
+  timer.start();
+  matrix::cholesky_backsub_multi(n, a_ch, d, x4, m);
+  timer.stop();
+  long t_ch_multi = timer.time_elapsed();
+
+  //  QR.
+  Mat a_qr = a;
+  std::vector<double> c(n), dq(n);
+  bool singular;
+  matrix::qr_decomp(n, n, a_qr, c, dq, singular);
+
+  Mat x5(n, std::vector<double>(m));
+  timer.start();
+  for (std::size_t j = 0; j < m; ++j)
+    {
+      for (std::size_t i = 0; i < n; ++i)
+        col[i] = b[i][j];
+      matrix::qr_backsub(n, n, a_qr, c, dq, col);
+      for (std::size_t i = 0; i < n; ++i)
+        x5[i][j] = col[i];
+    }
+  timer.stop();
+  long t_qr_vec = timer.time_elapsed();
+
+  Mat x6 = b;
+  timer.start();
+  matrix::qr_backsub_multi(n, n, a_qr, c, dq, x6, m);
+  timer.stop();
+  long t_qr_multi = timer.time_elapsed();
+
+  std::cout << "n = " << n << "  rhs = " << m << '\n';
+  std::cout << std::setw(10) << ""
+            << std::setw(12) << "vector ms"
+            << std::setw(12) << "multi ms"
+            << std::setw(14) << "vector res"
+            << std::setw(14) << "multi res" << '\n';
+  std::cout << std::setw(10) << "lu"
+            << std::setw(12) << t_lu_vec << std::setw(12) << t_lu_multi
+            << std::setw(14) << residual(a, x1, b)
+            << std::setw(14) << residual(a, x2, b) << '\n';
+  std::cout << std::setw(10) << "cholesky"
+            << std::setw(12) << t_ch_vec << std::setw(12) << t_ch_multi
+            << std::setw(14) << residual(spd, x3, b)
+            << std::setw(14) << residual(spd, x4, b) << '\n';
+  std::cout << std::setw(10) << "qr"
+            << std::setw(12) << t_qr_vec << std::setw(12) << t_qr_multi
+            << std::setw(14) << residual(a, x5, b)
+            << std::setw(14) << residual(a, x6, b) << '\n';
+
+  std::cout << '\n' << count << " small systems\n";
+  std::cout << std::setw(4) << "N"
+            << std::setw(12) << "small ms"
+            << std::setw(12) << "batch ms"
+            << std::setw(12) << "chol ms"
+            << std::setw(14) << "small res"
+            << std::setw(14) << "batch res"
+            << std::setw(14) << "chol res"
+            << std::setw(6) << "sing" << '\n';
+  test_small<3>(count, re);
+  test_small<4>(count, re);
+  test_small<6>(count, re);
+  test_small<8>(count, re);
+}
@@ -1,17 +1,306 @@
-// $HOME/bin/bin/g++ -o test_ode test_ode.cpp
+// $HOME/bin/bin/g++ -std=c++14 -O3 -march=native -o test_ode test_ode.cpp
 
-// LD_LIBRARY_PATH=$HOME/bin/lib64:$LD_LIBRARY_PATH ./test_ode
+// LD_LIBRARY_PATH=$HOME/bin/lib64:$LD_LIBRARY_PATH ./test_ode [n_orbits]
 
 #include <iostream>
 #include <iomanip>
-
+#include <array>
+#include <vector>
+#include <new>
+#include <cstdlib>
 
 #include "ode.tcc"
+#include "../timer.h"
+
+//  Count heap allocations so we can check that the stepping loops never allocate.
+static long num_allocs = 0;
+
+void *
+operator new(std::size_t n)
+{
+  ++num_allocs;
+  if (void * p = std::malloc(n))
+    return p;
+  throw std::bad_alloc();
+}
+
+void
+operator delete(void * p) noexcept
+{ std::free(p); }
+
+void
+operator delete(void * p, std::size_t) noexcept
+{ std::free(p); }
+
+//  Kepler problem with unit gravitational parameter: y = (x, y, vx, vy).
+struct kepler
+{
+  template<typename StateVec>
+    void
+    operator()(const StateVec & y, double, StateVec & dydx) const
+    {
+      const auto r2 = y[0] * y[0] + y[1] * y[1];
+      const auto r3 = r2 * std::sqrt(r2);
+      dydx[0] = y[2];
+      dydx[1] = y[3];
+      dydx[2] = -y[0] / r3;
+      dydx[3] = -y[1] / r3;
+    }
+};
+
+//  Kepler problem counting the calls of the right hand side.
+struct counting_kepler
+{
+  long * count;
+
+  template<typename StateVec>
+    void
+    operator()(const StateVec & y, double x, StateVec & dydx) const
+    {
+      ++*count;
+      kepler{}(y, x, dydx);
+    }
+};
+
+//  Crossing of the x axis from above, i.e. aphelion for an orbit starting at perihelion.
+struct aphelion
+{
+  template<typename StateVec>
+    double
+    operator()(double, const StateVec & y) const
+    { return y[3] > 0.0 ? 1.0 : y[1]; }
+};
+
+//  The exact position at time t for the orbit from initial_state().
+std::array<double, 2>
+kepler_position(double e, double t)
+{
+  //  Solve Kepler's equation E - e sin E = t by Newton's method.
+  double E = t;
+  for (int i = 0; i < 50; ++i)
+    {
+      const double dE = (E - e * std::sin(E) - t) / (1.0 - e * std::cos(E));
+      E -= dE;
+      if (std::abs(dE) < 1.0e-15)
+        break;
+    }
+  return {std::cos(E) - e, std::sqrt(1.0 - e * e) * std::sin(E)};
+}
+
+template<typename StateVec>
+  double
+  energy(const StateVec & y)
+  {
+    return 0.5 * (y[2] * y[2] + y[3] * y[3])
+         - 1.0 / std::sqrt(y[0] * y[0] + y[1] * y[1]);
+  }
+
+//  Elliptic orbit with eccentricity 0.5 starting at perihelion; the period is 2 pi.
+template<typename StateVec>
+  StateVec
+  initial_state()
+  {
+    const double e = 0.5;
+    StateVec y = StateVec{1.0 - e, 0.0, 0.0, std::sqrt((1.0 + e) / (1.0 - e))};
+    return y;
+  }
 
+template<typename StateVec, typename Stepper>
+  void
+  run_adaptive(const char * name, Stepper & stepper, int n_orbits, double eps)
+  {
+    const double period = 2 * M_PI;
+    auto y = initial_state<StateVec>();
+    const auto e0 = energy(y);
+    StateVec dydx = y, yscale = y;
+    kepler deriv;
+    double x = 0.0, h = 0.01, h_final, h_next;
+    const double x_end = n_orbits * period;
+    long n_steps = 0;
+
+    const auto y0 = initial_state<StateVec>();
+    Timer timer;
+    const auto allocs = num_allocs;
+    timer.start();
+    while (x < x_end)
+      {
+        if (x + h > x_end)
+          h = x_end - x;
+        deriv(y, x, dydx);
+        for (std::size_t i = 0; i < y.size(); ++i)
+          yscale[i] = std::abs(y[i]) + std::abs(h * dydx[i]) + 1.0e-30;
+        stepper.quad_step(deriv, y, dydx, x, h, eps, yscale, h_final, h_next);
+        h = h_next;
+        ++n_steps;
+      }
+    timer.stop();
+
+    std::cout << std::setw(24) << name
+              << std::setw(10) << n_steps
+              << std::setw(10) << timer.time_elapsed()
+              << std::setw(10) << num_allocs - allocs
+              << std::setw(14) << std::abs(energy(y) - e0)
+              << std::setw(14) << std::hypot(y[0] - y0[0], y[1] - y0[1]) << '\n';
+  }
+
+template<typename StateVec>
+  void
+  run_rk4(const char * name, int n_orbits, int steps_per_orbit)
+  {
+    const double period = 2 * M_PI;
+    auto y = initial_state<StateVec>();
+    const auto e0 = energy(y);
+    StateVec dydx = y;
+    runge_kutta_4_stepper<StateVec> rk4(y);
+    kepler deriv;
+    const double h = period / steps_per_orbit;
+    double x = 0.0;
+    const long n_steps = long(n_orbits) * steps_per_orbit;
+
+    const auto y0 = initial_state<StateVec>();
+    Timer timer;
+    const auto allocs = num_allocs;
+    timer.start();
+    for (long k = 0; k < n_steps; ++k)
+      {
+        deriv(y, x, dydx);
+        rk4.step(deriv, y, dydx, x, h, y);
+        x += h;
+      }
+    timer.stop();
+
+    std::cout << std::setw(24) << name
+              << std::setw(10) << n_steps
+              << std::setw(10) << timer.time_elapsed()
+              << std::setw(10) << num_allocs - allocs
+              << std::setw(14) << std::abs(energy(y) - e0)
+              << std::setw(14) << std::hypot(y[0] - y0[0], y[1] - y0[1]) << '\n';
+  }
 
 int
-main()
+main(int n_app_args, char ** app_args)
 {
+  int n_orbits = 1000;
+  if (n_app_args > 1)
+    n_orbits = std::atoi(app_args[1]);
+
+  using ArrayState = std::array<double, 4>;
+  using VectorState = std::vector<double>;
+
+  std::cout << n_orbits << " orbits\n";
+  std::cout << std::setw(24) << ""
+            << std::setw(10) << "steps"
+            << std::setw(10) << "ms"
+            << std::setw(10) << "allocs"
+            << std::setw(14) << "energy err"
+            << std::setw(14) << "position err" << '\n';
+
+  run_rk4<ArrayState>("rk4 array", n_orbits, 1000);
+  run_rk4<VectorState>("rk4 vector", n_orbits, 1000);
+
+  const double eps = 1.0e-10;
+
+  cash_karp_stepper<ArrayState> ck_a;
+  run_adaptive<ArrayState>("cash-karp array", ck_a, n_orbits, eps);
+  cash_karp_stepper<VectorState> ck_v(VectorState(4));
+  run_adaptive<VectorState>("cash-karp vector", ck_v, n_orbits, eps);
+
+  runge_kutta_4_stepper<ArrayState> rk4_a;
+  run_adaptive<ArrayState>("rk4 doubling array", rk4_a, n_orbits, eps);
+
+  bulirsch_stoer_stepper<ArrayState> bs_a;
+  run_adaptive<ArrayState>("bulirsch-stoer array", bs_a, n_orbits, eps);
+  bulirsch_stoer_stepper<VectorState> bs_v(VectorState(4));
+  run_adaptive<VectorState>("bulirsch-stoer vector", bs_v, n_orbits, eps);
+  bulirsch_stoer_stepper<ArrayState> bs_r(ArrayState{}, true);
+  run_adaptive<ArrayState>("bulirsch-stoer rational", bs_r, n_orbits, eps);
+
+  //  Dense output at many fixed times versus stopping the driver at each of them.
+  {
+    using State = ArrayState;
+    const int n_out = 1000;
+    const double period = 2 * M_PI;
+    std::vector<double> x_out(n_out + 1);
+    for (int k = 0; k <= n_out; ++k)
+      x_out[k] = k * period / n_out;
+
+    auto error = [&](const std::vector<State> & y_out)
+    {
+      double err = 0.0;
+      for (int k = 0; k <= n_out; ++k)
+        {
+          const auto p = kepler_position(0.5, x_out[k]);
+          err = std::max(err, std::hypot(y_out[k][0] - p[0], y_out[k][1] - p[1]));
+        }
+      return err;
+    };
+
+    std::cout << '\n' << n_out << " outputs over one orbit\n";
+    std::cout << std::setw(24) << ""
+              << std::setw(10) << "derivs"
+              << std::setw(14) << "max err" << '\n';
+
+    cash_karp_stepper<State> ck_d;
+    bulirsch_stoer_stepper<State> bs_d;
+    for (int use_bs = 0; use_bs < 2; ++use_bs)
+      {
+        long count = 0;
+        std::vector<State> y_out(n_out + 1);
+        auto y = initial_state<State>();
+        int nok, nbad;
+        if (use_bs)
+          ode_integrate_dense(y, 0.0, period, eps, 0.01, 0.0, nok, nbad, bs_d,
+                              counting_kepler{&count}, x_out.begin(), x_out.end(),
+                              y_out.begin());
+        else
+          ode_integrate_dense(y, 0.0, period, eps, 0.01, 0.0, nok, nbad, ck_d,
+                              counting_kepler{&count}, x_out.begin(), x_out.end(),
+                              y_out.begin());
+        std::cout << std::setw(24) << (use_bs ? "bulirsch-stoer dense" : "cash-karp dense")
+                  << std::setw(10) << count
+                  << std::setw(14) << error(y_out) << '\n';
+
+        count = 0;
+        y = initial_state<State>();
+        y_out[0] = y;
+        for (int k = 0; k < n_out; ++k)
+          {
+            if (use_bs)
+              ode_integrate(y, x_out[k], x_out[k + 1], eps, 0.01, 0.0, nok, nbad, bs_d,
+                            counting_kepler{&count});
+            else
+              ode_integrate(y, x_out[k], x_out[k + 1], eps, 0.01, 0.0, nok, nbad, ck_d,
+                            counting_kepler{&count});
+            y_out[k + 1] = y;
+          }
+        std::cout << std::setw(24) << (use_bs ? "bulirsch-stoer stops" : "cash-karp stops")
+                  << std::setw(10) << count
+                  << std::setw(14) << error(y_out) << '\n';
+      }
+
+    //  Stop at aphelion, half a period.
+    long count = 0;
+    auto y = initial_state<State>();
+    int nok, nbad;
+    std::vector<State> y_out;
+    const auto x_stop = ode_integrate_dense(y, 0.0, period, eps, 0.01, 0.0, nok, nbad, ck_d,
+                                            counting_kepler{&count},
+                                            x_out.begin(), x_out.end(),
+                                            std::back_inserter(y_out),
+                                            aphelion{}, 1.0e-12);
+    std::cout << "aphelion event at " << std::setprecision(15) << x_stop
+              << std::setprecision(6) << ", error " << std::abs(x_stop - M_PI)
+              << ", " << y_out.size() << " outputs, " << count << " derivs\n";
+  }
+
+  //  The driver with a reusable stepper.
+  auto y = initial_state<ArrayState>();
+  int nok, nbad;
+  cash_karp_stepper<ArrayState> ck;
+  ode_integrate(y, 0.0, 2 * M_PI, eps, 0.01, 0.0, nok, nbad, ck, kepler{});
+  const auto y0 = initial_state<ArrayState>();
+  std::cout << "\node_integrate one orbit: " << nok << " good, " << nbad << " bad steps"
+            << ", position err " << std::hypot(y[0] - y0[0], y[1] - y0[1]) << '\n';
 
   return 0;
 }
@@ -0,0 +1,133 @@
+// $HOME/bin/bin/g++ -std=c++14 -O3 -march=native -fno-math-errno -o test_ode_ensemble test_ode_ensemble.cpp -lpthread
+
+// ./test_ode_ensemble [count [num_threads]]
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <array>
+#include <vector>
+#include <cstdlib>
+#include <thread>
+
+#include "ode.tcc"
+#include "ode_ensemble.tcc"
+#include "../timer.h"
+
+//  Kepler problem with unit gravitational parameter: y = (x, y, vx, vy).
+struct kepler
+{
+  void
+  operator()(const std::array<double, 4> & y, double, std::array<double, 4> & dydx) const
+  {
+    const auto r2 = y[0] * y[0] + y[1] * y[1];
+    const auto r3 = r2 * std::sqrt(r2);
+    dydx[0] = y[2];
+    dydx[1] = y[3];
+    dydx[2] = -y[0] / r3;
+    dydx[3] = -y[1] / r3;
+  }
+
+  template<std::size_t L>
+    void
+    operator()(const double (&y)[4][L], const double (&)[L], double (&dydx)[4][L]) const
+    {
+      for (std::size_t l = 0; l < L; ++l)
+        {
+          const auto r2 = y[0][l] * y[0][l] + y[1][l] * y[1][l];
+          const auto r3 = r2 * std::sqrt(r2);
+          dydx[0][l] = y[2][l];
+          dydx[1][l] = y[3][l];
+          dydx[2][l] = -y[0][l] / r3;
+          dydx[3][l] = -y[1][l] / r3;
+        }
+    }
+};
+
+int
+main(int n_app_args, char ** app_args)
+{
+  std::size_t count = 100000;
+  if (n_app_args > 1)
+    count = std::atol(app_args[1]);
+  unsigned num_threads = std::thread::hardware_concurrency();
+  if (n_app_args > 2)
+    num_threads = std::atoi(app_args[2]);
+
+  //  Orbits starting at perihelion with eccentricities in [0, 0.8) integrated
+  //  over one period; the more eccentric orbits need many more steps.
+  std::mt19937 re;
+  std::uniform_real_distribution<double> ud(0.0, 0.8);
+  std::vector<double> y0(4 * count);
+  for (std::size_t s = 0; s < count; ++s)
+    {
+      const double e = ud(re);
+      y0[4 * s + 0] = 1.0 - e;
+      y0[4 * s + 1] = 0.0;
+      y0[4 * s + 2] = 0.0;
+      y0[4 * s + 3] = std::sqrt((1.0 + e) / (1.0 - e));
+    }
+
+  const double x2 = 2 * M_PI, eps = 1.0e-10, h1 = 0.01;
+
+  Timer timer;
+
+  //  One trajectory at a time through ode_integrate.
+  std::vector<double> y1 = y0;
+  cash_karp_stepper<std::array<double, 4>> ck;
+  long n_good = 0, n_bad = 0;
+  timer.start();
+  for (std::size_t s = 0; s < count; ++s)
+    {
+      std::array<double, 4> y;
+      std::copy(&y1[4 * s], &y1[4 * s] + 4, y.begin());
+      int nok, nbad;
+      ode_integrate(y, 0.0, x2, eps, h1, 0.0, nok, nbad, ck, kepler{});
+      std::copy(y.begin(), y.end(), &y1[4 * s]);
+      n_good += nok;
+      n_bad += nbad;
+    }
+  timer.stop();
+  long t_loop = timer.time_elapsed();
+
+  std::cout << count << " trajectories, " << n_good << " good and "
+            << n_bad << " bad steps\n";
+  std::cout << std::setw(24) << ""
+            << std::setw(10) << "ms"
+            << std::setw(14) << "max diff"
+            << std::setw(14) << "orbit err"
+            << std::setw(8) << "failed" << '\n';
+
+  auto report = [&](const char * name, long t, const std::vector<double> & y,
+                    std::size_t num_failed)
+  {
+    //  After one period each orbit should be back at its starting point.
+    double diff = 0.0, err = 0.0;
+    for (std::size_t i = 0; i < 4 * count; ++i)
+      {
+        diff = std::max(diff, std::abs(y[i] - y1[i]));
+        err = std::max(err, std::abs(y[i] - y0[i]));
+      }
+    std::cout << std::setw(24) << name
+              << std::setw(10) << t
+              << std::setw(14) << diff
+              << std::setw(14) << err
+              << std::setw(8) << num_failed << '\n';
+  };
+
+  report("per trajectory", t_loop, y1, 0);
+
+  std::vector<double> y2 = y0;
+  timer.start();
+  auto f2 = ode_integrate_ensemble<4>(count, y2.data(), 0.0, x2, eps, h1, 0.0, kepler{});
+  timer.stop();
+  report("ensemble", timer.time_elapsed(), y2, f2);
+
+  std::vector<double> y3 = y0;
+  timer.start();
+  auto f3 = ode_integrate_ensemble<4>(count, y3.data(), 0.0, x2, eps, h1, 0.0, kepler{},
+                                      num_threads);
+  timer.stop();
+  std::cout << num_threads << " threads:\n";
+  report("ensemble threaded", timer.time_elapsed(), y3, f3);
+}
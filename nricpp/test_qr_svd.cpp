@@ -0,0 +1,132 @@
+// $HOME/bin/bin/g++ -std=c++14 -O3 -march=native -o test_qr_svd test_qr_svd.cpp -lpthread
+
+// ./test_qr_svd [n_rows [n_cols [num_threads]]]
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <cstdlib>
+#include <thread>
+#include <stdexcept>
+
+#include "matrix_sv_decomp.tcc"
+#include "../timer.h"
+
+using Mat = std::vector<std::vector<double>>;
+
+//  Return max |u.w.vt - a|.
+double
+reconstruction_error(const Mat & a, const Mat & u,
+                     const std::vector<double> & w, const Mat & v)
+{
+  const std::size_t n_cols = w.size();
+  double err = 0.0;
+  for (std::size_t i = 0; i < a.size(); ++i)
+    for (std::size_t j = 0; j < n_cols; ++j)
+      {
+        double s = -a[i][j];
+        for (std::size_t k = 0; k < n_cols; ++k)
+          s += u[i][k] * w[k] * v[j][k];
+        err = std::max(err, std::abs(s));
+      }
+  return err;
+}
+
+//  Return max |ut.u - 1|.
+double
+orthogonality_error(const Mat & u)
+{
+  const std::size_t n_cols = u[0].size();
+  double err = 0.0;
+  for (std::size_t p = 0; p < n_cols; ++p)
+    for (std::size_t q = p; q < n_cols; ++q)
+      {
+        double s = (p == q ? -1.0 : 0.0);
+        for (std::size_t i = 0; i < u.size(); ++i)
+          s += u[i][p] * u[i][q];
+        err = std::max(err, std::abs(s));
+      }
+  return err;
+}
+
+int
+main(int n_app_args, char ** app_args)
+{
+  std::size_t n_rows = 100000;
+  if (n_app_args > 1)
+    n_rows = std::atol(app_args[1]);
+  std::size_t n_cols = 50;
+  if (n_app_args > 2)
+    n_cols = std::atol(app_args[2]);
+  unsigned num_threads = std::thread::hardware_concurrency();
+  if (n_app_args > 3)
+    num_threads = std::atoi(app_args[3]);
+
+  std::mt19937 re;
+  std::uniform_real_distribution<double> ud(-1.0, 1.0);
+
+  Mat a(n_rows, std::vector<double>(n_cols));
+  for (auto & row : a)
+    for (auto & x : row)
+      x = ud(re);
+
+  Timer timer;
+
+  //  QR: unblocked versus blocked; the results should agree to rounding.
+  Mat a1 = a, a2 = a;
+  std::vector<double> c1(n_cols), d1(n_cols), c2(n_cols), d2(n_cols);
+  bool sing1, sing2;
+
+  timer.start();
+  matrix::qr_decomp(n_rows, n_cols, a1, c1, d1, sing1);
+  timer.stop();
+  long t_qr = timer.time_elapsed();
+
+  timer.start();
+  matrix::qr_decomp_blocked(n_rows, n_cols, a2, c2, d2, sing2, num_threads);
+  timer.stop();
+  long t_qr_blocked = timer.time_elapsed();
+
+  double diff = 0.0;
+  for (std::size_t i = 0; i < n_rows; ++i)
+    for (std::size_t j = 0; j < n_cols; ++j)
+      diff = std::max(diff, std::abs(a1[i][j] - a2[i][j]));
+
+  std::cout << n_rows << " x " << n_cols << ", " << num_threads << " threads\n";
+  std::cout << std::setw(20) << "qr_decomp ms" << std::setw(10) << t_qr << '\n';
+  std::cout << std::setw(20) << "qr_decomp_blocked ms" << std::setw(10) << t_qr_blocked
+            << "    max diff " << diff << '\n';
+
+  //  A zero block size is rejected rather than looping forever.
+  bool rejected = false;
+  try
+    {
+      matrix::qr_decomp_blocked(n_rows, n_cols, a2, c2, d2, sing2, 1, 0);
+    }
+  catch (const std::logic_error &)
+    {
+      rejected = true;
+    }
+  std::cout << "zero block size rejected: " << (rejected ? "yes" : "no") << '\n';
+
+  //  SVD: one-sided Jacobi on the whole matrix versus QR then Jacobi on R.
+  for (int tall = 0; tall < 2; ++tall)
+    {
+      Mat u = a, v(n_cols, std::vector<double>(n_cols));
+      std::vector<double> w(n_cols);
+
+      timer.start();
+      if (tall)
+        matrix::sv_decomp_tall(n_rows, n_cols, u, w, v, num_threads);
+      else
+        matrix::sv_decomp_jacobi(n_rows, n_cols, u, w, v, num_threads);
+      timer.stop();
+
+      std::cout << std::setw(20) << (tall ? "sv_decomp_tall ms" : "sv_decomp_jacobi ms")
+                << std::setw(10) << timer.time_elapsed()
+                << "    recon " << reconstruction_error(a, u, w, v)
+                << "  orth " << orthogonality_error(u)
+                << "  orth v " << orthogonality_error(v) << '\n';
+    }
+}
@@ -0,0 +1,64 @@
+// $HOME/bin/bin/g++ -std=c++14 -O3 -march=native -o test_quad_callable test_quad_callable.cpp
+
+// ./test_quad_callable [n_stages]
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+
+#include "integration.tcc"
+#include "../timer.h"
+
+//  The integral of 4/(1 + x^2) over [0, 1] is pi.
+double
+lorentz(double x)
+{ return 4 / (1 + x * x); }
+
+int
+main(int n_app_args, char ** app_args)
+{
+  int n_stages = 24;
+  if (n_app_args > 1)
+    n_stages = std::atoi(app_args[1]);
+
+  std::cout << "trapezoid rule with " << n_stages << " stages, "
+            << (1L << (n_stages - 1)) + 1 << " points\n";
+  std::cout << std::setw(24) << ""
+            << std::setw(10) << "ms"
+            << std::setw(14) << "error" << '\n';
+
+  Timer timer;
+  auto run = [&](const char * name, auto func)
+  {
+    timer.start();
+    auto s = dumb_trapezoid(func, 0.0, 1.0, n_stages, n_stages);
+    timer.stop();
+    std::cout << std::setw(24) << name
+              << std::setw(10) << timer.time_elapsed()
+              << std::setw(14) << s - M_PI << '\n';
+  };
+
+  //  The legacy interface with a function pointer.
+  run("function pointer", lorentz);
+
+  //  A capturing lambda can now be passed and inlined.
+  const double c = 4.0;
+  run("lambda", [c](double x){ return c / (1 + x * x); });
+
+  //  A batch integrand evaluates blocks of points in one vectorizable loop.
+  run("batch lambda", [c](const double * x, double * f, std::size_t n)
+                      {
+                        for (std::size_t i = 0; i < n; ++i)
+                          f[i] = c / (1 + x[i] * x[i]);
+                      });
+
+  //  Open Romberg integration of an inverse square root singularity with a lambda.
+  std::cout << "\nquad_romberg_open, integral of 1/sqrt(x) over (0, 1]\n";
+  auto ans = quad_romberg_open([](double x){ return 1 / std::sqrt(x); }, 0.0, 1.0, 1.0e-10,
+                               midpoint_inv_sqrt_lower_map{});
+  std::cout << "  error " << ans - 2.0 << '\n';
+
+  //  The legacy routine selection by function pointer.
+  ans = quad_romberg_open(lorentz, 0.0, 1.0, 1.0e-10, midpoint);
+  std::cout << "  legacy midpoint error " << ans - M_PI << '\n';
+}
@@ -0,0 +1,121 @@
+// $HOME/bin/bin/g++ -std=c++14 -O3 -march=native -ffast-math -o test_roots_batch test_roots_batch.cpp
+
+// ./test_roots_batch [count]
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <cstdlib>
+
+#include "roots.tcc"
+#include "roots_batch.tcc"
+#include "../timer.h"
+
+int
+main(int n_app_args, char ** app_args)
+{
+  std::size_t count = 4000000;
+  if (n_app_args > 1)
+    count = std::atol(app_args[1]);
+
+  const double eps = 1.0e-12;
+  constexpr double pi = 3.1415926535897932384626433832795;
+
+  //  Kepler's equation E - e sin(E) = M for random eccentricities and mean anomalies.
+  std::mt19937_64 urng(42);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::vector<double> ecc(count), mean(count), lo(count), hi(count);
+  for (std::size_t i = 0; i < count; ++i)
+    {
+      ecc[i] = 0.99 * uniform(urng);
+      mean[i] = 2 * pi * uniform(urng);
+      lo[i] = 0.0;
+      hi[i] = 2 * pi;
+    }
+  auto kepler = [&ecc, &mean](std::size_t i, double E)
+  { return E - ecc[i] * std::sin(E) - mean[i]; };
+  auto kepler_d = [&ecc, &mean](std::size_t i, double E, double * f, double * df)
+  {
+    *f = E - ecc[i] * std::sin(E) - mean[i];
+    *df = 1 - ecc[i] * std::cos(E);
+  };
+
+  std::vector<double> E_ref(count), E(count);
+  Timer timer;
+  std::cout << "Kepler's equation, " << count << " problems\n";
+
+  timer.start();
+  for (std::size_t i = 0; i < count; ++i)
+    E_ref[i] = root_brent([&kepler, i](double x){ return kepler(i, x); }, lo[i], hi[i], eps);
+  timer.stop();
+  std::cout << "  root_brent loop     " << std::setw(8) << timer.time_elapsed() << " ms\n";
+
+  auto report = [&](const char * name, std::size_t failed)
+  {
+    timer.stop();
+    double diff = 0.0, resid = 0.0;
+    for (std::size_t i = 0; i < count; ++i)
+      {
+        diff = std::max(diff, std::abs(E[i] - E_ref[i]));
+        resid = std::max(resid, std::abs(kepler(i, E[i])));
+      }
+    std::cout << "  " << std::left << std::setw(20) << name << std::right
+              << std::setw(8) << timer.time_elapsed() << " ms"
+              << "  failed " << failed
+              << "  max diff " << std::setw(12) << diff
+              << "  max residual " << resid << '\n';
+  };
+
+  timer.start();
+  report("root_brent_batch", root_brent_batch(kepler, count, lo.data(), hi.data(), E.data(), eps));
+
+  timer.start();
+  report("root_safe_batch", root_safe_batch(kepler_d, count, lo.data(), hi.data(), E.data(), eps));
+
+  //  Inversion of the standard normal distribution function at random probabilities.
+  std::vector<double> u(count), z(count), z_ref(count);
+  for (std::size_t i = 0; i < count; ++i)
+    {
+      u[i] = uniform(urng);
+      lo[i] = -40.0;
+      hi[i] = 40.0;
+    }
+  auto cdf = [&u](std::size_t i, double x)
+  { return 0.5 * std::erfc(-x / std::sqrt(2.0)) - u[i]; };
+  auto cdf_d = [&u](std::size_t i, double x, double * f, double * df)
+  {
+    *f = 0.5 * std::erfc(-x / std::sqrt(2.0)) - u[i];
+    *df = std::exp(-0.5 * x * x) / std::sqrt(2 * pi);
+  };
+
+  std::cout << "\nnormal quantile, " << count << " problems\n";
+  timer.start();
+  for (std::size_t i = 0; i < count; ++i)
+    z_ref[i] = root_brent([&cdf, i](double x){ return cdf(i, x); }, lo[i], hi[i], eps);
+  timer.stop();
+  std::cout << "  root_brent loop     " << std::setw(8) << timer.time_elapsed() << " ms\n";
+
+  timer.start();
+  auto failed = root_brent_batch(cdf, count, lo.data(), hi.data(), z.data(), eps);
+  timer.stop();
+  double diff = 0.0;
+  for (std::size_t i = 0; i < count; ++i)
+    diff = std::max(diff, std::abs(z[i] - z_ref[i]));
+  std::cout << "  root_brent_batch    " << std::setw(8) << timer.time_elapsed() << " ms"
+            << "  failed " << failed << "  max diff " << diff << '\n';
+
+  timer.start();
+  failed = root_safe_batch(cdf_d, count, lo.data(), hi.data(), z.data(), eps);
+  timer.stop();
+  diff = 0.0;
+  for (std::size_t i = 0; i < count; ++i)
+    diff = std::max(diff, std::abs(z[i] - z_ref[i]));
+  std::cout << "  root_safe_batch     " << std::setw(8) << timer.time_elapsed() << " ms"
+            << "  failed " << failed << "  max diff " << diff << '\n';
+
+  //  Unbracketed problems come back as NaN.
+  std::vector<double> bad_lo{1.0, 0.0}, bad_hi{2.0, 2 * pi}, bad_root(2);
+  auto n_bad = root_brent_batch(kepler, 2, bad_lo.data(), bad_hi.data(), bad_root.data(), eps);
+  std::cout << "\nunbracketed: " << n_bad << " failed, roots " << bad_root[0] << ' ' << bad_root[1] << '\n';
+}
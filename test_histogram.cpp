@@ -0,0 +1,81 @@
+// $HOME/bin/bin/g++ -std=c++14 -O3 -o test_histogram test_histogram.cpp -lpthread
+
+#include <iostream>
+#include <random>
+#include <vector>
+#include <cassert>
+
+#include "histogram.h"
+#include "timer.h"
+
+int
+main()
+{
+  std::mt19937 re;
+  std::normal_distribution<double> nd(5.0, 2.0);
+
+  std::vector<double> data(10000000);
+  for (auto& x : data)
+    x = nd(re);
+  // Make sure the bin boundaries and the tails are hit exactly.
+  for (int i = 0; i <= 100; ++i)
+    data[i] = 0.1 * i;
+
+  histogram<double> uni(100, 0.0, 10.0);
+  std::vector<double> lims;
+  for (std::size_t i = 1; i <= uni.size() + 1; ++i)
+    lims.push_back(i <= uni.size() ? uni.value(i) : 10.0);
+  histogram<double> srch(lims.begin(), lims.end());
+  histogram<double> par(100, 0.0, 10.0);
+
+  assert(uni.uniform() && !srch.uniform());
+
+  Timer timer;
+
+  timer.start();
+  for (auto x : data)
+    srch << x;
+  timer.stop();
+  std::cout << "search:   " << timer.time_elapsed() << " ms\n";
+
+  timer.start();
+  uni.insert(data.begin(), data.end());
+  timer.stop();
+  std::cout << "uniform:  " << timer.time_elapsed() << " ms\n";
+
+  timer.start();
+  par.parallel_insert(data.begin(), data.end());
+  timer.stop();
+  std::cout << "parallel: " << timer.time_elapsed() << " ms\n";
+
+  assert(uni.count() == data.size());
+  for (std::size_t i = 0; i <= uni.size() + 1; ++i)
+    {
+      assert(uni[i] == srch[i]);
+      assert(uni[i] == par[i]);
+    }
+
+  histogram<double> merged(100, 0.0, 10.0);
+  merged += uni;
+  merged += par;
+  assert(merged.count() == 2 * data.size());
+
+  //  Integral values: the bin width is not truncated, and the bins
+  //  agree with a search over the same limits.
+  histogram<int> iuni(30, 0, 100);
+  std::vector<int> ilims;
+  for (std::size_t i = 1; i <= iuni.size() + 1; ++i)
+    ilims.push_back(i <= iuni.size() ? iuni.value(i) : 100);
+  histogram<int> isrch(ilims.begin(), ilims.end());
+  for (int x = -20; x <= 120; ++x)
+    {
+      iuni << x;
+      isrch << x;
+    }
+  for (std::size_t i = 0; i <= iuni.size() + 1; ++i)
+    assert(iuni[i] == isrch[i]);
+  assert(int(iuni[iuni.size()]) == 100 - iuni.value(iuni.size()));
+
+  std::cout << "Mean:  " << uni.mean() << '\n';
+  std::cout << "Sigma: " << uni.sigma() << '\n';
+}
@@ -0,0 +1,223 @@
+// $HOME/bin/bin/g++ -std=c++14 -O3 -march=native -pthread -o test_random_engines test_random_engines.cpp
+
+// ./test_random_engines
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <thread>
+#include <set>
+#include <cstdint>
+
+#include "random"
+#include "timer.h"
+
+using std::experimental::xoshiro256starstar;
+using std::experimental::pcg64;
+using std::experimental::randint;
+using std::experimental::reseed;
+
+bool
+check(const char* what, bool ok)
+{
+  std::cout << std::left << std::setw(48) << what << (ok ? "ok" : "FAIL") << '\n';
+  return ok;
+}
+
+//  Chi-square of the counts of randint(0, k - 1) against uniform,
+//  as a z-score (chi^2 - dof) / sqrt(2 dof).
+template<typename _Int>
+  double
+  chi2_z(_Int k, std::size_t n)
+  {
+    std::vector<std::size_t> count(k);
+    for (std::size_t i = 0; i < n; ++i)
+      ++count[randint(_Int(0), _Int(k - 1))];
+    const double e = double(n) / k;
+    double chi2 = 0.0;
+    for (auto c : count)
+      chi2 += (c - e) * (c - e) / e;
+    return (chi2 - (k - 1)) / std::sqrt(2.0 * (k - 1));
+  }
+
+int
+main()
+{
+  bool ok = true;
+
+  //  Reference outputs of the authors' code from the state {1, 2, 3, 4}.
+  {
+    xoshiro256starstar x;
+    std::istringstream("1 2 3 4") >> x;
+    auto y = x, z = x;
+    ok &= check("xoshiro256** outputs",
+		x() == 0x2d00 && x() == 0x0 && x() == 0x5a007080);
+    y.jump();
+    ok &= check("xoshiro256** jump", y() == 0xbbd2f312298443d8ULL);
+    z.long_jump();
+    ok &= check("xoshiro256** long_jump", z() == 0x527752a1d792704dULL);
+
+    std::stringstream str;
+    str << x;
+    xoshiro256starstar w(1234);
+    str >> w;
+    ok &= check("xoshiro256** state round trip", w == x && w() == x());
+  }
+
+  //  Reference outputs of pcg64_random_t seeded with (42, 54).
+  {
+    pcg64 p(42, 54);
+    ok &= check("pcg64 outputs",
+		p() == 0x86b1da1d72062b68ULL && p() == 0x1304aa46c9853d39ULL
+		&& p() == 0xa3670e9e0dd50358ULL && p() == 0xf9090e529a7dae00ULL);
+
+    pcg64 q(7, 11), r = q;
+    for (int i = 0; i < 12345; ++i)
+      q();
+    r.advance(12345);
+    ok &= check("pcg64 advance(n) == n steps", q == r && q() == r());
+
+    std::stringstream str;
+    str << q;
+    pcg64 s;
+    str >> s;
+    ok &= check("pcg64 state round trip", s == q && s() == q());
+
+    pcg64 t = q;
+    t.jump();
+    t.jump();
+    t.jump();
+    t.jump();
+    q.advance(__uint128_t(1) << 66);
+    ok &= check("pcg64 four jumps == advance(2^66)", t == q);
+  }
+
+  //  Uniformity of randint over small, odd and full ranges.
+  {
+    reseed(42);
+    std::cout << std::fixed << std::setprecision(2);
+    const double z6 = chi2_z<int>(6, 6000000);
+    const double z1000 = chi2_z<long>(1000, 10000000);
+    const double z256 = chi2_z<unsigned>(256, 10000000);
+    std::cout << "randint chi-square z: k = 6 " << z6
+	      << ", k = 1000 " << z1000 << ", k = 256 " << z256 << '\n';
+    ok &= check("randint uniform", std::abs(z6) < 5 && std::abs(z1000) < 5
+				   && std::abs(z256) < 5);
+
+    //  The full range: the top and bottom bits must both be fair.
+    std::size_t neg = 0, odd = 0;
+    const std::size_t n = 1000000;
+    for (std::size_t i = 0; i < n; ++i)
+      {
+	auto v = randint(std::numeric_limits<std::int64_t>::min(),
+			 std::numeric_limits<std::int64_t>::max());
+	neg += v < 0;
+	odd += v & 1;
+      }
+    ok &= check("randint full int64 range",
+		std::abs(double(neg) - n / 2) < 5 * std::sqrt(n / 4.0)
+		&& std::abs(double(odd) - n / 2) < 5 * std::sqrt(n / 4.0));
+
+    std::vector<std::uint8_t> b(1000000);
+    randint(b.begin(), b.end(), std::uint8_t(250), std::uint8_t(255));
+    bool inrange = true;
+    for (auto v : b)
+      inrange = inrange && v >= 250;
+    ok &= check("bulk randint in range", inrange);
+
+    //  Types narrower than int, across zero.
+    bool narrow = true;
+    for (std::size_t i = 0; i < 100000; ++i)
+      {
+	const short s = randint(short(-5), short(5));
+	const signed char c = randint((signed char)(-3), (signed char)(3));
+	narrow = narrow && s >= -5 && s <= 5 && c >= -3 && c <= 3;
+      }
+    std::vector<short> vs(100000);
+    randint(vs.begin(), vs.end(), short(-5), short(5));
+    for (auto v : vs)
+      narrow = narrow && v >= -5 && v <= 5;
+    std::vector<signed char> vc(100000);
+    randint(vc.begin(), vc.end(), (signed char)(-3), (signed char)(3));
+    for (auto v : vc)
+      narrow = narrow && v >= -3 && v <= 3;
+    ok &= check("randint short and signed char in range", narrow);
+
+    reseed(99);
+    auto a1 = randint(0, 1000000), a2 = randint(0, 1000000);
+    reseed(99);
+    ok &= check("reseed repeats", randint(0, 1000000) == a1
+				  && randint(0, 1000000) == a2);
+  }
+
+  //  Each thread draws from its own substream.
+  {
+    const int nthreads = 8;
+    std::vector<std::uint64_t> first(nthreads);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nthreads; ++i)
+      threads.emplace_back([&first, i]
+	{ first[i] = randint(std::uint64_t(0), ~std::uint64_t(0)); });
+    for (auto& t : threads)
+      t.join();
+    ok &= check("distinct thread streams",
+		std::set<std::uint64_t>(first.begin(), first.end()).size() == nthreads);
+  }
+
+  //  Throughput against uniform_int_distribution over the default engine.
+  {
+    const std::size_t n = 100000000;
+    std::vector<int> v(1 << 16);
+    Timer timer;
+    long sum = 0;
+
+    std::default_random_engine dre;
+    std::uniform_int_distribution<int> uid(0, 999);
+    timer.start();
+    for (std::size_t i = 0; i < n; ++i)
+      sum += uid(dre);
+    timer.stop();
+    std::cout << "uniform_int_distribution, default_random_engine: "
+	      << timer.time_elapsed() << " ms\n";
+
+    std::mt19937_64 mt;
+    std::uniform_int_distribution<int> uid64(0, 999);
+    timer.start();
+    for (std::size_t i = 0; i < n; ++i)
+      sum += uid64(mt);
+    timer.stop();
+    std::cout << "uniform_int_distribution, mt19937_64:            "
+	      << timer.time_elapsed() << " ms\n";
+
+    timer.start();
+    for (std::size_t i = 0; i < n; ++i)
+      sum += randint(0, 999);
+    timer.stop();
+    std::cout << "randint:                                         "
+	      << timer.time_elapsed() << " ms\n";
+
+    timer.start();
+    for (std::size_t i = 0; i < n; i += v.size())
+      {
+	randint(v.begin(), v.end(), 0, 999);
+	sum += v[0];
+      }
+    timer.stop();
+    std::cout << "bulk randint:                                    "
+	      << timer.time_elapsed() << " ms\n";
+
+    pcg64 p;
+    std::uniform_int_distribution<int> uidp(0, 999);
+    timer.start();
+    for (std::size_t i = 0; i < n; ++i)
+      sum += uidp(p);
+    timer.stop();
+    std::cout << "uniform_int_distribution, pcg64:                 "
+	      << timer.time_elapsed() << " ms\n";
+    std::cout << "(checksum " << sum << ")\n";
+  }
+
+  return ok ? 0 : 1;
+}
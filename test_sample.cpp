@@ -0,0 +1,233 @@
+// $HOME/bin/bin/g++ -std=c++14 -O3 -march=native -pthread -o test_sample test_sample.cpp
+
+// ./test_sample
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <iterator>
+#include <cmath>
+#include <cstdint>
+
+#include "random"
+#include "timer.h"
+
+using std::experimental::sample;
+using std::experimental::parallel_sample;
+using std::experimental::weighted_sample;
+
+//  A stream of the integers [0, n): an input iterator that cannot skip.
+class counting_input_iterator
+{
+public:
+  using iterator_category = std::input_iterator_tag;
+  using value_type = std::uint64_t;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const std::uint64_t*;
+  using reference = std::uint64_t;
+
+  explicit
+  counting_input_iterator(std::uint64_t i = 0)
+  : m_i(i)
+  { }
+
+  std::uint64_t
+  operator*() const
+  { return m_i; }
+
+  counting_input_iterator&
+  operator++()
+  {
+    ++m_i;
+    return *this;
+  }
+
+  counting_input_iterator
+  operator++(int)
+  { return counting_input_iterator(m_i++); }
+
+  bool
+  operator==(const counting_input_iterator& other) const
+  { return m_i == other.m_i; }
+
+  bool
+  operator!=(const counting_input_iterator& other) const
+  { return m_i != other.m_i; }
+
+private:
+  std::uint64_t m_i;
+};
+
+//  The reservoir sampling that sample() did before: a draw per element.
+template<typename _PopIter, typename _SampleIter, typename _Size,
+	 typename _URNG>
+  _SampleIter
+  reservoir_r(_PopIter first, _PopIter last, _SampleIter out, _Size n,
+	      _URNG&& urng)
+  {
+    std::uniform_int_distribution<_Size> dist{};
+    _Size sample_sz{};
+    while (first != last && sample_sz != n)
+      out[sample_sz++] = *first++;
+    for (_Size pop_sz{sample_sz}; first != last; ++first, ++pop_sz)
+      {
+	_Size k{dist(urng, typename decltype(dist)::param_type{0, pop_sz})};
+	if (k < n)
+	  out[k] = *first;
+      }
+    return out + sample_sz;
+  }
+
+//  The chi-square z-score of how often each of [0, npop) is chosen,
+//  against the expected counts.
+double
+chi2_z(const std::vector<std::size_t>& count, const std::vector<double>& expect)
+{
+  double chi2 = 0.0;
+  for (std::size_t i = 0; i < count.size(); ++i)
+    chi2 += (count[i] - expect[i]) * (count[i] - expect[i]) / expect[i];
+  const double dof = count.size() - 1;
+  return (chi2 - dof) / std::sqrt(2 * dof);
+}
+
+int
+main()
+{
+  bool ok = true;
+  std::cout << std::fixed << std::setprecision(2);
+
+  //  Every element is included with probability k/N.
+  {
+    const std::size_t npop = 50, k = 7, reps = 400000;
+    std::vector<std::size_t> c_input(npop), c_ra(npop), c_par(npop);
+    std::vector<std::uint64_t> pop(npop), out(k);
+    for (std::size_t i = 0; i < npop; ++i)
+      pop[i] = i;
+    std::mt19937_64 urng;
+    for (std::size_t r = 0; r < reps; ++r)
+      {
+	auto e = sample(counting_input_iterator(0), counting_input_iterator(npop),
+			out.begin(), k, urng);
+	for (auto i = out.begin(); i != e; ++i)
+	  ++c_input[*i];
+	e = sample(pop.begin(), pop.end(), out.begin(), k, urng);
+	for (auto i = out.begin(); i != e; ++i)
+	  ++c_ra[*i];
+	e = parallel_sample(pop.begin(), pop.end(), out.begin(), k, urng, 3);
+	for (auto i = out.begin(); i != e; ++i)
+	  ++c_par[*i];
+      }
+    std::vector<double> expect(npop, double(reps) * k / npop);
+    const double z_input = chi2_z(c_input, expect);
+    const double z_ra = chi2_z(c_ra, expect);
+    const double z_par = chi2_z(c_par, expect);
+    std::cout << "inclusion chi-square z: input " << z_input
+	      << ", random access " << z_ra << ", parallel " << z_par << '\n';
+    ok &= std::abs(z_input) < 5 && std::abs(z_ra) < 5 && std::abs(z_par) < 5;
+
+    //  Short populations are taken whole.
+    auto e = sample(pop.begin(), pop.begin() + 4, out.begin(), k, urng);
+    auto p = parallel_sample(pop.begin(), pop.begin() + 4, out.begin(), k, urng, 8);
+    ok &= e - out.begin() == 4 && p - out.begin() == 4;
+  }
+
+  //  The parallel sample is fixed by the seed and the thread count.
+  {
+    std::vector<std::uint64_t> pop(1000000), a(100), b(100);
+    for (std::size_t i = 0; i < pop.size(); ++i)
+      pop[i] = i;
+    parallel_sample(pop.begin(), pop.end(), a.begin(), 100, std::mt19937_64(5), 4);
+    parallel_sample(pop.begin(), pop.end(), b.begin(), 100, std::mt19937_64(5), 4);
+    std::cout << "parallel_sample repeatable: " << (a == b ? "ok" : "FAIL") << '\n';
+    ok &= a == b;
+  }
+
+  //  With one element drawn, the probabilities are the normalized weights;
+  //  with two, the first is chosen so and the second among the rest.
+  {
+    const std::size_t npop = 10, reps = 1000000;
+    std::vector<double> w(npop);
+    double wsum = 0.0;
+    for (std::size_t i = 0; i < npop; ++i)
+      wsum += w[i] = i % 3 == 0 ? 0.25 : double(i + 1);
+    std::vector<std::size_t> c1(npop), c2(npop);
+    std::vector<std::uint64_t> out(2);
+    auto weight = [&w](std::uint64_t i) { return w[i]; };
+    std::mt19937_64 urng;
+    for (std::size_t r = 0; r < reps; ++r)
+      {
+	weighted_sample(counting_input_iterator(0), counting_input_iterator(npop),
+			out.begin(), 2, weight, urng);
+	++c1[out[0]];
+	++c2[out[1]];
+      }
+    std::vector<double> e1(npop), e2(npop);
+    for (std::size_t i = 0; i < npop; ++i)
+      {
+	e1[i] = reps * w[i] / wsum;
+	for (std::size_t j = 0; j < npop; ++j)
+	  if (j != i)
+	    e2[i] += reps * w[j] / wsum * w[i] / (wsum - w[j]);
+      }
+    const double z1 = chi2_z(c1, e1), z2 = chi2_z(c2, e2);
+    std::cout << "weighted_sample chi-square z: first " << z1
+	      << ", second " << z2 << '\n';
+    ok &= std::abs(z1) < 5 && std::abs(z2) < 5;
+  }
+
+  //  Throughput on a stream of 10^9 elements and on an array of 10^8.
+  {
+    const std::uint64_t nstream = 1000000000;
+    const std::size_t k = 1000;
+    std::vector<std::uint64_t> out(k);
+    std::mt19937_64 urng;
+    Timer timer;
+
+    timer.start();
+    reservoir_r(counting_input_iterator(0), counting_input_iterator(nstream),
+		out.begin(), k, urng);
+    timer.stop();
+    std::cout << "stream of 1e9, k = 1000\n"
+	      << "  draw per element:  " << std::setw(8) << timer.time_elapsed() << " ms\n";
+
+    timer.start();
+    sample(counting_input_iterator(0), counting_input_iterator(nstream),
+	   out.begin(), k, urng);
+    timer.stop();
+    std::cout << "  sample:            " << std::setw(8) << timer.time_elapsed() << " ms\n";
+
+    timer.start();
+    weighted_sample(counting_input_iterator(0), counting_input_iterator(nstream),
+		    out.begin(), k, [](std::uint64_t i) { return 1.0 + (i & 7); }, urng);
+    timer.stop();
+    std::cout << "  weighted_sample:   " << std::setw(8) << timer.time_elapsed() << " ms\n";
+
+    std::vector<std::uint64_t> pop(100000000);
+    for (std::size_t i = 0; i < pop.size(); ++i)
+      pop[i] = i;
+
+    timer.start();
+    reservoir_r(pop.begin(), pop.end(), out.begin(), k, urng);
+    timer.stop();
+    std::cout << "array of 1e8, k = 1000\n"
+	      << "  draw per element:  " << std::setw(8) << timer.time_elapsed() << " ms\n";
+
+    timer.start();
+    sample(pop.begin(), pop.end(), out.begin(), k, urng);
+    timer.stop();
+    std::cout << "  sample:            " << std::setw(8) << timer.time_elapsed() << " ms\n";
+
+    for (unsigned nthreads : {1u, 4u})
+      {
+	timer.start();
+	parallel_sample(pop.begin(), pop.end(), out.begin(), k, urng, nthreads);
+	timer.stop();
+	std::cout << "  parallel_sample " << nthreads << ": "
+		  << std::setw(8) << timer.time_elapsed() << " ms\n";
+      }
+  }
+
+  std::cout << (ok ? "ok" : "FAIL") << '\n';
+  return ok ? 0 : 1;
+}
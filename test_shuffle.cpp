@@ -0,0 +1,128 @@
+// $HOME/bin/bin/g++ -std=c++14 -O3 -march=native -pthread -o test_shuffle test_shuffle.cpp
+
+// ./test_shuffle [length]
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+#include "random"
+#include "timer.h"
+
+using std::experimental::parallel_shuffle;
+
+//  The chi-square z-score of counts against equal expectations.
+double
+chi2_z(const std::vector<std::size_t>& count)
+{
+  double total = 0.0;
+  for (auto c : count)
+    total += c;
+  const double e = total / count.size();
+  double chi2 = 0.0;
+  for (auto c : count)
+    chi2 += (c - e) * (c - e) / e;
+  const double dof = count.size() - 1;
+  return (chi2 - dof) / std::sqrt(2 * dof);
+}
+
+int
+main(int n_app_args, char ** app_args)
+{
+  std::size_t length = 50000000;
+  if (n_app_args > 1)
+    length = std::atol(app_args[1]);
+
+  bool ok = true;
+  std::cout << std::fixed << std::setprecision(2);
+
+  //  Over many seeds, the final places of a few elements are uniform,
+  //  pairs of neighbours are in either order equally often, and there is
+  //  one fixed point on average.  The array is long enough to be bucketed.
+  {
+    const std::size_t n = 1 << 18, reps = 400, bins = 64;
+    const std::size_t tracked[] = {0, 1, n / 2, n - 1};
+    std::vector<std::size_t> place(bins);
+    std::size_t ascents = 0, fixed = 0;
+    std::vector<std::uint32_t> a(n);
+    bool perm = true;
+    for (std::size_t r = 0; r < reps; ++r)
+      {
+	std::iota(a.begin(), a.end(), 0);
+	parallel_shuffle(a.begin(), a.end(), std::mt19937_64(r), 1 + r % 4);
+	for (std::size_t i = 0; i < n; ++i)
+	  {
+	    for (auto t : tracked)
+	      if (a[i] == t)
+		++place[i * bins / n];
+	    fixed += a[i] == i;
+	    if (i + 1 < n)
+	      ascents += a[i] < a[i + 1];
+	  }
+	if (r == 0)
+	  {
+	    auto b = a;
+	    std::sort(b.begin(), b.end());
+	    for (std::size_t i = 0; i < n; ++i)
+	      perm = perm && b[i] == i;
+	  }
+      }
+    const double z = chi2_z(place);
+    //  Ascents of a uniform permutation: mean (n - 1) / 2, variance (n + 1) / 12.
+    const double za = (ascents / double(reps) - (n - 1) / 2.0)
+		    / std::sqrt((n + 1) / 12.0 / reps);
+    const double zf = (fixed - double(reps)) / std::sqrt(double(reps));
+    std::cout << "permutation: " << (perm ? "ok" : "FAIL")
+	      << "; z of tracked places " << z << ", ascents " << za
+	      << ", fixed points " << zf << '\n';
+    ok &= perm && std::abs(z) < 5 && std::abs(za) < 5 && std::abs(zf) < 5;
+  }
+
+  //  Fixed by the seed and the thread count.
+  {
+    std::vector<std::uint32_t> a(1 << 20), b(1 << 20);
+    std::iota(a.begin(), a.end(), 0);
+    std::iota(b.begin(), b.end(), 0);
+    parallel_shuffle(a.begin(), a.end(), std::mt19937_64(7), 3);
+    parallel_shuffle(b.begin(), b.end(), std::mt19937_64(7), 3);
+    std::cout << "repeatable: " << (a == b ? "ok" : "FAIL") << '\n';
+    ok &= a == b;
+  }
+
+  //  Throughput.
+  {
+    std::vector<std::uint32_t> a(length);
+    std::iota(a.begin(), a.end(), 0);
+    Timer timer;
+    std::cout << "shuffle " << length << " uint32_t\n";
+
+    std::mt19937_64 mt;
+    timer.start();
+    std::shuffle(a.begin(), a.end(), mt);
+    timer.stop();
+    std::cout << "  std::shuffle, mt19937_64:  " << std::setw(8) << timer.time_elapsed() << " ms\n";
+
+    timer.start();
+    std::experimental::shuffle(a.begin(), a.end());
+    timer.stop();
+    std::cout << "  shuffle, per-thread engine:" << std::setw(8) << timer.time_elapsed() << " ms\n";
+
+    for (unsigned nthreads : {1u, 2u, 4u, 8u})
+      {
+	timer.start();
+	parallel_shuffle(a.begin(), a.end(), mt, nthreads);
+	timer.stop();
+	std::cout << "  parallel_shuffle, " << nthreads << " threads:"
+		  << std::setw(8) << timer.time_elapsed() << " ms\n";
+      }
+  }
+
+  std::cout << (ok ? "ok" : "FAIL") << '\n';
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+// $HOME/bin/bin/g++ -std=c++14 -O3 -march=native -ffast-math -o test_von_mises_fisher_distribution test_von_mises_fisher_distribution.cpp
+
+// ./test_von_mises_fisher_distribution [count]
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+
+#include "von_mises_fisher_distribution.h"
+#include "timer.h"
+
+//  The mean resultant length E[x.mu] = I_{D/2}(kappa) / I_{D/2-1}(kappa).
+double
+mean_resultant(std::size_t dim, double kappa)
+{
+  if (kappa == 0)
+    return 0;
+  else if (dim == 3)
+    return 1 / std::tanh(kappa) - 1 / kappa;
+  else if (dim == 5)
+    return ((3 / (kappa * kappa) + 1) * std::sinh(kappa) - 3 * std::cosh(kappa) / kappa)
+	 / (std::cosh(kappa) - std::sinh(kappa) / kappa);
+  else
+    {
+      //  Power series of I_1 and I_0.
+      double i0 = 0.0, i1 = 0.0, term = 1.0;
+      const double q = kappa * kappa / 4;
+      for (int k = 0; k < 100; ++k)
+	{
+	  i0 += term;
+	  i1 += term * (kappa / 2) / (k + 1);
+	  term *= q / ((k + 1) * (k + 1));
+	}
+      return i1 / i0;
+    }
+}
+
+//  Deviations of the sample mean from A mu in units of its standard error,
+//  the largest departure from unit length and the time taken.
+template<std::size_t Dim>
+  void
+  report(const char * name, const std::vector<std::vector<double>>& x,
+	 const std::array<double, Dim>& mu, double kappa, double ms)
+  {
+    const std::size_t n = x[0].size();
+    const double A = mean_resultant(Dim, kappa);
+    double zmax = 0.0, len_err = 0.0;
+    for (std::size_t j = 0; j < Dim; ++j)
+      {
+	double sum = 0.0, sum2 = 0.0;
+	for (std::size_t i = 0; i < n; ++i)
+	  {
+	    sum += x[j][i];
+	    sum2 += x[j][i] * x[j][i];
+	  }
+	const double m = sum / n;
+	const double var = sum2 / n - m * m;
+	zmax = std::max(zmax, std::abs(m - A * mu[j]) / std::sqrt(var / n));
+      }
+    for (std::size_t i = 0; i < n; ++i)
+      {
+	double len2 = 0.0;
+	for (std::size_t j = 0; j < Dim; ++j)
+	  len2 += x[j][i] * x[j][i];
+	len_err = std::max(len_err, std::abs(std::sqrt(len2) - 1));
+      }
+    std::cout << "  " << std::left << std::setw(16) << name << std::right
+	      << std::setw(10) << ms << " ms"
+	      << "  max |z| " << std::setw(10) << zmax
+	      << "  max ||x| - 1| " << len_err << '\n';
+  }
+
+template<std::size_t Dim>
+  void
+  run(std::size_t count, const std::array<double, Dim>& mu, double kappa)
+  {
+    std::mt19937_64 urng(42);
+    __gnu_cxx::von_mises_fisher_distribution<Dim> vmf(mu, kappa);
+    std::vector<std::vector<double>> x(Dim, std::vector<double>(count));
+    std::array<double*, Dim> px;
+    for (std::size_t j = 0; j < Dim; ++j)
+      px[j] = x[j].data();
+
+    std::cout << "D = " << Dim << ", kappa = " << kappa << ", mu =";
+    for (auto m : mu)
+      std::cout << ' ' << m;
+    std::cout << '\n';
+
+    Timer timer;
+    timer.start();
+    for (std::size_t i = 0; i < count; ++i)
+      {
+	auto r = vmf(urng);
+	for (std::size_t j = 0; j < Dim; ++j)
+	  x[j][i] = r[j];
+      }
+    timer.stop();
+    report("operator()", x, mu, kappa, timer.time_elapsed());
+
+    std::vector<std::array<double, Dim>> y(count);
+    timer.start();
+    vmf.__generate(y.begin(), y.end(), urng);
+    timer.stop();
+    for (std::size_t i = 0; i < count; ++i)
+      for (std::size_t j = 0; j < Dim; ++j)
+	x[j][i] = y[i][j];
+    report("__generate AoS", x, mu, kappa, timer.time_elapsed());
+
+    timer.start();
+    vmf.__generate(px, count, urng);
+    timer.stop();
+    report("__generate SoA", x, mu, kappa, timer.time_elapsed());
+  }
+
+int
+main(int n_app_args, char ** app_args)
+{
+  std::size_t count = 10000000;
+  if (n_app_args > 1)
+    count = std::atol(app_args[1]);
+
+  const double s = 1 / std::sqrt(3.0);
+  run<3>(count, {0.0, 0.0, 1.0}, 10.0);
+  run<3>(count, {s, -s, s}, 0.5);
+  run<3>(count, {1.0, 0.0, 0.0}, 0.0);
+  run<5>(count, {1.0, 0.0, 0.0, 0.0, 0.0}, 4.0);
+  run<5>(count, {0.5, 0.5, -0.5, 0.5, 0.0}, 20.0);
+  run<2>(count / 10, {0.6, 0.8}, 3.0);
+}
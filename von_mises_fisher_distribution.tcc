@@ -39,18 +39,21 @@ _GLIBCXX_BEGIN_NAMESPACE_VERSION
 	for (size_t __i = 1; __i < _Dim; ++__i)
 	  if (std::abs(__mu[__i]) > std::abs(__mu[__max]))
 	    __max = __i;
-	//  The orthogonal lambdas are built with 1 in all te slots other than
-	//  the pivot and are orthonormalized wrt pu and teh previous lambdas.
+	//  The orthogonal lambdas start as the unit vectors of the slots other
+	//  than the pivot and are orthonormalized wrt mu and the previous lambdas.
+	//  Skipping the pivot keeps them independent of mu.
 	for (size_t __i = 0; __i < _Dim - 1; ++__i)
 	  {
-	    __lambda[__i][(__max + __i) % _Dim] = _RealType(1);
-	    auto __mudot = __mu[(__max + __i) % _Dim];
+	    const size_t __slot = (__max + 1 + __i) % _Dim;
+	    __lambda[__i].fill(_RealType(0));
+	    __lambda[__i][__slot] = _RealType(1);
+	    auto __mudot = __mu[__slot];
 	    if (__mudot != _RealType(0))
 	      for (size_t __j = 0; __j < _Dim; ++__j)
 		__lambda[__i][__j] -= __mudot * __mu[__j];
 		for (size_t __k = 0; __k < __i; ++__k)
 		  {
-		    auto __lambdot = __lambda[__k][(__max + __i) % _Dim];
+		    auto __lambdot = __lambda[__k][__slot];
 		    if (__lambdot != _RealType(0))
 		      for (size_t __j = 0; __j < _Dim; ++__j)
 			__lambda[__i][__j] -= __lambdot * __lambda[__k][__j];
@@ -58,6 +61,36 @@ _GLIBCXX_BEGIN_NAMESPACE_VERSION
 	    __make_normal(__lambda[__i]);
 	  }
       }
+
+    /**
+     * @brief Write the directions from a structure-of-arrays generator
+     *        to [__f, __t) a block at a time.
+     */
+    template<std::size_t _Dim, typename _RealType,
+	     typename _OutputIterator, typename _SoaGenerator>
+      void
+      __generate_vmf_aos(_OutputIterator __f, _OutputIterator __t,
+			 _SoaGenerator __gen)
+      {
+	alignas(64) _RealType __buf[_Dim][__bulk_block];
+	std::array<_RealType*, _Dim> __x;
+	for (std::size_t __j = 0; __j < _Dim; ++__j)
+	  __x[__j] = __buf[__j];
+	std::size_t __n = std::distance(__f, __t);
+	while (__n > 0)
+	  {
+	    const std::size_t __m = std::min(__n, __bulk_block);
+	    __gen(__x, __m);
+	    for (std::size_t __i = 0; __i < __m; ++__i)
+	      {
+		std::array<_RealType, _Dim> __res;
+		for (std::size_t __j = 0; __j < _Dim; ++__j)
+		  __res[__j] = __buf[__j][__i];
+		*__f++ = __res;
+	      }
+	    __n -= __m;
+	  }
+      }
   }
 
   template<std::size_t _Dim, typename _RealType>
@@ -106,8 +139,93 @@ _GLIBCXX_BEGIN_NAMESPACE_VERSION
       {
 	__glibcxx_function_requires(_OutputIteratorConcept<_OutputIterator>)
 
-	while (__f != __t)
-	  *__f++ = this->operator()(__urng, __param);
+	__detail::__generate_vmf_aos<_Dim, _RealType>(__f, __t,
+	  [&](const std::array<_RealType*, _Dim>& __x, std::size_t __m)
+	  { this->__generate_soa(__x, __m, __urng, __param); });
+      }
+
+  template<std::size_t _Dim, typename _RealType>
+    template<typename _UniformRandomNumberGenerator>
+      void
+      von_mises_fisher_distribution<_Dim, _RealType>::
+      __generate_soa(const std::array<_RealType*, _Dim>& __x, std::size_t __n,
+		     _UniformRandomNumberGenerator& __urng,
+		     const param_type& __p)
+      {
+	constexpr std::size_t __blk = __detail::__bulk_block;
+
+	//  The beta variates of Wood's method come from a pair of gamma blocks.
+	const __detail::_Gamma_bulk_param<_RealType>
+	  __pg(_RealType(_Dim - 1) / 2);
+	const _RealType __b1 = 1 + __p._M_b;
+	const _RealType __b2 = 1 - __p._M_b;
+	const _RealType __kappa = __p._M_kappa;
+	const _RealType __dim = __p._M_Dim;
+	const _RealType __x0 = __p._M_x;
+	const _RealType __c0 = __p._M_c;
+
+	alignas(64) _RealType __g1[__blk];
+	alignas(64) _RealType __g2[__blk];
+	alignas(64) _RealType __u[__blk];
+	alignas(64) _RealType __c[__blk];
+	int __ok[__blk];
+	//  The coordinates in the frame (mu, lambda_0, ..., lambda_{_Dim-2}):
+	//  W in the first row, sqrt(1 - W^2) times a uniform tangent in the rest.
+	alignas(64) _RealType __y[_Dim][__blk];
+
+	for (std::size_t __k = 0; __k < __n; __k += __blk)
+	  {
+	    const std::size_t __m = std::min(__blk, __n - __k);
+
+	    std::size_t __nw = 0;
+	    while (__nw < __m)
+	      {
+		const std::size_t __np = __m - __nw;
+		__detail::__generate_gamma(__urng, __g1, __np, __pg);
+		__detail::__generate_gamma(__urng, __g2, __np, __pg);
+		__detail::__generate_canonical_block(__urng, __u, __np);
+		for (std::size_t __i = 0; __i < __np; ++__i)
+		  {
+		    const _RealType __z = __g1[__i] / (__g1[__i] + __g2[__i]);
+		    const _RealType __w = (1 - __b1 * __z) / (1 - __b2 * __z);
+		    __c[__i] = __w;
+		    __ok[__i] = __kappa * __w + __dim * std::log(1 - __x0 * __w)
+			      - __c0 >= std::log(__u[__i]);
+		  }
+		for (std::size_t __i = 0; __i < __np; ++__i)
+		  if (__ok[__i])
+		    __y[0][__nw++] = __c[__i];
+	      }
+
+	    for (std::size_t __j = 1; __j < _Dim; ++__j)
+	      __detail::__generate_normal_block(__urng, __y[__j], __m);
+	    std::fill(__c, __c + __m, _RealType(0));
+	    for (std::size_t __j = 1; __j < _Dim; ++__j)
+	      for (std::size_t __i = 0; __i < __m; ++__i)
+		__c[__i] += __y[__j][__i] * __y[__j][__i];
+	    for (std::size_t __i = 0; __i < __m; ++__i)
+	      __c[__i] = std::sqrt(std::max(_RealType(0),
+					    1 - __y[0][__i] * __y[0][__i])
+				   / __c[__i]);
+	    for (std::size_t __j = 1; __j < _Dim; ++__j)
+	      for (std::size_t __i = 0; __i < __m; ++__i)
+		__y[__j][__i] *= __c[__i];
+
+	    //  x = [mu lambda_0 ... lambda_{_Dim-2}] y for the whole block.
+	    for (std::size_t __r = 0; __r < _Dim; ++__r)
+	      {
+		_RealType* __xr = __x[__r] + __k;
+		const _RealType __mur = __p._M_mu[__r];
+		for (std::size_t __i = 0; __i < __m; ++__i)
+		  __xr[__i] = __mur * __y[0][__i];
+		for (std::size_t __j = 1; __j < _Dim; ++__j)
+		  {
+		    const _RealType __l = __p._M_lambda[__j - 1][__r];
+		    for (std::size_t __i = 0; __i < __m; ++__i)
+		      __xr[__i] += __l * __y[__j][__i];
+		  }
+	      }
+	  }
       }
 
   template<typename _RealType>
@@ -135,7 +253,7 @@ _GLIBCXX_BEGIN_NAMESPACE_VERSION
       {
 	using __parm_t = typename von_mises_distribution<_RealType>::param_type;
 	using __res_t = typename von_mises_distribution<_RealType>::result_type;
-	__parm_t __parm(__p._M_theta0);
+	__parm_t __parm(__p._M_theta0, __p._M_kappa);
 	__res_t __vmd_res = _M_vmd(__urng, __parm);
 
 	result_type __res;
@@ -157,8 +275,11 @@ _GLIBCXX_BEGIN_NAMESPACE_VERSION
 	  __aurng(__urng);
 
 	auto __xi = __aurng();
-	auto __W = 1 + std::log(__xi + (1 - __xi) * std::exp(-2 * __p.kappa()))
-		 / __p.kappa();
+	//  kappa = 0 is the uniform distribution.
+	auto __W = __p.kappa() > 0
+		 ? 1 + std::log(__xi + (1 - __xi) * std::exp(-2 * __p.kappa()))
+		     / __p.kappa()
+		 : 2 * __xi - 1;
 	auto __rt = std::sqrt(1 - __W * __W);
 	auto __V = _M_uosd(__urng);
 
@@ -172,6 +293,133 @@ _GLIBCXX_BEGIN_NAMESPACE_VERSION
       }
 
 
+  template<typename _RealType>
+    template<typename _OutputIterator,
+	     typename _UniformRandomNumberGenerator>
+      void
+      von_mises_fisher_distribution<2, _RealType>::
+      __generate_impl(_OutputIterator __f, _OutputIterator __t,
+		      _UniformRandomNumberGenerator& __urng,
+		      const param_type& __p)
+      {
+	__glibcxx_function_requires(_OutputIteratorConcept<_OutputIterator>)
+
+	while (__f != __t)
+	  *__f++ = this->operator()(__urng, __p);
+      }
+
+  template<typename _RealType>
+    template<typename _UniformRandomNumberGenerator>
+      void
+      von_mises_fisher_distribution<2, _RealType>::
+      __generate_soa(const std::array<_RealType*, 2>& __x, std::size_t __n,
+		     _UniformRandomNumberGenerator& __urng,
+		     const param_type& __p)
+      {
+	for (std::size_t __i = 0; __i < __n; ++__i)
+	  {
+	    const auto __res = this->operator()(__urng, __p);
+	    __x[0][__i] = __res[0];
+	    __x[1][__i] = __res[1];
+	  }
+      }
+
+  template<typename _RealType>
+    template<typename _OutputIterator,
+	     typename _UniformRandomNumberGenerator>
+      void
+      von_mises_fisher_distribution<3, _RealType>::
+      __generate_impl(_OutputIterator __f, _OutputIterator __t,
+		      _UniformRandomNumberGenerator& __urng,
+		      const param_type& __p)
+      {
+	__glibcxx_function_requires(_OutputIteratorConcept<_OutputIterator>)
+
+	__detail::__generate_vmf_aos<3, _RealType>(__f, __t,
+	  [&](const std::array<_RealType*, 3>& __x, std::size_t __m)
+	  { this->__generate_soa(__x, __m, __urng, __p); });
+      }
+
+  template<typename _RealType>
+    template<typename _UniformRandomNumberGenerator>
+      void
+      von_mises_fisher_distribution<3, _RealType>::
+      __generate_soa(const std::array<_RealType*, 3>& __x, std::size_t __n,
+		     _UniformRandomNumberGenerator& __urng,
+		     const param_type& __p)
+      {
+	constexpr std::size_t __blk = __detail::__bulk_block;
+	const _RealType __2pi = _RealType(6.283185307179586476925286766559005768L);
+	const _RealType __kappa = __p._M_kappa;
+	const _RealType __e = std::exp(-2 * __kappa);
+	//  kappa = 0 is the uniform distribution, W = 2 xi - 1.
+	const bool __uniform = !(__kappa > _RealType(0));
+	const _RealType __ik = __uniform ? _RealType(0) : 1 / __kappa;
+
+	alignas(64) _RealType __xi[__blk];
+	alignas(64) _RealType __phi[__blk];
+	alignas(64) _RealType __w[__blk];
+	alignas(64) _RealType __s[__blk];
+	alignas(64) _RealType __t1[__blk];
+	alignas(64) _RealType __t2[__blk];
+
+	for (std::size_t __k = 0; __k < __n; __k += __blk)
+	  {
+	    const std::size_t __m = std::min(__blk, __n - __k);
+	    __detail::__generate_canonical_block(__urng, __xi, __m);
+	    for (std::size_t __i = 0; __i < __m; ++__i)
+	      {
+		const _RealType __W = __uniform
+		  ? 2 * __xi[__i] - 1
+		  : 1 + std::log(__xi[__i] + (1 - __xi[__i]) * __e) * __ik;
+		__w[__i] = __W;
+		__s[__i] = std::sqrt(std::max(_RealType(0), 1 - __W * __W));
+	      }
+#ifndef __FAST_MATH__
+	    //  Scalar cos and sin cost more than rejecting points of the
+	    //  square outside the unit disk; the tangent is the direction
+	    //  of an accepted point.
+	    for (std::size_t __j = 0; __j < __m; )
+	      {
+		const std::size_t __c = std::min(__blk / 2,
+						 (5 * (__m - __j) + 7) / 4 + 1);
+		__detail::__generate_canonical_block(__urng, __phi, 2 * __c);
+		for (std::size_t __i = 0; __i < __c && __j < __m; ++__i)
+		  {
+		    const _RealType __u = 2 * __phi[2 * __i] - 1;
+		    const _RealType __v = 2 * __phi[2 * __i + 1] - 1;
+		    const _RealType __r2 = __u * __u + __v * __v;
+		    if (__r2 >= _RealType(1) || __r2 == _RealType(0))
+		      continue;
+		    const _RealType __f = __s[__j] / std::sqrt(__r2);
+		    __t1[__j] = __u * __f;
+		    __t2[__j] = __v * __f;
+		    ++__j;
+		  }
+	      }
+#else
+	    __detail::__generate_canonical_block(__urng, __phi, __m);
+	    //  Separate loops for cos and sin: GCC would merge them into sincos,
+	    //  which has no vector variant.
+	    for (std::size_t __i = 0; __i < __m; ++__i)
+	      __t1[__i] = __s[__i] * std::cos(__2pi * __phi[__i]);
+	    for (std::size_t __i = 0; __i < __m; ++__i)
+	      __t2[__i] = __s[__i] * std::sin(__2pi * __phi[__i]);
+#endif
+
+	    for (std::size_t __r = 0; __r < 3; ++__r)
+	      {
+		_RealType* __xr = __x[__r] + __k;
+		const _RealType __mur = __p._M_mu[__r];
+		const _RealType __l0 = __p._M_lambda[0][__r];
+		const _RealType __l1 = __p._M_lambda[1][__r];
+		for (std::size_t __i = 0; __i < __m; ++__i)
+		  __xr[__i] = __mur * __w[__i] + __l0 * __t1[__i] + __l1 * __t2[__i];
+	      }
+	  }
+      }
+
+
   template<std::size_t _Dim, typename _RealType,
 	   typename _CharT, typename _Traits>
     std::basic_ostream<_CharT, _Traits>&
@@ -264,7 +512,8 @@ _GLIBCXX_BEGIN_NAMESPACE_VERSION
       __is.flags(__ios_base::dec | __ios_base::skipws);
 
       std::array<_RealType, _Dim> __mu;
-      __is >> __mu;
+      for (auto& __k : __mu)
+	__is >> __k;
       _RealType __kappa;
       __is >> __kappa;
       __x.param(typename von_mises_fisher_distribution<_Dim, _RealType>::